@@ -0,0 +1,31 @@
+/* instancing.vert - draws the test model instances of the stress mode */
+
+// per-instance attributes, set the instance count in the scene tab.
+attribute mat4 attrInstanceTransform;
+attribute vec4 attrInstanceColor;
+
+
+varying vec3 normal;
+varying vec3 position;
+
+
+//
+// entry point
+//
+void main( void )
+{
+	// place the instance in the world
+	vec4 vertex = attrInstanceTransform * gl_Vertex;
+	vec3 N = mat3( attrInstanceTransform[0].xyz,
+				   attrInstanceTransform[1].xyz,
+				   attrInstanceTransform[2].xyz ) * gl_Normal;
+
+	gl_FrontColor = attrInstanceColor;
+	gl_TexCoord[0] = gl_MultiTexCoord0;
+
+	// now apply the application provided transformations
+	normal = gl_NormalMatrix * N;
+	position = vec3( gl_ModelViewMatrix * vertex );
+
+	gl_Position = gl_ModelViewProjectionMatrix * vertex;
+}
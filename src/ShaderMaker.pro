@@ -41,6 +41,23 @@ win32 {
 
 macx:LIBS     += -lz -framework Carbon
 
+#
+# EGL, for the offscreen context of the batch mode.
+# To build without it:  qmake CONFIG+=no_egl
+#
+unix:!macx:!no_egl {
+	DEFINES += CONFIG_ENABLE_EGL
+	LIBS += -lEGL
+}
+
+#
+# "make check" builds and runs the tangent space check, see check/tangentcheck.pro
+#
+unix {
+	check.commands = cd check && $(QMAKE) tangentcheck.pro && $(MAKE) && ./tangentcheck ../../models/teapot.obj
+	QMAKE_EXTRA_TARGETS += check
+}
+
 ###############################################################################
 #	RESOURCES
 ###############################################################################
@@ -52,23 +69,38 @@ RESOURCES = images/images.qrc
 # sources
 ###############################################################################
 
-SOURCES += editor.cpp \
+SOURCES += batch.cpp \
+           benchmark.cpp \
+           debuglines.cpp \
+           deform.cpp \
+           editor.cpp \
            editwindow.cpp \
+           feedback.cpp \
            geometry.cpp \
+           glextra.cpp \
            glwidget.cpp \
            highlighter.cpp \
+           includegraph.cpp \
            lightwidget.cpp \
            main.cpp \
+           modelbuilder.cpp \
+           modelcache.cpp \
            objmodel.cpp \
+           offscreen.cpp \
+           parallel.cpp \
+           programcache.cpp \
+           programlinker.cpp \
            programwindow.cpp \
            scene.cpp \
            scenewidget.cpp \
            shader.cpp \
            sourceeditor.cpp \
+           tangentspace.cpp \
            texturewidget.cpp \
            uniform.cpp \
            uniformwidget.cpp \
            universalslider.cpp \
+           variantwidget.cpp \
            vertexstream.cpp \
            glee/GLee.c
 
@@ -78,25 +110,40 @@ SOURCES += editor.cpp \
 ###############################################################################
 
 HEADERS += application.h \
+           batch.h \
+           benchmark.h \
            camera.h \
            config.h \
+           debuglines.h \
+           deform.h \
            editor.h \
            editwindow.h \
+           feedback.h \
+           glextra.h \
            glwidget.h \
+           includegraph.h \
            light.h \
            lightwidget.h \
            model.h \
+           modelbuilder.h \
+           modelcache.h \
+           offscreen.h \
+           parallel.h \
+           programcache.h \
+           programlinker.h \
            programwindow.h \
            scene.h \
            scenewidget.h \
            shader.h \
            sourceeditor.h \
            stdshader.h \
+           tangentspace.h \
            texture.h \
            texturewidget.h \
            uniform.h \
            uniformwidget.h \
            universalslider.h \
+           variantwidget.h \
            vector.h \
            vertexstream.h \
            glee/GLee.h
@@ -72,30 +72,54 @@
 //	custom vertex attributes
 //=============================================================================
 
+#include <QtCore/QHash>
+
 /** Vertex attribute locations of a GLSL program.
  *
  * This is a list of all known/supported vertex attributes used by
- * the application.
+ * the application. Additionally it stores the locations of all active
+ * attributes of the program by name, so vertex streams can match their
+ * custom attributes, see IVertexStream::addAttribute().
  */
 class VertexAttribLocations
 {
 public:
+	/** Built-in attributes read by the program, see builtins. */
+	enum builtin_e
+	{
+		BUILTIN_NORMAL		= 0x01,	///< gl_Normal
+		BUILTIN_TEXCOORD	= 0x02,	///< gl_MultiTexCoord0
+		BUILTIN_COLOR		= 0x04,	///< gl_Color
+
+		BUILTIN_ALL			= 0x07,
+	};
+
 	/** Constructs the attribute locaion from given values.
 	 * It defaults to -1, which means 'not present'.
 	 * @param Tangent	Tangent attrubute.
 	 * @param Bitangent	Bitangent attrinute.
+	 * @param InstanceTransform	Per-instance transformation matrix attribute.
+	 * @param InstanceColor		Per-instance color attribute.
 	 */
-	VertexAttribLocations( int Tangent=-1, int Bitangent=-1 )
-		: tangent(Tangent), bitangent(Bitangent)
+	VertexAttribLocations( int Tangent=-1, int Bitangent=-1,
+						   int InstanceTransform=-1, int InstanceColor=-1 )
+		: tangent(Tangent), bitangent(Bitangent),
+		  instanceTransform(InstanceTransform), instanceColor(InstanceColor),
+		  programSerial(0), builtins(BUILTIN_ALL)
 	{
 	}
 
 	/** Returns nonzero if the objects store the same values, otherwise zero.
+	 * The named locations are compared by the program serial number.
 	 */
 	inline int operator==( const VertexAttribLocations & other ) const
 	{
-		return	( this->tangent		== other.tangent ) &&
-				( this->bitangent	== other.bitangent );
+		return	( this->tangent				== other.tangent ) &&
+				( this->bitangent			== other.bitangent ) &&
+				( this->instanceTransform	== other.instanceTransform ) &&
+				( this->instanceColor		== other.instanceColor ) &&
+				( this->programSerial		== other.programSerial ) &&
+				( this->builtins			== other.builtins );
 	}
 
 	/** Returns zero if the objects store the same values, otherwise nonzero.
@@ -108,6 +132,25 @@ public:
 	// tangent space basis vectors
 	int tangent;	///< tangent attrinute location.
 	int bitangent;	///< bitangent attribute location.
+
+	// instancing, see IScene::setNumInstances()
+	int instanceTransform;	///< mat4 attribute, uses 4 consecutive locations.
+	int instanceColor;		///< instance color attribute location.
+
+	/** Returns the location of an active attribute, -1 if the program doesn't read it. */
+	inline int find( const QString & name ) const
+	{
+		return named.value( name, -1 );
+	}
+
+	// all active attributes
+	int programSerial;			///< unique for every linked program, 0 if no program is bound.
+	QHash< QString, int > named; ///< active attribute locations by name.
+
+	/** builtin_e flags of the built-in attributes the program reads.
+	 * All of them if no program is bound, the fixed function pipeline reads them.
+	 */
+	int builtins;
 };
 
 
@@ -0,0 +1,593 @@
+//=============================================================================
+/** @file		batch.cpp
+ *
+ * Implements the headless batch mode.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QDirIterator>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMap>
+#include <QtCore/QProcess>
+#include <QtCore/QTextStream>
+#include <QtCore/QThread>
+
+#include <stdio.h>
+
+#include "application.h"
+#include "batch.h"
+#include "offscreen.h"
+#include "shader.h"
+
+
+// exit codes of the workers
+enum batchResult_e
+{
+	BATCH_PASS = 0,
+	BATCH_FAIL,
+	BATCH_ERROR,	// the program could not be built, e.g. no context
+	BATCH_SKIPPED,	// a stage is not supported by the driver
+
+	// only reported by the driver
+	BATCH_CRASHED,
+	BATCH_TIMEOUT,
+
+	NUM_BATCH_RESULTS,
+};
+
+static const char* const BATCH_RESULT_NAMES[ NUM_BATCH_RESULTS ] =
+{
+	"pass", "fail", "error", "skipped", "crashed", "timeout",
+};
+
+
+//=============================================================================
+//	JSON output
+//=============================================================================
+
+/*
+========================
+jsonString
+========================
+*/
+static QString jsonString( const QString & text )
+{
+	QString result( "\"" );
+
+	for( int i = 0 ; i < text.length() ; i++ )
+	{
+		QChar c = text[ i ];
+		switch( c.unicode() )
+		{
+		case '"':	result += QString( "\\\"" ); break;
+		case '\\':	result += QString( "\\\\" ); break;
+		case '\n':	result += QString( "\\n" ); break;
+		case '\r':	result += QString( "\\r" ); break;
+		case '\t':	result += QString( "\\t" ); break;
+		default:
+			if( c.unicode() < 0x20 ) {
+				result += QString( "\\u%1" ).arg( (int)c.unicode(), 4, 16, QChar( '0' ) );
+			} else {
+				result += c;
+			}
+		}
+	}
+
+	result += QChar( '"' );
+	return result;
+}
+
+
+/*
+========================
+jsonMember
+========================
+*/
+static QString jsonMember( const char* name, const QString & value )
+{
+	return QString( "\"%1\": %2" ).arg( name ).arg( value );
+}
+
+
+/*
+========================
+jsonNumber
+========================
+*/
+static QString jsonNumber( double value )
+{
+	return QString::number( value, 'f', 3 );
+}
+
+
+/*
+========================
+programMembers
+
+ the members every program of the report has.
+========================
+*/
+static QStringList programMembers( const QString & name, const QStringList & files )
+{
+	QStringList quoted;
+	for( int i = 0 ; i < files.size() ; i++ ) {
+		quoted.append( jsonString( files[ i ] ) );
+	}
+
+	QStringList members;
+	members.append( jsonMember( "name", jsonString( name ) ) );
+	members.append( jsonMember( "files", QString( "[ %1 ]" ).arg( quoted.join( ", " ) ) ) );
+	return members;
+}
+
+
+/*
+========================
+programObject
+
+ formats a program of the report, it is indented as an element of "programs".
+========================
+*/
+static QString programObject( QStringList members, int result, const QString & log )
+{
+	members.insert( 1, jsonMember( "result", jsonString( BATCH_RESULT_NAMES[ result ] ) ) );
+	members.append( jsonMember( "log", jsonString( log ) ) );
+
+	return QString( "\t\t{\n\t\t\t%1\n\t\t}" ).arg( members.join( ",\n\t\t\t" ) );
+}
+
+
+//=============================================================================
+//	worker process
+//=============================================================================
+
+/*
+========================
+shaderTypeFromFile
+
+ returns -1 for unknown extensions.
+========================
+*/
+static int shaderTypeFromFile( const QString & path )
+{
+	QString suffix = QFileInfo( path ).suffix().toLower();
+
+	if( suffix == QString( "vert" ) ) return IShader::TYPE_VERTEX;
+	if( suffix == QString( "geom" ) ) return IShader::TYPE_GEOMETRY;
+	if( suffix == QString( "frag" ) ) return IShader::TYPE_FRAGMENT;
+
+	return -1;
+}
+
+
+/*
+========================
+loadSources
+========================
+*/
+static int loadSources( IShader* shader, const QStringList & files, QString & log )
+{
+	for( int i = 0 ; i < files.size() ; i++ )
+	{
+		int type = shaderTypeFromFile( files[ i ] );
+		if( type < 0 )
+		{
+			log += QString( "ERROR: %1 is no .vert, .geom or .frag file\n" ).arg( files[ i ] );
+			return BATCH_ERROR;
+		}
+
+		if( !shader->isShaderTypeAvailable( type ) )
+		{
+			log += QString( "%1 is not supported by the driver\n" ).arg( IShader::getShaderTypeName( type ) );
+			return BATCH_SKIPPED;
+		}
+
+		QFile file( files[ i ] );
+		if( !file.open( QFile::ReadOnly | QFile::Text ) )
+		{
+			log += QString( "ERROR: can't read %1\n" ).arg( files[ i ] );
+			return BATCH_ERROR;
+		}
+
+		QTextStream in( &file );
+		shader->setShaderSource( type, in.readAll(), QFileInfo( files[ i ] ).absoluteFilePath() );
+	}
+
+	return BATCH_PASS;
+}
+
+
+/*
+========================
+runWorker
+
+ builds one program and prints its report object to stdout.
+========================
+*/
+static int runWorker( const QString & name, const QStringList & files )
+{
+	QStringList members = programMembers( name, files );
+	QString log;
+
+	IOffscreenContext* context = IOffscreenContext::create( log );
+	if( context == NULL )
+	{
+		QString object = programObject( members, BATCH_ERROR, log );
+		fprintf( stdout, "%s\n", object.toUtf8().constData() );
+		return BATCH_ERROR;
+	}
+
+	smglInit( context->getProcAddress() );
+
+	members.append( jsonMember( "context", jsonString( context->getDescription() ) ) );
+	members.append( jsonMember( "renderer", jsonString( QString( (const char*)glGetString( GL_RENDERER ) ) ) ) );
+	members.append( jsonMember( "version", jsonString( QString( (const char*)glGetString( GL_VERSION ) ) ) ) );
+
+	// no binaries, the times are the ones of real compiles
+	IShader* shader = IShader::create();
+	shader->init( false );
+
+	int result = loadSources( shader, files, log );
+	if( result == BATCH_PASS )
+	{
+		bool linked = shader->compileAndLink();
+		result = linked ? BATCH_PASS : BATCH_FAIL;
+		log += shader->getBuildLog();
+
+		double compileMs = 0.0, linkMs = 0.0;
+		shader->getBuildTimes( compileMs, linkMs );
+		members.append( jsonMember( "compileMs", jsonNumber( compileMs ) ) );
+		members.append( jsonMember( "linkMs", jsonNumber( linkMs ) ) );
+
+		QStringList uniforms;
+		for( int i = 0 ; i < shader->getActiveUniforms() ; i++ )
+		{
+			CUniform u = shader->getUniform( i );
+			uniforms.append( QString( "{ %1, %2, %3, %4 }" ).
+				arg( jsonMember( "name", jsonString( u.getName() ) ) ).
+				arg( jsonMember( "type", jsonString( u.getTypeName() ) ) ).
+				arg( jsonMember( "location", QString::number( u.getLocation() ) ) ).
+				arg( jsonMember( "block", QString::number( u.getBlock() ) ) ) );
+		}
+
+		// the active attributes are known once the program is bound
+		VertexAttribLocations attribs;
+		if( linked ) {
+			shader->bindState( attribs );
+		}
+
+		QStringList attributes;
+		QStringList names = attribs.named.keys();
+		names.sort();
+		for( int i = 0 ; i < names.size() ; i++ )
+		{
+			attributes.append( QString( "{ %1, %2 }" ).
+				arg( jsonMember( "name", jsonString( names[ i ] ) ) ).
+				arg( jsonMember( "location", QString::number( attribs.named.value( names[ i ] ) ) ) ) );
+		}
+
+		members.append( jsonMember( "uniforms", uniforms.isEmpty() ? QString( "[]" ) :
+			QString( "[\n\t\t\t\t%1\n\t\t\t]" ).arg( uniforms.join( ",\n\t\t\t\t" ) ) ) );
+		members.append( jsonMember( "attributes", attributes.isEmpty() ? QString( "[]" ) :
+			QString( "[\n\t\t\t\t%1\n\t\t\t]" ).arg( attributes.join( ",\n\t\t\t\t" ) ) ) );
+	}
+
+	shader->shutdown();
+	delete shader;
+	delete context;
+
+	QString object = programObject( members, result, log );
+	fprintf( stdout, "%s\n", object.toUtf8().constData() );
+	return result;
+}
+
+
+//=============================================================================
+//	driver process
+//=============================================================================
+
+/** A worker process building one program. */
+class BatchJob
+{
+public:
+	BatchJob( void ) : process( NULL ), index( 0 ) {}
+
+	QProcess*		process;
+	int				index;	// into the programs
+	QElapsedTimer	timer;
+};
+
+
+/*
+========================
+findPrograms
+
+ groups the shader files by directory and base name,
+ keyed by that name relative to the batch directory.
+========================
+*/
+static QMap< QString, QStringList > findPrograms( const QDir & dir )
+{
+	QMap< QString, QStringList > programs;
+
+	QStringList filters;
+	filters << QString( "*.vert" ) << QString( "*.geom" ) << QString( "*.frag" );
+
+	QDirIterator it( dir.absolutePath(), filters, QDir::Files, QDirIterator::Subdirectories );
+	while( it.hasNext() )
+	{
+		QFileInfo info( it.next() );
+		QString name = dir.relativeFilePath( info.absolutePath() + QString( "/" ) + info.completeBaseName() );
+		programs[ name ].append( info.absoluteFilePath() );
+	}
+
+	// the vertex shader first, like the editor windows
+	QMap< QString, QStringList >::iterator program;
+	for( program = programs.begin() ; program != programs.end() ; ++program )
+	{
+		QStringList sorted;
+		for( int type = 0 ; type < IShader::MAX_SHADER_TYPES ; type++ )
+		{
+			for( int i = 0 ; i < program.value().size() ; i++ )
+			{
+				if( shaderTypeFromFile( program.value()[ i ] ) == type ) {
+					sorted.append( program.value()[ i ] );
+				}
+			}
+		}
+		program.value() = sorted;
+	}
+
+	return programs;
+}
+
+
+/*
+========================
+finishJob
+
+ returns the report object of a finished or timed out worker.
+========================
+*/
+static QString finishJob( BatchJob & job, const QString & name, const QStringList & files,
+						  bool timedOut, int timeout, int & result )
+{
+	QString object = QString::fromUtf8( job.process->readAllStandardOutput() ).trimmed();
+	QString errors = QString::fromLocal8Bit( job.process->readAllStandardError() );
+
+	if( timedOut )
+	{
+		result = BATCH_TIMEOUT;
+		return programObject( programMembers( name, files ), result,
+			QString( "ERROR: the build took longer than %1 s\n" ).arg( timeout ) + errors );
+	}
+
+	if( job.process->exitStatus() != QProcess::NormalExit || object.isEmpty() )
+	{
+		result = BATCH_CRASHED;
+		return programObject( programMembers( name, files ), result,
+			QString( "ERROR: the worker process crashed\n" ) + errors );
+	}
+
+	result = job.process->exitCode();
+	if( result < BATCH_PASS || result > BATCH_SKIPPED ) {
+		result = BATCH_FAIL;
+	}
+
+	// the report object is indented by the worker
+	return QString( "\t\t" ) + object;
+}
+
+
+/*
+========================
+runDriver
+========================
+*/
+static int runDriver( const QString & directory, int jobs, const QString & output, int timeout )
+{
+	QDir dir( directory );
+	if( !dir.exists() )
+	{
+		fprintf( stderr, "ShaderMaker: the directory %s does not exist\n", directory.toLocal8Bit().constData() );
+		return BATCH_ERROR;
+	}
+
+	QMap< QString, QStringList > programs = findPrograms( dir );
+	if( programs.isEmpty() )
+	{
+		fprintf( stderr, "ShaderMaker: no .vert, .geom or .frag files below %s\n", directory.toLocal8Bit().constData() );
+		return BATCH_ERROR;
+	}
+
+	QStringList names = programs.keys();
+	QStringList objects;
+	for( int i = 0 ; i < names.size() ; i++ ) {
+		objects.append( QString() );
+	}
+	int counts[ NUM_BATCH_RESULTS ] = { 0 };
+
+	QElapsedTimer wallTimer;
+	wallTimer.start();
+
+	// N workers at a time, the results are kept in the order of the names
+	QList< BatchJob > running;
+	int next = 0;
+	while( next < names.size() || !running.isEmpty() )
+	{
+		while( running.size() < jobs && next < names.size() )
+		{
+			QStringList args;
+			args << QString( "--batch-worker" ) << names[ next ] << programs[ names[ next ] ];
+
+			BatchJob job;
+			job.index = next++;
+			job.process = new QProcess();
+			job.process->start( QCoreApplication::applicationFilePath(), args );
+			job.timer.start();
+			running.append( job );
+		}
+
+		for( int i = 0 ; i < running.size() ; )
+		{
+			BatchJob & job = running[ i ];
+
+			// also reads the output, so the pipes never fill up
+			bool finished = job.process->waitForFinished( 10 ) || job.process->state() == QProcess::NotRunning;
+			bool timedOut = !finished && job.timer.elapsed() > timeout * 1000;
+			if( !finished && !timedOut )
+			{
+				i++;
+				continue;
+			}
+
+			if( timedOut )
+			{
+				job.process->kill();
+				job.process->waitForFinished( -1 );
+			}
+
+			const QString & name = names[ job.index ];
+			int result = BATCH_FAIL;
+			objects[ job.index ] = finishJob( job, name, programs[ name ], timedOut, timeout, result );
+			counts[ result ]++;
+
+			fprintf( stderr, "%-8s %s\n", QString( BATCH_RESULT_NAMES[ result ] ).toUpper().toLatin1().constData(),
+					 name.toLocal8Bit().constData() );
+
+			delete job.process;
+			running.removeAt( i );
+		}
+	}
+
+	int failed = counts[ BATCH_FAIL ] + counts[ BATCH_ERROR ] + counts[ BATCH_CRASHED ] + counts[ BATCH_TIMEOUT ];
+
+	QStringList members;
+	members.append( jsonMember( "directory", jsonString( dir.absolutePath() ) ) );
+	members.append( jsonMember( "jobs", QString::number( jobs ) ) );
+	members.append( jsonMember( "wallMs", QString::number( wallTimer.elapsed() ) ) );
+	members.append( jsonMember( "passed", QString::number( counts[ BATCH_PASS ] ) ) );
+	members.append( jsonMember( "failed", QString::number( failed ) ) );
+	members.append( jsonMember( "skipped", QString::number( counts[ BATCH_SKIPPED ] ) ) );
+	members.append( jsonMember( "programs", QString( "[\n%1\n\t]" ).arg( objects.join( ",\n" ) ) ) );
+
+	QByteArray report = QString( "{\n\t%1\n}\n" ).arg( members.join( ",\n\t" ) ).toUtf8();
+
+	if( output.isEmpty() )
+	{
+		fwrite( report.constData(), 1, report.size(), stdout );
+	}
+	else
+	{
+		QFile file( output );
+		if( !file.open( QFile::WriteOnly | QFile::Truncate ) || file.write( report ) != report.size() )
+		{
+			fprintf( stderr, "ShaderMaker: can't write %s\n", output.toLocal8Bit().constData() );
+			return BATCH_ERROR;
+		}
+	}
+
+	fprintf( stderr, "%d passed, %d failed, %d skipped in %lld ms\n",
+			 counts[ BATCH_PASS ], failed, counts[ BATCH_SKIPPED ], (long long)wallTimer.elapsed() );
+
+	return ( failed > 0 ) ? BATCH_FAIL : BATCH_PASS;
+}
+
+
+//=============================================================================
+//	entry point
+//=============================================================================
+
+/*
+========================
+printUsage
+========================
+*/
+static void printUsage( void )
+{
+	fprintf( stderr,
+		"usage: ShaderMaker --batch directory [--jobs N] [--output report.json] [--timeout seconds]\n"
+		"\n"
+		"  Links the .vert, .geom and .frag files with the same name below the directory\n"
+		"  into programs and writes a JSON report with the logs, times, uniforms and attributes.\n"
+		"\n"
+		"  --jobs N             programs built at the same time, default: number of cores\n"
+		"  --output file        report file, default: stdout\n"
+		"  --timeout seconds    time a program may take, default: %d\n",
+		CONFIG_BATCH_TIMEOUT );
+}
+
+
+/*
+========================
+runBatchMode
+========================
+*/
+bool runBatchMode( int argc, char* argv[], int & exitCode )
+{
+	QStringList args;
+	for( int i = 0 ; i < argc ; i++ ) {
+		args.append( QString::fromLocal8Bit( argv[ i ] ) );
+	}
+
+	// ShaderMaker --batch-worker name file [file ...], started by the driver
+	if( args.size() > 1 && args[ 1 ] == QString( "--batch-worker" ) )
+	{
+		if( args.size() < 4 )
+		{
+			exitCode = BATCH_ERROR;
+			return true;
+		}
+
+		QCoreApplication app( argc, argv );
+		exitCode = runWorker( args[ 2 ], args.mid( 3 ) );
+		return true;
+	}
+
+	if( !args.contains( QString( "--batch" ) ) )
+		return false;
+
+	QString directory, output;
+	int jobs = qMax( QThread::idealThreadCount(), 1 );
+	int timeout = CONFIG_BATCH_TIMEOUT;
+
+	for( int i = 1 ; i < args.size() ; i++ )
+	{
+		bool ok = ( i + 1 < args.size() );
+		if( ok && args[ i ] == QString( "--batch" ) ) {
+			directory = args[ ++i ];
+		} else if( ok && args[ i ] == QString( "--jobs" ) ) {
+			jobs = args[ ++i ].toInt( &ok );
+		} else if( ok && args[ i ] == QString( "--output" ) ) {
+			output = args[ ++i ];
+		} else if( ok && args[ i ] == QString( "--timeout" ) ) {
+			timeout = args[ ++i ].toInt( &ok );
+		} else {
+			ok = false;
+		}
+
+		if( !ok || jobs < 1 || timeout < 1 )
+		{
+			printUsage();
+			exitCode = BATCH_ERROR;
+			return true;
+		}
+	}
+
+	QCoreApplication app( argc, argv );
+	exitCode = runDriver( directory, jobs, output, timeout );
+	return true;
+}
+
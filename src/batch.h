@@ -0,0 +1,47 @@
+//=============================================================================
+/** @file		batch.h
+ *
+ * Defines the headless batch mode.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#ifndef __BATCH_H_INCLUDED__
+#define __BATCH_H_INCLUDED__
+
+
+/** Runs the batch mode if the command line asks for it, before any window
+ * is created:
+ * \n\n
+ * ShaderMaker --batch directory [--jobs N] [--output report.json] [--timeout seconds]
+ * \n\n
+ * Every .vert, .geom and .frag file below the directory is compiled, the
+ * files with the same name in the same directory are linked into one
+ * program. The programs are built by worker processes of this executable,
+ * N at a time, each one with its own IOffscreenContext, so a crashing
+ * driver takes down only one program. The JSON report contains the result,
+ * the build log, the compile and link times, the active uniforms and the
+ * active attributes of every program. The program binary cache is not
+ * used, so the times are the ones of real compiles.
+ * \n\n
+ * The exit code is 0 if all programs linked, 1 if one failed, crashed or
+ * timed out, and 2 if the batch could not run. Programs with a stage the
+ * driver doesn't support are reported as skipped.
+ *
+ * @param argc Argument count of main().
+ * @param argv Arguments of main().
+ * @param exitCode Receives the exit code of the batch mode.
+ * @return False if the arguments don't select the batch mode.
+ */
+bool runBatchMode( int argc, char* argv[], int & exitCode );
+
+
+#endif	// __BATCH_H_INCLUDED__
+
@@ -0,0 +1,334 @@
+//=============================================================================
+/** @file		benchmark.cpp
+ *
+ * Implements the triangle throughput benchmark.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QTextStream>
+#include <math.h>
+
+#include "application.h"
+#include "benchmark.h"
+#include "scene.h"
+#include "model.h"
+
+
+//=============================================================================
+//	CTriangleBenchmark
+//=============================================================================
+
+// tuning constants
+static const int	BENCHMARK_WARMUP_FRAMES	= 3;	// not measured, includes the buffer upload
+static const int	BENCHMARK_MIN_FRAMES	= 10;	// per step
+static const qint64	BENCHMARK_MIN_TIME		= 250;	// ms per step
+static const qint64	BENCHMARK_MAX_TIME		= 2000;	// ms per step, for very slow programs
+
+
+/** Implementation of ITriangleBenchmark.
+ */
+class CTriangleBenchmark : public ITriangleBenchmark
+{
+public:
+	CTriangleBenchmark( IScene* scene );
+	virtual ~CTriangleBenchmark( void );
+
+	// ITriangleBenchmark interface
+	void	start( int model );
+	void	cancel( void ) { m_running = false; }
+	bool	isRunning( void ) { return m_running; }
+	bool	renderFrame( void );
+	void	getProgress( int & step, int & numSteps ) { step = m_step; numSteps = m_levels.size(); }
+	const QVector< Sample > & getResults( void ) { return m_results; }
+	int		getSaturationSample( void );
+	bool	writeCSV( const QString & fileName );
+
+private:
+
+	// step management
+	void	beginStep( void );
+	void	endStep( void );
+	void	deleteModel( void );
+
+	IScene*			m_scene;
+	int				m_modelType;
+	bool			m_running;
+
+	// tessellation levels, rings for the sphere, quads per side for the plane.
+	QVector< int >	m_levels;
+	int				m_step;
+
+	// current step
+	IModel*			m_model;
+	int				m_numFrames;	// including the warm-up frames
+	qint64			m_stepTime;		// ns, measured frames only
+	QElapsedTimer	m_stepTimer;	// since the first measured frame
+
+	QVector< Sample > m_results;
+};
+
+
+// construction
+CTriangleBenchmark::CTriangleBenchmark( IScene* scene )
+{
+	m_scene = scene;
+	m_modelType = MODEL_SPHERE;
+	m_running = false;
+	m_step = 0;
+	m_model = NULL;
+	m_numFrames = 0;
+	m_stepTime = 0;
+}
+
+// destruction
+CTriangleBenchmark::~CTriangleBenchmark( void )
+{
+	deleteModel();
+}
+
+
+/*
+========================
+ITriangleBenchmark::create
+========================
+*/
+ITriangleBenchmark* ITriangleBenchmark::create( IScene* scene )
+{
+	return new CTriangleBenchmark( scene );
+}
+
+
+/*
+========================
+start
+
+ every level has about twice the triangles of the previous one.
+========================
+*/
+void CTriangleBenchmark::start( int model )
+{
+	m_modelType = ( model == MODEL_PLANE ) ? MODEL_PLANE : MODEL_SPHERE;
+	m_levels.clear();
+	m_results.clear();
+	m_step = 0;
+
+	for( double level = 4.0 ; ; level *= sqrt( 2.0 ) )
+	{
+		int n = (int)( level + 0.5 );
+		double numTriangles;
+
+		if( m_modelType == MODEL_SPHERE ) {
+			numTriangles = 4.0 * n * ( n - 1 ); // n rings, 2n segments, single triangles at the poles
+		} else {
+			numTriangles = 2.0 * n * n;
+			if( n > CONFIG_MAX_GRID_RESOLUTION )
+				break;
+		}
+
+		if( numTriangles > CONFIG_BENCHMARK_MAX_TRIANGLES )
+			break;
+
+		if( m_levels.isEmpty() || m_levels.last() != n ) {
+			m_levels.append( n );
+		}
+	}
+
+	m_running = true;
+}
+
+
+/*
+========================
+deleteModel
+========================
+*/
+void CTriangleBenchmark::deleteModel( void )
+{
+	if( m_model == NULL )
+		return;
+
+	// don't leave a dangling pointer in the scene
+	if( m_scene->getCurrentModel() == m_model ) {
+		m_scene->setCurrentModel( NULL );
+	}
+
+	SAFE_DELETE( m_model );
+}
+
+
+/*
+========================
+beginStep
+========================
+*/
+void CTriangleBenchmark::beginStep( void )
+{
+	int n = m_levels[ m_step ];
+
+	if( m_modelType == MODEL_SPHERE ) {
+		m_model = IModel::createSphere( n, 2 * n, 1.0f );
+	} else {
+		m_model = IModel::createPlane( n, n );
+	}
+
+	m_numFrames = 0;
+	m_stepTime = 0;
+}
+
+
+/*
+========================
+endStep
+========================
+*/
+void CTriangleBenchmark::endStep( void )
+{
+	int n = m_levels[ m_step ];
+	int numMeasured = m_numFrames - BENCHMARK_WARMUP_FRAMES;
+
+	Sample sample;
+	if( m_modelType == MODEL_SPHERE ) {
+		sample.modelName = QString( "sphere %1x%2" ).arg( n ).arg( 2 * n );
+	} else {
+		sample.modelName = QString( "plane %1x%2" ).arg( n ).arg( n );
+	}
+
+	sample.numTriangles = m_model->getNumPrimitives();
+	sample.numInstances = m_scene->getNumInstances();
+	sample.numFrames = numMeasured;
+	sample.msPerFrame = double( m_stepTime ) / ( 1000000.0 * numMeasured );
+	if( m_stepTime > 0 ) {
+		sample.trianglesPerSecond = double( sample.numTriangles ) * sample.numInstances *
+			numMeasured * 1000000000.0 / double( m_stepTime );
+	}
+	m_results.append( sample );
+
+	deleteModel();
+
+	// next level
+	if( ++m_step >= m_levels.size() ) {
+		m_running = false;
+	}
+}
+
+
+/*
+========================
+renderFrame
+========================
+*/
+bool CTriangleBenchmark::renderFrame( void )
+{
+	if( !m_running )
+	{
+		// cancelled, clean up.
+		deleteModel();
+		return false;
+	}
+
+	if( m_model == NULL ) {
+		beginStep();
+	}
+
+	// the scene widget may have changed the model in the meantime
+	m_scene->setCurrentModel( m_model );
+
+	// wait for the previous frame, so only this one is measured.
+	glFinish();
+
+	QElapsedTimer timer;
+	timer.start();
+	m_scene->render();
+	glFinish();
+	qint64 frameTime = timer.nsecsElapsed();
+
+	// count
+	if( ++m_numFrames <= BENCHMARK_WARMUP_FRAMES )
+	{
+		if( m_numFrames == BENCHMARK_WARMUP_FRAMES ) {
+			m_stepTimer.start();
+		}
+		return true;
+	}
+
+	m_stepTime += frameTime;
+
+	// step done?
+	int numMeasured = m_numFrames - BENCHMARK_WARMUP_FRAMES;
+	qint64 elapsed = m_stepTimer.elapsed();
+	if( ( numMeasured >= BENCHMARK_MIN_FRAMES && elapsed >= BENCHMARK_MIN_TIME ) ||
+		elapsed >= BENCHMARK_MAX_TIME )
+	{
+		endStep();
+	}
+
+	return true;
+}
+
+
+/*
+========================
+getSaturationSample
+
+ the first sample that reaches 90% of the peak throughput.
+========================
+*/
+int CTriangleBenchmark::getSaturationSample( void )
+{
+	double peak = 0.0;
+	int i;
+
+	for( i = 0 ; i < m_results.size() ; i++ ) {
+		peak = qMax( peak, m_results[ i ].trianglesPerSecond );
+	}
+
+	for( i = 0 ; i < m_results.size() ; i++ )
+	{
+		if( m_results[ i ].trianglesPerSecond >= 0.9 * peak )
+			return i;
+	}
+
+	return -1;
+}
+
+
+/*
+========================
+writeCSV
+========================
+*/
+bool CTriangleBenchmark::writeCSV( const QString & fileName )
+{
+	QFile file( fileName );
+
+	if( !file.open( QFile::WriteOnly | QFile::Text | QFile::Truncate ) )
+		return false;
+
+	QTextStream out( &file );
+	out << "model,triangles,instances,frames,ms_per_frame,triangles_per_second\n";
+
+	for( int i = 0 ; i < m_results.size() ; i++ )
+	{
+		const Sample & s = m_results[ i ];
+		out << s.modelName << ","
+			<< s.numTriangles << ","
+			<< s.numInstances << ","
+			<< s.numFrames << ","
+			<< QString::number( s.msPerFrame, 'f', 4 ) << ","
+			<< QString::number( s.trianglesPerSecond, 'f', 0 ) << "\n";
+	}
+
+	out.flush();
+	return file.error() == QFile::NoError;
+}
+
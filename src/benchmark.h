@@ -0,0 +1,119 @@
+//=============================================================================
+/** @file		benchmark.h
+ *
+ * Defines the triangle throughput benchmark.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#ifndef __BENCHMARK_H_INCLUDED__
+#define __BENCHMARK_H_INCLUDED__
+
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+// forward declarations
+class IScene;
+
+
+//=============================================================================
+//	ITriangleBenchmark
+//=============================================================================
+
+/** Measures how the triangle throughput scales with the model size.
+ * The benchmark builds a procedural test model at increasing tessellation
+ * levels, each step has about twice the triangles of the previous one.
+ * Every step is rendered with the current scene state for some frames, so
+ * the shader program, the instance count, etc. are included in the measurement.
+ * \n\n
+ * The benchmark is driven by the render loop: call renderFrame() instead
+ * of IScene::render() while isRunning() returns true. The frame time
+ * includes a glFinish(), so it measures the GPU work, not the time to
+ * queue the commands.
+ */
+class ITriangleBenchmark
+{
+public:
+	/** The procedural models that can be measured. */
+	enum model_e
+	{
+		MODEL_SPHERE,	///< IModel::createSphere()
+		MODEL_PLANE,	///< IModel::createPlane()
+	};
+
+	/** The measurement of a single tessellation level. */
+	class Sample
+	{
+	public:
+		Sample( void ) : numTriangles( 0 ), numInstances( 1 ), numFrames( 0 ),
+			msPerFrame( 0.0 ), trianglesPerSecond( 0.0 ) {}
+
+		QString	modelName;			///< name and generator parameters
+		int		numTriangles;		///< triangles of a single instance
+		int		numInstances;		///< instances per frame, see IScene::setNumInstances()
+		int		numFrames;			///< number of measured frames
+		double	msPerFrame;			///< average frame time in milliseconds
+		double	trianglesPerSecond;	///< numTriangles * numInstances / frame time
+	};
+
+	/** Creates an ITriangleBenchmark object.
+	 * @param scene The scene to render, the benchmark replaces its test model.
+	 */
+	static ITriangleBenchmark* create( IScene* scene );
+
+	/** Destructor, a valid OpenGL context must be active. */
+	virtual ~ITriangleBenchmark( void ) {}
+
+	/** Starts a new run, the previous results are cleared.
+	 * @param model The model to measure, one of model_e.
+	 */
+	virtual void start( int model ) = 0;
+
+	/** Stops the current run. The results of the finished steps are kept.
+	 * The current test model is deleted by the next renderFrame() call or
+	 * by the destructor.
+	 */
+	virtual void cancel( void ) = 0;
+
+	/** Returns true while the benchmark needs frames. */
+	virtual bool isRunning( void ) = 0;
+
+	/** Renders the scene with the model of the current step and measures
+	 * the frame time. The scene's test model is changed, the caller must
+	 * restore it when the benchmark is done.
+	 * A valid OpenGL context must be active.
+	 * @return False if the benchmark is not running.
+	 */
+	virtual bool renderFrame( void ) = 0;
+
+	/** Returns the current step and the total number of steps. */
+	virtual void getProgress( int & step, int & numSteps ) = 0;
+
+	/** Returns the measurements of all finished steps. */
+	virtual const QVector< Sample > & getResults( void ) = 0;
+
+	/** Returns the index of the sample, where the throughput stops growing.
+	 * Below that size, the frame time is dominated by a constant overhead.
+	 * Above it, the frame time grows linearly with the triangle count, the
+	 * vertex or geometry stage is the bottleneck.
+	 * @return Index into getResults(), -1 if there are no results.
+	 */
+	virtual int getSaturationSample( void ) = 0;
+
+	/** Writes the results as comma separated values.
+	 * The first line contains the column names.
+	 * @return False if the file could not be written.
+	 */
+	virtual bool writeCSV( const QString & fileName ) = 0;
+};
+
+
+#endif	// __BENCHMARK_H_INCLUDED__
+
@@ -0,0 +1,590 @@
+//=============================================================================
+/** @file		mikkreference.cpp
+ *
+ * Implements genTangSpaceDefault() as a port of the algorithm of
+ * mikktspace.c, for triangles and the default angular threshold:
+ * - Corners with equal position, normal and texcoord are welded.
+ * - Triangles are neighbors if they share an edge in opposite directions.
+ * - The triangles around a vertex form groups, a group grows across the
+ *   edges of the vertex and only contains triangles of one orientation.
+ *   Triangles without texture area join a group, but don't contribute.
+ * - Every group gets the angle weighted sum of its projected triangle
+ *   tangents, a corner gets the tangent of its group.
+ * - Triangles with a repeated vertex copy the tangent space of another
+ *   corner of that vertex.
+ *
+ * The code is written for clarity, not speed, and shares nothing with
+ * tangentspace.cpp.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "mikkreference.h"
+
+
+// triangle flags
+#define MARK_DEGENERATE			1	// a vertex is repeated
+#define ORIENT_PRESERVING		2	// the texture mapping is not mirrored
+#define GROUP_WITH_ANY			4	// no texture area, joins any group
+
+
+/** A vector, kept apart from vector.h on purpose. */
+struct SVec3
+{
+	float x, y, z;
+};
+
+static SVec3 vec( float x, float y, float z )		{ SVec3 r = { x, y, z }; return r; }
+static SVec3 vadd( SVec3 a, SVec3 b )				{ return vec( a.x + b.x, a.y + b.y, a.z + b.z ); }
+static SVec3 vsub( SVec3 a, SVec3 b )				{ return vec( a.x - b.x, a.y - b.y, a.z - b.z ); }
+static SVec3 vscale( float s, SVec3 a )				{ return vec( s * a.x, s * a.y, s * a.z ); }
+static float vdot( SVec3 a, SVec3 b )				{ return a.x * b.x + a.y * b.y + a.z * b.z; }
+static float vlength( SVec3 a )						{ return sqrtf( vdot( a, a ) ); }
+static bool  notZero( float f )						{ return fabsf( f ) > FLT_MIN; }
+static bool  vnotZero( SVec3 a )					{ return notZero( a.x ) || notZero( a.y ) || notZero( a.z ); }
+static SVec3 vnormalize( SVec3 a )					{ return vscale( 1.0f / vlength( a ), a ); }
+
+// removes the normal component, normalizes the rest if possible
+static SVec3 vproject( SVec3 v, SVec3 n )
+{
+	v = vsub( v, vscale( vdot( n, v ), n ) );
+	return vnotZero( v ) ? vnormalize( v ) : v;
+}
+
+
+/** The input data of a corner. */
+struct SCorner
+{
+	float data[ 8 ]; // position, normal, texcoord
+};
+
+static SVec3 cornerPosition( const SCorner & c )	{ return vec( c.data[ 0 ], c.data[ 1 ], c.data[ 2 ] ); }
+static SVec3 cornerNormal( const SCorner & c )		{ return vec( c.data[ 3 ], c.data[ 4 ], c.data[ 5 ] ); }
+
+
+/** Triangle state, see mikktspace.c */
+struct STriInfo
+{
+	int		neighbors[ 3 ];		// across the edge from corner i to i+1, -1 if none
+	int		group[ 3 ];			// of each corner, -1 if none yet
+	SVec3	vOs, vOt;			// normalized first order derivatives, times the orientation
+	float	magS, magT;
+	int		flags;
+};
+
+
+/** A group of triangles around a vertex. */
+struct SGroup
+{
+	int		vertex;				// welded index
+	bool	orientPreserving;
+	int		first;				// in the face list
+	int		numFaces;
+};
+
+
+/** An edge for the neighbor search. */
+struct SEdge
+{
+	int		i0, i1;				// smaller and larger welded index
+	int		face;
+	int		edge;
+};
+
+
+// the corners being sorted by weldCorners()
+static const SCorner* s_sortCorners = NULL;
+
+
+/*
+========================
+compareCorners
+========================
+*/
+static int compareCorners( const void* a, const void* b )
+{
+	int ia = *(const int*)a;
+	int ib = *(const int*)b;
+
+	int result = memcmp( s_sortCorners[ ia ].data, s_sortCorners[ ib ].data, sizeof( s_sortCorners[ ia ].data ) );
+	if( result != 0 )
+		return result;
+
+	return ia - ib;
+}
+
+
+/*
+========================
+compareEdges
+========================
+*/
+static int compareEdges( const void* a, const void* b )
+{
+	const SEdge* ea = (const SEdge*)a;
+	const SEdge* eb = (const SEdge*)b;
+
+	if( ea->i0 != eb->i0 ) return ea->i0 - eb->i0;
+	if( ea->i1 != eb->i1 ) return ea->i1 - eb->i1;
+	if( ea->face != eb->face ) return ea->face - eb->face;
+	return ea->edge - eb->edge;
+}
+
+
+/*
+========================
+weldCorners
+
+ maps every corner to the first corner with the same data.
+========================
+*/
+static void weldCorners( const SCorner* corners, int numCorners, int* welded )
+{
+	int* order = new int[ numCorners ];
+	for( int i = 0 ; i < numCorners ; i++ ) {
+		order[ i ] = i;
+	}
+
+	s_sortCorners = corners;
+	qsort( order, numCorners, sizeof( int ), compareCorners );
+	s_sortCorners = NULL;
+
+	// within a run of equal corners the first one has the smallest index
+	int first = 0;
+	for( int i = 0 ; i < numCorners ; i++ )
+	{
+		if( i == 0 || memcmp( corners[ order[ i ] ].data, corners[ order[ i-1 ] ].data, sizeof( corners[ 0 ].data ) ) != 0 ) {
+			first = order[ i ];
+		}
+		welded[ order[ i ] ] = first;
+	}
+
+	delete [] order;
+}
+
+
+/*
+========================
+initTriInfo
+========================
+*/
+static void initTriInfo( STriInfo & info, const SCorner* corners, const int* tri )
+{
+	for( int i = 0 ; i < 3 ; i++ )
+	{
+		info.neighbors[ i ] = -1;
+		info.group[ i ] = -1;
+	}
+	info.vOs = vec( 0,0,0 );
+	info.vOt = vec( 0,0,0 );
+	info.magS = 0.0f;
+	info.magT = 0.0f;
+	info.flags = GROUP_WITH_ANY;
+
+	if( tri[ 0 ] == tri[ 1 ] || tri[ 1 ] == tri[ 2 ] || tri[ 0 ] == tri[ 2 ] ) {
+		info.flags |= MARK_DEGENERATE;
+	}
+
+	const float* c1 = corners[ tri[ 0 ] ].data;
+	const float* c2 = corners[ tri[ 1 ] ].data;
+	const float* c3 = corners[ tri[ 2 ] ].data;
+
+	float t21x = c2[ 6 ] - c1[ 6 ];
+	float t21y = c2[ 7 ] - c1[ 7 ];
+	float t31x = c3[ 6 ] - c1[ 6 ];
+	float t31y = c3[ 7 ] - c1[ 7 ];
+	SVec3 d1 = vsub( cornerPosition( corners[ tri[ 1 ] ] ), cornerPosition( corners[ tri[ 0 ] ] ) );
+	SVec3 d2 = vsub( cornerPosition( corners[ tri[ 2 ] ] ), cornerPosition( corners[ tri[ 0 ] ] ) );
+
+	float signedArea = t21x * t31y - t21y * t31x;
+	SVec3 vOs = vsub( vscale( t31y, d1 ), vscale( t21y, d2 ) );
+	SVec3 vOt = vadd( vscale( -t31x, d1 ), vscale( t21x, d2 ) );
+
+	if( signedArea > 0.0f ) {
+		info.flags |= ORIENT_PRESERVING;
+	}
+
+	if( notZero( signedArea ) )
+	{
+		float absArea = fabsf( signedArea );
+		float lenOs = vlength( vOs );
+		float lenOt = vlength( vOt );
+		float sign = ( info.flags & ORIENT_PRESERVING ) ? 1.0f : -1.0f;
+
+		if( notZero( lenOs ) ) info.vOs = vscale( sign / lenOs, vOs );
+		if( notZero( lenOt ) ) info.vOt = vscale( sign / lenOt, vOt );
+
+		info.magS = lenOs / absArea;
+		info.magT = lenOt / absArea;
+
+		if( notZero( info.magS ) && notZero( info.magT ) ) {
+			info.flags &= ~GROUP_WITH_ANY;
+		}
+	}
+}
+
+
+/*
+========================
+buildNeighbors
+
+ triangles are neighbors if they share an edge in opposite directions.
+========================
+*/
+static void buildNeighbors( STriInfo* infos, const int* triList, int numTriangles )
+{
+	SEdge* edges = new SEdge[ 3 * numTriangles ];
+	int numEdges = 0;
+
+	for( int f = 0 ; f < numTriangles ; f++ )
+	{
+		if( infos[ f ].flags & MARK_DEGENERATE )
+			continue;
+
+		for( int i = 0 ; i < 3 ; i++ )
+		{
+			int a = triList[ 3*f + i ];
+			int b = triList[ 3*f + ( i + 1 ) % 3 ];
+
+			SEdge & e = edges[ numEdges++ ];
+			e.i0 = ( a < b ) ? a : b;
+			e.i1 = ( a < b ) ? b : a;
+			e.face = f;
+			e.edge = i;
+		}
+	}
+
+	qsort( edges, numEdges, sizeof( SEdge ), compareEdges );
+
+	for( int i = 0 ; i < numEdges ; i++ )
+	{
+		const SEdge & a = edges[ i ];
+		if( infos[ a.face ].neighbors[ a.edge ] != -1 )
+			continue;
+
+		int a0 = triList[ 3*a.face + a.edge ];
+		int a1 = triList[ 3*a.face + ( a.edge + 1 ) % 3 ];
+
+		// the first unassigned edge with the opposite direction
+		for( int j = i + 1 ; j < numEdges && edges[ j ].i0 == a.i0 && edges[ j ].i1 == a.i1 ; j++ )
+		{
+			const SEdge & b = edges[ j ];
+			int b0 = triList[ 3*b.face + b.edge ];
+			int b1 = triList[ 3*b.face + ( b.edge + 1 ) % 3 ];
+
+			if( b0 == a1 && b1 == a0 && infos[ b.face ].neighbors[ b.edge ] == -1 )
+			{
+				infos[ a.face ].neighbors[ a.edge ] = b.face;
+				infos[ b.face ].neighbors[ b.edge ] = a.face;
+				break;
+			}
+		}
+	}
+
+	delete [] edges;
+}
+
+
+/*
+========================
+cornerOfVertex
+
+ the corner of a triangle that uses a welded vertex, -1 if none does.
+========================
+*/
+static int cornerOfVertex( const int* triList, int face, int vertex )
+{
+	for( int i = 0 ; i < 3 ; i++ ) {
+		if( triList[ 3*face + i ] == vertex )
+			return i;
+	}
+
+	return -1;
+}
+
+
+/*
+========================
+assignRecur
+
+ adds a triangle and its neighbors around the vertex to a group.
+========================
+*/
+static bool assignRecur( STriInfo* infos, const int* triList, int face,
+						 SGroup* groups, int groupIndex, int* faceList )
+{
+	SGroup & group = groups[ groupIndex ];
+	STriInfo & info = infos[ face ];
+
+	int i = cornerOfVertex( triList, face, group.vertex );
+	if( i < 0 )
+		return false;
+
+	if( info.group[ i ] == groupIndex )
+		return true;
+	if( info.group[ i ] != -1 )
+		return false;
+
+	// a triangle without texture area takes the orientation of its first group
+	if( ( info.flags & GROUP_WITH_ANY ) && info.group[ 0 ] == -1 && info.group[ 1 ] == -1 && info.group[ 2 ] == -1 )
+	{
+		info.flags &= ~ORIENT_PRESERVING;
+		if( group.orientPreserving ) {
+			info.flags |= ORIENT_PRESERVING;
+		}
+	}
+
+	if( ( ( info.flags & ORIENT_PRESERVING ) != 0 ) != group.orientPreserving )
+		return false;
+
+	faceList[ group.first + group.numFaces++ ] = face;
+	info.group[ i ] = groupIndex;
+
+	int left  = info.neighbors[ i ];
+	int right = info.neighbors[ ( i + 2 ) % 3 ];
+	if( left >= 0 ) {
+		assignRecur( infos, triList, left, groups, groupIndex, faceList );
+	}
+	if( right >= 0 ) {
+		assignRecur( infos, triList, right, groups, groupIndex, faceList );
+	}
+
+	return true;
+}
+
+
+/*
+========================
+evalTSpace
+
+ the angle weighted tangent of some triangles around a vertex.
+========================
+*/
+static SVec3 evalTSpace( const int* faces, int numFaces, const STriInfo* infos,
+						 const int* triList, const SCorner* corners, int vertex )
+{
+	SVec3 sum = vec( 0,0,0 );
+
+	for( int k = 0 ; k < numFaces ; k++ )
+	{
+		int f = faces[ k ];
+		if( infos[ f ].flags & GROUP_WITH_ANY )
+			continue;
+
+		int i = cornerOfVertex( triList, f, vertex );
+		SVec3 n = cornerNormal( corners[ triList[ 3*f + i ] ] );
+		SVec3 vOs = vproject( infos[ f ].vOs, n );
+
+		SVec3 p0 = cornerPosition( corners[ triList[ 3*f + ( i + 2 ) % 3 ] ] );
+		SVec3 p1 = cornerPosition( corners[ triList[ 3*f + i ] ] );
+		SVec3 p2 = cornerPosition( corners[ triList[ 3*f + ( i + 1 ) % 3 ] ] );
+		SVec3 v1 = vproject( vsub( p0, p1 ), n );
+		SVec3 v2 = vproject( vsub( p2, p1 ), n );
+
+		float cosine = vdot( v1, v2 );
+		cosine = ( cosine > 1.0f ) ? 1.0f : ( ( cosine < -1.0f ) ? -1.0f : cosine );
+		float angle = (float)acos( cosine );
+
+		sum = vadd( sum, vscale( angle, vOs ) );
+	}
+
+	return vnotZero( sum ) ? vnormalize( sum ) : sum;
+}
+
+
+/*
+========================
+compareInts
+========================
+*/
+static int compareInts( const void* a, const void* b )
+{
+	return *(const int*)a - *(const int*)b;
+}
+
+
+/*
+========================
+genTangSpaceDefault
+========================
+*/
+tbool genTangSpaceDefault( const SMikkTSpaceContext* pContext )
+{
+	const SMikkTSpaceInterface* in = pContext->m_pInterface;
+	if( in == NULL || in->m_getNumFaces == NULL || in->m_getNumVerticesOfFace == NULL ||
+		in->m_getPosition == NULL || in->m_getNormal == NULL || in->m_getTexCoord == NULL ||
+		in->m_setTSpaceBasic == NULL )
+		return 0;
+
+	int numTriangles = in->m_getNumFaces( pContext );
+	for( int f = 0 ; f < numTriangles ; f++ ) {
+		if( in->m_getNumVerticesOfFace( pContext, f ) != 3 )
+			return 0;
+	}
+
+	int numCorners = 3 * numTriangles;
+	int f, i, g;
+
+	//
+	// corners, welded by their data
+	//
+	SCorner* corners = new SCorner[ numCorners ];
+	for( f = 0 ; f < numTriangles ; f++ ) {
+		for( i = 0 ; i < 3 ; i++ )
+		{
+			float* data = corners[ 3*f + i ].data;
+			in->m_getPosition( pContext, data + 0, f, i );
+			in->m_getNormal  ( pContext, data + 3, f, i );
+			in->m_getTexCoord( pContext, data + 6, f, i );
+		}
+	}
+
+	int* triList = new int[ numCorners ];
+	weldCorners( corners, numCorners, triList );
+
+	//
+	// triangles and their neighbors
+	//
+	STriInfo* infos = new STriInfo[ numTriangles ];
+	for( f = 0 ; f < numTriangles ; f++ ) {
+		initTriInfo( infos[ f ], corners, triList + 3*f );
+	}
+	buildNeighbors( infos, triList, numTriangles );
+
+	//
+	// groups around the vertices
+	//
+	SGroup* groups = new SGroup[ numCorners ];
+	int* faceList = new int[ numCorners ];
+	int numGroups = 0;
+	int numListed = 0;
+
+	for( f = 0 ; f < numTriangles ; f++ )
+	{
+		if( infos[ f ].flags & ( MARK_DEGENERATE | GROUP_WITH_ANY ) )
+			continue;
+
+		for( i = 0 ; i < 3 ; i++ )
+		{
+			if( infos[ f ].group[ i ] != -1 )
+				continue;
+
+			SGroup & group = groups[ numGroups ];
+			group.vertex = triList[ 3*f + i ];
+			group.orientPreserving = ( infos[ f ].flags & ORIENT_PRESERVING ) != 0;
+			group.first = numListed;
+			group.numFaces = 0;
+
+			assignRecur( infos, triList, f, groups, numGroups, faceList );
+			numListed += group.numFaces;
+			numGroups++;
+		}
+	}
+
+	//
+	// tangent of each corner
+	//
+	SVec3* tangents = new SVec3[ numCorners ];
+	float* signs	= new float[ numCorners ];
+	bool*  done		= new bool [ numCorners ];
+	for( i = 0 ; i < numCorners ; i++ )
+	{
+		tangents[ i ] = vec( 1,0,0 );
+		signs[ i ] = -1.0f;
+		done[ i ] = false;
+	}
+
+	int* members = new int[ numTriangles ];
+	float thresholdCos = (float)cos( 180.0 * 3.14159265358979323846 / 180.0 );
+
+	for( g = 0 ; g < numGroups ; g++ )
+	{
+		const SGroup & group = groups[ g ];
+		const int* faces = faceList + group.first;
+
+		for( int k = 0 ; k < group.numFaces ; k++ )
+		{
+			int fk = faces[ k ];
+			int ik = cornerOfVertex( triList, fk, group.vertex );
+			SVec3 n = cornerNormal( corners[ triList[ 3*fk + ik ] ] );
+			SVec3 os = vproject( infos[ fk ].vOs, n );
+			SVec3 ot = vproject( infos[ fk ].vOt, n );
+
+			// the triangles whose tangents are close to this one
+			int numMembers = 0;
+			for( int j = 0 ; j < group.numFaces ; j++ )
+			{
+				int fj = faces[ j ];
+				SVec3 os2 = vproject( infos[ fj ].vOs, n );
+				SVec3 ot2 = vproject( infos[ fj ].vOt, n );
+
+				bool any = ( ( infos[ fk ].flags | infos[ fj ].flags ) & GROUP_WITH_ANY ) != 0;
+				if( any || fk == fj || ( vdot( os, os2 ) > thresholdCos && vdot( ot, ot2 ) > thresholdCos ) ) {
+					members[ numMembers++ ] = fj;
+				}
+			}
+			qsort( members, numMembers, sizeof( int ), compareInts );
+
+			int c = 3*fk + ik;
+			tangents[ c ] = evalTSpace( members, numMembers, infos, triList, corners, group.vertex );
+			signs[ c ] = group.orientPreserving ? 1.0f : -1.0f;
+			done[ c ] = true;
+		}
+	}
+
+	//
+	// corners of degenerate triangles copy another corner of their vertex
+	//
+	for( f = 0 ; f < numTriangles ; f++ )
+	{
+		if( ( infos[ f ].flags & MARK_DEGENERATE ) == 0 )
+			continue;
+
+		for( i = 0 ; i < 3 ; i++ )
+		{
+			int c = 3*f + i;
+			for( int d = 0 ; d < numCorners ; d++ )
+			{
+				if( done[ d ] && triList[ d ] == triList[ c ] )
+				{
+					tangents[ c ] = tangents[ d ];
+					signs[ c ] = signs[ d ];
+					break;
+				}
+			}
+		}
+	}
+
+	for( f = 0 ; f < numTriangles ; f++ ) {
+		for( i = 0 ; i < 3 ; i++ )
+		{
+			const SVec3 & t = tangents[ 3*f + i ];
+			float tangent[ 3 ] = { t.x, t.y, t.z };
+			in->m_setTSpaceBasic( pContext, tangent, signs[ 3*f + i ], f, i );
+		}
+	}
+
+	delete [] members;
+	delete [] done;
+	delete [] signs;
+	delete [] tangents;
+	delete [] faceList;
+	delete [] groups;
+	delete [] infos;
+	delete [] triList;
+	delete [] corners;
+
+	return 1;
+}
@@ -0,0 +1,67 @@
+//=============================================================================
+/** @file		mikkreference.h
+ *
+ * Declares the interface of Morten S. Mikkelsen's mikktspace.c.
+ *
+ * mikkreference.cpp implements genTangSpaceDefault() as an independent
+ * port of the algorithm of mikktspace.c, so tangentcheck has a reference
+ * that shares no code with tangentspace.cpp. The declarations match the
+ * original mikktspace.h, building with CONFIG+=mikktspace uses the
+ * original mikktspace.c instead, see tangentcheck.pro.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#ifndef __MIKKREFERENCE_H_INCLUDED__
+#define __MIKKREFERENCE_H_INCLUDED__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int tbool;
+typedef struct SMikkTSpaceContext SMikkTSpaceContext;
+
+/** Callbacks, iFace is the face and iVert the corner of the face. */
+typedef struct
+{
+	int  ( *m_getNumFaces )( const SMikkTSpaceContext* pContext );
+	int  ( *m_getNumVerticesOfFace )( const SMikkTSpaceContext* pContext, const int iFace );
+	void ( *m_getPosition )( const SMikkTSpaceContext* pContext, float fvPosOut[], const int iFace, const int iVert );
+	void ( *m_getNormal )( const SMikkTSpaceContext* pContext, float fvNormOut[], const int iFace, const int iVert );
+	void ( *m_getTexCoord )( const SMikkTSpaceContext* pContext, float fvTexcOut[], const int iFace, const int iVert );
+
+	/** Receives the tangent of a corner, the bitangent is fSign * cross( normal, tangent ). */
+	void ( *m_setTSpaceBasic )( const SMikkTSpaceContext* pContext, const float fvTangent[], const float fSign, const int iFace, const int iVert );
+
+	/** Not used by the reference, may be NULL. */
+	void ( *m_setTSpace )( const SMikkTSpaceContext* pContext, const float fvTangent[], const float fvBiTangent[],
+						   const float fMagS, const float fMagT, const tbool bIsOrientationPreserving,
+						   const int iFace, const int iVert );
+} SMikkTSpaceInterface;
+
+struct SMikkTSpaceContext
+{
+	SMikkTSpaceInterface*	m_pInterface;
+	void*					m_pUserData;
+};
+
+/** Computes the tangent space of every corner.
+ * The reference supports triangles only.
+ * @return False if the interface is incomplete or a face is no triangle.
+ */
+tbool genTangSpaceDefault( const SMikkTSpaceContext* pContext );
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif	// __MIKKREFERENCE_H_INCLUDED__
@@ -0,0 +1,328 @@
+//=============================================================================
+/** @file		tangentcheck.cpp
+ *
+ * Standalone check of the tangent space generator.
+ *
+ * Loads an .OBJ file, runs splitTangentGroups() and computeTangentSpace()
+ * and compares the result of every triangle corner with the tangent space
+ * of genTangSpaceDefault(), see mikkreference.h.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#include <stdio.h>
+#include <math.h>
+#include <float.h>
+
+#include <QtCore/QFile>
+#include <QtCore/QTextStream>
+#include <QtCore/QStringList>
+#include <QtCore/QHash>
+#include <QtCore/QVector>
+
+#include "application.h"
+#include "tangentspace.h"
+
+#ifdef USE_MIKKTSPACE
+#include "mikktspace.h"
+#else
+#include "mikkreference.h"
+#endif
+
+
+// minimum cosine between the result and the reference
+#define MIN_COSINE	0.9999f
+
+
+/** A triangle mesh with welded corners. */
+class CMesh
+{
+public:
+	QVector< vec3_t >		positions;
+	QVector< vec3_t >		normals;
+	QVector< vec2_t >		texCoords;
+	QVector< unsigned int >	indices;	// 3 per triangle
+};
+
+
+/*
+========================
+loadObj
+
+ reads positions, normals, texcoords and faces, the faces are triangulated as fans.
+========================
+*/
+static bool loadObj( const QString & fileName, CMesh & mesh )
+{
+	QFile file( fileName );
+	if( !file.open( QIODevice::ReadOnly | QIODevice::Text ) )
+		return false;
+
+	QVector< vec3_t > v, vn;
+	QVector< vec2_t > vt;
+	QHash< QString, int > welded;
+
+	QTextStream stream( &file );
+	while( !stream.atEnd() )
+	{
+		QStringList tokens = stream.readLine().split( ' ', QString::SkipEmptyParts );
+		if( tokens.isEmpty() )
+			continue;
+
+		if( tokens[ 0 ] == "v" && tokens.size() >= 4 ) {
+			v.append( vec3_t( tokens[ 1 ].toFloat(), tokens[ 2 ].toFloat(), tokens[ 3 ].toFloat() ) );
+		} else if( tokens[ 0 ] == "vn" && tokens.size() >= 4 ) {
+			vn.append( vec3_t( tokens[ 1 ].toFloat(), tokens[ 2 ].toFloat(), tokens[ 3 ].toFloat() ).normalize() );
+		} else if( tokens[ 0 ] == "vt" && tokens.size() >= 3 ) {
+			vt.append( vec2_t( tokens[ 1 ].toFloat(), tokens[ 2 ].toFloat() ) );
+		} else if( tokens[ 0 ] == "f" )
+		{
+			QVector< unsigned int > face;
+			for( int i = 1 ; i < tokens.size() ; i++ )
+			{
+				QStringList idx = tokens[ i ].split( '/' );
+				if( idx.size() < 3 )
+					return false; // the check needs texcoords and normals
+
+				QHash< QString, int >::const_iterator it = welded.constFind( tokens[ i ] );
+				if( it != welded.constEnd() ) {
+					face.append( (unsigned int)it.value() );
+					continue;
+				}
+
+				int p = idx[ 0 ].toInt() - 1;
+				int t = idx[ 1 ].toInt() - 1;
+				int n = idx[ 2 ].toInt() - 1;
+				if( p < 0 || p >= v.size() || t < 0 || t >= vt.size() || n < 0 || n >= vn.size() )
+					return false;
+
+				welded.insert( tokens[ i ], mesh.positions.size() );
+				face.append( (unsigned int)mesh.positions.size() );
+				mesh.positions.append( v [ p ] );
+				mesh.normals  .append( vn[ n ] );
+				mesh.texCoords.append( vt[ t ] );
+			}
+
+			for( int i = 2 ; i < face.size() ; i++ )
+			{
+				mesh.indices.append( face[ 0 ] );
+				mesh.indices.append( face[ i-1 ] );
+				mesh.indices.append( face[ i ] );
+			}
+		}
+	}
+
+	return !mesh.indices.isEmpty();
+}
+
+
+/** A reference tangent space for every triangle corner. */
+class CReference
+{
+public:
+	const CMesh*		mesh;
+	QVector< vec3_t >	tangents;	// 3 per triangle
+	QVector< float >	signs;
+
+	// SMikkTSpaceInterface callbacks
+	static int getNumFaces( const SMikkTSpaceContext* context );
+	static int getNumVerticesOfFace( const SMikkTSpaceContext* context, const int face );
+	static void getPosition( const SMikkTSpaceContext* context, float out[], const int face, const int vert );
+	static void getNormal( const SMikkTSpaceContext* context, float out[], const int face, const int vert );
+	static void getTexCoord( const SMikkTSpaceContext* context, float out[], const int face, const int vert );
+	static void setTSpaceBasic( const SMikkTSpaceContext* context, const float tangent[], const float sign, const int face, const int vert );
+
+	static const CMesh & meshOf( const SMikkTSpaceContext* context ) {
+		return *( (CReference*)context->m_pUserData )->mesh;
+	}
+	static unsigned int vertexOf( const SMikkTSpaceContext* context, int face, int vert ) {
+		return meshOf( context ).indices[ 3*face + vert ];
+	}
+};
+
+
+/*
+========================
+CReference callbacks
+========================
+*/
+int CReference::getNumFaces( const SMikkTSpaceContext* context )
+{
+	return meshOf( context ).indices.size() / 3;
+}
+
+int CReference::getNumVerticesOfFace( const SMikkTSpaceContext*, const int )
+{
+	return 3;
+}
+
+void CReference::getPosition( const SMikkTSpaceContext* context, float out[], const int face, const int vert )
+{
+	const vec3_t & p = meshOf( context ).positions[ vertexOf( context, face, vert ) ];
+	out[ 0 ] = p.x; out[ 1 ] = p.y; out[ 2 ] = p.z;
+}
+
+void CReference::getNormal( const SMikkTSpaceContext* context, float out[], const int face, const int vert )
+{
+	const vec3_t & n = meshOf( context ).normals[ vertexOf( context, face, vert ) ];
+	out[ 0 ] = n.x; out[ 1 ] = n.y; out[ 2 ] = n.z;
+}
+
+void CReference::getTexCoord( const SMikkTSpaceContext* context, float out[], const int face, const int vert )
+{
+	const vec2_t & t = meshOf( context ).texCoords[ vertexOf( context, face, vert ) ];
+	out[ 0 ] = t.x; out[ 1 ] = t.y;
+}
+
+void CReference::setTSpaceBasic( const SMikkTSpaceContext* context, const float tangent[], const float sign, const int face, const int vert )
+{
+	CReference* reference = (CReference*)context->m_pUserData;
+	reference->tangents[ 3*face + vert ] = vec3_t( tangent[ 0 ], tangent[ 1 ], tangent[ 2 ] );
+	reference->signs   [ 3*face + vert ] = sign;
+}
+
+
+/*
+========================
+hasTextureArea
+
+ triangles without texture area get an arbitrary tangent space, they are not compared.
+========================
+*/
+static bool hasTextureArea( const CMesh & mesh, int triangle )
+{
+	const unsigned int* v = mesh.indices.constData() + 3 * triangle;
+	const vec2_t & t0 = mesh.texCoords[ v[ 0 ] ];
+	const vec2_t & t1 = mesh.texCoords[ v[ 1 ] ];
+	const vec2_t & t2 = mesh.texCoords[ v[ 2 ] ];
+
+	float det = ( t1.x - t0.x ) * ( t2.y - t0.y ) - ( t2.x - t0.x ) * ( t1.y - t0.y );
+	return fabs( det ) > FLT_MIN;
+}
+
+
+/*
+========================
+main
+========================
+*/
+int main( int argc, char* argv[] )
+{
+	QString fileName = ( argc > 1 ) ? QString( argv[ 1 ] ) : QString( "../../models/teapot.obj" );
+
+	CMesh mesh;
+	if( !loadObj( fileName, mesh ) ) {
+		fprintf( stderr, "failed to load '%s'\n", fileName.toLatin1().constData() );
+		return 2;
+	}
+
+	int numVertices  = mesh.positions.size();
+	int numTriangles = mesh.indices.size() / 3;
+	int i, k;
+
+	//
+	// reference
+	//
+	CReference reference;
+	reference.mesh = &mesh;
+	reference.tangents.resize( 3 * numTriangles );
+	reference.signs.resize( 3 * numTriangles );
+
+	SMikkTSpaceInterface callbacks;
+	callbacks.m_getNumFaces				= CReference::getNumFaces;
+	callbacks.m_getNumVerticesOfFace	= CReference::getNumVerticesOfFace;
+	callbacks.m_getPosition				= CReference::getPosition;
+	callbacks.m_getNormal				= CReference::getNormal;
+	callbacks.m_getTexCoord				= CReference::getTexCoord;
+	callbacks.m_setTSpaceBasic			= CReference::setTSpaceBasic;
+	callbacks.m_setTSpace				= NULL;
+
+	SMikkTSpaceContext context;
+	context.m_pInterface = &callbacks;
+	context.m_pUserData	 = &reference;
+
+	if( !genTangSpaceDefault( &context ) ) {
+		fprintf( stderr, "the reference failed\n" );
+		return 2;
+	}
+
+	//
+	// generator
+	//
+	vec3_t* positions = new vec3_t[ numVertices ];
+	vec3_t* normals   = new vec3_t[ numVertices ];
+	vec2_t* texCoords = new vec2_t[ numVertices ];
+	unsigned int* indices = new unsigned int[ 3 * numTriangles ];
+
+	for( i = 0 ; i < numVertices ; i++ )
+	{
+		positions[ i ] = mesh.positions[ i ];
+		normals  [ i ] = mesh.normals  [ i ];
+		texCoords[ i ] = mesh.texCoords[ i ];
+	}
+	for( i = 0 ; i < 3 * numTriangles ; i++ ) {
+		indices[ i ] = mesh.indices[ i ];
+	}
+
+	QVector< int > copies;
+	splitTangentGroups( numVertices, positions, texCoords, numTriangles, indices, copies );
+	appendSplitVertices( positions, numVertices, copies );
+	appendSplitVertices( normals,   numVertices, copies );
+	appendSplitVertices( texCoords, numVertices, copies );
+
+	int numSplit = numVertices + copies.size();
+	vec3_t* tangents   = new vec3_t[ numSplit ];
+	vec3_t* bitangents = new vec3_t[ numSplit ];
+	computeTangentSpace( numSplit, positions, normals, texCoords,
+						 numTriangles, indices, tangents, bitangents );
+
+	//
+	// compare every corner
+	//
+	int numCorners = 0;
+	int numFailed  = 0;
+	float minCosine = 1.0f;
+
+	for( i = 0 ; i < numTriangles ; i++ ) {
+		for( k = 0 ; k < 3 ; k++ )
+		{
+			if( !hasTextureArea( mesh, i ) )
+				continue;
+
+			const vec3_t & normal = mesh.normals[ mesh.indices[ 3*i + k ] ];
+			const vec3_t & refTangent = reference.tangents[ 3*i + k ];
+			vec3_t refBitangent = normal.crossProduct( refTangent ) * reference.signs[ 3*i + k ];
+
+			int split = (int)indices[ 3*i + k ];
+			float cosine = qMin( tangents[ split ].dotProduct( refTangent ),
+								 bitangents[ split ].dotProduct( refBitangent ) );
+
+			numCorners++;
+			minCosine = qMin( minCosine, cosine );
+			if( cosine < MIN_COSINE ) {
+				numFailed++;
+			}
+		}
+	}
+
+	printf( "%s: %d vertices, %d split, %d triangles\n",
+		fileName.toLatin1().constData(), numVertices, copies.size(), numTriangles );
+	printf( "%d of %d corners differ from the reference, minimum cosine %f\n",
+		numFailed, numCorners, minCosine );
+
+	SAFE_DELETE_ARRAY( bitangents );
+	SAFE_DELETE_ARRAY( tangents );
+	SAFE_DELETE_ARRAY( indices );
+	SAFE_DELETE_ARRAY( texCoords );
+	SAFE_DELETE_ARRAY( normals );
+	SAFE_DELETE_ARRAY( positions );
+
+	return ( numFailed == 0 ) ? 0 : 1;
+}
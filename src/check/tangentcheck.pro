@@ -0,0 +1,36 @@
+###############################################################################
+#
+# tangentcheck.pro - standalone check of the tangent space generator
+#
+# Compares computeTangentSpace() with the MikkTSpace algorithm on
+# models/teapot.obj. "make check" in src builds and runs it.
+#
+#    qmake tangentcheck.pro && make && ./tangentcheck ../../models/teapot.obj
+#
+# The reference is a port of mikktspace.c, see mikkreference.h. To compare
+# with the original, copy mikktspace.c and mikktspace.h into this directory
+# and run qmake CONFIG+=mikktspace.
+#
+
+
+CONFIG += qt console release warn_on
+CONFIG -= app_bundle
+QT += opengl
+
+TEMPLATE = app
+TARGET = tangentcheck
+
+OBJECTS_DIR = obj
+INCLUDEPATH += ..
+
+SOURCES += tangentcheck.cpp \
+           ../parallel.cpp \
+           ../tangentspace.cpp
+
+mikktspace {
+	DEFINES += USE_MIKKTSPACE
+	SOURCES += mikktspace.c
+} else {
+	HEADERS += mikkreference.h
+	SOURCES += mikkreference.cpp
+}
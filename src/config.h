@@ -53,10 +53,37 @@
 #define	CONFIG_TAB_SIZE				4			///< One tab quals that many spaces
 #define CONFIG_REFRESH_INTERVAL		10			///< 100 fps, periodic screen refesh in ms
 #define CONFIG_MAX_USED_TMUS		4			///< number of texture mapping units accessable by CTextureWidget
+#define CONFIG_DEFAULT_GRID_RESOLUTION	64		///< quads per side of the plane and cube test models
+#define CONFIG_MAX_GRID_RESOLUTION	1024		///< largest density, keeps the cube's vertex buffer near 450 MB, the buffer offsets are ints
+#define CONFIG_SLIDER_GRID_RESOLUTION	512		///< largest density selectable with the slider, the spin box allows more
+#define CONFIG_MODEL_CACHE_BUDGET	( 256 * 1024 * 1024 )	///< bytes of procedural model geometry kept for reuse
+#define CONFIG_MAX_INSTANCES		1000000		///< largest number of test model instances in the stress mode
+#define CONFIG_MAX_LOOP_INSTANCES	10000		///< instances drawn one by one if instancing is not available
+#define CONFIG_BENCHMARK_MAX_TRIANGLES	( 4 * 1024 * 1024 )	///< largest test model of the triangle throughput benchmark
+#define CONFIG_ANIMATED_MODEL_RINGS	256			///< rings of the animated test models, they are deformed every frame
+#define CONFIG_MAX_CAPTURE_BYTES	( 16 * 1024 * 1024 )	///< size of the transform feedback capture buffer
+#define CONFIG_MAX_CAPTURE_ROWS		10000		///< vertices shown in the capture table, the file contains all
+#define CONFIG_GEOMETRY_TUNING_DRAWS	8		///< draws per timing of the geometry shader output measurement
+#define CONFIG_PROGRAM_CACHE_DIRECTORY	"cache/programs/"	///< Where linked program binaries are stored
+#define CONFIG_SHADER_OBJECT_CACHE_SIZE	16		///< unused compiled shaders kept for reuse by the next link
+#define CONFIG_REMEMBERED_UNIFORM_LINKS	32		///< links a removed uniform keeps its value for
+#define CONFIG_MAX_SHADER_VARIANTS	64		///< permutations of the define sets that are built
+#define CONFIG_AUTO_COMPILE_DELAY	500		///< default ms without edits before the auto compile mode links
+#define CONFIG_BATCH_TIMEOUT		60		///< default seconds a stage set may take in the batch mode
 
 /** Commet this out to disable geometry shader support */
 #define CONFIG_ENABLE_GEOMETRY_SHADER
 
+/** Comment this out to disable the SSE code paths of the vertex deformation kernels and the tangent generator */
+#define CONFIG_ENABLE_SSE
+
+/** Comment this out to always compile the shaders, instead of reloading linked program binaries */
+#define CONFIG_ENABLE_PROGRAM_CACHE
+
+/** CONFIG_ENABLE_EGL is defined by the project files on Linux, together with linking libEGL.
+ *  The batch mode needs it for its offscreen context. Run qmake with CONFIG+=no_egl to build without it.
+ */
+
 /** Font size for the editor.
  *  10 is hard to read on linux.
  */
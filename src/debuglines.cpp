@@ -0,0 +1,385 @@
+//=============================================================================
+/** @file		debuglines.cpp
+ *
+ * Implements IDebugLines.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "application.h"
+#include "debuglines.h"
+
+
+//=============================================================================
+//	line program
+//=============================================================================
+
+// the start vertex of a line has a zero offset, the end vertex the line direction.
+static const char* const lineVertexShader =
+	"uniform float length;\n"
+	"attribute vec3 attrBase;\n"
+	"attribute vec3 attrOffset;\n"
+	"attribute vec4 attrColor;\n"
+	"void main( void )\n"
+	"{\n"
+	"	gl_FrontColor = attrColor;\n"
+	"	gl_Position = gl_ModelViewProjectionMatrix * vec4( attrBase + attrOffset * length, 1.0 );\n"
+	"}\n";
+
+// attribute locations, attrBase must use 0 to provoke vertex processing.
+enum lineAttribute_e
+{
+	LINE_ATTRIB_BASE	= 0,
+	LINE_ATTRIB_OFFSET	= 1,
+	LINE_ATTRIB_COLOR	= 2,
+};
+
+// shared by all line sets
+static GLuint	s_lineProgram = 0;
+static GLint	s_lineLengthLocation = -1;
+static int		s_lineProgramRefs = 0;
+static bool		s_lineProgramFailed = false;
+
+
+/*
+========================
+acquireLineProgram
+
+ creates the program on first use, returns 0 if it failed.
+========================
+*/
+static GLuint acquireLineProgram( void )
+{
+	if( s_lineProgram != 0 || s_lineProgramFailed )
+		return s_lineProgram;
+
+	GLuint shader = glCreateShader( GL_VERTEX_SHADER );
+	glShaderSource( shader, 1, &lineVertexShader, NULL );
+	glCompileShader( shader );
+
+	GLuint program = glCreateProgram();
+	glAttachShader( program, shader );
+	glBindAttribLocation( program, LINE_ATTRIB_BASE,   "attrBase" );
+	glBindAttribLocation( program, LINE_ATTRIB_OFFSET, "attrOffset" );
+	glBindAttribLocation( program, LINE_ATTRIB_COLOR,  "attrColor" );
+	glLinkProgram( program );
+
+	// the program keeps the shader alive
+	glDeleteShader( shader );
+
+	GLint status = GL_FALSE;
+	glGetProgramiv( program, GL_LINK_STATUS, &status );
+	if( status != GL_TRUE )
+	{
+		fprintf( stderr, "failed to build the debug line program, debug lines are disabled.\n" );
+		glDeleteProgram( program );
+		s_lineProgramFailed = true;
+		return 0;
+	}
+
+	s_lineProgram = program;
+	s_lineLengthLocation = glGetUniformLocation( program, "length" );
+	return s_lineProgram;
+}
+
+
+//=============================================================================
+//	CDebugLines
+//=============================================================================
+
+/** Implementation of IDebugLines.
+ * Each line is stored as two vertices, the index buffer for step > 1
+ * is built when the step changes.
+ */
+class CDebugLines : public IDebugLines
+{
+public:
+	CDebugLines( void );
+	virtual ~CDebugLines( void );
+
+	// IDebugLines interface
+	void	begin( int numLines, int linesPerGroup );
+	void	setLine( int index, const vec3_t & base, const vec3_t & direction, const vec3_t & color );
+	void	end( void );
+	void	render( float length, int step );
+	int		getNumLines( void ) { return m_numLines; }
+	size_t	getMemoryUsage( void );
+
+private:
+
+	/** Vertex buffer layout. */
+	struct lineVertex_t
+	{
+		vec3_t			base;
+		vec3_t			offset;
+		unsigned char	color[ 4 ];
+	};
+
+	// helpers
+	void	updateIndices( int step );
+
+	int				m_numLines;
+	int				m_linesPerGroup;
+	lineVertex_t*	m_vertices;		// [ 2 * m_numLines ], only between begin() and end()
+
+	GLuint			m_vbo;
+	GLuint			m_ibo;			// for step > 1
+	int				m_iboStep;		// step the index buffer was built for
+	int				m_numIndices;
+};
+
+
+// construction
+CDebugLines::CDebugLines( void )
+{
+	m_numLines = 0;
+	m_linesPerGroup = 1;
+	m_vertices = NULL;
+	m_vbo = 0;
+	m_ibo = 0;
+	m_iboStep = 0;
+	m_numIndices = 0;
+
+	s_lineProgramRefs++;
+}
+
+// destruction
+CDebugLines::~CDebugLines( void )
+{
+	SAFE_DELETE_ARRAY( m_vertices );
+
+	if( m_vbo != 0 ) {
+		glDeleteBuffers( 1, &m_vbo );
+	}
+	if( m_ibo != 0 ) {
+		glDeleteBuffers( 1, &m_ibo );
+	}
+
+	// the last one deletes the program
+	if( --s_lineProgramRefs == 0 && s_lineProgram != 0 )
+	{
+		glDeleteProgram( s_lineProgram );
+		s_lineProgram = 0;
+		s_lineLengthLocation = -1;
+	}
+}
+
+
+/*
+========================
+IDebugLines::create
+========================
+*/
+IDebugLines* IDebugLines::create( void )
+{
+	return new CDebugLines();
+}
+
+
+/*
+========================
+begin
+========================
+*/
+void CDebugLines::begin( int numLines, int linesPerGroup )
+{
+	SAFE_DELETE_ARRAY( m_vertices );
+
+	m_numLines = qMax( numLines, 0 );
+	m_linesPerGroup = qMax( linesPerGroup, 1 );
+	m_vertices = new lineVertex_t[ 2 * m_numLines ];
+
+	// invalidate the index buffer
+	m_iboStep = 0;
+}
+
+
+/*
+========================
+setLine
+========================
+*/
+void CDebugLines::setLine( int index, const vec3_t & base, const vec3_t & direction, const vec3_t & color )
+{
+	if( m_vertices == NULL || index < 0 || index >= m_numLines )
+		return;
+
+	unsigned char rgba[ 4 ] = {
+		(unsigned char)( qBound( 0.0f, color.x, 1.0f ) * 255.0f ),
+		(unsigned char)( qBound( 0.0f, color.y, 1.0f ) * 255.0f ),
+		(unsigned char)( qBound( 0.0f, color.z, 1.0f ) * 255.0f ), 255 };
+
+	lineVertex_t* v = m_vertices + 2 * index;
+	v[0].base = base;
+	v[0].offset = vec3_t( 0,0,0 );
+	v[1].base = base;
+	v[1].offset = direction;
+	memcpy( v[0].color, rgba, 4 );
+	memcpy( v[1].color, rgba, 4 );
+}
+
+
+/*
+========================
+end
+========================
+*/
+void CDebugLines::end( void )
+{
+	if( m_vertices == NULL )
+		return;
+
+	if( m_vbo == 0 ) {
+		glGenBuffers( 1, &m_vbo );
+	}
+
+	glBindBuffer( GL_ARRAY_BUFFER, m_vbo );
+	glBufferData( GL_ARRAY_BUFFER, 2 * m_numLines * sizeof(lineVertex_t), m_vertices, GL_STATIC_DRAW );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+	// the CPU copy is not needed anymore
+	SAFE_DELETE_ARRAY( m_vertices );
+}
+
+
+/*
+========================
+updateIndices
+
+ selects every step-th group of lines.
+========================
+*/
+void CDebugLines::updateIndices( int step )
+{
+	if( step == m_iboStep )
+		return;
+
+	int numGroups = ( m_numLines + m_linesPerGroup - 1 ) / m_linesPerGroup;
+	int numDrawn = ( numGroups + step - 1 ) / step;
+	unsigned int* indices = new unsigned int[ 2 * numDrawn * m_linesPerGroup ];
+
+	m_numIndices = 0;
+	for( int group = 0 ; group < numGroups ; group += step )
+	{
+		int first = group * m_linesPerGroup;
+		int last = qMin( first + m_linesPerGroup, m_numLines );
+
+		for( int line = first ; line < last ; line++ )
+		{
+			indices[ m_numIndices++ ] = 2 * line;
+			indices[ m_numIndices++ ] = 2 * line + 1;
+		}
+	}
+
+	if( m_ibo == 0 ) {
+		glGenBuffers( 1, &m_ibo );
+	}
+
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_ibo );
+	glBufferData( GL_ELEMENT_ARRAY_BUFFER, m_numIndices * sizeof(unsigned int), indices, GL_STATIC_DRAW );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+	SAFE_DELETE_ARRAY( indices );
+	m_iboStep = step;
+}
+
+
+/*
+========================
+render
+========================
+*/
+void CDebugLines::render( float length, int step )
+{
+	if( m_vbo == 0 || m_numLines == 0 )
+		return;
+
+	GLuint program = acquireLineProgram();
+	if( program == 0 )
+		return;
+
+	step = qMax( step, 1 );
+	if( step > 1 ) {
+		updateIndices( step );
+	}
+
+	glUseProgram( program );
+	glUniform1f( s_lineLengthLocation, length );
+
+	// setup arrays
+	glBindBuffer( GL_ARRAY_BUFFER, m_vbo );
+	glVertexAttribPointer( LINE_ATTRIB_BASE,   3, GL_FLOAT, GL_FALSE, sizeof(lineVertex_t), (const char*)NULL + 0 );
+	glVertexAttribPointer( LINE_ATTRIB_OFFSET, 3, GL_FLOAT, GL_FALSE, sizeof(lineVertex_t), (const char*)NULL + sizeof(vec3_t) );
+	glVertexAttribPointer( LINE_ATTRIB_COLOR,  4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(lineVertex_t), (const char*)NULL + 2 * sizeof(vec3_t) );
+	glEnableVertexAttribArray( LINE_ATTRIB_BASE );
+	glEnableVertexAttribArray( LINE_ATTRIB_OFFSET );
+	glEnableVertexAttribArray( LINE_ATTRIB_COLOR );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+	// draw
+	if( step > 1 )
+	{
+		glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_ibo );
+		glDrawElements( GL_LINES, m_numIndices, GL_UNSIGNED_INT, NULL );
+		glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+	}
+	else
+	{
+		glDrawArrays( GL_LINES, 0, 2 * m_numLines );
+	}
+
+	// restore state
+	glDisableVertexAttribArray( LINE_ATTRIB_BASE );
+	glDisableVertexAttribArray( LINE_ATTRIB_OFFSET );
+	glDisableVertexAttribArray( LINE_ATTRIB_COLOR );
+	glUseProgram( 0 );
+}
+
+
+/*
+========================
+getMemoryUsage
+========================
+*/
+size_t CDebugLines::getMemoryUsage( void )
+{
+	return 2 * m_numLines * sizeof(lineVertex_t) + m_numIndices * sizeof(unsigned int);
+}
+
+
+
+/*
+========================
+debugNormalColor
+========================
+*/
+vec3_t debugNormalColor( const vec3_t & normal )
+{
+	float x = fabs( normal.x );
+	float y = fabs( normal.y );
+	float z = fabs( normal.z );
+
+	// select max. component as color
+	if( x > y && x > z ) {
+		return vec3_t( 1,0,0 );
+	} else if( y > x && y > z ) {
+		return vec3_t( 0,1,0 );
+	} else if( z > x && z > y ) {
+		return vec3_t( 0,0,1 );
+	}
+
+	// two components equal
+	return vec3_t( 1,1,1 );
+}
+
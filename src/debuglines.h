@@ -0,0 +1,86 @@
+//=============================================================================
+/** @file		debuglines.h
+ *
+ * Defines a GPU-resident set of debug lines.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#ifndef __DEBUGLINES_H_INCLUDED__
+#define __DEBUGLINES_H_INCLUDED__
+
+#include <stddef.h>
+
+#include "vector.h"
+
+
+//=============================================================================
+//	IDebugLines
+//=============================================================================
+
+/** A set of colored lines, used to visualize normals and tangent space vectors.
+ * Every line starts at a base point and points into a direction. The lines
+ * are built once into a vertex buffer object. A small built-in program scales
+ * the directions when drawing, so the line length can be changed without
+ * rebuilding the buffer.
+ * \n\n
+ * Lines can be grouped, e.g. the three tangent space vectors of a vertex.
+ * The density only skips whole groups.
+ * \n\n
+ * All methods, including the destructor, require a valid OpenGL context.
+ */
+class IDebugLines
+{
+public:
+	/** Creates an empty IDebugLines object. */
+	static IDebugLines* create( void );
+	virtual ~IDebugLines( void ) {} ///< Destructor.
+
+	/** Starts to build a new set of lines, the old lines are discarded.
+	 * @param numLines Number of lines.
+	 * @param linesPerGroup Number of consecutive lines that belong together.
+	 */
+	virtual void begin( int numLines, int linesPerGroup = 1 ) = 0;
+
+	/** Sets a line, must be called between begin() and end().
+	 * @param index Line index, [ 0, numLines ).
+	 * @param base Start point of the line.
+	 * @param direction Direction and length of the line, scaled by render().
+	 * @param color Line color.
+	 */
+	virtual void setLine( int index, const vec3_t & base, const vec3_t & direction, const vec3_t & color ) = 0;
+
+	/** Uploads the lines into the vertex buffer object. */
+	virtual void end( void ) = 0;
+
+	/** Draws the lines.
+	 * The current program is replaced, no program is bound after this call.
+	 * @param length Scale factor for the line directions.
+	 * @param step Only every step-th group is drawn, 1 draws all lines.
+	 */
+	virtual void render( float length, int step = 1 ) = 0;
+
+	/** Returns the number of lines. */
+	virtual int getNumLines( void ) = 0;
+
+	/** Returns the size of the buffer objects in bytes. */
+	virtual size_t getMemoryUsage( void ) = 0;
+};
+
+
+/** Returns the color used to visualize a normal.
+ * The color is chosen from the largest component:
+ *  x == red, Y == green, Z == blue, white if two components are equal.
+ */
+vec3_t debugNormalColor( const vec3_t & normal );
+
+
+#endif	// __DEBUGLINES_H_INCLUDED__
+
@@ -0,0 +1,312 @@
+//=============================================================================
+/** @file		deform.cpp
+ *
+ * Implements the vertex skinning and morphing kernels.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#include <math.h>
+
+#include "config.h"
+#include "deform.h"
+#include "parallel.h"
+
+// SSE is part of every x86-64 target, 32 bit targets must enable it.
+#if defined( CONFIG_ENABLE_SSE ) && \
+	( defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 ) )
+#define DEFORM_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+
+// number of arrays in vertexFrame_t, the positions come first.
+#define NUM_FRAME_ARRAYS	4
+
+
+/*
+========================
+frameArray
+
+ accesses the arrays of a frame by index.
+========================
+*/
+static inline vec3_t* frameArray( const vertexFrame_t & frame, int array )
+{
+	switch( array )
+	{
+	case 0: return frame.positions;
+	case 1: return frame.normals;
+	case 2: return frame.tangents;
+	case 3: return frame.bitangents;
+	}
+
+	return NULL;
+}
+
+
+/*
+========================
+normalizeRange
+========================
+*/
+static void normalizeRange( vec3_t* v, int first, int last )
+{
+	for( int i = first ; i < last ; i++ ) {
+		v[ i ] = v[ i ].normalize();
+	}
+}
+
+
+//=============================================================================
+//	skinning
+//=============================================================================
+
+/** Skins a range of vertices, see skinVertices(). */
+class CSkinJob : public IParallelJob
+{
+public:
+	const skinWeights_t*	weights;
+	const float*			bones;		// column major 4x4 matrices
+	vec3_t*					src[ NUM_FRAME_ARRAYS ];
+	vec3_t*					dst[ NUM_FRAME_ARRAYS ];
+
+	void run( int first, int last );
+};
+
+
+/*
+========================
+CSkinJob::run
+========================
+*/
+void CSkinJob::run( int first, int last )
+{
+	for( int i = first ; i < last ; i++ )
+	{
+		const skinWeights_t & w = weights[ i ];
+
+#ifdef DEFORM_USE_SSE
+		// blend the matrix columns
+		__m128 c0 = _mm_setzero_ps();
+		__m128 c1 = _mm_setzero_ps();
+		__m128 c2 = _mm_setzero_ps();
+		__m128 c3 = _mm_setzero_ps();
+
+		for( int k = 0 ; k < 4 ; k++ )
+		{
+			if( w.weights[ k ] == 0.0f )
+				continue;
+
+			const float* m = bones + 16 * w.bones[ k ];
+			__m128 s = _mm_set1_ps( w.weights[ k ] );
+			c0 = _mm_add_ps( c0, _mm_mul_ps( s, _mm_loadu_ps( m + 0 ) ) );
+			c1 = _mm_add_ps( c1, _mm_mul_ps( s, _mm_loadu_ps( m + 4 ) ) );
+			c2 = _mm_add_ps( c2, _mm_mul_ps( s, _mm_loadu_ps( m + 8 ) ) );
+			c3 = _mm_add_ps( c3, _mm_mul_ps( s, _mm_loadu_ps( m + 12 ) ) );
+		}
+
+		for( int a = 0 ; a < NUM_FRAME_ARRAYS ; a++ )
+		{
+			if( src[ a ] == NULL || dst[ a ] == NULL )
+				continue;
+
+			const vec3_t & v = src[ a ][ i ];
+			__m128 r = _mm_add_ps( _mm_add_ps(
+						_mm_mul_ps( c0, _mm_set1_ps( v.x ) ),
+						_mm_mul_ps( c1, _mm_set1_ps( v.y ) ) ),
+						_mm_mul_ps( c2, _mm_set1_ps( v.z ) ) );
+
+			// only the positions are translated
+			if( a == 0 ) {
+				r = _mm_add_ps( r, c3 );
+			}
+
+			float out[ 4 ];
+			_mm_storeu_ps( out, r );
+			dst[ a ][ i ] = vec3_t( out[0], out[1], out[2] );
+		}
+#else
+		// blend the matrices
+		float m[ 16 ];
+		for( int j = 0 ; j < 16 ; j++ ) {
+			m[ j ] = 0.0f;
+		}
+
+		for( int k = 0 ; k < 4 ; k++ )
+		{
+			if( w.weights[ k ] == 0.0f )
+				continue;
+
+			const float* bone = bones + 16 * w.bones[ k ];
+			for( int j = 0 ; j < 16 ; j++ ) {
+				m[ j ] += w.weights[ k ] * bone[ j ];
+			}
+		}
+
+		for( int a = 0 ; a < NUM_FRAME_ARRAYS ; a++ )
+		{
+			if( src[ a ] == NULL || dst[ a ] == NULL )
+				continue;
+
+			const vec3_t & v = src[ a ][ i ];
+			float t = ( a == 0 ) ? 1.0f : 0.0f; // only the positions are translated
+
+			dst[ a ][ i ] = vec3_t(
+				m[0] * v.x + m[4] * v.y + m[ 8] * v.z + m[12] * t,
+				m[1] * v.x + m[5] * v.y + m[ 9] * v.z + m[13] * t,
+				m[2] * v.x + m[6] * v.y + m[10] * v.z + m[14] * t );
+		}
+#endif
+	}
+
+	// renormalize the directions
+	for( int a = 1 ; a < NUM_FRAME_ARRAYS ; a++ )
+	{
+		if( src[ a ] != NULL && dst[ a ] != NULL ) {
+			normalizeRange( dst[ a ], first, last );
+		}
+	}
+}
+
+
+/*
+========================
+skinVertices
+========================
+*/
+void skinVertices( int numVertices, const skinWeights_t* weights, const mat4_t* bones,
+				   const vertexFrame_t & bindPose, const vertexFrame_t & result )
+{
+	CSkinJob job;
+	job.weights	= weights;
+	job.bones	= bones->toConstFloatPointer();
+
+	for( int a = 0 ; a < NUM_FRAME_ARRAYS ; a++ )
+	{
+		job.src[ a ] = frameArray( bindPose, a );
+		job.dst[ a ] = frameArray( result, a );
+	}
+
+	parallelFor( numVertices, &job, 1024 );
+}
+
+
+//=============================================================================
+//	morphing
+//=============================================================================
+
+/** Blends a range of vertices, see morphVertices(). */
+class CMorphJob : public IParallelJob
+{
+public:
+	vertexFrame_t			base;
+	vertexFrame_t			result;
+	const vertexFrame_t*	deltas;
+	const float*			targetWeights;
+	int						numTargets;
+
+	void run( int first, int last );
+};
+
+
+/*
+========================
+CMorphJob::run
+
+ the arrays are blended as flat float arrays, three floats per vertex.
+========================
+*/
+void CMorphJob::run( int first, int last )
+{
+	for( int a = 0 ; a < NUM_FRAME_ARRAYS ; a++ )
+	{
+		const vec3_t* src = frameArray( base, a );
+		vec3_t* dst = frameArray( result, a );
+		if( src == NULL || dst == NULL )
+			continue;
+
+		const float* in = src->toFloatPointer() + 3 * first;
+		float* out = (float*)dst->toFloatPointer() + 3 * first;
+		int count = 3 * ( last - first );
+		int i = 0;
+
+#ifdef DEFORM_USE_SSE
+		// four floats at a time
+		for( ; i + 4 <= count ; i += 4 )
+		{
+			__m128 r = _mm_loadu_ps( in + i );
+
+			for( int t = 0 ; t < numTargets ; t++ )
+			{
+				const float* delta = frameArray( deltas[ t ], a )->toFloatPointer() + 3 * first;
+				r = _mm_add_ps( r, _mm_mul_ps( _mm_set1_ps( targetWeights[ t ] ), _mm_loadu_ps( delta + i ) ) );
+			}
+
+			_mm_storeu_ps( out + i, r );
+		}
+#endif
+
+		// the remaining floats
+		for( ; i < count ; i++ )
+		{
+			float r = in[ i ];
+
+			for( int t = 0 ; t < numTargets ; t++ )
+			{
+				const float* delta = frameArray( deltas[ t ], a )->toFloatPointer() + 3 * first;
+				r += targetWeights[ t ] * delta[ i ];
+			}
+
+			out[ i ] = r;
+		}
+
+		// renormalize the directions
+		if( a > 0 ) {
+			normalizeRange( dst, first, last );
+		}
+	}
+}
+
+
+/*
+========================
+morphVertices
+========================
+*/
+void morphVertices( int numVertices, const vertexFrame_t & base,
+					int numTargets, const vertexFrame_t* deltas, const float* targetWeights,
+					const vertexFrame_t & result )
+{
+	CMorphJob job;
+	job.base			= base;
+	job.result			= result;
+	job.deltas			= deltas;
+	job.targetWeights	= targetWeights;
+	job.numTargets		= numTargets;
+
+	parallelFor( numVertices, &job, 1024 );
+}
+
+
+/*
+========================
+isDeformSimdEnabled
+========================
+*/
+bool isDeformSimdEnabled( void )
+{
+#ifdef DEFORM_USE_SSE
+	return true;
+#else
+	return false;
+#endif
+}
+
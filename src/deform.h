@@ -0,0 +1,83 @@
+//=============================================================================
+/** @file		deform.h
+ *
+ * Defines the vertex skinning and morphing kernels.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#ifndef __DEFORM_H_INCLUDED__
+#define __DEFORM_H_INCLUDED__
+
+#include "vector.h"
+
+
+/** The deformed per-vertex arrays.
+ * The positions are transformed as points, the other arrays as directions,
+ * which are normalized after deformation. Arrays that are NULL are skipped.
+ */
+typedef struct vertexFrame_s {
+	vec3_t*	positions;
+	vec3_t*	normals;
+	vec3_t*	tangents;
+	vec3_t*	bitangents;
+} vertexFrame_t;
+
+/** Bone influences of a skinned vertex.
+ * Up to four bones, unused influences must have a zero weight.
+ * The weights of a vertex should sum up to one.
+ */
+typedef struct skinWeights_s {
+	unsigned short	bones[ 4 ];
+	float			weights[ 4 ];
+} skinWeights_t;
+
+
+/** Applies linear blend skinning.
+ * Each vertex is transformed by the weighted sum of its bone matrices.
+ * The bone matrices transform from the bind pose into the animated pose,
+ * directions are transformed by their upper 3x3 part, so the bones should
+ * not contain non-uniform scaling.
+ * \n\n
+ * The vertices are processed by several threads, see parallelFor(),
+ * and with SSE if CONFIG_ENABLE_SSE is defined and the target supports it.
+ *
+ * @param numVertices Number of vertices.
+ * @param weights Bone influences [ numVertices ].
+ * @param bones Bone matrices.
+ * @param bindPose Source arrays [ numVertices ].
+ * @param result Destination arrays [ numVertices ], an array is only
+ *        written if both the source and the destination are not NULL.
+ */
+void skinVertices( int numVertices, const skinWeights_t* weights, const mat4_t* bones,
+				   const vertexFrame_t & bindPose, const vertexFrame_t & result );
+
+/** Blends morph targets.
+ * result = base + sum( targetWeights[ i ] * deltas[ i ] ) for every array.
+ * Parallelization and SSE work like in skinVertices().
+ *
+ * @param numVertices Number of vertices.
+ * @param base Source arrays [ numVertices ].
+ * @param numTargets Number of morph targets.
+ * @param deltas Difference between each target and the base [ numTargets ].
+ *        An array must be present in all deltas if it is present in the base.
+ * @param targetWeights Blend weights [ numTargets ].
+ * @param result Destination arrays [ numVertices ], see skinVertices().
+ */
+void morphVertices( int numVertices, const vertexFrame_t & base,
+					int numTargets, const vertexFrame_t* deltas, const float* targetWeights,
+					const vertexFrame_t & result );
+
+/** Returns true if the kernels were compiled with SSE. */
+bool isDeformSimdEnabled( void );
+
+
+#endif	// __DEFORM_H_INCLUDED__
+
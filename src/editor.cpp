@@ -13,6 +13,9 @@
 
 =============================================================================*/
 
+#include <QtCore/QTimer>
+#include <QInputDialog>
+
 #include "application.h"
 #include "editor.h"
 #include "editwindow.h"
@@ -36,6 +39,14 @@ CEditor::CEditor( IShader* shader )
 		m_editWindows[ i ] = NULL;
 
 	m_isMDI = true;
+
+	// auto compile mode
+	m_autoCompile = false;
+	m_editToLink = -1;
+	m_autoCompileTimer = new QTimer( this );
+	m_autoCompileTimer->setSingleShot( true );
+	m_autoCompileTimer->setInterval( CONFIG_AUTO_COMPILE_DELAY );
+	connect( m_autoCompileTimer, SIGNAL(timeout()), this, SLOT(autoCompile()) );
 }
 
 CEditor::~CEditor( void )
@@ -297,6 +308,11 @@ void CEditor::setupSignals( void )
 			connect( m_editWindows[i], SIGNAL(aboutToQuit()),       this, SLOT(gotQuitSignal()) );
 			connect( m_editWindows[i], SIGNAL(requestMdiMode()),    this, SLOT(switchToMDI()) );
 			connect( m_editWindows[i], SIGNAL(requestSdiMode()),    this, SLOT(switchToSDI()) );
+			connect( m_editWindows[i], SIGNAL(sourceChanged()),     this, SLOT(sourceChanged()) );
+			connect( m_editWindows[i], SIGNAL(autoCompileToggled(bool)), this, SLOT(setAutoCompile(bool)) );
+			connect( m_editWindows[i], SIGNAL(requestAutoCompileDelay()), this, SLOT(selectAutoCompileDelay()) );
+
+			m_editWindows[i]->setAutoCompile( m_autoCompile );
 		}
 	}
 }
@@ -309,6 +325,21 @@ link
 */
 void CEditor::link( void )
 {
+	uploadAndLink( -1 );
+}
+
+
+/*
+========================
+uploadAndLink
+========================
+*/
+void CEditor::uploadAndLink( qint64 editToLink )
+{
+	// the sources are up to date now
+	m_autoCompileTimer->stop();
+	m_editToLink = editToLink;
+
 	// upload shader source code.
 	for( int i = 0 ; i < IShader::MAX_SHADER_TYPES ; i++ )
 	{
@@ -323,6 +354,96 @@ void CEditor::link( void )
 }
 
 
+/*
+========================
+sourceChanged
+
+ restarts the auto compile timer, so only the last change of a burst links.
+========================
+*/
+void CEditor::sourceChanged( void )
+{
+	if( !m_autoCompile )
+		return;
+
+	m_lastEdit.start();
+	m_autoCompileTimer->start();
+}
+
+
+/*
+========================
+autoCompile
+========================
+*/
+void CEditor::autoCompile( void )
+{
+	// a link that is still running is superseded by this one
+	uploadAndLink( m_lastEdit.elapsed() );
+}
+
+
+/*
+========================
+setAutoCompile
+========================
+*/
+void CEditor::setAutoCompile( bool enabled )
+{
+	m_autoCompile = enabled;
+	if( !enabled ) {
+		m_autoCompileTimer->stop();
+	}
+
+	// every window shows the mode
+	for( int i = 0 ; i < IShader::MAX_SHADER_TYPES ; i++ )
+	{
+		if( m_editWindows[ i ] != NULL ) {
+			m_editWindows[ i ]->setAutoCompile( enabled );
+		}
+	}
+}
+
+
+/*
+========================
+selectAutoCompileDelay
+========================
+*/
+void CEditor::selectAutoCompileDelay( void )
+{
+	bool ok = false;
+	int delay = QInputDialog::getInt( m_editWindows[ 0 ], tr( "Auto Compile" ),
+		tr( "Link after the sources were not changed for (ms):" ),
+		m_autoCompileTimer->interval(), 0, 10000, 50, &ok );
+
+	if( ok ) {
+		m_autoCompileTimer->setInterval( delay );
+	}
+}
+
+
+/*
+========================
+showLinkTime
+========================
+*/
+void CEditor::showLinkTime( int ms )
+{
+	QString text = QString( "Linked in %1 ms" ).arg( ms );
+	if( m_editToLink >= 0 ) {
+		text += QString( ", %1 ms after the last edit" ).arg( m_editToLink + ms );
+	}
+
+	for( int i = 0 ; i < IShader::MAX_SHADER_TYPES ; i++ )
+	{
+		if( m_editWindows[ i ] != NULL ) {
+			m_editWindows[ i ]->showLinkStatus( text );
+		}
+	}
+}
+
+
 /*
 ========================
 shouldDeactivateProgram
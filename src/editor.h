@@ -18,9 +18,11 @@
 
 #include <QtCore/QObject>
 #include <QtCore/QPoint>
+#include <QtCore/QElapsedTimer>
 
 
 // forward declarations
+class QTimer;
 class IShader;
 class CBaseEditWindow;
 
@@ -64,6 +66,18 @@ public:
 	 */
 	bool maybeSave( void );
 
+	/** Shows the time a link took in the status bars of the editor windows.
+	 * If the auto compile mode requested the link, the time since the
+	 * last edit is shown, too.
+	 * @param ms Milliseconds from the linkProgram() signal to the new program.
+	 */
+	void showLinkTime( int ms );
+
+	/** Returns true if the auto compile mode emitted the last
+	 * linkProgram() signal, false if the user requested it.
+	 */
+	bool isAutoCompiledLink( void ) { return m_editToLink >= 0; }
+
 signals:
 	/** The user requested to compile link the current shader.
 	 * @pre
@@ -88,6 +102,12 @@ private slots:;
 	void shouldDeactivateProgram( void );
 	void gotQuitSignal( void );
 
+	// auto compile mode
+	void sourceChanged( void );
+	void autoCompile( void );
+	void setAutoCompile( bool enabled );
+	void selectAutoCompileDelay( void );
+
 	// switching between SDI and MDI windows.
 	void switchToSDI( void );
 	void switchToMDI( void );
@@ -100,6 +120,9 @@ private:
 	void destroyEditWindow( void );
 	void setupSignals( void );
 
+	// uploads the sources and emits linkProgram()
+	void uploadAndLink( qint64 editToLink );
+
 	// the shader object
 	IShader* m_shader;
 
@@ -111,6 +134,13 @@ private:
 	// If the editor is in single-window mode, 
 	// then only m_editWindows[0] is used, the others are NULL.
 	CBaseEditWindow** m_editWindows; // [ IShader::MAX_SHADER_TYPES ]
+
+	// Links the program when no source was changed for its interval.
+	// Every change restarts it, so a burst of keystrokes causes a single link.
+	QTimer*			m_autoCompileTimer;
+	bool			m_autoCompile;
+	QElapsedTimer	m_lastEdit;
+	qint64			m_editToLink;	// ms from the last edit to the link, -1 if linked by the user
 };
 
 #endif // __EDITOR_H_INCLUDED__
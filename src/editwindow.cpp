@@ -22,6 +22,7 @@
 #include <QApplication>
 #include <QGridLayout>
 #include <QInputDialog>
+#include <QStatusBar>
 
 #include <QLabel>
 #include <QLineEdit>
@@ -190,6 +191,31 @@ contentsChanged
 void CBaseEditWindow::contentsChanged( void )
 {
 	updateWindowTitle();
+
+	emit sourceChanged();
+}
+
+
+/*
+========================
+setAutoCompile
+========================
+*/
+void CBaseEditWindow::setAutoCompile( bool enabled )
+{
+	// doesn't emit triggered()
+	m_actAutoCompile->setChecked( enabled );
+}
+
+
+/*
+========================
+showLinkStatus
+========================
+*/
+void CBaseEditWindow::showLinkStatus( const QString & text )
+{
+	statusBar()->showMessage( text );
 }
 
 
@@ -302,6 +328,14 @@ void CBaseEditWindow::createActions( IShader* )
 	m_actLink->setShortcut( tr( "F5" ) );
 	connect( m_actLink, SIGNAL(triggered()), this, SLOT(link()) );
 
+	m_actAutoCompile = new QAction( tr( "&Auto Compile" ), this );
+	m_actAutoCompile->setCheckable( true );
+	m_actAutoCompile->setStatusTip( tr( "Links the program when you stop typing" ) );
+	connect( m_actAutoCompile, SIGNAL(triggered(bool)), this, SIGNAL(autoCompileToggled(bool)) );
+
+	m_actAutoCompileDelay = new QAction( tr( "Auto Compile &Delay..." ), this );
+	connect( m_actAutoCompileDelay, SIGNAL(triggered()), this, SIGNAL(requestAutoCompileDelay()) );
+
 	//
 	// help
 	//
@@ -341,6 +375,9 @@ void CBaseEditWindow::createMenus( IShader* )
 	// shader
 	m_menuShader = menuBar()->addMenu( tr( "&Shader" ) );
 	m_menuShader->addAction( m_actLink );
+	m_menuShader->addSeparator();
+	m_menuShader->addAction( m_actAutoCompile );
+	m_menuShader->addAction( m_actAutoCompileDelay );
 
 	// view
 	m_menuView = menuBar()->addMenu( tr( "&View" ) );
@@ -450,7 +487,8 @@ void CSdiEditWindow::uploadShaderSource( IShader* shader )
 	if( m_attachToShader )
 	{
 		shader->setShaderSource( m_document->shaderType(), 
-								 m_document->document()->toPlainText() );
+								 m_document->document()->toPlainText(),
+								 m_document->fileName() );
 	}
 	else // disabled by the user
 	{
@@ -682,7 +720,8 @@ void CMdiEditWindow::uploadShaderSource( IShader* shader )
 
 		if( m_attachToShader[ i ] )
 		{
-			shader->setShaderSource( i, m_editors[ i ]->document()->toPlainText() );
+			shader->setShaderSource( i, m_editors[ i ]->document()->toPlainText(),
+									 m_editors[ i ]->fileName() );
 		}
 		else // user diabled this shader type
 		{
@@ -70,11 +70,32 @@ public:
 	 */
 	virtual void uploadShaderSource( IShader* shader ) = 0;
 
+	/** Shows the state of the auto compile mode in the 'Shader' menu.
+	 * @param enabled Wether the program is linked when the sources change.
+	 */
+	void setAutoCompile( bool enabled );
+
+	/** Shows a message about the last link in the status bar.
+	 */
+	void showLinkStatus( const QString & text );
+
 signals:;
 	/** The user requested to compile and link the current shader.
 	 */
 	void linkProgram( void );
 
+	/** The source code of a document changed.
+	 */
+	void sourceChanged( void );
+
+	/** The user switched the auto compile mode on or off.
+	 */
+	void autoCompileToggled( bool enabled );
+
+	/** The user wants to change the delay of the auto compile mode.
+	 */
+	void requestAutoCompileDelay( void );
+
 	/** The current shader should be deactivated.
 	 * This happens, when the user opens an existing or creates a new shader.
 	 */
@@ -176,6 +197,8 @@ private:
 	QAction* m_actCut;
 	QAction* m_actPaste;
 	QAction* m_actLink; // when the 'compile and link' button is pushed.
+	QAction* m_actAutoCompile;
+	QAction* m_actAutoCompileDelay;
 	QAction* m_actAbout;
 	QAction* m_actAboutQt;
 };
@@ -0,0 +1,237 @@
+//=============================================================================
+/** @file		feedback.cpp
+ *
+ * Implements FeedbackCapture.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#include <QtCore/QFile>
+#include <QtCore/QTextStream>
+
+#include "application.h"
+#include "feedback.h"
+#include "uniform.h"
+
+
+//=============================================================================
+//	FeedbackCapture
+//=============================================================================
+
+/*
+========================
+getTypeComponents
+========================
+*/
+int FeedbackCapture::getTypeComponents( int type )
+{
+	switch( type )
+	{
+	case GL_FLOAT:
+	case GL_INT:
+	case GL_UNSIGNED_INT:
+		return 1;
+
+	case GL_FLOAT_VEC2:
+	case GL_INT_VEC2:
+	case GL_UNSIGNED_INT_VEC2_EXT:
+		return 2;
+
+	case GL_FLOAT_VEC3:
+	case GL_INT_VEC3:
+	case GL_UNSIGNED_INT_VEC3_EXT:
+		return 3;
+
+	case GL_FLOAT_VEC4:
+	case GL_INT_VEC4:
+	case GL_UNSIGNED_INT_VEC4_EXT:
+	case GL_FLOAT_MAT2:
+		return 4;
+
+	case GL_FLOAT_MAT2x3:
+	case GL_FLOAT_MAT3x2:
+		return 6;
+
+	case GL_FLOAT_MAT2x4:
+	case GL_FLOAT_MAT4x2:
+		return 8;
+
+	case GL_FLOAT_MAT3:
+		return 9;
+
+	case GL_FLOAT_MAT3x4:
+	case GL_FLOAT_MAT4x3:
+		return 12;
+
+	case GL_FLOAT_MAT4:
+		return 16;
+	}
+
+	return 0;
+}
+
+
+/*
+========================
+isIntegerType
+========================
+*/
+bool FeedbackCapture::isIntegerType( int type )
+{
+	switch( type )
+	{
+	case GL_INT:
+	case GL_INT_VEC2:
+	case GL_INT_VEC3:
+	case GL_INT_VEC4:
+	case GL_UNSIGNED_INT:
+	case GL_UNSIGNED_INT_VEC2_EXT:
+	case GL_UNSIGNED_INT_VEC3_EXT:
+	case GL_UNSIGNED_INT_VEC4_EXT:
+		return true;
+	}
+
+	return false;
+}
+
+
+/*
+========================
+getNumComponents
+========================
+*/
+int FeedbackCapture::getNumComponents( int varying ) const
+{
+	if( varying < 0 || varying >= types.size() )
+		return 0;
+
+	return getTypeComponents( types[ varying ] ) * sizes[ varying ];
+}
+
+
+/*
+========================
+getVertexSize
+========================
+*/
+int FeedbackCapture::getVertexSize( void ) const
+{
+	int size = 0;
+	for( int i = 0 ; i < types.size() ; i++ ) {
+		size += getNumComponents( i ) * 4;
+	}
+
+	return size;
+}
+
+
+/*
+========================
+getNumVertices
+========================
+*/
+int FeedbackCapture::getNumVertices( void ) const
+{
+	int size = getVertexSize();
+	return ( size > 0 ) ? data.size() / size : 0;
+}
+
+
+/*
+========================
+getVerticesPerPrimitive
+========================
+*/
+int FeedbackCapture::getVerticesPerPrimitive( void ) const
+{
+	switch( primitiveType )
+	{
+	case GL_LINES:		return 2;
+	case GL_TRIANGLES:	return 3;
+	}
+
+	return 1;
+}
+
+
+/*
+========================
+getValueText
+========================
+*/
+QString FeedbackCapture::getValueText( int vertex, int varying ) const
+{
+	if( vertex < 0 || vertex >= getNumVertices() || varying < 0 || varying >= types.size() )
+		return QString();
+
+	// find the varying inside the vertex
+	int offset = vertex * getVertexSize();
+	for( int i = 0 ; i < varying ; i++ ) {
+		offset += getNumComponents( i ) * 4;
+	}
+
+	const char* p = data.constData() + offset;
+	bool isInteger = isIntegerType( types[ varying ] );
+	int n = getNumComponents( varying );
+
+	QString text;
+	for( int i = 0 ; i < n ; i++ )
+	{
+		if( i > 0 ) {
+			text += ' ';
+		}
+
+		if( isInteger ) {
+			text += QString::number( ((const GLint*)p)[ i ] );
+		} else {
+			text += QString::number( ((const GLfloat*)p)[ i ], 'g', 6 );
+		}
+	}
+
+	return text;
+}
+
+
+/*
+========================
+writeText
+========================
+*/
+bool FeedbackCapture::writeText( const QString & fileName ) const
+{
+	QFile file( fileName );
+	if( !file.open( QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text ) )
+		return false;
+
+	QTextStream out( &file );
+
+	out << "# transform feedback capture\n";
+	out << "# primitives: " << primitivesWritten << " written, " << primitivesGenerated << " generated\n";
+	out << "# vertices per primitive: " << getVerticesPerPrimitive() << "\n";
+	out << "# varyings:";
+	for( int i = 0 ; i < varyings.size() ; i++ ) {
+		out << " " << varyings[ i ] << " (" << CUniform::getTypeNameString( types[ i ] ) << ")";
+	}
+	out << "\n";
+
+	// one vertex per line, the varyings are separated by tabs
+	int numVertices = getNumVertices();
+	for( int v = 0 ; v < numVertices ; v++ )
+	{
+		for( int i = 0 ; i < varyings.size() ; i++ ) {
+			out << ( i > 0 ? "\t" : "" ) << getValueText( v, i );
+		}
+		out << "\n";
+	}
+
+	out.flush();
+	return file.error() == QFile::NoError;
+}
+
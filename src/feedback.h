@@ -0,0 +1,85 @@
+//=============================================================================
+/** @file		feedback.h
+ *
+ * Defines the result of a transform feedback capture.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#ifndef __FEEDBACK_H_INCLUDED__
+#define __FEEDBACK_H_INCLUDED__
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+#include <QtCore/QByteArray>
+
+
+//=============================================================================
+//	FeedbackCapture
+//=============================================================================
+
+/** The vertices emitted by the last shader stage before rasterization,
+ * recorded with transform feedback during a single frame.
+ * See IShader::beginCapture() and IScene::requestCapture().
+ * \n\n
+ * The vertices are stored interleaved, in the order of the varyings.
+ * Every varying is made of 32 bit floats or integers, depending on its type.
+ * The capture buffer has a fixed size, if the program emits more primitives
+ * than fit into it, the remaining primitives are counted but not recorded.
+ */
+class FeedbackCapture
+{
+public:
+	FeedbackCapture( void ) : primitiveType( 0 ), primitivesGenerated( 0 ), primitivesWritten( 0 ) {}
+
+	QStringList		varyings;				///< names of the recorded varyings
+	QVector< int >	types;					///< GL type of each varying, e.g. GL_FLOAT_VEC4
+	QVector< int >	sizes;					///< array size of each varying, 1 for non-arrays
+	int				primitiveType;			///< GL_POINTS, GL_LINES or GL_TRIANGLES
+	int				primitivesGenerated;	///< primitives emitted by the program
+	int				primitivesWritten;		///< primitives stored in data
+	QByteArray		data;					///< interleaved vertices
+	QString			error;					///< empty if the capture succeeded
+
+	/** Returns true if the capture buffer was too small for all primitives. */
+	bool isTruncated( void ) const { return primitivesWritten < primitivesGenerated; }
+
+	/** Returns the number of 32 bit components of a varying, including array elements. */
+	int getNumComponents( int varying ) const;
+
+	/** Returns the size of a single vertex in bytes. */
+	int getVertexSize( void ) const;
+
+	/** Returns the number of recorded vertices. */
+	int getNumVertices( void ) const;
+
+	/** Returns the number of vertices of each primitive, 1, 2 or 3. */
+	int getVerticesPerPrimitive( void ) const;
+
+	/** Formats the value of a varying, the components are separated by spaces. */
+	QString getValueText( int vertex, int varying ) const;
+
+	/** Writes the vertices as text, one vertex per line.
+	 * The header lines start with '#' and list the counts and the varyings.
+	 * @return False if the file could not be written.
+	 */
+	bool writeText( const QString & fileName ) const;
+
+	/** Returns the number of 32 bit components of a GL type, 0 for unknown types. */
+	static int getTypeComponents( int type );
+
+	/** Returns true if the GL type is made of integers. */
+	static bool isIntegerType( int type );
+};
+
+
+#endif	// __FEEDBACK_H_INCLUDED__
+
@@ -16,6 +16,10 @@
 #include "application.h"
 #include "model.h"
 #include "vertexstream.h"
+#include "parallel.h"
+#include "glextra.h"
+#include "tangentspace.h"
+#include "deform.h"
 
 //=============================================================================
 //	IModel implementation
@@ -69,60 +73,64 @@ public:
 	QString getName( void ) { return m_name; }
 	int     getPrimitiveType( void ) { return m_primitiveType; }
 	QString getPrimitiveTypeName( void );
+	int		getNumPrimitives( void );
 	float   getBoundingRadius( void ) { return m_boundingRadius; }
 	void	getBoundingBox( vec3_t & mins, vec3_t & maxs ) { mins = m_mins; maxs = m_maxs; }
+	size_t	getMemoryUsage( void ) { return ( m_vertices != NULL ) ? m_vertices->getMemoryUsage() : 0; }
+	bool	animate( float ) { return false; }
+	int		getUploadedBytes( void ) { return ( m_vertices != NULL ) ? m_vertices->getUploadedBytes() : 0; }
 
 	void    render( const VertexAttribLocations* attribs, const vec4_t * overrideColor );
-	void    renderNormals( void );
-	void	renderTangents( void );
-
-	/** Builds a tesseleted plane.
-	 * This function recursively builds a plane of triangle pairs.
-	 * In fact, the plane is a quad.
-	 * Each recursion level splits the quad into four sub-qurads,
-	 * the upper-left, upper-right, lower-left and lower-right quads.
-	 * These quads are created by calling the buildPlane functions
-	 * with level-1. The base level is 1.
+	bool    renderInstanced( const VertexAttribLocations* attribs, int numInstances );
+	void    renderNormals( float lengthScale, int step );
+	void	renderTangents( float lengthScale, int step );
+
+	/** Builds a tesselated, indexed plane.
+	 * The plane is a quad, split into numQuadsX * numQuadsY sub-quads.
+	 * Neighboring sub-quads share their vertices, so the grid stores
+	 * ( numQuadsX + 1 ) * ( numQuadsY + 1 ) vertices and two triangles,
+	 * which are 6 indices, per sub-quad.
+	 * The rows of the grid are generated in parallel and written directly
+	 * into the stream, including the tangent space vectors, so there is
+	 * no need to call IVertexStream::coumputeTangentVectors() afterwards.
 	 * \n\n
-	 * The parameters v,n,t and c point to arrays of n elements, where
-	 * n = 6 * 4^level. This means every quad is created by two triangles,
-	 * which require 6 vertices. Because the quads are split each level,
-	 * the number of quads increases by factor 4 at each level. This results
-	 * in 4^level. The caller of this function must make sure that enough
-	 * space is allocated to hold the triangles for the requested recursion level.
-	 * \n\n
-	 * The parameters holds the vetex normal that is assigned to every
-	 * vertex this function produces.
+	 * The grid is stored at firstVertex and firstIndex inside the stream.
+	 * The caller of this function must make sure that enough space is
+	 * allocated, see gridVertexCount() and gridIndexCount().
 	 * \n\n
 	 * The parameters mainVertices, mainTexCoords and mainColors point to
 	 * arrays with four element wich hold the vertex attributes for the
 	 * lower-left, lower-right, uppler-left, upper-right corner of the quad,
-	 * in that order. Thses values are linear interpolated when goint into recursion.
+	 * in that order. Thses values are bilinear interpolated across the grid.
 	 *
-	 * @param v Vertex position array.
-	 * @param n Normal array.
-	 * @param t TexCoord array.
-	 * @param c Color array.
+	 * @param stream Vertex stream to write to.
+	 * @param firstVertex Stream index of the first grid vertex.
+	 * @param firstIndex Position of the first grid index in the index array.
 	 * @param mainVertices Input position.
 	 * @param normal Surface normal.
 	 * @param mainTexCoords Input texture coordinates.
 	 * @param mainColors Input colors.
-	 * @param level Recursion level, must be >= 1.
+	 * @param numQuadsX Number of sub-quads from left to right, must be >= 1.
+	 * @param numQuadsY Number of sub-quads from bottom to top, must be >= 1.
 	 */
-	static void buildPlane( vec3_t* v, vec3_t* n, vec2_t* t, vec4_t* c,
-							const vec3_t* mainVertices, const vec3_t & normal,
-							const vec2_t* mainTexCoords, const vec4_t* mainColors,
-							int level );
+	static void buildGrid( IVertexStream* stream, int firstVertex, int firstIndex,
+						   const vec3_t* mainVertices, const vec3_t & normal,
+						   const vec2_t* mainTexCoords, const vec4_t* mainColors,
+						   int numQuadsX, int numQuadsY );
+
+	/** Helper methods for buildGrid.
+	 * They calculate the amount of vertices and indices in a grid.
+	 * @see buildGrid.
+	 */
+	static int gridVertexCount( int numQuadsX, int numQuadsY ) { return ( numQuadsX + 1 ) * ( numQuadsY + 1 ); }
+	static int gridIndexCount ( int numQuadsX, int numQuadsY ) { return 6 * numQuadsX * numQuadsY; }
 
-	/** Helper method for buildPlane.
-	 * It calculates the amount of vertices in a plane for a recusion level.
-	 * @param level Recusion level.
-	 * @return Vertex count for that level.
-	 * @see buildPlane.
+	/** Builds the vertex stream of a sphere, see IModel::createSphere().
+	 * The normals are the unit directions from the center to the vertices.
 	 */
-	static int vertexCountForPlaneLevel( int level );
+	static IVertexStream* buildSphere( int numRings, int numSegments, float radius );
 
-private:
+protected:
 
 	QString			m_name;
 	int				m_primitiveType;
@@ -171,16 +179,31 @@ void CBaseModel::render( const VertexAttribLocations * attribs, const vec4_t * o
 }
 
 
+/*
+========================
+renderInstanced
+========================
+*/
+bool CBaseModel::renderInstanced( const VertexAttribLocations * attribs, int numInstances )
+{
+	if( m_vertices == NULL || !smglIsInstancingAvailable() )
+		return false;
+
+	m_vertices->render( m_primitiveType, NULL, attribs, numInstances );
+	return true;
+}
+
+
 /*
 ========================
 renderNormals
 ========================
 */
-void CBaseModel::renderNormals( void )
+void CBaseModel::renderNormals( float lengthScale, int step )
 {
 	if( m_vertices != NULL )
 	{
-		m_vertices->renderNormals();
+		m_vertices->renderNormals( lengthScale, step );
 	}
 }
 
@@ -190,11 +213,11 @@ void CBaseModel::renderNormals( void )
 renderTangents
 ========================
 */
-void CBaseModel::renderTangents( void )
+void CBaseModel::renderTangents( float lengthScale, int step )
 {
 	if( m_vertices != NULL )
 	{
-		m_vertices->renderTangentVectors();
+		m_vertices->renderTangentVectors( lengthScale, step );
 	}
 }
 
@@ -212,165 +235,183 @@ QString CBaseModel::getPrimitiveTypeName( void )
 
 /*
 ========================
-vertexCountForPlaneLevel
-
- see buildPlane()
+getNumPrimitives
 ========================
 */
-int CBaseModel::vertexCountForPlaneLevel( int level )
+int CBaseModel::getNumPrimitives( void )
 {
-	int count = 1;
+	if( m_vertices == NULL )
+		return 0;
+
+	int count = m_vertices->getNumIndices();
+	if( count == 0 ) {
+		count = m_vertices->getNumVertices();
+	}
 
-	for( int i = 1 ; i < level ; i++ )
+	switch( m_primitiveType )
 	{
-		count = count * 4;
+	case GL_LINES:					return count / 2;
+	case GL_LINE_STRIP:				return qMax( count - 1, 0 );
+	case GL_LINE_STRIP_ADJACENCY:	return qMax( count - 3, 0 );
+	case GL_TRIANGLES:				return count / 3;
+	case GL_TRIANGLE_STRIP:
+	case GL_TRIANGLE_FAN:			return qMax( count - 2, 0 );
 	}
 
-	return 6 * count;
+	return count;
 }
 
 
+//=============================================================================
+//	CGridJob
+//=============================================================================
+
+/** Generates the rows of a grid, see CBaseModel::buildGrid().
+ * Each call to run() writes the vertices of some rows and the indices
+ * of the sub-quads above them, so different calls never write to the
+ * same memory.
+ */
+class CGridJob : public IParallelJob
+{
+public:
+	vec3_t*			v;
+	vec3_t*			n;
+	vec2_t*			t;
+	vec4_t*			c;
+	vec3_t*			tan1;
+	vec3_t*			tan2;
+	unsigned int*	indices;
+	int				baseVertex;
+
+	const vec3_t*	mainVertices;
+	const vec2_t*	mainTexCoords;
+	const vec4_t*	mainColors;
+	vec3_t			normal;
+	vec3_t			tangent;
+	vec3_t			bitangent;
+	int				numQuadsX;
+	int				numQuadsY;
+
+	void run( int first, int last );
+};
+
+
 /*
 ========================
-buildPlane
+CGridJob::run
 
- Recursively builds a plane.
- v,n,t,c will hold the result and must be allocated by the caller.
- level controls how often the plane is split along both axis.
- level must be >= 1.
- The data order is (-1,-1), (+1,-1), (-1,+1), (+1,+1) both in input
- and output buffers, where -1 represents the minimum and +1 the maximum.
- It uses two triangles for each rectangle.
- The buffer size in components is 6 * NumOfRects(level) = 6 * 4 ^ ( level - 1 ).
+ builds the vertex rows [first, last).
+ The indices of a row connect it with the next row, the last row has none.
 ========================
 */
-void CBaseModel::buildPlane( vec3_t* v, vec3_t* n, vec2_t*t, vec4_t* c,
-							 const vec3_t* mainVertices, const vec3_t & normal,
-							 const vec2_t* mainTexCoords, const vec4_t* mainColors,
-							 int level )
-{
-	//
-	// recursion case
-	//
-	if( level > 1 )
-	{
-		// temp buffers for interpolation
-		vec3_t tmpV[ 4 ];
-		vec2_t tmpT[ 4 ];
-		vec4_t tmpC[ 4 ];
-		int skip = 0;
-		int skipIncrement = vertexCountForPlaneLevel( level - 1 );
-
-		//
-		// (-1,-1) rectangle
-		//
-		tmpV[0] =   mainVertices[0];
-		tmpV[1] = ( mainVertices[1] + mainVertices[0] ) * 0.5f;
-		tmpV[2] = ( mainVertices[2] + mainVertices[0] ) * 0.5f;
-		tmpV[3] = ( mainVertices[3] + mainVertices[0] ) * 0.5f;
-		tmpT[0] =   mainTexCoords[0];
-		tmpT[1] = ( mainTexCoords[1] + mainTexCoords[0] ) * 0.5f;
-		tmpT[2] = ( mainTexCoords[2] + mainTexCoords[0] ) * 0.5f;
-		tmpT[3] = ( mainTexCoords[3] + mainTexCoords[0] ) * 0.5f;
-		tmpC[0] =   mainColors[0];
-		tmpC[1] = ( mainColors[1] + mainColors[0] ) * 0.5f;
-		tmpC[2] = ( mainColors[2] + mainColors[0] ) * 0.5f;
-		tmpC[3] = ( mainColors[3] + mainColors[0] ) * 0.5f;
-
-		// recursion step
-		buildPlane( v,n,t,c, tmpV, normal, tmpT, tmpC, level-1 );
-
-		//
-		// (+1,-1) rectangle
-		//
-		tmpV[0] = ( mainVertices[1] + mainVertices[0] ) * 0.5f;
-		tmpV[1] =   mainVertices[1];
-		tmpV[2] = ( mainVertices[3] + mainVertices[0] ) * 0.5f;
-		tmpV[3] = ( mainVertices[3] + mainVertices[1] ) * 0.5f;
-		tmpT[0] = ( mainTexCoords[1] + mainTexCoords[0] ) * 0.5f;
-		tmpT[1] =   mainTexCoords[1];
-		tmpT[2] = ( mainTexCoords[3] + mainTexCoords[0] ) * 0.5f;
-		tmpT[3] = ( mainTexCoords[3] + mainTexCoords[1] ) * 0.5f;
-		tmpC[0] = ( mainColors[1] + mainColors[0] ) * 0.5f;
-		tmpC[1] =   mainColors[1];
-		tmpC[2] = ( mainColors[3] + mainColors[0] ) * 0.5f;
-		tmpC[3] = ( mainColors[3] + mainColors[1] ) * 0.5f;
-
-		// recursion step
-		skip += skipIncrement;
-		buildPlane( v+skip, n+skip, t+skip, c+skip, tmpV, normal, tmpT, tmpC, level - 1 );
-
-		//
-		// (-1,+1) rectangle
-		//
-		tmpV[0] = ( mainVertices[2] + mainVertices[0] ) * 0.5f;
-		tmpV[1] = ( mainVertices[3] + mainVertices[0] ) * 0.5f;
-		tmpV[2] =   mainVertices[2];
-		tmpV[3] = ( mainVertices[3] + mainVertices[2] ) * 0.5f;
-		tmpT[0] = ( mainTexCoords[2] + mainTexCoords[0] ) * 0.5f;
-		tmpT[1] = ( mainTexCoords[3] + mainTexCoords[0] ) * 0.5f;
-		tmpT[2] =   mainTexCoords[2];
-		tmpT[3] = ( mainTexCoords[3] + mainTexCoords[2] ) * 0.5f;
-		tmpC[0] = ( mainColors[2] + mainColors[0] ) * 0.5f;
-		tmpC[1] = ( mainColors[3] + mainColors[0] ) * 0.5f;
-		tmpC[2] =   mainColors[2];
-		tmpC[3] = ( mainColors[3] + mainColors[2] ) * 0.5f;
-
-		// recursion step
-		skip += skipIncrement;
-		buildPlane( v+skip, n+skip, t+skip, c+skip, tmpV, normal, tmpT, tmpC, level - 1 );
-
-		//
-		// (+1,+1) rectangle
-		//
-		tmpV[0] = ( mainVertices[3] + mainVertices[0] ) * 0.5f;
-		tmpV[1] = ( mainVertices[3] + mainVertices[1] ) * 0.5f;
-		tmpV[2] = ( mainVertices[3] + mainVertices[2] ) * 0.5f;
-		tmpV[3] =   mainVertices[3];
-		tmpT[0] = ( mainTexCoords[3] + mainTexCoords[0] ) * 0.5f;
-		tmpT[1] = ( mainTexCoords[3] + mainTexCoords[1] ) * 0.5f;
-		tmpT[2] = ( mainTexCoords[3] + mainTexCoords[2] ) * 0.5f;
-		tmpT[3] =   mainTexCoords[3];
-		tmpC[0] = ( mainColors[3] + mainColors[0] ) * 0.5f;
-		tmpC[1] = ( mainColors[3] + mainColors[1] ) * 0.5f;
-		tmpC[2] = ( mainColors[3] + mainColors[2] ) * 0.5f;
-		tmpC[3] =   mainColors[3];
-
-		skip += skipIncrement;
-		buildPlane( v+skip, n+skip, t+skip, c+skip, tmpV, normal, tmpT, tmpC, level - 1 );
-	}
-
+void CGridJob::run( int first, int last )
+{
+	int rowLength = numQuadsX + 1;
 
-	//
-	// base case.
-	//
-	else if( level == 1 )
+	for( int y = first ; y < last ; y++ )
 	{
-		// maps input to output:
-		//  out[ i ] = in[ map[ i ] ]
-		static const int map[ 6 ] =
+		float fy = float( y ) / float( numQuadsY );
+
+		// left and right end of this row
+		vec3_t v0 = mainVertices [0] + ( mainVertices [2] - mainVertices [0] ) * fy;
+		vec3_t v1 = mainVertices [1] + ( mainVertices [3] - mainVertices [1] ) * fy;
+		vec2_t t0 = mainTexCoords[0] + ( mainTexCoords[2] - mainTexCoords[0] ) * fy;
+		vec2_t t1 = mainTexCoords[1] + ( mainTexCoords[3] - mainTexCoords[1] ) * fy;
+		vec4_t c0 = mainColors   [0] * ( 1.0f - fy ) + mainColors[2] * fy;
+		vec4_t c1 = mainColors   [1] * ( 1.0f - fy ) + mainColors[3] * fy;
+
+		// vertices, bilinear interpolation of the corners
+		for( int x = 0 ; x <= numQuadsX ; x++ )
 		{
-			0, 1, 2, // first triangle
-			3, 2, 1, // second triangle
-		};
+			float fx = float( x ) / float( numQuadsX );
+			int k = y * rowLength + x;
+
+			v   [ k ] = v0 + ( v1 - v0 ) * fx;
+			n   [ k ] = normal;
+			t   [ k ] = t0 + ( t1 - t0 ) * fx;
+			c   [ k ] = c0 * ( 1.0f - fx ) + c1 * fx;
+			tan1[ k ] = tangent;
+			tan2[ k ] = bitangent;
+		}
+
+		if( y == numQuadsY )
+			continue;
+
+		// indices, two triangles per sub-quad
+		unsigned int* i = indices + 6 * (size_t)numQuadsX * y;
 
-		for( int i = 0 ; i < 6 ; i++ )
+		for( int x = 0 ; x < numQuadsX ; x++ )
 		{
-			v[ i ] = mainVertices[ map[i] ];
-			n[ i ] = normal;
-			t[ i ] = mainTexCoords[ map[i] ];
-			c[ i ] = mainColors[ map[i] ];
+			unsigned int ll = baseVertex + y * rowLength + x;
+			unsigned int lr = ll + 1;
+			unsigned int ul = ll + rowLength;
+			unsigned int ur = ul + 1;
+
+			// first triangle
+			i[0] = ll;
+			i[1] = lr;
+			i[2] = ul;
+
+			// second triangle
+			i[3] = ur;
+			i[4] = ul;
+			i[5] = lr;
+
+			i += 6;
 		}
 	}
 }
 
 
+/*
+========================
+buildGrid
+
+ The corner order is (-1,-1), (+1,-1), (-1,+1), (+1,+1), where -1 represents
+ the minimum and +1 the maximum. The vertices are stored row by row,
+ starting at the (-1,-1) corner.
+ It uses two triangles for each sub-quad, with the same winding as the
+ corners: (-1,-1), (+1,-1), (-1,+1) and (+1,+1), (-1,+1), (+1,-1).
+========================
+*/
+void CBaseModel::buildGrid( IVertexStream* stream, int firstVertex, int firstIndex,
+							const vec3_t* mainVertices, const vec3_t & normal,
+							const vec2_t* mainTexCoords, const vec4_t* mainColors,
+							int numQuadsX, int numQuadsY )
+{
+	CGridJob job;
+	job.v				= stream->v()    + firstVertex;
+	job.n				= stream->n()    + firstVertex;
+	job.t				= stream->t()    + firstVertex;
+	job.c				= stream->c()    + firstVertex;
+	job.tan1			= stream->tan1() + firstVertex;
+	job.tan2			= stream->tan2() + firstVertex;
+	job.indices			= stream->i()    + firstIndex;
+	job.baseVertex		= firstVertex;
+	job.mainVertices	= mainVertices;
+	job.mainTexCoords	= mainTexCoords;
+	job.mainColors		= mainColors;
+	job.normal			= normal;
+	job.numQuadsX		= numQuadsX;
+	job.numQuadsY		= numQuadsY;
+
+	// the grid is planar, so all vertices share the tangent space of the
+	// first triangle. see computeTangentSpace().
+	computeTriangleTangentSpace( mainVertices [0], mainVertices [1], mainVertices [2],
+								 mainTexCoords[0], mainTexCoords[1], mainTexCoords[2],
+								 normal, job.tangent, job.bitangent );
+
+	// one row per iteration
+	parallelFor( numQuadsY + 1, &job, 16 );
+}
+
+
 //=============================================================================
 //	cube test model
 //=============================================================================
 IModel* IModel::createCube( void )
 {
-    return createCube(7);
+	return createCube( CONFIG_DEFAULT_GRID_RESOLUTION, CONFIG_DEFAULT_GRID_RESOLUTION );
 }
 
 //======================
@@ -380,12 +421,19 @@ IModel* IModel::createCube( void )
  * The components intensities increase with increasing vertex coordinate.
  * The texture coordinates define the full texture image on every face of the cube.
  * The face normals point out of the cube.
+ * Each face is a grid of numQuadsX * numQuadsY sub-quads.
  */
 //======================
-IModel* IModel::createCube( int level )
+IModel* IModel::createCube( int numQuadsX, int numQuadsY )
 {
-	int vertexCount = CBaseModel::vertexCountForPlaneLevel( level );
-	IVertexStream* v = IVertexStream::create( vertexCount * 6 );
+	numQuadsX = qMax( numQuadsX, 1 );
+	numQuadsY = qMax( numQuadsY, 1 );
+
+	int vertexCount = CBaseModel::gridVertexCount( numQuadsX, numQuadsY );
+	int indexCount  = CBaseModel::gridIndexCount ( numQuadsX, numQuadsY );
+
+	// the faces do not share vertices, their normals differ.
+	IVertexStream* v = IVertexStream::create( vertexCount * 6, indexCount * 6 );
 
 	// vertices
 	static vec3_t vIn[6][4] =
@@ -521,14 +569,10 @@ IModel* IModel::createCube( int level )
 	// setup all cube sides
 	for( int i = 0 ; i < 6 ; i++ )
 	{
-		int side = i * vertexCount;
-
-		CBaseModel::buildPlane( v->v()+side, v->n()+side, v->t()+side, v->c()+side,
-								vIn[i], nIn[i], tIn[i], cIn[i], level );
+		CBaseModel::buildGrid( v, i * vertexCount, i * indexCount,
+							   vIn[i], nIn[i], tIn[i], cIn[i], numQuadsX, numQuadsY );
 	}
 
-	v->coumputeTangentVectors();
-
 	return new CBaseModel( QString( "Cube" ), GL_TRIANGLES, 
 				vec3_t( -1,-1,-1 ), vec3_t( 1,1,1 ), sqrtf(3.0f), v );
 }
@@ -540,7 +584,7 @@ IModel* IModel::createCube( int level )
 
 IModel* IModel::createPlane( void )
 {
-    return createPlane(7);
+	return createPlane( CONFIG_DEFAULT_GRID_RESOLUTION, CONFIG_DEFAULT_GRID_RESOLUTION );
 }
 
 //======================
@@ -548,11 +592,16 @@ IModel* IModel::createPlane( void )
  * The returned model has the color (1,1,1,1) and a the normal (0,0,1).
  * The vertex coordinates range form (-1,-1,0) to (+1,+1,0).
  * The texture coordinates cover th entire quad.
+ * The quad is a grid of numQuadsX * numQuadsY sub-quads.
  */
 //======================
-IModel* IModel::createPlane( int level )
+IModel* IModel::createPlane( int numQuadsX, int numQuadsY )
 {
-	IVertexStream* v = IVertexStream::create( CBaseModel::vertexCountForPlaneLevel(level) );
+	numQuadsX = qMax( numQuadsX, 1 );
+	numQuadsY = qMax( numQuadsY, 1 );
+
+	IVertexStream* v = IVertexStream::create( CBaseModel::gridVertexCount( numQuadsX, numQuadsY ),
+											  CBaseModel::gridIndexCount ( numQuadsX, numQuadsY ) );
 
 	// vertices
 	static vec3_t vIn[] =
@@ -575,11 +624,8 @@ IModel* IModel::createPlane( int level )
 		vec4_t( 1,1,1,1 ), vec4_t( 1,1,1,1 ),
 	};
 
-	CBaseModel::buildPlane( v->v(), v->n(), v->t(), v->c(),
-							vIn, vec3_t(0,0,1), tIn, cIn,
-							level );
-
-	v->coumputeTangentVectors();
+	CBaseModel::buildGrid( v, 0, 0, vIn, vec3_t(0,0,1), tIn, cIn,
+						   numQuadsX, numQuadsY );
 
 	return new CBaseModel( QString( "Plane" ), GL_TRIANGLES,
 		vec3_t( -1,-1,0 ), vec3_t( 1,1,0 ), sqrtf( 2.0f ), v );
@@ -639,19 +685,22 @@ IModel *IModel::createLineStrip(QString name, GLenum op) {
 
 //======================
 /** Creates an UV sphere.
- * The sphere is a list of single triangles that form a sphere.
+ * The sphere is an indexed list of triangles that form a sphere.
  * The sphere is approximated by several rings, stacked from one pole to the other.
  * Each ring is a list of segments (quads), which are defined by two triangles.
- * As a result, the number of vertices required for the sphere is approx.
- * 3 * numTriangles = 3 * 2 * numQuads = 3 * 2 * numRings * numSegments.
  * The rings at the poles are created of triangles list to avoid degenerated triangles,
- * so the exact amount of vertices is 3 * 2 * ( numRings - 2 ) * numSegments + 3 * numSegments * ( 1 + 1 )
+ * so the amount of indices is 3 * 2 * ( numRings - 2 ) * numSegments + 3 * numSegments * ( 1 + 1 )
  * = 3 * 2 * numSegments * ( numRings - 1 ).
+ * Neighboring triangles share their vertices. The vertices are stored on a grid of
+ * ( numRings + 1 ) * ( numSegments + 1 ) points, the first and the last point of each
+ * ring have the same position but different texture coordinates, the same applies to
+ * the points of the pole rings.
  * The vertex colors are interpolated between the north pole (red) and the equator (green)
  * and between the equator (green) and the south pole (blue).
  * The shere's texture coordiantes wrap the complete 2D texture image around the sphere,
  * which causes singularities on the poles and a seam on the edge shared by the first and the last
  * quad of each segment. The normals point out of the sphere.
+ * The custom attribute 'attrCurvature' stores the mean and the gaussian curvature.
  *
  * @param numRings Number of rings of the sphere.
  * @param numSegments Number of segments of the sphere.
@@ -661,123 +710,121 @@ IModel *IModel::createLineStrip(QString name, GLenum op) {
 //======================
 IModel* IModel::createSphere( int numRings, int numSegments, float radius )
 {
-	int verticesPerQuad = 6; // must match the algorithm below!
+	IVertexStream* stream = CBaseModel::buildSphere( numRings, numSegments, radius );
 
+	// principal curvatures are 1/r everywhere
+	vec2_t* curvature = (vec2_t*)stream->attribute( stream->addAttribute( "attrCurvature", 2 ) );
+	for( int i = 0 ; i < stream->getNumVertices() ; i++ ) {
+		curvature[ i ] = vec2_t( 1.0f / radius, 1.0f / ( radius * radius ) );
+	}
+
+	return new CBaseModel( QString( "Sphere" ), GL_TRIANGLES,
+				vec3_t( -1,-1,-1 ), vec3_t( 1,1,1 ), radius, stream );
+}
+
+
+/*
+========================
+buildSphere
+========================
+*/
+IVertexStream* CBaseModel::buildSphere( int numRings, int numSegments, float radius )
+{
 	static const vec4_t colorNorth  ( 1,0,0,1 );
 	static const vec4_t colorSouth  ( 0,0,1,1 );
 	static const vec4_t colorEquator( 0,1,0,1 );
 
-	// alloc space for numVertices = verticesPerQuad * numQuads
-	IVertexStream* stream = IVertexStream::create( verticesPerQuad * numSegments * ( numRings - 1 ) );
+	int rowLength = numSegments + 1;
+
+	// numIndices = 6 * numQuads, the pole rings only use one triangle per quad.
+	IVertexStream* stream = IVertexStream::create( ( numRings + 1 ) * rowLength,
+												   6 * numSegments * ( numRings - 1 ) );
 
 	// get array pointers
 	vec3_t* v = stream->v();
 	vec3_t* n = stream->n();
 	vec2_t* t = stream->t();
 	vec4_t* c = stream->c();
+	unsigned int* indices = stream->i();
 
 	static const float pi = 4.0f * atanf( 1.0f );
 	float stepNS = pi / float(numRings);    // north -> south
 	float stepWE = 2.0f * pi / float(numSegments); // west ->east
-	float alpha  = 0.5f * pi; // starting at top
-	float V2 = 0.0f; // texture coord
 
-	// for each ring
-	for( int i = 0 ; i < numRings; i++ )
+	// vertices, ring by ring, starting at the north pole
+	for( int i = 0 ; i <= numRings; i++ )
 	{
-		float oldalpha = alpha;
-		alpha -= stepNS;
+		float alpha = 0.5f * pi - float( i ) * stepNS; // starting at top
+		float sa = sinf( alpha );
+		float ca = cosf( alpha );
+		float V  = float( i ) / float( numRings ); // texture coord
+
+		for( int j = 0 ; j <= numSegments ; j++ )
+		{
+			float beta = 1.0f + float( j ) * stepWE;
+			float sb = sinf( beta );
+			float cb = cosf( beta );
 
-		float V1 = V2;
-		V2 = float( i+1 ) / float( numRings );
+			// X texture coord, points from right to left.
+			float U = 1.0f - float( j ) / float( numSegments );
 
-		float sa1 = sin( oldalpha );
-		float sa2 = sin( alpha );
-		float ca1 = cos( oldalpha );
-		float ca2 = cos( alpha );
+			// setup normal / vertex position
+			*n = vec3_t( ca * cb, sa, ca * sb );
+			*v = (*n) * radius;
 
-		float beta = 1.0;
+			// setup color - interpolate along Y axis
+			*c = n->y < 0.0f ?
+				( colorNorth * (-(n->y)) + colorEquator * ( 1 + (n->y)) ) :
+				( colorSouth *   (n->y)  + colorEquator * ( 1 - (n->y)) );
 
-		// X texture coord, see note below.
-		float U2 = 1.0f;
+			// setup texture coords
+			*t = vec2_t( U, V );
 
-		// for each segment
+			// advance array pointers
+			v++; n++; t++; c++;
+		}
+	}
+
+	// indices, the corners of each quad are:
+	//  a = ( ring, seg ), b = ( ring, seg + 1 ), 
+	//  c = ( ring + 1, seg + 1 ), d = ( ring + 1, seg )
+	for( int i = 0 ; i < numRings ; i++ )
+	{
 		for( int j = 0 ; j < numSegments ; j++ )
 		{
-			float oldbeta = beta;
-			beta += stepWE;
-
-			float U1 = U2;
-			U2 = 1.0f - float( j+1 ) / float( numSegments );
-
-			float sb1 = sinf( oldbeta );
-			float sb2 = sinf( beta );
-			float cb1 = cosf( oldbeta );
-			float cb2 = cosf( beta );
-
-	//
-	// Helper macro for creating sphere vertices.
-	// Imagine the ring unrolled in a 2D cartesian coordinate system:
-	//    +-+-+-+-+-+
-	//    |\|\|\|\|\|
-	//    +-+-+-+-+-+
-	//  X points from right to left!
-	//  Y points from top to bottom!
-	//  First argument is the 'y' coord, second the 'x' coord.
-	//
-#define DEFINE_VERTEX(ring,seg) \
-	/* setup normal / vertex position */ \
-	*n = vec3_t( ca ## ring * cb ## seg, \
-				 sa ## ring, \
-				 ca ## ring * sb ## seg ); \
-	/* setup vertex position */ \
-	*v = (*n) * radius; \
-	\
-	/* setup color - interpolate along Y axis */ \
-	*c = n->y < 0.0f ? \
-		( colorNorth * (-(n->y)) + colorEquator * ( 1 + (n->y)) ) : \
-		( colorSouth *   (n->y)  + colorEquator * ( 1 - (n->y)) ); \
-	\
-	/* setup texture coords */ \
-	*t = vec2_t( U ## seg, V ## ring ); \
-	\
-	/* advance array pointers */ \
-	v++; n++; t++; c++;
-
-
-			// setup vertices for this ring
+			unsigned int a = i * rowLength + j;
+			unsigned int b = a + 1;
+			unsigned int d = a + rowLength;
+			unsigned int c = d + 1;
+
 			if( i == 0 ) // north pole
 			{
-				DEFINE_VERTEX( 2,2 );
-				DEFINE_VERTEX( 2,1 );
-				DEFINE_VERTEX( 1,1 );
+				*indices++ = c;
+				*indices++ = d;
+				*indices++ = a;
 			}
 			else if( i == numRings - 1 ) // south pole
 			{
-				DEFINE_VERTEX( 1,1 );
-				DEFINE_VERTEX( 1,2 );
-				DEFINE_VERTEX( 2,2 );
+				*indices++ = a;
+				*indices++ = b;
+				*indices++ = c;
 			}
 			else
 			{
-				DEFINE_VERTEX( 1,1 );
-				DEFINE_VERTEX( 1,2 );
-				DEFINE_VERTEX( 2,2 );
-				DEFINE_VERTEX( 2,2 );
-				DEFINE_VERTEX( 2,1 );
-				DEFINE_VERTEX( 1,1 );
+				*indices++ = a;
+				*indices++ = b;
+				*indices++ = c;
+				*indices++ = c;
+				*indices++ = d;
+				*indices++ = a;
 			}
-
-#undef DEFINE_VERTEX
-
 		}
 	}
 
 	// setup tangent space vectors
 	stream->coumputeTangentVectors();
 
-	return new CBaseModel( QString( "Sphere" ), GL_TRIANGLES,
-				vec3_t( -1,-1,-1 ), vec3_t( 1,1,1 ), radius, stream );
+	return stream;
 }
 
 
@@ -787,15 +834,19 @@ IModel* IModel::createSphere( int numRings, int numSegments, float radius )
 
 //======================
 /** Creates a torus.
- * The torus is a list of single triangles that form the torus.
+ * The torus is an indexed list of triangles that form the torus.
  * The torus is a cylinder with radius2 deformed so that the top and the bottom of the cylinder are connected.
  * This cylinder is located on a circle with radius1 around the origin.
  * The cylinder is a stack of several rings.
  * Each ring is created of several segments (quads), which are defined by two triangles.
- * The required amount of vertices is 3 * numTriangles = 3 * 2 * numQuads = 3 * 2 * numRings * numSegments.
+ * The required amount of indices is 3 * numTriangles = 3 * 2 * numQuads = 3 * 2 * numRings * numSegments.
+ * Neighboring triangles share their vertices. The vertices are stored on a grid of
+ * ( numRings + 1 ) * ( numSegments + 1 ) points, the points on both seams are duplicated
+ * because their texture coordinates differ.
  * The vertex colors are interpolated between the west end (red) and the origin (green) and between the origin (green) and the east end (blue).
  * The texture coordinates map the entire image around the cylinder.
  * The vertex normals point out of the cylinder.
+ * The custom attribute 'attrCurvature' stores the mean and the gaussian curvature.
  * 
  * @param numRings Number of rings the torus is split into.
  * @param numSegments Number of segments each ring is split into.
@@ -808,14 +859,19 @@ IModel* IModel::createTorus( int numRings, int numSegments, float radius1, float
 {
 	static const float pi = 4.0f * atan( 1.0f );
 
+	int rowLength = numSegments + 1;
+
 	// two triangles per quad, numRings * numSegments quads
-	IVertexStream* stream = IVertexStream::create( 6 * numRings * numSegments );
+	IVertexStream* stream = IVertexStream::create( ( numRings + 1 ) * rowLength,
+												   6 * numRings * numSegments );
 
 	// access arrays
 	vec3_t* v = stream->v();
 	vec3_t* n = stream->n();
 	vec2_t* t = stream->t();
 	vec4_t* c = stream->c();
+	unsigned int* indices = stream->i();
+	vec2_t* curvature = (vec2_t*)stream->attribute( stream->addAttribute( "attrCurvature", 2 ) );
 
 	vec4_t colorWest( 1,0,0,1 );
 	vec4_t colorMid ( 0,1,0,1 );
@@ -826,63 +882,67 @@ IModel* IModel::createTorus( int numRings, int numSegments, float radius1, float
 	colorMid  = colorMid  * ( 1.0f / ( radius1 + radius2 ) );
 	colorEast = colorEast * ( 1.0f / ( radius1 + radius2 ) );
 
-	// for each ring
-	for( int i = 0 ; i < numRings ; i++ )
+	// vertices, for each ring
+	for( int i = 0 ; i <= numRings ; i++ )
 	{
-		float oldalpha = 2.0f * pi * float(i)   / float(numRings);
-		float alpha    = 2.0f * pi * float(i+1) / float(numRings);
-
-		float U1 = 1.0f - float(i)   / float( numRings );
-		float U2 = 1.0f - float(i+1) / float( numRings );
+		float alpha = 2.0f * pi * float(i) / float(numRings);
+		float U = 1.0f - float(i) / float( numRings );
 
-		float sa1 = sin( oldalpha );
-		float sa2 = sin( alpha );
-		float ca1 = cos( oldalpha );
-		float ca2 = cos( alpha );
+		float sa = sinf( alpha );
+		float ca = cosf( alpha );
 
 		// for each segment
+		for( int j = 0 ; j <= numSegments ; j++ )
+		{
+			float beta = 2.0f * pi * float(j) / float(numSegments);
+			float V = ( 1.0f - float(j) / float(numSegments) ) + 0.5f;
+
+			// point on unit circle
+			vec3_t p( cosf( beta ), sinf( beta ), 0.0f );
+
+			// point on circle rotated around Y axis
+			*n = vec3_t( p.x * ca, p.y, p.x * sa );
+
+			// translate and scale
+			vec3_t p2 = p * radius2;
+			p2.x += radius1;
+
+			// transformed and rotated around Y axis
+			*v = vec3_t( p2.x * ca, p2.y, p2.x * sa );
+
+			// tex coord
+			*t = vec2_t( U, V );
+
+			// mean and gaussian curvature, p2.x is the distance to the Y axis
+			*curvature = vec2_t( ( radius1 + 2.0f * radius2 * p.x ) / ( 2.0f * radius2 * p2.x ),
+								 p.x / ( radius2 * p2.x ) );
+
+			// interpolate color along X axis
+			*c = v->x < 0.0f ?
+				( colorWest * (-(v->x)) + colorMid * ( 1 + (v->x)) ) :
+				( colorEast *   (v->x)  + colorMid * ( 1 - (v->x)) );
+
+			// advance pointers
+			v++; n++; t++; c++; curvature++;
+		}
+	}
+
+	// indices, two triangles per quad
+	for( int i = 0 ; i < numRings ; i++ )
+	{
 		for( int j = 0 ; j < numSegments ; j++ )
 		{
-			vec3_t p,p2;
-
-			float oldbeta = 2.0f * pi * float(j)   / float(numSegments);
-			float beta    = 2.0f * pi * float(j+1) / float(numSegments);
-
-			float V1 = ( 1.0f - float(j)   / float(numSegments) ) + 0.5f;
-			float V2 = ( 1.0f - float(j+1) / float(numSegments) ) + 0.5f;
-
-			float sb1 = sinf( oldbeta );
-			float sb2 = sinf( beta );
-			float cb1 = cosf( oldbeta );
-			float cb2 = cosf( beta );
-
-#define DEFINE_VERTEX(ring,seg) \
-	/* point on unit circle */ \
-	p = vec3_t( cb ## seg, sb ## seg, 0.0f ); \
-	/* point on circle rotated around Y axis*/ \
-	*n = vec3_t( p.x * ca ## ring, p.y, p.x * sa ## ring ); \
-	/* translate and scale */ \
-	p2 = p * radius2; p2.x += radius1; \
-	/* transformed and rotated around Y axis */ \
-	*v = vec3_t( p2.x * ca ## ring, p2.y, p2.x * sa ## ring ); \
-	/* tex coord */ \
-	*t = vec2_t( U ## ring , V ## seg ); \
-	/* interpolate color along X axis */ \
-	*c = v->x < 0.0f ? \
-		( colorWest * (-(v->x)) + colorMid * ( 1 + (v->x)) ) : \
-		( colorEast *   (v->x)  + colorMid * ( 1 - (v->x)) ); \
-	/* advance pointers */ \
-	v++; n++; t++; c++;
-
-
-			DEFINE_VERTEX( 1,1 );
-			DEFINE_VERTEX( 1,2 );
-			DEFINE_VERTEX( 2,2 );
-			DEFINE_VERTEX( 2,2 );
-			DEFINE_VERTEX( 2,1 );
-			DEFINE_VERTEX( 1,1 );
-
-#undef DEFINE_VERTEX
+			unsigned int a = i * rowLength + j;
+			unsigned int b = a + 1;
+			unsigned int d = a + rowLength;
+			unsigned int c = d + 1;
+
+			*indices++ = a;
+			*indices++ = b;
+			*indices++ = c;
+			*indices++ = c;
+			*indices++ = d;
+			*indices++ = a;
 		}
 	}
 
@@ -923,6 +983,398 @@ IModel* IModel::createPoint( void )
 }
 
 
+//=============================================================================
+//	animated test models
+//=============================================================================
+
+/** A cylinder along the Y axis, skinned to a chain of bones.
+ * The bones twist around the Y axis and bend around the Z axis,
+ * both grow from the bottom to the top of the cylinder.
+ */
+class CSkinnedCylinder : public CBaseModel
+{
+public:
+	CSkinnedCylinder( IVertexStream* stream, float radius, float height, int numBones );
+	virtual ~CSkinnedCylinder( void );
+
+	// IModel interface
+	bool	animate( float time );
+	size_t	getMemoryUsage( void );
+
+private:
+	float			m_height;
+	int				m_numBones;
+	mat4_t*			m_bones;		// [ m_numBones ]
+	skinWeights_t*	m_weights;		// [ numVertices ]
+	vertexFrame_t	m_bindPose;		// copy of the initial stream
+};
+
+
+/*
+========================
+CSkinnedCylinder::CSkinnedCylinder
+
+ each vertex is bound to the two nearest bones.
+========================
+*/
+CSkinnedCylinder::CSkinnedCylinder( IVertexStream* stream, float radius, float height, int numBones )
+ : CBaseModel( QString( "Twisting Cylinder" ), GL_TRIANGLES,
+			   vec3_t( -1,-1,-1 ) * ( height + radius ), vec3_t( 1,1,1 ) * ( height + radius ),
+			   height + radius, stream ),
+   m_height( height ), m_numBones( qMax( numBones, 2 ) )
+{
+	int numVertices = stream->getNumVertices();
+
+	m_bones		= new mat4_t[ m_numBones ];
+	m_weights	= new skinWeights_t[ numVertices ];
+
+	m_bindPose.positions	= new vec3_t[ numVertices ];
+	m_bindPose.normals		= new vec3_t[ numVertices ];
+	m_bindPose.tangents		= new vec3_t[ numVertices ];
+	m_bindPose.bitangents	= new vec3_t[ numVertices ];
+
+	const vec3_t* v = stream->constV();
+	const vec3_t* n = stream->constN();
+	const vec3_t* tan1 = stream->constTan1();
+	const vec3_t* tan2 = stream->constTan2();
+
+	for( int i = 0 ; i < numVertices ; i++ )
+	{
+		m_bindPose.positions[ i ]	= v[ i ];
+		m_bindPose.normals[ i ]		= n[ i ];
+		m_bindPose.tangents[ i ]	= tan1[ i ];
+		m_bindPose.bitangents[ i ]	= tan2[ i ];
+
+		// position along the bone chain
+		float s = ( v[ i ].y / m_height + 0.5f ) * float( m_numBones - 1 );
+		int bone = qBound( 0, int( s ), m_numBones - 2 );
+		float f = s - float( bone );
+
+		skinWeights_t & w = m_weights[ i ];
+		w.bones[ 0 ] = bone;
+		w.bones[ 1 ] = bone + 1;
+		w.bones[ 2 ] = w.bones[ 3 ] = 0;
+		w.weights[ 0 ] = 1.0f - f;
+		w.weights[ 1 ] = f;
+		w.weights[ 2 ] = w.weights[ 3 ] = 0.0f;
+	}
+}
+
+CSkinnedCylinder::~CSkinnedCylinder( void )
+{
+	SAFE_DELETE_ARRAY( m_bones );
+	SAFE_DELETE_ARRAY( m_weights );
+	SAFE_DELETE_ARRAY( m_bindPose.positions );
+	SAFE_DELETE_ARRAY( m_bindPose.normals );
+	SAFE_DELETE_ARRAY( m_bindPose.tangents );
+	SAFE_DELETE_ARRAY( m_bindPose.bitangents );
+}
+
+
+/*
+========================
+CSkinnedCylinder::animate
+
+ every bone rotates around the bottom center of the cylinder:
+ M = T( base ) * Rz( bend ) * Ry( twist ) * T( -base )
+========================
+*/
+bool CSkinnedCylinder::animate( float time )
+{
+	float base = -0.5f * m_height;
+
+	for( int b = 0 ; b < m_numBones ; b++ )
+	{
+		float s = float( b ) / float( m_numBones - 1 );
+		float twist = 1.5f * s * sinf( time );
+		float bend  = 0.6f * s * sinf( 0.7f * time );
+
+		float ca = cosf( twist ), sa = sinf( twist );
+		float cb = cosf( bend ),  sb = sinf( bend );
+
+		// column major
+		float* m = m_bones[ b ].toFloatPointer();
+		m[0] = cb * ca;	m[4] = -sb;	m[ 8] = cb * sa;	m[12] = base * sb;
+		m[1] = sb * ca;	m[5] = cb;	m[ 9] = sb * sa;	m[13] = base - base * cb;
+		m[2] = -sa;		m[6] = 0;	m[10] = ca;			m[14] = 0;
+		m[3] = 0;		m[7] = 0;	m[11] = 0;			m[15] = 1;
+	}
+
+	vertexFrame_t result;
+	result.positions	= m_vertices->v();
+	result.normals		= m_vertices->n();
+	result.tangents		= m_vertices->tan1();
+	result.bitangents	= m_vertices->tan2();
+
+	skinVertices( m_vertices->getNumVertices(), m_weights, m_bones, m_bindPose, result );
+	return true;
+}
+
+
+/*
+========================
+CSkinnedCylinder::getMemoryUsage
+========================
+*/
+size_t CSkinnedCylinder::getMemoryUsage( void )
+{
+	return CBaseModel::getMemoryUsage() +
+		   m_vertices->getNumVertices() * ( sizeof( skinWeights_t ) + 4 * sizeof( vec3_t ) );
+}
+
+
+//======================
+/** Creates a cylinder that is deformed on the CPU every frame.
+ * The cylinder is an open tube along the Y axis, made of numRings rings
+ * of numSegments quads. It is skinned to numBones bones, which twist and
+ * bend the cylinder when IModel::animate() is called.
+ * The texture coordinates wrap around the cylinder, the colors are
+ * interpolated from red at the bottom to blue at the top.
+ *
+ * @param numRings Number of rings along the Y axis.
+ * @param numSegments Number of quads around the Y axis.
+ * @param radius Radius of the cylinder.
+ * @param height Length of the cylinder, it is centered at the origin.
+ * @param numBones Number of bones, at least two.
+ * @return An IModel representing the cylinder.
+ */
+//======================
+IModel* IModel::createTwistingCylinder( int numRings, int numSegments, float radius, float height, int numBones )
+{
+	static const float pi = 4.0f * atanf( 1.0f );
+
+	int rowLength = numSegments + 1;
+
+	IVertexStream* stream = IVertexStream::create( ( numRings + 1 ) * rowLength,
+												   6 * numRings * numSegments );
+
+	vec3_t* v = stream->v();
+	vec3_t* n = stream->n();
+	vec2_t* t = stream->t();
+	vec4_t* c = stream->c();
+	unsigned int* indices = stream->i();
+
+	// vertices, ring by ring from the bottom to the top
+	for( int i = 0 ; i <= numRings ; i++ )
+	{
+		float V = float( i ) / float( numRings );
+		float y = ( V - 0.5f ) * height;
+
+		for( int j = 0 ; j <= numSegments ; j++ )
+		{
+			float U = float( j ) / float( numSegments );
+			float alpha = 2.0f * pi * U;
+
+			*n = vec3_t( cosf( alpha ), 0.0f, -sinf( alpha ) );
+			*v = vec3_t( n->x * radius, y, n->z * radius );
+			*t = vec2_t( U, V );
+			*c = vec4_t( 1.0f - V, 0.0f, V, 1.0f );
+
+			v++; n++; t++; c++;
+		}
+	}
+
+	// indices, two triangles per quad
+	for( int i = 0 ; i < numRings ; i++ )
+	{
+		for( int j = 0 ; j < numSegments ; j++ )
+		{
+			unsigned int a = i * rowLength + j;
+			unsigned int b = a + 1;
+			unsigned int d = a + rowLength;
+			unsigned int c = d + 1;
+
+			*indices++ = a;
+			*indices++ = b;
+			*indices++ = c;
+			*indices++ = c;
+			*indices++ = d;
+			*indices++ = a;
+		}
+	}
+
+	stream->coumputeTangentVectors();
+
+	return new CSkinnedCylinder( stream, radius, height, numBones );
+}
+
+
+/** A sphere that blends between an ellipsoid and a rounded cube. */
+class CMorphingSphere : public CBaseModel
+{
+public:
+	CMorphingSphere( IVertexStream* stream, float radius );
+	virtual ~CMorphingSphere( void );
+
+	// IModel interface
+	bool	animate( float time );
+	size_t	getMemoryUsage( void );
+
+private:
+	enum { NUM_TARGETS = 2 };
+
+	// helpers
+	static void allocFrame( vertexFrame_t & frame, int numVertices );
+	static void freeFrame( vertexFrame_t & frame );
+
+	vertexFrame_t	m_base;					// copy of the sphere
+	vertexFrame_t	m_deltas[ NUM_TARGETS ];	// target - base
+};
+
+
+/*
+========================
+CMorphingSphere::allocFrame
+========================
+*/
+void CMorphingSphere::allocFrame( vertexFrame_t & frame, int numVertices )
+{
+	frame.positions		= new vec3_t[ numVertices ];
+	frame.normals		= new vec3_t[ numVertices ];
+	frame.tangents		= new vec3_t[ numVertices ];
+	frame.bitangents	= new vec3_t[ numVertices ];
+}
+
+
+/*
+========================
+CMorphingSphere::freeFrame
+========================
+*/
+void CMorphingSphere::freeFrame( vertexFrame_t & frame )
+{
+	SAFE_DELETE_ARRAY( frame.positions );
+	SAFE_DELETE_ARRAY( frame.normals );
+	SAFE_DELETE_ARRAY( frame.tangents );
+	SAFE_DELETE_ARRAY( frame.bitangents );
+}
+
+
+/*
+========================
+CMorphingSphere::CMorphingSphere
+
+ the targets are built from the sphere's normals, which are the unit
+ directions of the vertices. Both shapes have analytic normals.
+========================
+*/
+CMorphingSphere::CMorphingSphere( IVertexStream* stream, float radius )
+ : CBaseModel( QString( "Morphing Sphere" ), GL_TRIANGLES,
+			   vec3_t( -1,-1,-1 ) * ( 1.4f * radius ), vec3_t( 1,1,1 ) * ( 1.4f * radius ),
+			   1.4f * radius, stream )
+{
+	static const vec3_t axes( 1.4f, 0.6f, 1.0f ); // ellipsoid
+
+	int numVertices = stream->getNumVertices();
+
+	allocFrame( m_base, numVertices );
+	memcpy( m_base.positions,	stream->constV(),		numVertices * sizeof( vec3_t ) );
+	memcpy( m_base.normals,		stream->constN(),		numVertices * sizeof( vec3_t ) );
+	memcpy( m_base.tangents,	stream->constTan1(),	numVertices * sizeof( vec3_t ) );
+	memcpy( m_base.bitangents,	stream->constTan2(),	numVertices * sizeof( vec3_t ) );
+
+	vertexFrame_t target;
+	allocFrame( target, numVertices );
+
+	for( int k = 0 ; k < NUM_TARGETS ; k++ )
+	{
+		for( int i = 0 ; i < numVertices ; i++ )
+		{
+			const vec3_t & d = m_base.normals[ i ];
+
+			if( k == 0 )
+			{
+				// ellipsoid
+				target.positions[ i ] = vec3_t( d.x * axes.x, d.y * axes.y, d.z * axes.z ) * radius;
+				target.normals[ i ] = vec3_t( d.x / axes.x, d.y / axes.y, d.z / axes.z ).normalize();
+			}
+			else
+			{
+				// rounded cube, x^4 + y^4 + z^4 = r^4
+				float len = powf( d.x*d.x*d.x*d.x + d.y*d.y*d.y*d.y + d.z*d.z*d.z*d.z, 0.25f );
+				vec3_t q = d * ( 1.0f / len );
+				target.positions[ i ] = q * ( 0.85f * radius );
+				target.normals[ i ] = vec3_t( q.x*q.x*q.x, q.y*q.y*q.y, q.z*q.z*q.z ).normalize();
+			}
+		}
+
+		computeTangentSpace( numVertices, target.positions, target.normals, stream->constT(),
+							 stream->getNumIndices() / 3, stream->constI(),
+							 target.tangents, target.bitangents );
+
+		// store the difference
+		allocFrame( m_deltas[ k ], numVertices );
+		for( int i = 0 ; i < numVertices ; i++ )
+		{
+			m_deltas[ k ].positions[ i ]	= target.positions[ i ]		- m_base.positions[ i ];
+			m_deltas[ k ].normals[ i ]		= target.normals[ i ]		- m_base.normals[ i ];
+			m_deltas[ k ].tangents[ i ]		= target.tangents[ i ]		- m_base.tangents[ i ];
+			m_deltas[ k ].bitangents[ i ]	= target.bitangents[ i ]	- m_base.bitangents[ i ];
+		}
+	}
+
+	freeFrame( target );
+}
+
+CMorphingSphere::~CMorphingSphere( void )
+{
+	freeFrame( m_base );
+
+	for( int k = 0 ; k < NUM_TARGETS ; k++ ) {
+		freeFrame( m_deltas[ k ] );
+	}
+}
 
 
+/*
+========================
+CMorphingSphere::animate
+
+ the weights never sum up to more than one.
+========================
+*/
+bool CMorphingSphere::animate( float time )
+{
+	float weights[ NUM_TARGETS ];
+	weights[ 0 ] = 0.5f - 0.5f * cosf( time );
+	weights[ 1 ] = ( 0.5f - 0.5f * cosf( 0.5f * time ) ) * ( 1.0f - weights[ 0 ] );
+
+	vertexFrame_t result;
+	result.positions	= m_vertices->v();
+	result.normals		= m_vertices->n();
+	result.tangents		= m_vertices->tan1();
+	result.bitangents	= m_vertices->tan2();
+
+	morphVertices( m_vertices->getNumVertices(), m_base, NUM_TARGETS, m_deltas, weights, result );
+	return true;
+}
+
+
+/*
+========================
+CMorphingSphere::getMemoryUsage
+========================
+*/
+size_t CMorphingSphere::getMemoryUsage( void )
+{
+	return CBaseModel::getMemoryUsage() +
+		   m_vertices->getNumVertices() * ( 1 + NUM_TARGETS ) * 4 * sizeof( vec3_t );
+}
+
+
+//======================
+/** Creates a sphere that is deformed on the CPU every frame.
+ * The geometry matches createSphere(). When IModel::animate() is called,
+ * the sphere is blended with two morph targets, an ellipsoid and a rounded cube.
+ *
+ * @param numRings Number of rings of the sphere.
+ * @param numSegments Number of segments of the sphere.
+ * @param radius Radius of the sphere.
+ * @return An IModel representing the sphere.
+ */
+//======================
+IModel* IModel::createMorphingSphere( int numRings, int numSegments, float radius )
+{
+	return new CMorphingSphere( CBaseModel::buildSphere( numRings, numSegments, radius ), radius );
+}
 
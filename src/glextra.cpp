@@ -0,0 +1,286 @@
+//=============================================================================
+/** @file		glextra.cpp
+ *
+ * Resolves OpenGL entry points that are not covered by GLee.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#include "application.h"
+#include "glextra.h"
+
+#include <QtOpenGL/QGLContext>
+
+#include <stdio.h>
+#include <string.h>
+
+
+//=============================================================================
+//	entry points
+//=============================================================================
+
+SMGLVERTEXATTRIBDIVISORPROC		smglVertexAttribDivisor		= NULL;
+SMGLDRAWARRAYSINSTANCEDPROC		smglDrawArraysInstanced		= NULL;
+SMGLDRAWELEMENTSINSTANCEDPROC	smglDrawElementsInstanced	= NULL;
+SMGLTRANSFORMFEEDBACKVARYINGSPROC	smglTransformFeedbackVaryings	= NULL;
+SMGLGETTRANSFORMFEEDBACKVARYINGPROC	smglGetTransformFeedbackVarying	= NULL;
+SMGLBEGINTRANSFORMFEEDBACKPROC		smglBeginTransformFeedback		= NULL;
+SMGLENDTRANSFORMFEEDBACKPROC		smglEndTransformFeedback		= NULL;
+SMGLBINDBUFFERBASEPROC				smglBindBufferBase				= NULL;
+SMGLGETPROGRAMBINARYPROC			smglGetProgramBinary			= NULL;
+SMGLPROGRAMBINARYPROC				smglProgramBinary				= NULL;
+SMGLPROGRAMPARAMETERIPROC			smglProgramParameteri			= NULL;
+SMGLGETACTIVEUNIFORMSIVPROC			smglGetActiveUniformsiv			= NULL;
+SMGLGETACTIVEUNIFORMBLOCKIVPROC		smglGetActiveUniformBlockiv		= NULL;
+SMGLGETACTIVEUNIFORMBLOCKNAMEPROC	smglGetActiveUniformBlockName	= NULL;
+SMGLGETUNIFORMBLOCKINDEXPROC		smglGetUniformBlockIndex		= NULL;
+SMGLUNIFORMBLOCKBINDINGPROC			smglUniformBlockBinding			= NULL;
+
+// passed to smglInit(), NULL for the current QGLContext
+static SMGLGETPROCADDRESSPROC s_getProcAddress = NULL;
+
+
+/*
+========================
+resolveFunction
+
+ tries the names in order, the list is terminated by NULL.
+ The core name comes first, followed by the extension names.
+========================
+*/
+static void* resolveFunction( const char* const * names )
+{
+	const QGLContext* context = QGLContext::currentContext();
+	if( context == NULL && s_getProcAddress == NULL )
+		return NULL;
+
+	for( int i = 0 ; names[ i ] != NULL ; i++ )
+	{
+		void* function = NULL;
+		if( s_getProcAddress != NULL ) {
+			function = s_getProcAddress( names[ i ] );
+		} else {
+			function = (void*)context->getProcAddress( QString( names[ i ] ) );
+		}
+
+		if( function != NULL )
+			return function;
+	}
+
+	return NULL;
+}
+
+
+/*
+========================
+isVersionAvailable
+
+ compares with the <major>.<minor> at the start of GL_VERSION.
+========================
+*/
+static bool isVersionAvailable( int majorRequired, int minorRequired )
+{
+	const char* version = (const char*)glGetString( GL_VERSION );
+	int major = 0, minor = 0;
+	if( version == NULL || sscanf( version, "%d.%d", &major, &minor ) != 2 )
+		return false;
+
+	return ( major > majorRequired ) || ( major == majorRequired && minor >= minorRequired );
+}
+
+
+/*
+========================
+isExtensionAvailable
+
+ the names are separated by spaces, so a prefix of another name is no match.
+========================
+*/
+static bool isExtensionAvailable( const char* name )
+{
+	const char* extensions = (const char*)glGetString( GL_EXTENSIONS );
+	if( extensions == NULL )
+		return false;
+
+	size_t length = strlen( name );
+	for( const char* s = strstr( extensions, name ) ; s != NULL ; s = strstr( s + length, name ) )
+	{
+		bool start = ( s == extensions || s[ -1 ] == ' ' );
+		bool end = ( s[ length ] == ' ' || s[ length ] == '\0' );
+		if( start && end )
+			return true;
+	}
+
+	return false;
+}
+
+
+/*
+========================
+smglInit
+========================
+*/
+void smglInit( SMGLGETPROCADDRESSPROC getProcAddress )
+{
+	s_getProcAddress = getProcAddress;
+
+	static const char* const vertexAttribDivisor[] =
+		{ "glVertexAttribDivisor", "glVertexAttribDivisorARB", NULL };
+	static const char* const drawArraysInstanced[] =
+		{ "glDrawArraysInstanced", "glDrawArraysInstancedARB", "glDrawArraysInstancedEXT", NULL };
+	static const char* const drawElementsInstanced[] =
+		{ "glDrawElementsInstanced", "glDrawElementsInstancedARB", "glDrawElementsInstancedEXT", NULL };
+	static const char* const transformFeedbackVaryings[] =
+		{ "glTransformFeedbackVaryings", "glTransformFeedbackVaryingsEXT", NULL };
+	static const char* const getTransformFeedbackVarying[] =
+		{ "glGetTransformFeedbackVarying", "glGetTransformFeedbackVaryingEXT", NULL };
+	static const char* const beginTransformFeedback[] =
+		{ "glBeginTransformFeedback", "glBeginTransformFeedbackEXT", NULL };
+	static const char* const endTransformFeedback[] =
+		{ "glEndTransformFeedback", "glEndTransformFeedbackEXT", NULL };
+	static const char* const bindBufferBase[] =
+		{ "glBindBufferBase", "glBindBufferBaseEXT", NULL };
+	static const char* const getProgramBinary[] =
+		{ "glGetProgramBinary", NULL };
+	static const char* const programBinary[] =
+		{ "glProgramBinary", NULL };
+	static const char* const programParameteri[] =
+		{ "glProgramParameteri", NULL };
+	static const char* const getActiveUniformsiv[] =
+		{ "glGetActiveUniformsiv", NULL };
+	static const char* const getActiveUniformBlockiv[] =
+		{ "glGetActiveUniformBlockiv", NULL };
+	static const char* const getActiveUniformBlockName[] =
+		{ "glGetActiveUniformBlockName", NULL };
+	static const char* const getUniformBlockIndex[] =
+		{ "glGetUniformBlockIndex", NULL };
+	static const char* const uniformBlockBinding[] =
+		{ "glUniformBlockBinding", NULL };
+
+	smglVertexAttribDivisor		= (SMGLVERTEXATTRIBDIVISORPROC)		resolveFunction( vertexAttribDivisor );
+	smglDrawArraysInstanced		= (SMGLDRAWARRAYSINSTANCEDPROC)		resolveFunction( drawArraysInstanced );
+	smglDrawElementsInstanced	= (SMGLDRAWELEMENTSINSTANCEDPROC)	resolveFunction( drawElementsInstanced );
+
+	// the window system returns addresses for any name, the driver must implement them.
+	if( !isVersionAvailable( 3, 3 ) && !isExtensionAvailable( "GL_ARB_instanced_arrays" ) )
+	{
+		smglVertexAttribDivisor		= NULL;
+		smglDrawArraysInstanced		= NULL;
+		smglDrawElementsInstanced	= NULL;
+	}
+
+	smglTransformFeedbackVaryings	= (SMGLTRANSFORMFEEDBACKVARYINGSPROC)	resolveFunction( transformFeedbackVaryings );
+	smglGetTransformFeedbackVarying	= (SMGLGETTRANSFORMFEEDBACKVARYINGPROC)	resolveFunction( getTransformFeedbackVarying );
+	smglBeginTransformFeedback		= (SMGLBEGINTRANSFORMFEEDBACKPROC)		resolveFunction( beginTransformFeedback );
+	smglEndTransformFeedback		= (SMGLENDTRANSFORMFEEDBACKPROC)		resolveFunction( endTransformFeedback );
+	smglBindBufferBase				= (SMGLBINDBUFFERBASEPROC)				resolveFunction( bindBufferBase );
+
+	bool transformFeedback = isVersionAvailable( 3, 0 ) || isExtensionAvailable( "GL_EXT_transform_feedback" );
+	if( !transformFeedback )
+	{
+		smglTransformFeedbackVaryings	= NULL;
+		smglGetTransformFeedbackVarying	= NULL;
+		smglBeginTransformFeedback		= NULL;
+		smglEndTransformFeedback		= NULL;
+	}
+
+	smglGetProgramBinary			= (SMGLGETPROGRAMBINARYPROC)			resolveFunction( getProgramBinary );
+	smglProgramBinary				= (SMGLPROGRAMBINARYPROC)				resolveFunction( programBinary );
+	smglProgramParameteri			= (SMGLPROGRAMPARAMETERIPROC)			resolveFunction( programParameteri );
+
+	if( !isVersionAvailable( 4, 1 ) && !isExtensionAvailable( "GL_ARB_get_program_binary" ) )
+	{
+		smglGetProgramBinary			= NULL;
+		smglProgramBinary				= NULL;
+		smglProgramParameteri			= NULL;
+	}
+
+	smglGetActiveUniformsiv			= (SMGLGETACTIVEUNIFORMSIVPROC)			resolveFunction( getActiveUniformsiv );
+	smglGetActiveUniformBlockiv		= (SMGLGETACTIVEUNIFORMBLOCKIVPROC)		resolveFunction( getActiveUniformBlockiv );
+	smglGetActiveUniformBlockName	= (SMGLGETACTIVEUNIFORMBLOCKNAMEPROC)	resolveFunction( getActiveUniformBlockName );
+	smglGetUniformBlockIndex		= (SMGLGETUNIFORMBLOCKINDEXPROC)		resolveFunction( getUniformBlockIndex );
+	smglUniformBlockBinding			= (SMGLUNIFORMBLOCKBINDINGPROC)			resolveFunction( uniformBlockBinding );
+
+	bool uniformBuffer = isVersionAvailable( 3, 1 ) || isExtensionAvailable( "GL_ARB_uniform_buffer_object" );
+	if( !uniformBuffer )
+	{
+		smglGetActiveUniformsiv			= NULL;
+		smglGetActiveUniformBlockiv		= NULL;
+		smglGetActiveUniformBlockName	= NULL;
+		smglGetUniformBlockIndex		= NULL;
+		smglUniformBlockBinding			= NULL;
+	}
+
+	// shared by transform feedback and uniform buffers
+	if( !transformFeedback && !uniformBuffer ) {
+		smglBindBufferBase = NULL;
+	}
+}
+
+
+/*
+========================
+smglIsInstancingAvailable
+========================
+*/
+bool smglIsInstancingAvailable( void )
+{
+	return	smglVertexAttribDivisor		!= NULL &&
+			smglDrawArraysInstanced		!= NULL &&
+			smglDrawElementsInstanced	!= NULL;
+}
+
+
+/*
+========================
+smglIsTransformFeedbackAvailable
+========================
+*/
+bool smglIsTransformFeedbackAvailable( void )
+{
+	return	smglTransformFeedbackVaryings	!= NULL &&
+			smglGetTransformFeedbackVarying	!= NULL &&
+			smglBeginTransformFeedback		!= NULL &&
+			smglEndTransformFeedback		!= NULL &&
+			smglBindBufferBase				!= NULL;
+}
+
+
+/*
+========================
+smglIsProgramBinaryAvailable
+========================
+*/
+bool smglIsProgramBinaryAvailable( void )
+{
+	if( smglGetProgramBinary == NULL || smglProgramBinary == NULL || smglProgramParameteri == NULL )
+		return false;
+
+	GLint numFormats = 0;
+	glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats );
+	return numFormats > 0;
+}
+
+
+/*
+========================
+smglIsUniformBufferAvailable
+========================
+*/
+bool smglIsUniformBufferAvailable( void )
+{
+	return	smglGetActiveUniformsiv			!= NULL &&
+			smglGetActiveUniformBlockiv		!= NULL &&
+			smglGetActiveUniformBlockName	!= NULL &&
+			smglGetUniformBlockIndex		!= NULL &&
+			smglUniformBlockBinding			!= NULL &&
+			smglBindBufferBase				!= NULL;
+}
+
@@ -0,0 +1,184 @@
+//=============================================================================
+/** @file		glextra.h
+ *
+ * Defines OpenGL entry points that are not covered by GLee.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#ifndef __GLEXTRA_H_INCLUDED__
+#define __GLEXTRA_H_INCLUDED__
+
+// -> include application.h before this file, it includes GLee.h.
+
+
+//=============================================================================
+//	function types
+//=============================================================================
+
+// window system function that returns the entry points of the current context
+typedef void* (*SMGLGETPROCADDRESSPROC) ( const char* name );
+
+// GL 3.3 / ARB_instanced_arrays
+typedef void (APIENTRYP SMGLVERTEXATTRIBDIVISORPROC) ( GLuint index, GLuint divisor );
+
+// GL 3.1 / ARB_draw_instanced / EXT_draw_instanced
+typedef void (APIENTRYP SMGLDRAWARRAYSINSTANCEDPROC) ( GLenum mode, GLint first, GLsizei count, GLsizei primcount );
+typedef void (APIENTRYP SMGLDRAWELEMENTSINSTANCEDPROC) ( GLenum mode, GLsizei count, GLenum type, const GLvoid* indices, GLsizei primcount );
+
+// GL 3.0 / EXT_transform_feedback
+typedef void (APIENTRYP SMGLTRANSFORMFEEDBACKVARYINGSPROC) ( GLuint program, GLsizei count, const GLchar** varyings, GLenum bufferMode );
+typedef void (APIENTRYP SMGLGETTRANSFORMFEEDBACKVARYINGPROC) ( GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLsizei* size, GLenum* type, GLchar* name );
+typedef void (APIENTRYP SMGLBEGINTRANSFORMFEEDBACKPROC) ( GLenum primitiveMode );
+typedef void (APIENTRYP SMGLENDTRANSFORMFEEDBACKPROC) ( void );
+typedef void (APIENTRYP SMGLBINDBUFFERBASEPROC) ( GLenum target, GLuint index, GLuint buffer );
+
+// GL 4.1 / ARB_get_program_binary
+typedef void (APIENTRYP SMGLGETPROGRAMBINARYPROC) ( GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, GLvoid* binary );
+typedef void (APIENTRYP SMGLPROGRAMBINARYPROC) ( GLuint program, GLenum binaryFormat, const GLvoid* binary, GLsizei length );
+typedef void (APIENTRYP SMGLPROGRAMPARAMETERIPROC) ( GLuint program, GLenum pname, GLint value );
+
+// GL 3.1 / ARB_uniform_buffer_object
+typedef void (APIENTRYP SMGLGETACTIVEUNIFORMSIVPROC) ( GLuint program, GLsizei uniformCount, const GLuint* uniformIndices, GLenum pname, GLint* params );
+typedef void (APIENTRYP SMGLGETACTIVEUNIFORMBLOCKIVPROC) ( GLuint program, GLuint uniformBlockIndex, GLenum pname, GLint* params );
+typedef void (APIENTRYP SMGLGETACTIVEUNIFORMBLOCKNAMEPROC) ( GLuint program, GLuint uniformBlockIndex, GLsizei bufSize, GLsizei* length, GLchar* uniformBlockName );
+typedef GLuint (APIENTRYP SMGLGETUNIFORMBLOCKINDEXPROC) ( GLuint program, const GLchar* uniformBlockName );
+typedef void (APIENTRYP SMGLUNIFORMBLOCKBINDINGPROC) ( GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding );
+
+
+//=============================================================================
+//	constants
+//=============================================================================
+
+// GL 3.0 / EXT_transform_feedback, the values match the extension.
+#ifndef GL_TRANSFORM_FEEDBACK_BUFFER
+#define GL_TRANSFORM_FEEDBACK_BUFFER				0x8C8E
+#endif
+#ifndef GL_INTERLEAVED_ATTRIBS
+#define GL_INTERLEAVED_ATTRIBS						0x8C8C
+#endif
+#ifndef GL_PRIMITIVES_GENERATED
+#define GL_PRIMITIVES_GENERATED						0x8C87
+#endif
+#ifndef GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN
+#define GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN	0x8C88
+#endif
+#ifndef GL_TRANSFORM_FEEDBACK_VARYINGS
+#define GL_TRANSFORM_FEEDBACK_VARYINGS				0x8C83
+#endif
+#ifndef GL_RASTERIZER_DISCARD
+#define GL_RASTERIZER_DISCARD						0x8C89
+#endif
+
+// GL 4.1 / ARB_get_program_binary
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT			0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH					0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS				0x87FE
+#endif
+
+// GL 3.1 / ARB_uniform_buffer_object
+#ifndef GL_UNIFORM_BUFFER
+#define GL_UNIFORM_BUFFER							0x8A11
+#endif
+#ifndef GL_MAX_UNIFORM_BUFFER_BINDINGS
+#define GL_MAX_UNIFORM_BUFFER_BINDINGS				0x8A2F
+#endif
+#ifndef GL_ACTIVE_UNIFORM_BLOCKS
+#define GL_ACTIVE_UNIFORM_BLOCKS					0x8A36
+#endif
+#ifndef GL_UNIFORM_BLOCK_INDEX
+#define GL_UNIFORM_BLOCK_INDEX						0x8A3A
+#endif
+#ifndef GL_UNIFORM_OFFSET
+#define GL_UNIFORM_OFFSET							0x8A3B
+#endif
+#ifndef GL_UNIFORM_ARRAY_STRIDE
+#define GL_UNIFORM_ARRAY_STRIDE						0x8A3C
+#endif
+#ifndef GL_UNIFORM_MATRIX_STRIDE
+#define GL_UNIFORM_MATRIX_STRIDE					0x8A3D
+#endif
+#ifndef GL_UNIFORM_IS_ROW_MAJOR
+#define GL_UNIFORM_IS_ROW_MAJOR						0x8A3E
+#endif
+#ifndef GL_UNIFORM_BLOCK_DATA_SIZE
+#define GL_UNIFORM_BLOCK_DATA_SIZE					0x8A40
+#endif
+#ifndef GL_INVALID_INDEX
+#define GL_INVALID_INDEX							0xFFFFFFFFu
+#endif
+
+
+//=============================================================================
+//	entry points
+//=============================================================================
+
+/** The entry points are resolved by smglInit(). They are NULL if neither
+ * the core function nor one of the extension functions is available, or if
+ * the driver reports neither the OpenGL version nor the extension.
+ * The names match the core OpenGL names, prefixed with 'smgl' to avoid
+ * collisions with the OpenGL headers.
+ */
+extern SMGLVERTEXATTRIBDIVISORPROC		smglVertexAttribDivisor;
+extern SMGLDRAWARRAYSINSTANCEDPROC		smglDrawArraysInstanced;
+extern SMGLDRAWELEMENTSINSTANCEDPROC	smglDrawElementsInstanced;
+extern SMGLTRANSFORMFEEDBACKVARYINGSPROC	smglTransformFeedbackVaryings;
+extern SMGLGETTRANSFORMFEEDBACKVARYINGPROC	smglGetTransformFeedbackVarying;
+extern SMGLBEGINTRANSFORMFEEDBACKPROC		smglBeginTransformFeedback;
+extern SMGLENDTRANSFORMFEEDBACKPROC			smglEndTransformFeedback;
+extern SMGLBINDBUFFERBASEPROC				smglBindBufferBase;
+extern SMGLGETPROGRAMBINARYPROC				smglGetProgramBinary;
+extern SMGLPROGRAMBINARYPROC				smglProgramBinary;
+extern SMGLPROGRAMPARAMETERIPROC			smglProgramParameteri;
+extern SMGLGETACTIVEUNIFORMSIVPROC			smglGetActiveUniformsiv;
+extern SMGLGETACTIVEUNIFORMBLOCKIVPROC		smglGetActiveUniformBlockiv;
+extern SMGLGETACTIVEUNIFORMBLOCKNAMEPROC	smglGetActiveUniformBlockName;
+extern SMGLGETUNIFORMBLOCKINDEXPROC			smglGetUniformBlockIndex;
+extern SMGLUNIFORMBLOCKBINDINGPROC			smglUniformBlockBinding;
+
+
+/** Resolves the entry points for the current OpenGL context.
+ * This must be called once after the rendering context was created.
+ * @param getProcAddress Resolves the names, NULL to use the current QGLContext.
+ *			Contexts not created by Qt pass their window system function,
+ *			see IOffscreenContext.
+ */
+void smglInit( SMGLGETPROCADDRESSPROC getProcAddress = NULL );
+
+/** Returns true if instanced drawing with per-instance vertex attributes is available.
+ * Needs OpenGL 3.3 or GL_ARB_instanced_arrays.
+ */
+bool smglIsInstancingAvailable( void );
+
+/** Returns true if the output of the vertex or geometry stage can be
+ * recorded into buffer objects with transform feedback.
+ * Needs OpenGL 3.0 or GL_EXT_transform_feedback.
+ */
+bool smglIsTransformFeedbackAvailable( void );
+
+/** Returns true if linked programs can be read back and reloaded as
+ * driver specific binaries. Needs OpenGL 4.1 or GL_ARB_get_program_binary,
+ * and the driver must support at least one format.
+ */
+bool smglIsProgramBinaryAvailable( void );
+
+/** Returns true if uniform blocks can be backed by buffer objects.
+ * Needs OpenGL 3.1 or GL_ARB_uniform_buffer_object.
+ */
+bool smglIsUniformBufferAvailable( void );
+
+
+#endif	// __GLEXTRA_H_INCLUDED__
+
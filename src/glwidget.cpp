@@ -16,10 +16,12 @@
 #include <QMessageBox>
 #include <QtGui/QKeyEvent>
 #include <QtGui/QMouseEvent>
+#include <QtCore/QStringList>
 
 #include "application.h"
 #include "glwidget.h"
 #include "camera.h"
+#include "glextra.h"
 
 
 //=============================================================================
@@ -96,6 +98,9 @@ void CGLWidget::initializeGL( void )
 		return;
 	}
 
+	// resolve the functions GLee doesn't know about
+	smglInit();
+
 	// start FPS timer
 	m_fpsTimer.start();
 	m_fpsLastPeriod = m_fpsTimer.elapsed() - 1000;
@@ -159,6 +164,15 @@ void CGLWidget::drawFPS( void )
 	glDisable( GL_TEXTURE_2D );
 	glColor3f( 1,1,1 );
 	renderText( m_viewportSize.width() - length - 1, font().pointSize() + 1, text );
+
+	// statistics, one line each below the frame rate
+	QStringList lines = m_statisticsText.split( '\n', QString::SkipEmptyParts );
+	int lineHeight = fontMetrics().lineSpacing();
+	for( int i = 0 ; i < lines.size() ; i++ )
+	{
+		length = fontMetrics().width( lines[ i ] );
+		renderText( m_viewportSize.width() - length - 1, font().pointSize() + 1 + lineHeight * ( i + 1 ), lines[ i ] );
+	}
 }
 
 
@@ -252,12 +266,53 @@ void CGLWidget::mouseMoveEvent( QMouseEvent* event )
 		glPopMatrix();
     }
 
+	// the shader sees the position while a button is held
+	if( buttons != Qt::NoButton )
+	{
+		m_mouseState.x = float( event->x() );
+		m_mouseState.y = float( m_viewportSize.height() - 1 - event->y() );
+	}
+
 	// save state and accept event.
 	m_lastMousePosition = event->pos();
 	event->accept();
 }
 
 
+/*
+========================
+mousePressEvent
+========================
+*/
+void CGLWidget::mousePressEvent( QMouseEvent* event )
+{
+	m_mouseState.x = float( event->x() );
+	m_mouseState.y = float( m_viewportSize.height() - 1 - event->y() );
+	m_mouseState.z = m_mouseState.x;
+	m_mouseState.w = m_mouseState.y;
+
+	QGLWidget::mousePressEvent( event );
+}
+
+
+/*
+========================
+mouseReleaseEvent
+========================
+*/
+void CGLWidget::mouseReleaseEvent( QMouseEvent* event )
+{
+	// like shadertoy, the click position turns negative
+	if( event->buttons() == Qt::NoButton )
+	{
+		m_mouseState.z = -fabsf( m_mouseState.z );
+		m_mouseState.w = -fabsf( m_mouseState.w );
+	}
+
+	QGLWidget::mouseReleaseEvent( event );
+}
+
+
 /*
 ========================
 timerEvent
@@ -19,6 +19,8 @@
 #include <QtCore/QTime>
 #include <QtOpenGL/QGLWidget>
 
+#include "vector.h"
+
 // forward declarations
 class ICameraState;
 
@@ -61,6 +63,16 @@ public:
 	 */
 	QString getDriverInfoString( void ) const;
 
+	/** Sets the text displayed below the frame rate.
+	 * Lines are separated by '\n'. An empty string shows nothing.
+	 */
+	void setStatisticsText( const QString & text ) { m_statisticsText = text; }
+
+	/** Returns the mouse state for the 'mouse' uniform, see FrameInputs::mouse.
+	 * The origin is the lower left corner of the viewport.
+	 */
+	const vec4_t & getMouseState( void ) const { return m_mouseState; }
+
 signals:;
 
 	/** Periodic render event.
@@ -85,6 +97,8 @@ private:
 	// event handling
 	void  timerEvent( QTimerEvent* timer );
 	void  mouseMoveEvent( QMouseEvent* event );
+	void  mousePressEvent( QMouseEvent* event );
+	void  mouseReleaseEvent( QMouseEvent* event );
 	void  keyPressEvent( QKeyEvent* event );
 
 	// parses GL_VERSION and checks wether we have the requested version.
@@ -97,12 +111,18 @@ private:
 	int   m_fpsLastPeriod;  // time point of last update
 	QTime m_fpsTimer;
 
+	// shown below the frame rate
+	QString m_statisticsText;
+
 	// caught on resizeGL()
 	QSize m_viewportSize;
 
 	// store last position to calc deltas
 	QPoint m_lastMousePosition;
 
+	// xy: position while a button is held, zw: last click, negative while released
+	vec4_t m_mouseState;
+
 	// wether OpenGL 2.0 and shader functions are available.
 	bool m_initSucceeded;
 
@@ -0,0 +1,404 @@
+//=============================================================================
+/** @file		includegraph.cpp
+ *
+ * Implements IIncludeGraph.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QDir>
+#include <QtCore/QDateTime>
+#include <QtCore/QTextStream>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QRegExp>
+#include <QtCore/QCryptographicHash>
+
+#include "application.h"
+#include "includegraph.h"
+
+
+//=============================================================================
+//	CIncludeGraph
+//=============================================================================
+
+/** Implementation of IIncludeGraph.
+ * The nodes are keyed by canonical path, so a file reached
+ * over different relative paths is read only once.
+ */
+class CIncludeGraph : public IIncludeGraph
+{
+public:
+	CIncludeGraph( const QString & searchDirectory );
+	virtual ~CIncludeGraph( void );
+
+	// IIncludeGraph interface
+	bool expand( const QString & source, const QString & fileName,
+				 QString & expanded, QStringList & files, QString & error );
+
+private:
+
+	/** A file as it was read last time. */
+	class Node
+	{
+	public:
+		Node( void ) : size( 0 ) {}
+
+		QDateTime	modified;
+		qint64		size;
+		QByteArray	hash;
+		QString		text;
+	};
+
+	/** The last expansion of a source, reused while the source and
+	 * the included files have the same hashes. */
+	class CachedExpansion
+	{
+	public:
+		QByteArray			sourceHash;
+		QString				text;
+		QStringList			files;
+		QList< QByteArray >	fileHashes;	// of files[ 1.. ]
+	};
+
+	/** State of one expand() call. */
+	class Expansion
+	{
+	public:
+		Expansion( void ) : lineBias( 0 ) {}
+
+		QString		text;
+		QStringList	files;		// by source string number
+		QStringList	stack;		// files being expanded, to find cycles
+		QString		error;
+		int			lineBias;	// added to the #line numbers
+	};
+
+	bool	expandText( const QString & text, const QString & directory, int fileIndex, Expansion & e );
+	bool	parseInclude( const QString & line, QString & name );
+	QString	findFile( const QString & name, const QString & directory );
+	bool	readFile( const QString & path, QString & text, QByteArray & hash );
+	bool	isCurrent( const CachedExpansion & cached );
+
+	QString					m_searchDirectory;
+	QHash< QString, Node >	m_nodes;
+	QHash< QString, CachedExpansion > m_expansions;	// by file name of the source
+	QRegExp					m_includeExp;
+	QRegExp					m_versionExp;
+};
+
+
+// construction
+CIncludeGraph::CIncludeGraph( const QString & searchDirectory )
+ : m_searchDirectory( searchDirectory ),
+   m_includeExp( "^\\s*#\\s*include\\s*[\"<]([^\">]+)[\">]" ),
+   m_versionExp( "#\\s*version\\s+(\\d+)" )
+{
+}
+
+// destruction
+CIncludeGraph::~CIncludeGraph( void )
+{
+}
+
+
+/*
+========================
+IIncludeGraph::create
+========================
+*/
+IIncludeGraph* IIncludeGraph::create( const QString & searchDirectory )
+{
+	return new CIncludeGraph( searchDirectory );
+}
+
+
+/*
+========================
+expand
+========================
+*/
+bool CIncludeGraph::expand( const QString & source, const QString & fileName,
+							QString & expanded, QStringList & files, QString & error )
+{
+	files.clear();
+	files.append( fileName );
+
+	// most sources include nothing
+	if( !source.contains( "include" ) )
+	{
+		expanded = source;
+		return true;
+	}
+
+	// reuse the last expansion, if nothing changed
+	QByteArray sourceHash = QCryptographicHash::hash( source.toUtf8(), QCryptographicHash::Sha1 );
+	QHash< QString, CachedExpansion >::iterator cached = m_expansions.find( fileName );
+	if( cached != m_expansions.end() &&
+		cached.value().sourceHash == sourceHash &&
+		isCurrent( cached.value() ) )
+	{
+		expanded = cached.value().text;
+		files = cached.value().files;
+		return true;
+	}
+
+	Expansion e;
+	e.files = files;
+
+	// before GLSL 3.30, #line numbers the line of the directive itself
+	int version = 110;
+	if( m_versionExp.indexIn( source ) >= 0 ) {
+		version = m_versionExp.cap( 1 ).toInt();
+	}
+	e.lineBias = ( version >= 330 ) ? 0 : -1;
+
+	QString directory;
+	if( !fileName.isEmpty() )
+	{
+		QFileInfo info( fileName );
+		directory = info.absolutePath();
+		e.stack.append( info.canonicalFilePath() );
+	}
+
+	if( !expandText( source, directory, 0, e ) )
+	{
+		error = e.error;
+		return false;
+	}
+
+	expanded = e.text;
+	files = e.files;
+
+	CachedExpansion & entry = m_expansions[ fileName ];
+	entry.sourceHash = sourceHash;
+	entry.text = e.text;
+	entry.files = e.files;
+	entry.fileHashes.clear();
+	for( int i = 1 ; i < e.files.size() ; i++ ) {
+		entry.fileHashes.append( m_nodes.value( e.files[ i ] ).hash );
+	}
+
+	return true;
+}
+
+
+/*
+========================
+isCurrent
+
+ true if every included file still has the hash it had when the
+ expansion was made. Re-reads only files whose time or size changed.
+========================
+*/
+bool CIncludeGraph::isCurrent( const CachedExpansion & cached )
+{
+	for( int i = 0 ; i < cached.fileHashes.size() ; i++ )
+	{
+		QString text;
+		QByteArray hash;
+		if( !readFile( cached.files[ i + 1 ], text, hash ) || hash != cached.fileHashes[ i ] )
+			return false;
+	}
+
+	return true;
+}
+
+
+/*
+========================
+expandText
+
+ appends text to e.text, with the includes replaced recursively.
+========================
+*/
+bool CIncludeGraph::expandText( const QString & text, const QString & directory, int fileIndex, Expansion & e )
+{
+	QStringList lines = text.split( '\n' );
+
+	for( int i = 0 ; i < lines.size() ; i++ )
+	{
+		QString name;
+		if( !parseInclude( lines[ i ], name ) )
+		{
+			e.text += lines[ i ];
+			if( i + 1 < lines.size() ) {
+				e.text += '\n';
+			}
+			continue;
+		}
+
+		QString file = e.files[ fileIndex ].isEmpty() ? QString( "source" ) : QFileInfo( e.files[ fileIndex ] ).fileName();
+		QString location = QString( "%1(%2)" ).arg( file ).arg( i + 1 );
+
+		QString path = findFile( name, directory );
+		if( path.isEmpty() )
+		{
+			e.error = QString( "ERROR: %1: can't find the include file \"%2\"\n" ).arg( location ).arg( name );
+			return false;
+		}
+		if( e.stack.contains( path ) )
+		{
+			e.error = QString( "ERROR: %1: \"%2\" includes itself\n" ).arg( location ).arg( name );
+			return false;
+		}
+
+		QString included;
+		QByteArray hash;
+		if( !readFile( path, included, hash ) )
+		{
+			e.error = QString( "ERROR: %1: can't read the include file \"%2\"\n" ).arg( location ).arg( name );
+			return false;
+		}
+
+		// the number of a file stays the same if it is included again
+		int index = e.files.indexOf( path );
+		if( index < 0 )
+		{
+			index = e.files.size();
+			e.files.append( path );
+		}
+
+		e.text += QString( "#line %1 %2\n" ).arg( 1 + e.lineBias ).arg( index );
+
+		e.stack.append( path );
+		if( !expandText( included, QFileInfo( path ).absolutePath(), index, e ) )
+			return false;
+		e.stack.removeLast();
+
+		// back to the line after the directive
+		if( !e.text.endsWith( '\n' ) ) {
+			e.text += '\n';
+		}
+		e.text += QString( "#line %1 %2\n" ).arg( i + 2 + e.lineBias ).arg( fileIndex );
+	}
+
+	return true;
+}
+
+
+/*
+========================
+parseInclude
+========================
+*/
+bool CIncludeGraph::parseInclude( const QString & line, QString & name )
+{
+	if( m_includeExp.indexIn( line ) < 0 )
+		return false;
+
+	name = m_includeExp.cap( 1 ).trimmed();
+	return !name.isEmpty();
+}
+
+
+/*
+========================
+findFile
+
+ returns the canonical path, empty if the file does not exist.
+========================
+*/
+QString CIncludeGraph::findFile( const QString & name, const QString & directory )
+{
+	if( !directory.isEmpty() )
+	{
+		QFileInfo info( QDir( directory ), name );
+		if( info.isFile() )
+			return info.canonicalFilePath();
+	}
+
+	QFileInfo info( QDir( m_searchDirectory ), name );
+	if( info.isFile() )
+		return info.canonicalFilePath();
+
+	return QString();
+}
+
+
+/*
+========================
+readFile
+
+ returns the cached text if the file is unchanged. The hash tells a touched
+ file with the same contents from an edited one.
+========================
+*/
+bool CIncludeGraph::readFile( const QString & path, QString & text, QByteArray & hash )
+{
+	QFileInfo info( path );
+
+	QHash< QString, Node >::iterator it = m_nodes.find( path );
+	if( it != m_nodes.end() &&
+		it.value().modified == info.lastModified() &&
+		it.value().size == info.size() )
+	{
+		text = it.value().text;
+		hash = it.value().hash;
+		return true;
+	}
+
+	QFile file( path );
+	if( !file.open( QFile::ReadOnly | QFile::Text ) )
+		return false;
+
+	QTextStream in( &file );
+	text = in.readAll();
+
+	hash = QCryptographicHash::hash( text.toUtf8(), QCryptographicHash::Sha1 );
+
+	Node & node = m_nodes[ path ];
+	node.modified = info.lastModified();
+	node.size = info.size();
+	node.hash = hash;
+	node.text = text;
+
+	return true;
+}
+
+
+/*
+========================
+IIncludeGraph::mapLog
+========================
+*/
+QString IIncludeGraph::mapLog( const QString & log, const QStringList & files )
+{
+	// without includes the numbers are unchanged
+	if( files.size() < 2 )
+		return log;
+
+	// "0(12)" and "0:12", optionally after "ERROR: " or "WARNING: "
+	QRegExp exp( "(^|\\n)((ERROR|WARNING): )?(\\d+)[:(](\\d+)" );
+
+	QString result;
+	int last = 0;
+	int pos = 0;
+	while( ( pos = exp.indexIn( log, pos ) ) != -1 )
+	{
+		int index = exp.cap( 4 ).toInt();
+		int numberPos = exp.pos( 4 );
+
+		if( index >= 0 && index < files.size() && !files[ index ].isEmpty() )
+		{
+			result += log.mid( last, numberPos - last );
+			result += QFileInfo( files[ index ] ).fileName();
+			last = numberPos + exp.cap( 4 ).length();
+		}
+
+		pos += qMax( exp.matchedLength(), 1 );
+	}
+	result += log.mid( last );
+
+	return result;
+}
+
@@ -0,0 +1,76 @@
+//=============================================================================
+/** @file		includegraph.h
+ *
+ * Defines the #include preprocessing of GLSL sources.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#ifndef __INCLUDEGRAPH_H_INCLUDED__
+#define __INCLUDEGRAPH_H_INCLUDED__
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+
+//=============================================================================
+//	IIncludeGraph
+//=============================================================================
+
+/** Replaces the #include "file" and #include <file> directives of GLSL
+ * sources with the contents of the files. A file is searched relative to
+ * the including file first, then in the search directory.
+ * \n\n
+ * The included files are numbered in the order they are first included,
+ * the main source is number 0. #line directives with these numbers keep
+ * the line numbers of the compiler log intact, mapLog() replaces the
+ * numbers with the file names.
+ * \n\n
+ * Every file is read once and kept with its modification time, size and
+ * hash. It is read again only if the time or the size changed. The last
+ * expansion of each source is kept with the hashes of its files, and it is
+ * returned without expanding again while none of them changed, e.g. if a
+ * file was only touched. Unchanged includes expand to the same text, so
+ * the shader object cache of IShader compiles only the stages that depend
+ * on an edited file.
+ */
+class IIncludeGraph
+{
+public:
+	/** Creates an IIncludeGraph object.
+	 * @param searchDirectory Searched after the directory of the including file.
+	 */
+	static IIncludeGraph* create( const QString & searchDirectory );
+	virtual ~IIncludeGraph( void ) {} ///< Destructor.
+
+	/** Expands the #include directives of a source.
+	 * A source without directives is returned unchanged.
+	 * @param source The source code.
+	 * @param fileName The file of the source, empty if it was not saved.
+	 * @param expanded Receives the expanded source.
+	 * @param files Receives the file of each source string number,
+	 *			starting with fileName.
+	 * @param error Receives the message if an include fails.
+	 * @return False if a file could not be found or read, or includes itself.
+	 */
+	virtual bool expand( const QString & source, const QString & fileName,
+						 QString & expanded, QStringList & files, QString & error ) = 0;
+
+	/** Replaces the source string numbers of a compiler log with the file names.
+	 * Understands the "0(12)" and the "0:12" formats.
+	 * @param log The compiler log of an expanded source.
+	 * @param files The files returned by expand().
+	 */
+	static QString mapLog( const QString & log, const QStringList & files );
+};
+
+
+#endif	// __INCLUDEGRAPH_H_INCLUDED__
+
@@ -31,6 +31,7 @@
 
 #include "application.h"
 #include "programwindow.h"
+#include "batch.h"
 
 /** @mainpage Documentation / User's manual
 
@@ -277,6 +278,17 @@ and transforming a tangent space vector is done with a multiplication:
 vec3 tangentVector = ... \n
 vec3 modelVector = tangentToModelMatrix * tangentVector; \n
 
+Other custom attributes are matched to the program by name. The sphere and the torus provide
+
+attribute vec2 attrCurvature; \n
+
+which stores the mean curvature in x and the gaussian curvature in y. Meshes loaded from .OBJ files provide
+
+attribute vec3 attrFaceNormal; \n
+
+which stores the normal of the face, e.g. for flat shading.
+Attributes a model provides but the program does not read are not sent to OpenGL.
+
 */
 
 
@@ -446,6 +458,7 @@ QString extractFileNameFromPath( const QString & path )
 /**  C style application entry point.
  * Creates a QApplication and a CProgramWindow object and runs them.
  * Calls init() and shutdown() on the program window.
+ * With --batch, no window is created, see runBatchMode().
  *
  * @param argc    argument count
  * @param argv    arguments
@@ -457,9 +470,18 @@ int main( int argc, char* argv[] )
 {
 	int code = -1;
 
+	// headless, a crashing driver must not show a message box
+	if( runBatchMode( argc, argv, code ) )
+		return code;
+
 	// setup signal handler on UNIX style systems
 	setupSignalHandler();
 
+#if QT_VERSION >= 0x040800
+	// the programs are linked on a worker thread with its own context
+	QApplication::setAttribute( Qt::AA_X11InitThreads );
+#endif
+
 	// init application object
 	QApplication app( argc, argv );
 
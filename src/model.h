@@ -40,12 +40,14 @@ public:
 	// factory
 	static IModel* createPoint( void ); // a single point located in the origin.
     static IModel* createPlane( void );
-    static IModel* createPlane( int level );
+    static IModel* createPlane( int numQuadsX, int numQuadsY ); // a grid of numQuadsX * numQuadsY quads.
     static IModel* createLineStrip (QString name, GLenum op);
 	static IModel* createCube ( void );
-    static IModel* createCube ( int level );
+    static IModel* createCube ( int numQuadsX, int numQuadsY ); // each face is a grid like createPlane().
 	static IModel* createSphere( int numRings, int numSegments, float radius );
 	static IModel* createTorus ( int numRings, int numSegments, float radius1, float radius2  );
+	static IModel* createTwistingCylinder( int numRings, int numSegments, float radius, float height, int numBones ); // skinned, see animate().
+	static IModel* createMorphingSphere( int numRings, int numSegments, float radius ); // morph targets, see animate().
 	virtual ~IModel( void ) {} ///< Destructor.
 
 	/** Returns the name of this model. */
@@ -67,22 +69,37 @@ public:
 	virtual void render( const VertexAttribLocations * attribs = NULL,
 						 const vec4_t * overrideColor = NULL ) = 0;
 
+	/** Draws several instances of the model with a single draw call.
+	 * The caller must setup the per-instance vertex attributes.
+	 * The model's vertex colors are used.
+	 *
+	 * @param attribs Custom vertex attribute locations, see render().
+	 * @param numInstances Number of instances to draw.
+	 * @return False if the model or the OpenGL driver does not support
+	 *         instanced drawing. Nothing is drawn in that case.
+	 */
+	virtual bool renderInstanced( const VertexAttribLocations * attribs, int numInstances ) = 0;
+
 	/** Draws the vertex normals stored in this model.
 	 * If no normal are available, this call has no effect.
 	 * It loops through all vertices and draws a colored line starting
 	 * at the vertex position and pointing into the normal's direction.
 	 * The colors are chosen from the largest component:
 	 *  x == red, Y == green, Z == blue.
+	 * @param lengthScale Scale factor for the default line length.
+	 * @param step Only every step-th vertex is drawn.
 	 */
-	virtual void renderNormals( void ) = 0;
+	virtual void renderNormals( float lengthScale = 1.0f, int step = 1 ) = 0;
 
 	/** Draw vertex tangent space basis stored in this model.
 	 * If no tangent space vectors are available,
 	 * this call has no effect. Otherwise it draws a line from the vertex position
 	 * in the direction of each tangent space vector.
 	 * Tangent == red, Bitangent == green, Normal == blue.
+	 * @param lengthScale Scale factor for the default line length.
+	 * @param step Only every step-th vertex is drawn.
 	 */
-	virtual void renderTangents( void ) = 0;
+	virtual void renderTangents( float lengthScale = 1.0f, int step = 1 ) = 0;
 
 	/** Returns the primitive type of this model.
 	 * It assumes that the model is constructed of only one primitive type.
@@ -96,11 +113,35 @@ public:
 	 */
 	virtual QString getPrimitiveTypeName( void ) = 0;
 
+	/** Returns the number of primitives drawn by render().
+	 * Strips and fans are counted as the number of separate primitives
+	 * they produce, e.g. the triangles of a triangle strip.
+	 */
+	virtual int getNumPrimitives( void ) = 0;
+
 	/** Returns the bounding radius of this model.
 	 * @return A bounding sphere radius that can be used for culling, etc.
 	 */
 	virtual float getBoundingRadius( void ) = 0;
 
+	/** Returns the amount of memory used by the model's geometry in bytes,
+	 * including the buffer objects created so far.
+	 * This is used to limit the size of the model cache, see IModelCache.
+	 */
+	virtual size_t getMemoryUsage( void ) = 0;
+
+	/** Deforms the vertices of animated models.
+	 * Static models ignore this call.
+	 * @param time Animation time in seconds.
+	 * @return True if the vertices were modified.
+	 */
+	virtual bool animate( float time ) = 0;
+
+	/** Returns the number of bytes sent to OpenGL since the last call.
+	 * The counter is reset to zero by this call.
+	 */
+	virtual int getUploadedBytes( void ) = 0;
+
 	/** Returns the bounding box of this model.
 	 * The bounding box is defined by minimum and maximum coordinates.
 	 * @param mins Buffer to store the minimum coordiantes of the bounding box.
@@ -129,6 +170,9 @@ public:
  * It scales the model to fit into a unit shere. Missing attributes are
  * filled with default values. \n
  * \n
+ * Like IVertexStream, a mesh stores named custom attributes, see addAttribute().
+ * The loader declares 'attrFaceNormal', the normal of the face a corner belongs to.
+ * \n
  * \n
  * This class does not support loading of external material files, because
  * IModel does not support material properties. Materials must be set by the user
@@ -146,6 +190,30 @@ public:
 	 * @return Ture if loading succeeded, flase otherwise.
 	 */
 	virtual bool loadObjModel( const QString & fileName ) = 0;
+
+	/** Adds a named custom vertex attribute array.
+	 * The array stores one value per face corner. On render() it is written
+	 * into the display lists if the program has an active attribute with the
+	 * same name, otherwise it costs nothing but memory.
+	 * The display lists are rebuilt on the next render().
+	 * @param name Name of the GLSL attribute.
+	 * @param numComponents Number of float components per corner, 1 to 4.
+	 * @return Index of the attribute for attribute(), -1 if the parameters are
+	 *         invalid, no model is loaded, or the name exists with another size.
+	 */
+	virtual int addAttribute( const QString & name, int numComponents ) = 0;
+
+	/** Returns the index of a custom attribute, -1 if there is none with this name. */
+	virtual int findAttribute( const QString & name ) = 0;
+
+	/** Returns a custom attribute array and schedules a display list rebuild.
+	 * The array stores getNumCorners() tightly packed elements.
+	 * @return The array, NULL if the index is invalid.
+	 */
+	virtual float* attribute( int index ) = 0;
+
+	/** Returns the number of face corners, the size of the custom attribute arrays. */
+	virtual int getNumCorners( void ) = 0;
 };
 
 
@@ -0,0 +1,221 @@
+//=============================================================================
+/** @file		modelbuilder.cpp
+ *
+ * Implements IModelBuilder.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#include <QtCore/QThread>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#include <QtCore/QList>
+#include <QtCore/QHash>
+
+#include "application.h"
+#include "model.h"
+#include "modelbuilder.h"
+
+
+//=============================================================================
+//	CModelBuilder
+//=============================================================================
+
+/** Implementation of IModelBuilder.
+ * The thread sleeps while the queue is empty. All members
+ * except the thread itself are protected by m_mutex.
+ */
+class CModelBuilder : public IModelBuilder, private QThread
+{
+public:
+	CModelBuilder( void );
+	virtual ~CModelBuilder( void );
+
+	// IModelBuilder interface
+	void	enqueue( int slot, IModelJob* job );
+	void	prioritize( int slot );
+	IModel*	takeModel( int slot );
+	int		getNumPending( void );
+
+private:
+
+	/** A queued job. */
+	class Entry
+	{
+	public:
+		Entry( int Slot=-1, IModelJob* Job=NULL ) : slot( Slot ), job( Job ) {}
+
+		int			slot;
+		IModelJob*	job;
+	};
+
+	// the worker thread
+	void run( void );
+
+	QMutex					m_mutex;
+	QWaitCondition			m_wake;		// signaled on new jobs and on quit
+	QList< Entry >			m_queue;
+	QHash< int, IModel* >	m_done;		// finished models, keyed by slot
+	int						m_numRunning;
+	bool					m_quit;
+};
+
+
+// construction
+CModelBuilder::CModelBuilder( void )
+ : m_numRunning( 0 ), m_quit( false )
+{
+}
+
+// destruction
+CModelBuilder::~CModelBuilder( void )
+{
+	m_mutex.lock();
+	m_quit = true;
+	for( int i = 0 ; i < m_queue.size() ; i++ ) {
+		SAFE_DELETE( m_queue[ i ].job );
+	}
+	m_queue.clear();
+	m_wake.wakeAll();
+	m_mutex.unlock();
+
+	// finishes the current job
+	wait();
+
+	// the models have no buffer objects yet, so no context is needed.
+	QHash< int, IModel* >::iterator it;
+	for( it = m_done.begin() ; it != m_done.end() ; ++it ) {
+		SAFE_DELETE( it.value() );
+	}
+	m_done.clear();
+}
+
+
+/*
+========================
+IModelBuilder::create
+========================
+*/
+IModelBuilder* IModelBuilder::create( void )
+{
+	return new CModelBuilder();
+}
+
+
+/*
+========================
+enqueue
+========================
+*/
+void CModelBuilder::enqueue( int slot, IModelJob* job )
+{
+	if( job == NULL )
+		return;
+
+	m_mutex.lock();
+	m_queue.append( Entry( slot, job ) );
+	m_wake.wakeAll();
+	m_mutex.unlock();
+
+	if( !isRunning() ) {
+		start( QThread::LowPriority );
+	}
+}
+
+
+/*
+========================
+prioritize
+========================
+*/
+void CModelBuilder::prioritize( int slot )
+{
+	m_mutex.lock();
+	for( int i = 1 ; i < m_queue.size() ; i++ )
+	{
+		if( m_queue[ i ].slot == slot )
+		{
+			m_queue.move( i, 0 );
+			break;
+		}
+	}
+	m_mutex.unlock();
+}
+
+
+/*
+========================
+takeModel
+========================
+*/
+IModel* CModelBuilder::takeModel( int slot )
+{
+	m_mutex.lock();
+	IModel* model = m_done.take( slot );
+	m_mutex.unlock();
+
+	return model;
+}
+
+
+/*
+========================
+getNumPending
+========================
+*/
+int CModelBuilder::getNumPending( void )
+{
+	m_mutex.lock();
+	int n = m_queue.size() + m_numRunning + m_done.size();
+	m_mutex.unlock();
+
+	return n;
+}
+
+
+/*
+========================
+run
+
+ takes jobs from the front of the queue until m_quit is set.
+========================
+*/
+void CModelBuilder::run( void )
+{
+	m_mutex.lock();
+
+	for( ;; )
+	{
+		while( m_queue.isEmpty() && !m_quit ) {
+			m_wake.wait( &m_mutex );
+		}
+
+		if( m_quit )
+			break;
+
+		Entry entry = m_queue.takeFirst();
+		m_numRunning++;
+		m_mutex.unlock();
+
+		IModel* model = entry.job->build();
+		delete entry.job;
+
+		m_mutex.lock();
+		m_numRunning--;
+		if( m_quit ) {
+			SAFE_DELETE( model );
+		} else {
+			m_done.insert( entry.slot, model );
+		}
+	}
+
+	m_mutex.unlock();
+}
+
@@ -0,0 +1,88 @@
+//=============================================================================
+/** @file		modelbuilder.h
+ *
+ * Defines a worker thread that builds test models in the background.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#ifndef __MODELBUILDER_H_INCLUDED__
+#define __MODELBUILDER_H_INCLUDED__
+
+// forward declarations
+class IModel;
+
+
+//=============================================================================
+//	IModelJob
+//=============================================================================
+
+/** Builds a single model on the worker thread of an IModelBuilder.
+ * The IModel factory methods only fill client memory, the buffer
+ * objects are created by the first render() call, so they can be
+ * called without an OpenGL context. Jobs must not call OpenGL.
+ */
+class IModelJob
+{
+public:
+	virtual ~IModelJob( void ) {} ///< Destructor.
+
+	/** Builds the model, called on the worker thread. */
+	virtual IModel* build( void ) = 0;
+};
+
+
+//=============================================================================
+//	IModelBuilder
+//=============================================================================
+
+/** Builds models on a worker thread, in the order they were queued.
+ * Every job is identified by a slot number chosen by the caller, the
+ * finished model is picked up with takeModel(). A slot can be moved to
+ * the front of the queue, e.g. when the user selects a model that is
+ * not built yet.
+ * \n\n
+ * The worker runs parallelFor() loops like any other thread, so the
+ * factory methods use all cores.
+ */
+class IModelBuilder
+{
+public:
+	/** Creates an IModelBuilder object, the thread is started by the first job. */
+	static IModelBuilder* create( void );
+
+	/** Destructor. Waits for the current job, drops the queued ones
+	 * and deletes the models that were not taken.
+	 */
+	virtual ~IModelBuilder( void ) {}
+
+	/** Queues a job.
+	 * @param slot Identifies the model, must not be queued twice.
+	 * @param job The job, it is deleted by the builder.
+	 */
+	virtual void enqueue( int slot, IModelJob* job ) = 0;
+
+	/** Moves a queued job to the front of the queue.
+	 * This call has no effect if the job is already running or done.
+	 */
+	virtual void prioritize( int slot ) = 0;
+
+	/** Returns the finished model of a slot and forgets about it.
+	 * @return NULL if the job is still queued or running, or if there is no such job.
+	 */
+	virtual IModel* takeModel( int slot ) = 0;
+
+	/** Returns the number of jobs whose model was not taken yet. */
+	virtual int getNumPending( void ) = 0;
+};
+
+
+#endif	// __MODELBUILDER_H_INCLUDED__
+
@@ -0,0 +1,269 @@
+//=============================================================================
+/** @file		modelcache.cpp
+ *
+ * Implements IModelCache.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#include <QtCore/QHash>
+
+#include "application.h"
+#include "model.h"
+#include "modelcache.h"
+
+
+//=============================================================================
+//	CModelCache
+//=============================================================================
+
+/** Implementation of IModelCache.
+ * The models are stored in a hash table, keyed by a string built
+ * from the generator name and its parameters, e.g. "plane:64x64".
+ */
+class CModelCache : public IModelCache
+{
+public:
+	CModelCache( size_t memoryBudget );
+	virtual ~CModelCache( void );
+
+	// IModelCache interface
+	IModel* acquirePlane ( int numQuadsX, int numQuadsY );
+	IModel* acquireCube  ( int numQuadsX, int numQuadsY );
+	bool	release( IModel* model );
+	void	setMemoryBudget( size_t memoryBudget );
+	size_t	getMemoryUsage( void ) { return m_memoryUsage; }
+	int		getNumModels( void ) { return m_entries.size(); }
+
+private:
+
+	/** A cached model. */
+	class Entry
+	{
+	public:
+		Entry( IModel* Model=NULL, size_t Size=0 )
+		{
+			model = Model; size = Size; numRefs = 0; lastUse = 0;
+		}
+
+		IModel*	model;
+		size_t	size;		// memory usage in bytes
+		int		numRefs;	// number of acquire calls without release
+		int		lastUse;	// value of m_useCounter at the last acquire call
+	};
+
+	// cache management
+	IModel* lookup( const QString & key );
+	IModel* insert( const QString & key, IModel* model );
+	void	evict( void );
+
+	QHash< QString, Entry >		m_entries;
+	QHash< IModel*, QString >	m_keys;			// reverse lookup for release()
+	size_t						m_memoryBudget;
+	size_t						m_memoryUsage;
+	int							m_useCounter;	// increased on every acquire call
+};
+
+
+// construction
+CModelCache::CModelCache( size_t memoryBudget )
+ : m_memoryBudget( memoryBudget ), m_memoryUsage( 0 ), m_useCounter( 0 )
+{
+}
+
+// destruction
+CModelCache::~CModelCache( void )
+{
+	QHash< QString, Entry >::iterator it;
+	for( it = m_entries.begin() ; it != m_entries.end() ; ++it )
+	{
+		SAFE_DELETE( it.value().model );
+	}
+
+	m_entries.clear();
+	m_keys.clear();
+	m_memoryUsage = 0;
+}
+
+
+/*
+========================
+IModelCache::create
+========================
+*/
+IModelCache* IModelCache::create( size_t memoryBudget )
+{
+	return new CModelCache( memoryBudget );
+}
+
+
+/*
+========================
+lookup
+
+ returns the cached model and adds a reference, NULL if not cached.
+========================
+*/
+IModel* CModelCache::lookup( const QString & key )
+{
+	QHash< QString, Entry >::iterator it = m_entries.find( key );
+	if( it == m_entries.end() )
+		return NULL;
+
+	it.value().numRefs++;
+	it.value().lastUse = ++m_useCounter;
+	return it.value().model;
+}
+
+
+/*
+========================
+insert
+
+ stores a new model with one reference.
+========================
+*/
+IModel* CModelCache::insert( const QString & key, IModel* model )
+{
+	Entry entry( model, model->getMemoryUsage() );
+	entry.numRefs = 1;
+	entry.lastUse = ++m_useCounter;
+
+	m_entries.insert( key, entry );
+	m_keys.insert( model, key );
+	m_memoryUsage += entry.size;
+
+	// make room for the new model
+	evict();
+
+	return model;
+}
+
+
+/*
+========================
+evict
+
+ deletes the least recently used unreferenced models
+ until the cache fits into the memory budget.
+========================
+*/
+void CModelCache::evict( void )
+{
+	while( m_memoryUsage > m_memoryBudget )
+	{
+		// find the oldest unused entry
+		QHash< QString, Entry >::iterator oldest = m_entries.end();
+		QHash< QString, Entry >::iterator it;
+
+		for( it = m_entries.begin() ; it != m_entries.end() ; ++it )
+		{
+			if( it.value().numRefs > 0 )
+				continue;
+
+			if( oldest == m_entries.end() || it.value().lastUse < oldest.value().lastUse ) {
+				oldest = it;
+			}
+		}
+
+		// everything is in use
+		if( oldest == m_entries.end() )
+			break;
+
+		m_memoryUsage -= oldest.value().size;
+		m_keys.remove( oldest.value().model );
+		SAFE_DELETE( oldest.value().model );
+		m_entries.erase( oldest );
+	}
+}
+
+
+/*
+========================
+release
+
+ updates the memory usage of the model, it may have grown while in use.
+========================
+*/
+bool CModelCache::release( IModel* model )
+{
+	if( model == NULL )
+		return true;
+
+	QHash< IModel*, QString >::iterator key = m_keys.find( model );
+	if( key == m_keys.end() )
+		return false;
+
+	QHash< QString, Entry >::iterator it = m_entries.find( key.value() );
+	if( it != m_entries.end() )
+	{
+		if( it.value().numRefs > 0 ) {
+			it.value().numRefs--;
+		}
+
+		// the buffer objects and debug lines are created by render(),
+		// after the model was inserted, so measure it again.
+		size_t size = model->getMemoryUsage();
+		m_memoryUsage = m_memoryUsage - it.value().size + size;
+		it.value().size = size;
+	}
+
+	evict();
+	return true;
+}
+
+
+/*
+========================
+setMemoryBudget
+========================
+*/
+void CModelCache::setMemoryBudget( size_t memoryBudget )
+{
+	m_memoryBudget = memoryBudget;
+	evict();
+}
+
+
+/*
+========================
+acquirePlane
+========================
+*/
+IModel* CModelCache::acquirePlane( int numQuadsX, int numQuadsY )
+{
+	QString key = QString( "plane:%1x%2" ).arg( numQuadsX ).arg( numQuadsY );
+
+	IModel* model = lookup( key );
+	if( model == NULL ) {
+		model = insert( key, IModel::createPlane( numQuadsX, numQuadsY ) );
+	}
+
+	return model;
+}
+
+
+/*
+========================
+acquireCube
+========================
+*/
+IModel* CModelCache::acquireCube( int numQuadsX, int numQuadsY )
+{
+	QString key = QString( "cube:%1x%2" ).arg( numQuadsX ).arg( numQuadsY );
+
+	IModel* model = lookup( key );
+	if( model == NULL ) {
+		model = insert( key, IModel::createCube( numQuadsX, numQuadsY ) );
+	}
+
+	return model;
+}
+
@@ -0,0 +1,82 @@
+//=============================================================================
+/** @file		modelcache.h
+ *
+ * Defines a cache for procedural test models.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#ifndef __MODELCACHE_H_INCLUDED__
+#define __MODELCACHE_H_INCLUDED__
+
+#include <stddef.h>
+#include <QtCore/QString>
+
+// forward declarations
+class IModel;
+
+
+//=============================================================================
+//	IModelCache
+//=============================================================================
+
+/** A cache for the procedural models created by the IModel factory methods.
+ * It holds the models that depend on the vertex density, the plane and
+ * the cube. The others are built once by the model builder.
+ * The models are identified by the generator and its parameters, so asking
+ * twice for the same model returns the same object, without building the
+ * geometry again.
+ * \n\n
+ * The cache counts references: every acquire call must be paired with a
+ * release() call. Released models stay in the cache until the sum of the
+ * memory used by all models exceeds the memory budget. Then the least recently
+ * used unreferenced models are deleted. Referenced models are never deleted.
+ * The memory used by a model, including its buffer objects and debug lines,
+ * is measured when it is inserted and again on every release() call.
+ * \n\n
+ * Models are deleted by the cache, so a valid OpenGL rendering context
+ * must be active when calling release(), setMemoryBudget() and the destructor.
+ */
+class IModelCache
+{
+public:
+	/** Creates an IModelCache object.
+	 * @param memoryBudget Amount of memory in bytes the cached models may use.
+	 *        It is only exceeded if the referenced models need more.
+	 */
+	static IModelCache* create( size_t memoryBudget );
+	virtual ~IModelCache( void ) {} ///< Destructor, deletes all models.
+
+	// procedural models, see the IModel factory methods.
+	virtual IModel* acquirePlane ( int numQuadsX, int numQuadsY ) = 0;
+	virtual IModel* acquireCube  ( int numQuadsX, int numQuadsY ) = 0;
+
+	/** Releases a model returned by one of the acquire methods.
+	 * If the model is no longer referenced, it may be deleted if the cache
+	 * exceeds its memory budget.
+	 * @param model The model to release, may be NULL.
+	 * @return False if the model is not managed by this cache, it is not
+	 *         modified in that case.
+	 */
+	virtual bool release( IModel* model ) = 0;
+
+	/** Sets the memory budget in bytes and deletes models that do not fit into it. */
+	virtual void setMemoryBudget( size_t memoryBudget ) = 0;
+
+	/** Returns the amount of memory used by all cached models in bytes. */
+	virtual size_t getMemoryUsage( void ) = 0;
+
+	/** Returns the number of models stored in the cache. */
+	virtual int getNumModels( void ) = 0;
+};
+
+
+#endif	// __MODELCACHE_H_INCLUDED__
+
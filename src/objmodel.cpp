@@ -16,11 +16,15 @@
 #include <QtCore/QFile>
 #include <QtCore/QTextStream>
 #include <QtCore/QTime>
+#include <QtCore/QHash>
+#include <QtCore/QVector>
 #include <QMessageBox>
 #include <QApplication>
 
 #include "application.h"
 #include "model.h"
+#include "tangentspace.h"
+#include "debuglines.h"
 
 
 //=============================================================================
@@ -39,15 +43,24 @@ public:
 	// IModel interface
 	QString getName( void ) { return QString( "Mesh" ); }
 	void    render( const VertexAttribLocations* attribs, const vec4_t * overrideColor );
-	void	renderNormals( void );
-	void	renderTangents( void );
+	bool    renderInstanced( const VertexAttribLocations*, int ) { return false; } // display lists can't be instanced
+	void	renderNormals( float lengthScale, int step );
+	void	renderTangents( float lengthScale, int step );
 	int		getPrimitiveType( void );
 	QString	getPrimitiveTypeName( void );
+	int		getNumPrimitives( void ) { return m_numIndices - 2 * m_numFaces; } // every face is a triangle fan
 	float	getBoundingRadius( void );
 	void	getBoundingBox( vec3_t & mins, vec3_t & maxs );
+	size_t	getMemoryUsage( void );
+	bool	animate( float ) { return false; }
+	int		getUploadedBytes( void ) { return 0; } // display lists are uploaded once
 
 	// IMeshModel interface
 	bool	loadObjModel( const QString & fileName );
+	int		addAttribute( const QString & name, int numComponents );
+	int		findAttribute( const QString & name );
+	float*	attribute( int index );
+	int		getNumCorners( void ) { return m_numIndices; }
 
 	/** Prints mesh statistics to stderr. */
 	void	printStatistics( void ) const;
@@ -95,6 +108,16 @@ private:
 		int startIndex, numIndices;
 	};
 
+	/** A named custom attribute, one value per index. */
+	class CustomAttribute
+	{
+	public:
+		QString	name;
+		int		numComponents;
+		float*	data;		// [ m_numIndices * numComponents ]
+		int		location;	// in the display lists, -1 if not stored
+	};
+
 
 	// misc helpers
 	void    clearContent( void );
@@ -112,12 +135,16 @@ private:
 	void	computeNormals( void );
 	void	computeTexCoords( void );
 	void	computeTangents( void );
+	void	computeFaceNormals( void );
 	void	rescaleModel( void );
 
 	// display lists
 	void	setupDisplayListModel( const VertexAttribLocations & attribs, bool colored );
-	void	setupDisplayListNormals( void );
-	void	setupDisplayListTangents( void );
+	bool	attributeLocationsChanged( const VertexAttribLocations & attribs );
+
+	// debug lines
+	void	setupNormalLines( void );
+	void	setupTangentLines( void );
 
 	// data array sizes
 	int		m_numVertices;
@@ -134,10 +161,15 @@ private:
 	Index*	m_indices;		// [ m_numIndices ]
 	vec3_t*	m_tangents;		// [ m_numIndices ]
 	vec3_t*	m_bitangents;	// [ m_numIndices ]
+	QVector< CustomAttribute > m_attributes;
 
 	// rendering acceleration
-	GLuint	m_displayLists; // +0: model uncolored, +1: model colored, +2: normals, +3: tangents
+	GLuint	m_displayLists; // +0: model uncolored, +1: model colored
 	VertexAttribLocations m_attribsInDL; // values encoded into the display list
+	bool	m_attributesDirty; // a custom attribute was modified or added
+	int		m_attributesSerial; // program serial of the last lookup
+	IDebugLines*	m_normalLines;
+	IDebugLines*	m_tangentLines;
 
 	// metadata
 	int		m_primitiveType; // every mesh must have this type!
@@ -169,6 +201,10 @@ constructor
 CObjModel::CObjModel( void )
 {
 	m_displayLists = 0;
+	m_attributesDirty = false;
+	m_attributesSerial = 0;
+	m_normalLines = NULL;
+	m_tangentLines = NULL;
 	m_primitiveType = GL_POINTS;
 	m_boundingRadius = 0.0f;
 	m_mins = m_maxs = vec3_t( 0,0,0 );
@@ -264,13 +300,17 @@ bool CObjModel::loadObjModel( const QString & fileName )
 	// .OBJ files don't support tangent/bitangent
 	// -> create them now.
 	computeTangents();
+	computeFaceNormals();
 
 	// display lists
-	m_displayLists = glGenLists( 4 );
+	m_displayLists = glGenLists( 2 );
 	setupDisplayListModel( m_attribsInDL, false );
 	setupDisplayListModel( m_attribsInDL, true );
-	setupDisplayListNormals();
-	setupDisplayListTangents();
+	m_attributesDirty = false; // no program reads them yet
+
+	// debug lines
+	setupNormalLines();
+	setupTangentLines();
 
 	// report triangles
 	m_primitiveType = GL_TRIANGLES;
@@ -293,10 +333,13 @@ void CObjModel::clearContent( void )
 	// free display lists
 	if( m_displayLists != 0 )
 	{
-		glDeleteLists( m_displayLists, 3 );
+		glDeleteLists( m_displayLists, 2 );
 		m_displayLists = 0;
 	}
 
+	SAFE_DELETE( m_normalLines );
+	SAFE_DELETE( m_tangentLines );
+
 	SAFE_DELETE_ARRAY( m_vertices );
 	SAFE_DELETE_ARRAY( m_normals );
 	SAFE_DELETE_ARRAY( m_texCoords );
@@ -305,6 +348,13 @@ void CObjModel::clearContent( void )
 	SAFE_DELETE_ARRAY( m_tangents );
 	SAFE_DELETE_ARRAY( m_bitangents );
 
+	for( int i = 0 ; i < m_attributes.size() ; i++ ) {
+		SAFE_DELETE_ARRAY( m_attributes[ i ].data );
+	}
+	m_attributes.clear();
+	m_attributesDirty = false;
+	m_attributesSerial = 0;
+
 	m_numVertices = 0;
 	m_numNormals = 0;
 	m_numTexCoords = 0;
@@ -330,20 +380,32 @@ void CObjModel::render( const VertexAttribLocations* attribs, const vec4_t * ove
 	if( m_displayLists == 0 )
 		return;
 
+	// the fixed function pipeline reads all built-in attributes
+	VertexAttribLocations fixedFunction;
+	if( attribs == NULL ) {
+		attribs = &fixedFunction;
+	}
+
 	// rebuild the display lists when the attrib locations change
-	if( attribs != NULL )
+	// Make sure we don't rebuild the DL if the GLSL program is deactivated!
+	// Only rebuild it, when the actual LOCATIONS changes!
+	// The built-in attributes are rebuilt if the list lacks one, or if a
+	// new program reads fewer of them.
+	bool builtinsMissing = ( attribs->builtins & ~m_attribsInDL.builtins ) != 0;
+	bool builtinsUnused  = attribs->builtins != m_attribsInDL.builtins &&
+						   attribs->programSerial != 0 &&
+						   attribs->programSerial != m_attribsInDL.programSerial;
+	bool attributesChanged = attributeLocationsChanged( *attribs );
+
+	if( ( attribs->tangent != -1 &&
+		  attribs->tangent != m_attribsInDL.tangent ) ||
+		( attribs->bitangent != -1 &&
+		  attribs->bitangent != m_attribsInDL.bitangent ) ||
+		builtinsMissing || builtinsUnused || attributesChanged )
 	{
-		// Make sure we don't rebuild the DL if the GLSL program is deactivated!
-		// Only rebuild it, when the actual LOCATIONS changes!
-		if( ( attribs->tangent != -1 &&
-			  attribs->tangent != m_attribsInDL.tangent ) ||
-			( attribs->bitangent != -1 &&
-			  attribs->bitangent != m_attribsInDL.bitangent ) )
-		{
-		//	fprintf( stderr, "rebuilding DL...\n" );
-			setupDisplayListModel( *attribs, true );
-			setupDisplayListModel( *attribs, false );
-		}
+	//	fprintf( stderr, "rebuilding DL...\n" );
+		setupDisplayListModel( *attribs, true );
+		setupDisplayListModel( *attribs, false );
 	}
 
 	// call the list with/without colors
@@ -365,11 +427,11 @@ void CObjModel::render( const VertexAttribLocations* attribs, const vec4_t * ove
 renderNormals
 ========================
 */
-void CObjModel::renderNormals( void )
+void CObjModel::renderNormals( float lengthScale, int step )
 {
-	if( m_displayLists != 0 )
+	if( m_normalLines != NULL )
 	{
-		glCallList( m_displayLists + 2 );
+		m_normalLines->render( 0.3f * lengthScale, step );
 	}
 }
 
@@ -379,11 +441,11 @@ void CObjModel::renderNormals( void )
 renderTangents
 ========================
 */
-void CObjModel::renderTangents( void )
+void CObjModel::renderTangents( float lengthScale, int step )
 {
-	if( m_displayLists != 0 )
+	if( m_tangentLines != NULL )
 	{
-		glCallList( m_displayLists + 3 );
+		m_tangentLines->render( 0.1f * lengthScale, step );
 	}
 }
 
@@ -427,17 +489,40 @@ void CObjModel::setupDisplayListModel( const VertexAttribLocations & attribs, bo
 				glVertexAttrib3fv( attribs.bitangent, m_bitangents[ f.startIndex + j ].toFloatPointer() );
 			}
 
-			// 'must' attribute
-			if( colored )
+			// named attributes the program reads
+			for( int k = 0 ; k < m_attributes.size() ; k++ )
+			{
+				const CustomAttribute & a = m_attributes[ k ];
+				if( a.location == -1 )
+					continue;
+
+				const float* value = a.data + ( f.startIndex + j ) * a.numComponents;
+				switch( a.numComponents )
+				{
+				case 1: glVertexAttrib1fv( a.location, value ); break;
+				case 2: glVertexAttrib2fv( a.location, value ); break;
+				case 3: glVertexAttrib3fv( a.location, value ); break;
+				case 4: glVertexAttrib4fv( a.location, value ); break;
+				}
+			}
+
+			// only the built-in attributes the program reads
+			if( colored && ( attribs.builtins & VertexAttribLocations::BUILTIN_COLOR ) )
 			{
 				// we are in the unit cube...
 				vec3_t color = vec3_t( 1.0f, 1.0, 1.0f ) - v.absolute();
 				glColor3fv( color.toFloatPointer() );
 			}
 
-			glTexCoord2fv( m_texCoords[ idx.t ].toFloatPointer() );
-			glNormal3fv  ( m_normals[ idx.n ].toFloatPointer() );
-			glVertex3fv  ( v.toFloatPointer() );
+			if( attribs.builtins & VertexAttribLocations::BUILTIN_TEXCOORD ) {
+				glTexCoord2fv( m_texCoords[ idx.t ].toFloatPointer() );
+			}
+			if( attribs.builtins & VertexAttribLocations::BUILTIN_NORMAL ) {
+				glNormal3fv( m_normals[ idx.n ].toFloatPointer() );
+			}
+
+			// 'must' attribute
+			glVertex3fv( v.toFloatPointer() );
 		}
 
 		glEnd();
@@ -449,16 +534,112 @@ void CObjModel::setupDisplayListModel( const VertexAttribLocations & attribs, bo
 
 /*
 ========================
-setupDisplayListNormals
+attributeLocationsChanged
+
+ looks up the custom attributes in the program, returns true if the
+ display lists store other locations. A program without named locations
+ keeps the current lists, like the built-in attributes.
+========================
+*/
+bool CObjModel::attributeLocationsChanged( const VertexAttribLocations & attribs )
+{
+	bool changed = m_attributesDirty;
+
+	// look up the names only once per program
+	if( ( attribs.programSerial != 0 && attribs.programSerial != m_attributesSerial ) ||
+		m_attributesDirty )
+	{
+		for( int i = 0 ; i < m_attributes.size() ; i++ )
+		{
+			CustomAttribute & a = m_attributes[ i ];
+			int location = attribs.find( a.name );
+			if( location != a.location )
+			{
+				a.location = location;
+				changed = true;
+			}
+		}
+	}
+
+	m_attributesSerial = attribs.programSerial;
+	m_attributesDirty = false;
+	return changed;
+}
+
+
+/*
+========================
+addAttribute
+========================
+*/
+int CObjModel::addAttribute( const QString & name, int numComponents )
+{
+	if( name.isEmpty() || numComponents < 1 || numComponents > 4 || m_numIndices == 0 )
+		return -1;
+
+	// reuse an existing attribute
+	int index = findAttribute( name );
+	if( index != -1 ) {
+		return ( m_attributes[ index ].numComponents == numComponents ) ? index : -1;
+	}
+
+	CustomAttribute a;
+	a.name			= name;
+	a.numComponents	= numComponents;
+	a.data			= new float[ m_numIndices * numComponents ];
+	a.location		= -1;
+	memset( a.data, 0, m_numIndices * numComponents * sizeof( float ) );
+
+	m_attributes.append( a );
+	m_attributesDirty = true;
+	return m_attributes.size() - 1;
+}
+
+
+/*
+========================
+findAttribute
+========================
+*/
+int CObjModel::findAttribute( const QString & name )
+{
+	for( int i = 0 ; i < m_attributes.size() ; i++ )
+	{
+		if( m_attributes[ i ].name == name )
+			return i;
+	}
+
+	return -1;
+}
+
+
+/*
+========================
+attribute
 ========================
 */
-void CObjModel::setupDisplayListNormals( void )
+float* CObjModel::attribute( int index )
+{
+	if( index < 0 || index >= m_attributes.size() )
+		return NULL;
+
+	m_attributesDirty = true;
+	return m_attributes[ index ].data;
+}
+
+
+/*
+========================
+setupNormalLines
+========================
+*/
+void CObjModel::setupNormalLines( void )
 {
 	if( m_numNormals <= 0 )
 		return;
 
-	glNewList( m_displayLists + 2, GL_COMPILE );
-	glBegin( GL_LINES );
+	m_normalLines = IDebugLines::create();
+	m_normalLines->begin( m_numIndices );
 
 	//
 	// for each face
@@ -470,47 +651,29 @@ void CObjModel::setupDisplayListNormals( void )
 		// for each index
 		for( int j = 0 ; j < f.numIndices ; j++ )
 		{
-			const Index & idx = m_indices[ f.startIndex + j ];
-			const vec3_t & v = m_vertices[ idx.v ];
-			const vec3_t & n = m_normals [ idx.n ];
-
-			float x = fabs( n.x );
-			float y = fabs( n.y );
-			float z = fabs( n.z );
-
-			// select max. component as color
-			if( x > y && x > z ) {
-				glColor3f( 1,0,0 );
-			} else if( y > x && y > z ) {
-				glColor3f( 0,1,0 );
-			} else if( z > x && z > y ) {
-				glColor3f( 0,0,1 );
-			} else { // two components equal
-				glColor3f( 1,1,1 );
-			}
+			int k = f.startIndex + j;
+			const Index & idx = m_indices[ k ];
+			const vec3_t & n = m_normals[ idx.n ];
 
-			glVertex3fv( v.toFloatPointer() );
-			glVertex3fv( ( v + n * 0.3f ).toFloatPointer() );
+			m_normalLines->setLine( k, m_vertices[ idx.v ], n, debugNormalColor( n ) );
 		}
 	}
 
-	glEnd();
-	glEndList();
+	m_normalLines->end();
 }
 
 
 /*
 ========================
-setupDisplayListTangens
+setupTangentLines
 ========================
 */
-void CObjModel::setupDisplayListTangents( void )
+void CObjModel::setupTangentLines( void )
 {
 	int i,j;
-	float length = 0.1f;
 
-	glNewList( m_displayLists + 3, GL_COMPILE );
-	glBegin( GL_LINES );
+	m_tangentLines = IDebugLines::create();
+	m_tangentLines->begin( 3 * m_numIndices, 3 );
 
 	for( i = 0 ; i < m_numFaces ; i++ )
 	{
@@ -520,26 +683,15 @@ void CObjModel::setupDisplayListTangents( void )
 		{
 			int k = f.startIndex + j;
 			const Index & idx = m_indices[ k ];
+			const vec3_t & v = m_vertices[ idx.v ];
 
-			// tangent
-			glColor3f( 1,0,0 );
-			glVertex3fv( m_vertices[ idx.v ].toFloatPointer() );
-			glVertex3fv( ( m_vertices[ idx.v ] + m_tangents[ k ] * length ).toFloatPointer() );
-
-			// bitangent
-			glColor3f( 0,1,0 );
-			glVertex3fv( m_vertices[ idx.v ].toFloatPointer() );
-			glVertex3fv( ( m_vertices[ idx.v ] + m_bitangents[ k ] * length ).toFloatPointer() );
-
-			// normal
-			glColor3f( 0,0,1 );
-			glVertex3fv( m_vertices[ idx.v ].toFloatPointer() );
-			glVertex3fv( ( m_vertices[ idx.v ] + m_normals[ idx.n ] * length ).toFloatPointer() );
+			m_tangentLines->setLine( 3*k + 0, v, m_tangents[ k ],      vec3_t( 1,0,0 ) );
+			m_tangentLines->setLine( 3*k + 1, v, m_bitangents[ k ],    vec3_t( 0,1,0 ) );
+			m_tangentLines->setLine( 3*k + 2, v, m_normals[ idx.n ],   vec3_t( 0,0,1 ) );
 		}
 	}
 
-	glEnd();
-	glEndList();
+	m_tangentLines->end();
 }
 
 
@@ -945,50 +1097,151 @@ computeTangents
 
  Assigns one pair of tangent vectors to every INDEX.
  Data arrrays are already allocated.
- Assumes the tangent data arrays are all zeroed-out.
+ The indices are welded into vertices with unique position, normal and
+ texture coordinate, so faces sharing a vertex share its tangent space.
+ Welded vertices used by mirrored or unconnected faces are split again.
 ========================
 */
 void CObjModel::computeTangents( void )
 {
 	int i,j;
 
-	// compute tangent vectors for every face.
-	for( i = 0 ; i < m_numFaces ; i++ )
+	// weld indices
+	QHash< quint64, int > weldedIndices;
+	int* weld = new int[ m_numIndices ]; // index -> welded vertex
+	int numWelded = 0;
+
+	for( i = 0 ; i < m_numIndices ; i++ )
 	{
-		const Face & f = m_faces[ i ];
+		const Index & idx = m_indices[ i ];
+		quint64 key = ( quint64( qMax( idx.v, 0 ) ) * quint64( m_numNormals + 1 ) + quint64( qMax( idx.n, 0 ) ) ) *
+					  quint64( m_numTexCoords + 1 ) + quint64( qMax( idx.t, 0 ) );
+
+		QHash< quint64, int >::const_iterator it = weldedIndices.constFind( key );
+		if( it == weldedIndices.constEnd() ) {
+			weld[ i ] = numWelded;
+			weldedIndices.insert( key, numWelded++ );
+		} else {
+			weld[ i ] = it.value();
+		}
+	}
 
-		// degenerated face
-		if( f.numIndices < 3 )
-			continue;
+	// vertex arrays
+	vec3_t* positions = new vec3_t[ numWelded ];
+	vec3_t* normals   = new vec3_t[ numWelded ];
+	vec2_t* texCoords = new vec2_t[ numWelded ];
+	vec3_t* tangents  = new vec3_t[ numWelded ];
+	vec3_t* bitangents= new vec3_t[ numWelded ];
 
-		const Index & idx0 = m_indices[ f.startIndex + 0 ];
-		const Index & idx1 = m_indices[ f.startIndex + 1 ];
-		const Index & idx2 = m_indices[ f.startIndex + 2 ];
+	for( i = 0 ; i < m_numIndices ; i++ )
+	{
+		const Index & idx = m_indices[ i ];
+		positions[ weld[ i ] ] = m_vertices [ qMax( idx.v, 0 ) ];
+		normals  [ weld[ i ] ] = m_normals  [ qMax( idx.n, 0 ) ];
+		texCoords[ weld[ i ] ] = m_texCoords[ qMax( idx.t, 0 ) ];
+	}
 
-		vec3_t e1 = m_vertices [ idx1.v ] - m_vertices [ idx0.v ];
-		vec3_t e2 = m_vertices [ idx2.v ] - m_vertices [ idx0.v ];
-		vec2_t t1 = m_texCoords[ idx1.t ] - m_texCoords[ idx0.t ];
-		vec2_t t2 = m_texCoords[ idx2.t ] - m_texCoords[ idx0.t ];
+	// triangulate the faces, they are drawn as triangle fans.
+	int numTriangles = 0;
+	for( i = 0 ; i < m_numFaces ; i++ ) {
+		numTriangles += qMax( m_faces[ i ].numIndices - 2, 0 );
+	}
 
-		float length = t1.y * t2.x - t1.x *t2.y;
-		if( fabs(length) > 0.000001 ) // triangle not degenerated
+	unsigned int* triangles = new unsigned int[ 3 * numTriangles ];
+	unsigned int* t = triangles;
+	for( i = 0 ; i < m_numFaces ; i++ )
+	{
+		const Face & f = m_faces[ i ];
+		for( j = 2 ; j < f.numIndices ; j++ )
 		{
-			// solve linear equations
-			vec3_t planeTangent = ( e2 * t1.y - e1 * t2.y );
+			*t++ = weld[ f.startIndex ];
+			*t++ = weld[ f.startIndex + j - 1 ];
+			*t++ = weld[ f.startIndex + j ];
+		}
+	}
 
-			// adjust tangents to the vertex normal
-			for( j = 0 ; j < f.numIndices ; j++ )
+	// vertices shared by mirrored or unconnected faces get a copy
+	QVector< int > copies;
+	splitTangentGroups( numWelded, positions, texCoords, numTriangles, triangles, copies );
+	if( !copies.isEmpty() )
+	{
+		appendSplitVertices( positions, numWelded, copies );
+		appendSplitVertices( normals,   numWelded, copies );
+		appendSplitVertices( texCoords, numWelded, copies );
+		numWelded += copies.size();
+
+		SAFE_DELETE_ARRAY( bitangents );
+		SAFE_DELETE_ARRAY( tangents );
+		tangents   = new vec3_t[ numWelded ];
+		bitangents = new vec3_t[ numWelded ];
+
+		// the corners of the split faces now use the copies
+		t = triangles;
+		for( i = 0 ; i < m_numFaces ; i++ )
+		{
+			const Face & f = m_faces[ i ];
+			for( j = 2 ; j < f.numIndices ; j++, t += 3 )
 			{
-				// assumed to be normalized.
-				const vec3_t & normal = m_normals[ m_indices[ f.startIndex + j ].n ];
+				weld[ f.startIndex ]		 = t[ 0 ];
+				weld[ f.startIndex + j - 1 ] = t[ 1 ];
+				weld[ f.startIndex + j ]	 = t[ 2 ];
+			}
+		}
+	}
 
-				// orthogonalize
-				vec3_t tangent = planeTangent - normal * planeTangent.dotProduct( normal );
-				tangent = tangent.normalize();
+	computeTangentSpace( numWelded, positions, normals, texCoords,
+						 numTriangles, triangles, tangents, bitangents );
 
-				m_tangents  [ f.startIndex + j ] = tangent;
-				m_bitangents[ f.startIndex + j ] = tangent.crossProduct( normal );
-			}
+	// back to the indices
+	for( i = 0 ; i < m_numIndices ; i++ )
+	{
+		m_tangents  [ i ] = tangents  [ weld[ i ] ];
+		m_bitangents[ i ] = bitangents[ weld[ i ] ];
+	}
+
+	SAFE_DELETE_ARRAY( triangles );
+	SAFE_DELETE_ARRAY( bitangents );
+	SAFE_DELETE_ARRAY( tangents );
+	SAFE_DELETE_ARRAY( texCoords );
+	SAFE_DELETE_ARRAY( normals );
+	SAFE_DELETE_ARRAY( positions );
+	SAFE_DELETE_ARRAY( weld );
+}
+
+
+/*
+========================
+computeFaceNormals
+
+ stores the normal of every face in the custom attribute 'attrFaceNormal'.
+ the faces are triangle fans, the normal is the sum of the fan's triangles.
+========================
+*/
+void CObjModel::computeFaceNormals( void )
+{
+	vec3_t* faceNormals = (vec3_t*)attribute( addAttribute( "attrFaceNormal", 3 ) );
+	if( faceNormals == NULL )
+		return;
+
+	for( int i = 0 ; i < m_numFaces ; i++ )
+	{
+		const Face & f = m_faces[ i ];
+		const vec3_t & p0 = m_vertices[ m_indices[ f.startIndex ].v ];
+
+		vec3_t normal( 0,0,0 );
+		for( int j = 2 ; j < f.numIndices ; j++ )
+		{
+			const vec3_t & p1 = m_vertices[ m_indices[ f.startIndex + j - 1 ].v ];
+			const vec3_t & p2 = m_vertices[ m_indices[ f.startIndex + j ].v ];
+			normal = normal + ( p1 - p0 ).crossProduct( p2 - p0 );
+		}
+
+		if( normal.lengthSq() > 0.0f ) {
+			normal = normal.normalize();
+		}
+
+		for( int j = 0 ; j < f.numIndices ; j++ ) {
+			faceNormals[ f.startIndex + j ] = normal;
 		}
 	}
 }
@@ -1077,3 +1330,30 @@ void CObjModel::getBoundingBox( vec3_t & mins, vec3_t & maxs )
 	maxs = m_maxs;
 }
 
+
+/*
+========================
+getMemoryUsage
+
+ the display lists are not included, their size is unknown.
+========================
+*/
+size_t CObjModel::getMemoryUsage( void )
+{
+	size_t lines = 0;
+	if( m_normalLines != NULL )  { lines += m_normalLines->getMemoryUsage(); }
+	if( m_tangentLines != NULL ) { lines += m_tangentLines->getMemoryUsage(); }
+
+	size_t attributes = 0;
+	for( int i = 0 ; i < m_attributes.size() ; i++ ) {
+		attributes += m_numIndices * m_attributes[ i ].numComponents * sizeof( float );
+	}
+
+	return lines + attributes +
+		   m_numVertices  * sizeof( vec3_t ) +
+		   m_numNormals   * sizeof( vec3_t ) +
+		   m_numTexCoords * sizeof( vec2_t ) +
+		   m_numFaces     * sizeof( Face ) +
+		   m_numIndices   * ( sizeof( Index ) + 2 * sizeof( vec3_t ) );
+}
+
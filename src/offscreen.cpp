@@ -0,0 +1,255 @@
+//=============================================================================
+/** @file		offscreen.cpp
+ *
+ * Implements IOffscreenContext.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#include "application.h"
+#include "offscreen.h"
+
+#ifdef CONFIG_ENABLE_EGL
+
+// the X11 headers define macros like None and Status that collide with Qt
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <string.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA	0x31DD
+#endif
+
+
+//=============================================================================
+//	COffscreenContextEGL
+//=============================================================================
+
+/** Implementation of IOffscreenContext with EGL.
+ */
+class COffscreenContextEGL : public IOffscreenContext
+{
+public:
+	COffscreenContextEGL( void );
+	virtual ~COffscreenContextEGL( void );
+
+	bool init( QString & error );
+
+	// IOffscreenContext interface
+	SMGLGETPROCADDRESSPROC getProcAddress( void ) { return getProcAddressEGL; }
+	QString getDescription( void ) { return m_description; }
+
+private:
+
+	static void* getProcAddressEGL( const char* name );
+	static bool hasExtension( const char* extensions, const char* name );
+
+	EGLDisplay	m_display;
+	EGLSurface	m_surface; // EGL_NO_SURFACE if the context is surfaceless
+	EGLContext	m_context;
+	QString		m_description;
+};
+
+
+// construction
+COffscreenContextEGL::COffscreenContextEGL( void )
+{
+	m_display = EGL_NO_DISPLAY;
+	m_surface = EGL_NO_SURFACE;
+	m_context = EGL_NO_CONTEXT;
+}
+
+// destruction
+COffscreenContextEGL::~COffscreenContextEGL( void )
+{
+	if( m_display == EGL_NO_DISPLAY )
+		return;
+
+	eglMakeCurrent( m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+
+	if( m_context != EGL_NO_CONTEXT ) {
+		eglDestroyContext( m_display, m_context );
+	}
+	if( m_surface != EGL_NO_SURFACE ) {
+		eglDestroySurface( m_display, m_surface );
+	}
+
+	eglTerminate( m_display );
+}
+
+
+/*
+========================
+IOffscreenContext::create
+========================
+*/
+IOffscreenContext* IOffscreenContext::create( QString & error )
+{
+	COffscreenContextEGL* context = new COffscreenContextEGL();
+	if( !context->init( error ) )
+	{
+		delete context;
+		return NULL;
+	}
+
+	return context;
+}
+
+
+/*
+========================
+init
+========================
+*/
+bool COffscreenContextEGL::init( QString & error )
+{
+	// a display without a window system, if the driver has one
+	bool surfaceless = false;
+	const char* clientExtensions = eglQueryString( EGL_NO_DISPLAY, EGL_EXTENSIONS );
+	if( hasExtension( clientExtensions, "EGL_MESA_platform_surfaceless" ) &&
+		hasExtension( clientExtensions, "EGL_EXT_platform_base" ) )
+	{
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress( "eglGetPlatformDisplayEXT" );
+		if( getPlatformDisplay != NULL )
+		{
+			m_display = getPlatformDisplay( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL );
+			surfaceless = ( m_display != EGL_NO_DISPLAY );
+		}
+	}
+
+	if( m_display == EGL_NO_DISPLAY ) {
+		m_display = eglGetDisplay( EGL_DEFAULT_DISPLAY );
+	}
+
+	EGLint major = 0, minor = 0;
+	if( m_display == EGL_NO_DISPLAY || !eglInitialize( m_display, &major, &minor ) )
+	{
+		m_display = EGL_NO_DISPLAY;
+		error = QString( "No EGL display available.\n" );
+		return false;
+	}
+
+	// the shaders use the built-in uniforms and attributes of OpenGL 2.0
+	if( !eglBindAPI( EGL_OPENGL_API ) )
+	{
+		error = QString( "The EGL implementation does not support desktop OpenGL.\n" );
+		return false;
+	}
+
+	static const EGLint configAttribs[] =
+	{
+		EGL_SURFACE_TYPE,		EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE,	EGL_OPENGL_BIT,
+		EGL_RED_SIZE,			8,
+		EGL_GREEN_SIZE,			8,
+		EGL_BLUE_SIZE,			8,
+		EGL_DEPTH_SIZE,			24,
+		EGL_NONE
+	};
+
+	EGLConfig config;
+	EGLint numConfigs = 0;
+	if( !eglChooseConfig( m_display, configAttribs, &config, 1, &numConfigs ) || numConfigs < 1 )
+	{
+		error = QString( "No EGL config with desktop OpenGL and pbuffers found.\n" );
+		return false;
+	}
+
+	// no attributes, so the driver creates a compatibility profile
+	m_context = eglCreateContext( m_display, config, EGL_NO_CONTEXT, NULL );
+	if( m_context == EGL_NO_CONTEXT )
+	{
+		error = QString( "eglCreateContext() failed with error 0x%1.\n" ).arg( eglGetError(), 0, 16 );
+		return false;
+	}
+
+	// nothing is drawn, the surface is only needed if the context can't be current without one
+	if( !hasExtension( eglQueryString( m_display, EGL_EXTENSIONS ), "EGL_KHR_surfaceless_context" ) )
+	{
+		static const EGLint pbufferAttribs[] = { EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE };
+		m_surface = eglCreatePbufferSurface( m_display, config, pbufferAttribs );
+		if( m_surface == EGL_NO_SURFACE )
+		{
+			error = QString( "eglCreatePbufferSurface() failed with error 0x%1.\n" ).arg( eglGetError(), 0, 16 );
+			return false;
+		}
+	}
+
+	if( !eglMakeCurrent( m_display, m_surface, m_surface, m_context ) )
+	{
+		error = QString( "eglMakeCurrent() failed with error 0x%1.\n" ).arg( eglGetError(), 0, 16 );
+		return false;
+	}
+
+	m_description = QString( "EGL %1.%2 (%3)" ).arg( major ).arg( minor ).
+		arg( surfaceless ? "surfaceless" : ( m_surface == EGL_NO_SURFACE ? "no surface" : "pbuffer" ) );
+
+	return true;
+}
+
+
+/*
+========================
+getProcAddressEGL
+========================
+*/
+void* COffscreenContextEGL::getProcAddressEGL( const char* name )
+{
+	return (void*)eglGetProcAddress( name );
+}
+
+
+/*
+========================
+hasExtension
+
+ the names are separated by spaces, so a prefix of another name is no match.
+========================
+*/
+bool COffscreenContextEGL::hasExtension( const char* extensions, const char* name )
+{
+	if( extensions == NULL )
+		return false;
+
+	size_t length = strlen( name );
+	for( const char* s = strstr( extensions, name ) ; s != NULL ; s = strstr( s + length, name ) )
+	{
+		bool start = ( s == extensions || s[ -1 ] == ' ' );
+		bool end = ( s[ length ] == ' ' || s[ length ] == '\0' );
+		if( start && end )
+			return true;
+	}
+
+	return false;
+}
+
+
+#else // CONFIG_ENABLE_EGL
+
+
+/*
+========================
+IOffscreenContext::create
+========================
+*/
+IOffscreenContext* IOffscreenContext::create( QString & error )
+{
+	error = QString( "Shader Maker was built without CONFIG_ENABLE_EGL, "
+					 "offscreen contexts are not available.\n" );
+	return NULL;
+}
+
+
+#endif // CONFIG_ENABLE_EGL
+
@@ -0,0 +1,56 @@
+//=============================================================================
+/** @file		offscreen.h
+ *
+ * Defines an OpenGL context without a window.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#ifndef __OFFSCREEN_H_INCLUDED__
+#define __OFFSCREEN_H_INCLUDED__
+
+#include <QtCore/QString>
+
+#include "glextra.h"
+
+
+//=============================================================================
+//	IOffscreenContext
+//=============================================================================
+
+/** A compatibility profile context that needs no window system, so shaders
+ * can be compiled without a display, e.g. on a build server. It is created
+ * with EGL on a surfaceless display if the driver supports that, on the
+ * default display with a small pbuffer otherwise.
+ * \n\n
+ * The context is current on the creating thread until it is deleted.
+ * Pass getProcAddress() to smglInit().
+ */
+class IOffscreenContext
+{
+public:
+	/** Creates the context and makes it current.
+	 * @param error Receives the reason if no context could be created.
+	 * @return The context, NULL on failure or if Shader Maker was
+	 *			built without CONFIG_ENABLE_EGL.
+	 */
+	static IOffscreenContext* create( QString & error );
+	virtual ~IOffscreenContext( void ) {} ///< Destructor, releases the context.
+
+	/** Returns the function that resolves the entry points of the context. */
+	virtual SMGLGETPROCADDRESSPROC getProcAddress( void ) = 0;
+
+	/** Returns the window system API and its version, e.g. "EGL 1.5 (surfaceless)". */
+	virtual QString getDescription( void ) = 0;
+};
+
+
+#endif	// __OFFSCREEN_H_INCLUDED__
+
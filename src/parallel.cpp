@@ -0,0 +1,92 @@
+//=============================================================================
+/** @file		parallel.cpp
+ *
+ * Implements the parallel loop helper.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#include <QtCore/QThreadPool>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+
+#include "parallel.h"
+
+
+//=============================================================================
+//	CParallelRange
+//=============================================================================
+
+/** Executes a sub-range of a parallel loop on a pool thread.
+ * It releases the semaphore when done, so the caller can wait
+ * for its own ranges without waiting for unrelated pool work.
+ */
+class CParallelRange : public QRunnable
+{
+public:
+	CParallelRange( IParallelJob* job, int first, int last, QSemaphore* done )
+	 : m_job( job ), m_first( first ), m_last( last ), m_done( done )
+	{
+		setAutoDelete( true );
+	}
+
+	void run( void )
+	{
+		m_job->run( m_first, m_last );
+		m_done->release();
+	}
+
+private:
+	IParallelJob*	m_job;
+	int				m_first;
+	int				m_last;
+	QSemaphore*		m_done;
+};
+
+
+/*
+========================
+parallelFor
+========================
+*/
+void parallelFor( int count, IParallelJob* job, int minRangeSize )
+{
+	if( count <= 0 || job == NULL )
+		return;
+
+	// one range per thread, the calling thread takes the first one.
+	int numRanges = QThreadPool::globalInstance()->maxThreadCount();
+	if( minRangeSize > 0 ) {
+		numRanges = qMin( numRanges, count / minRangeSize );
+	}
+
+	if( numRanges <= 1 )
+	{
+		job->run( 0, count );
+		return;
+	}
+
+	int rangeSize = ( count + numRanges - 1 ) / numRanges;
+	int numQueued = 0;
+	QSemaphore done;
+
+	for( int first = rangeSize ; first < count ; first += rangeSize )
+	{
+		int last = qMin( first + rangeSize, count );
+		QThreadPool::globalInstance()->start( new CParallelRange( job, first, last, &done ) );
+		numQueued++;
+	}
+
+	job->run( 0, qMin( rangeSize, count ) );
+
+	// wait for the pool threads
+	done.acquire( numQueued );
+}
+
@@ -0,0 +1,55 @@
+//=============================================================================
+/** @file		parallel.h
+ *
+ * Defines a simple parallel loop helper.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#ifndef __PARALLEL_H_INCLUDED__
+#define __PARALLEL_H_INCLUDED__
+
+
+//=============================================================================
+//	IParallelJob
+//=============================================================================
+
+/** A loop body that can be executed in parallel.
+ * The loop range is split into several sub-ranges, which are passed to
+ * run() from different threads. Implementations must not write to
+ * memory shared by different sub-ranges.
+ */
+class IParallelJob
+{
+public:
+	virtual ~IParallelJob( void ) {} ///< Destructor.
+
+	/** Executes the loop body for the iterations [first, last).
+	 * @param first First iteration.
+	 * @param last Iteration behind the last one to execute.
+	 */
+	virtual void run( int first, int last ) = 0;
+};
+
+
+/** Executes a loop on the global thread pool.
+ * The iterations [0, count) are split into one range per thread,
+ * the calling thread executes one of them. The call returns after
+ * all iterations have been executed.
+ * @param count Number of loop iterations.
+ * @param job The loop body.
+ * @param minRangeSize Minimum number of iterations per thread. Small loops
+ *        are executed on the calling thread only.
+ */
+void parallelFor( int count, IParallelJob* job, int minRangeSize = 64 );
+
+
+#endif	// __PARALLEL_H_INCLUDED__
+
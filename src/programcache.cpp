@@ -0,0 +1,164 @@
+//=============================================================================
+/** @file		programcache.cpp
+ *
+ * Implements IProgramCache.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#include <QtCore/QFile>
+#include <QtCore/QDir>
+#include <QtCore/QDataStream>
+#include <QtCore/QCryptographicHash>
+
+#include "application.h"
+#include "programcache.h"
+
+
+// file header, the version must change with the file layout
+#define PROGRAM_CACHE_MAGIC		0x534d5042	// 'SMPB'
+#define PROGRAM_CACHE_VERSION	1
+
+
+//=============================================================================
+//	CProgramCache
+//=============================================================================
+
+/** Implementation of IProgramCache.
+ * Every entry is a file named after its key.
+ */
+class CProgramCache : public IProgramCache
+{
+public:
+	CProgramCache( const QString & directory );
+	virtual ~CProgramCache( void );
+
+	// IProgramCache interface
+	bool load( const QString & key, ProgramBinary & binary );
+	bool store( const QString & key, const ProgramBinary & binary );
+	void remove( const QString & key );
+
+private:
+	QString getFileName( const QString & key );
+
+	QString m_directory;
+};
+
+
+// construction
+CProgramCache::CProgramCache( const QString & directory )
+ : m_directory( directory )
+{
+}
+
+// destruction
+CProgramCache::~CProgramCache( void )
+{
+}
+
+
+/*
+========================
+IProgramCache::create
+========================
+*/
+IProgramCache* IProgramCache::create( const QString & directory )
+{
+	return new CProgramCache( directory );
+}
+
+
+/*
+========================
+IProgramCache::makeKey
+========================
+*/
+QString IProgramCache::makeKey( const QByteArray & description )
+{
+	return QString( QCryptographicHash::hash( description, QCryptographicHash::Sha1 ).toHex() );
+}
+
+
+/*
+========================
+getFileName
+========================
+*/
+QString CProgramCache::getFileName( const QString & key )
+{
+	return QDir( m_directory ).filePath( key + QString( ".bin" ) );
+}
+
+
+/*
+========================
+load
+========================
+*/
+bool CProgramCache::load( const QString & key, ProgramBinary & binary )
+{
+	QFile file( getFileName( key ) );
+	if( !file.open( QIODevice::ReadOnly ) )
+		return false;
+
+	QDataStream in( &file );
+	quint32 magic = 0, version = 0;
+	qint32 format = 0;
+	in >> magic >> version;
+	if( magic != PROGRAM_CACHE_MAGIC || version != PROGRAM_CACHE_VERSION )
+		return false;
+
+	in >> format >> binary.log >> binary.data;
+	binary.format = format;
+
+	return in.status() == QDataStream::Ok && !binary.data.isEmpty();
+}
+
+
+/*
+========================
+store
+========================
+*/
+bool CProgramCache::store( const QString & key, const ProgramBinary & binary )
+{
+	if( !QDir().mkpath( m_directory ) )
+		return false;
+
+	QFile file( getFileName( key ) );
+	if( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+		return false;
+
+	QDataStream out( &file );
+	out << quint32( PROGRAM_CACHE_MAGIC ) << quint32( PROGRAM_CACHE_VERSION );
+	out << qint32( binary.format ) << binary.log << binary.data;
+
+	if( out.status() != QDataStream::Ok )
+	{
+		// don't leave a truncated entry behind
+		file.close();
+		file.remove();
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+========================
+remove
+========================
+*/
+void CProgramCache::remove( const QString & key )
+{
+	QFile::remove( getFileName( key ) );
+}
+
@@ -0,0 +1,84 @@
+//=============================================================================
+/** @file		programcache.h
+ *
+ * Defines an on-disk cache for linked program binaries.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#ifndef __PROGRAMCACHE_H_INCLUDED__
+#define __PROGRAMCACHE_H_INCLUDED__
+
+#include <QtCore/QString>
+#include <QtCore/QByteArray>
+
+
+//=============================================================================
+//	ProgramBinary
+//=============================================================================
+
+/** A linked program as returned by glGetProgramBinary(), together with
+ * the build log of the compile and link steps that produced it.
+ */
+class ProgramBinary
+{
+public:
+	ProgramBinary( void ) : format( 0 ) {}
+
+	int			format;	///< driver specific binary format
+	QByteArray	data;	///< the binary
+	QString		log;	///< compiler and linker messages
+};
+
+
+//=============================================================================
+//	IProgramCache
+//=============================================================================
+
+/** Stores program binaries in a directory, one file per program.
+ * The programs are identified by a key, made from everything that
+ * changes the linked program: the shader sources, the link parameters
+ * and the driver identification. The driver may still reject a binary,
+ * e.g. after an update that didn't change the version string, such
+ * entries must be removed by the caller.
+ * \n\n
+ * The cache does not call OpenGL, the binaries are passed in and out.
+ */
+class IProgramCache
+{
+public:
+	/** Creates an IProgramCache object.
+	 * @param directory Where the binaries are stored, it is created on demand.
+	 */
+	static IProgramCache* create( const QString & directory );
+	virtual ~IProgramCache( void ) {} ///< Destructor.
+
+	/** Hashes the description of a program into a key.
+	 * @param description Everything the linked program depends on.
+	 */
+	static QString makeKey( const QByteArray & description );
+
+	/** Reads a binary.
+	 * @return False if there is no valid entry for this key.
+	 */
+	virtual bool load( const QString & key, ProgramBinary & binary ) = 0;
+
+	/** Writes a binary, an existing entry is replaced.
+	 * @return False if the file could not be written.
+	 */
+	virtual bool store( const QString & key, const ProgramBinary & binary ) = 0;
+
+	/** Removes an entry, e.g. after the driver rejected it. */
+	virtual void remove( const QString & key ) = 0;
+};
+
+
+#endif	// __PROGRAMCACHE_H_INCLUDED__
+
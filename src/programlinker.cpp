@@ -0,0 +1,288 @@
+//=============================================================================
+/** @file		programlinker.cpp
+ *
+ * Implements IProgramLinker.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#include <QtCore/QThread>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#include <QtCore/QList>
+#include <QtCore/QCoreApplication>
+#include <QtOpenGL/QGLWidget>
+
+#include "application.h"
+#include "shader.h"
+#include "programlinker.h"
+
+
+//=============================================================================
+//	CProgramLinker
+//=============================================================================
+
+/** Implementation of IProgramLinker.
+ * The context of m_contextWidget is current on the worker thread for
+ * its whole lifetime. All builds are deleted on the worker thread, except
+ * queued ones, they have no objects yet. All members except the thread
+ * and m_contextWidget are protected by m_mutex.
+ */
+class CProgramLinker : public IProgramLinker, private QThread
+{
+public:
+	CProgramLinker( QGLWidget* contextWidget );
+	virtual ~CProgramLinker( void );
+
+	// IProgramLinker interface
+	void			link( IShaderBuild* build );
+	void			cancel( void );
+	IShaderBuild*	takeResult( void );
+	bool			isBusy( void );
+
+private:
+
+	// the worker thread
+	void run( void );
+	void deleteGarbage( void );
+
+	QGLWidget*				m_contextWidget;	// hidden, shares with the render context
+
+	QMutex					m_mutex;
+	QWaitCondition			m_wake;				// signaled on new builds, garbage and quit
+	IShaderBuild*			m_pending;			// next build to run
+	IShaderBuild*			m_result;			// finished, not taken yet
+	QList< IShaderBuild* >	m_garbage;			// superseded results
+	IShaderBuild*			m_running;			// owned by the worker while it runs
+	bool					m_superseded;		// drop the result of the running build
+	bool					m_quit;
+};
+
+
+// construction
+CProgramLinker::CProgramLinker( QGLWidget* contextWidget )
+ : m_contextWidget( contextWidget ),
+   m_pending( NULL ), m_result( NULL ),
+   m_running( NULL ), m_superseded( false ), m_quit( false )
+{
+}
+
+// destruction
+CProgramLinker::~CProgramLinker( void )
+{
+	m_mutex.lock();
+	m_quit = true;
+	m_superseded = true;
+	SAFE_DELETE( m_pending ); // never run, no objects
+	if( m_running != NULL ) {
+		m_running->cancel();
+	}
+	m_wake.wakeAll();
+	m_mutex.unlock();
+
+	// the thread deletes the other builds before it exits
+	wait();
+
+	SAFE_DELETE( m_contextWidget );
+}
+
+
+/*
+========================
+IProgramLinker::create
+========================
+*/
+IProgramLinker* IProgramLinker::create( QGLWidget* shareWidget )
+{
+	QGLWidget* contextWidget = new QGLWidget( shareWidget->format(), NULL, shareWidget );
+	if( !contextWidget->isValid() || !contextWidget->isSharing() )
+	{
+		delete contextWidget;
+		return NULL;
+	}
+
+	// the worker makes it current
+	contextWidget->doneCurrent();
+
+	return new CProgramLinker( contextWidget );
+}
+
+
+/*
+========================
+link
+========================
+*/
+void CProgramLinker::link( IShaderBuild* build )
+{
+	if( build == NULL )
+		return;
+
+	m_mutex.lock();
+	SAFE_DELETE( m_pending );
+	m_pending = build;
+	m_superseded = ( m_running != NULL );
+	if( m_running != NULL ) {
+		m_running->cancel(); // returns before its next compile
+	}
+	if( m_result != NULL )
+	{
+		m_garbage.append( m_result );
+		m_result = NULL;
+	}
+	m_wake.wakeAll();
+	m_mutex.unlock();
+
+	if( !isRunning() )
+	{
+#if QT_VERSION >= 0x050000
+		// the context must live on the thread that makes it current
+		m_contextWidget->context()->moveToThread( this );
+#endif
+		start( QThread::LowPriority );
+	}
+}
+
+
+/*
+========================
+cancel
+========================
+*/
+void CProgramLinker::cancel( void )
+{
+	m_mutex.lock();
+	SAFE_DELETE( m_pending );
+	m_superseded = ( m_running != NULL );
+	if( m_running != NULL ) {
+		m_running->cancel(); // returns before its next compile
+	}
+	if( m_result != NULL )
+	{
+		m_garbage.append( m_result );
+		m_result = NULL;
+	}
+	m_wake.wakeAll();
+	m_mutex.unlock();
+}
+
+
+/*
+========================
+takeResult
+========================
+*/
+IShaderBuild* CProgramLinker::takeResult( void )
+{
+	m_mutex.lock();
+	IShaderBuild* build = m_result;
+	m_result = NULL;
+	m_mutex.unlock();
+
+	return build;
+}
+
+
+/*
+========================
+isBusy
+========================
+*/
+bool CProgramLinker::isBusy( void )
+{
+	m_mutex.lock();
+	bool busy = ( m_pending != NULL || m_running != NULL );
+	m_mutex.unlock();
+
+	return busy;
+}
+
+
+/*
+========================
+deleteGarbage
+
+ assumes m_mutex is locked and the context is current.
+========================
+*/
+void CProgramLinker::deleteGarbage( void )
+{
+	for( int i = 0 ; i < m_garbage.size() ; i++ ) {
+		delete m_garbage[ i ];
+	}
+	m_garbage.clear();
+}
+
+
+/*
+========================
+run
+
+ runs the pending build until m_quit is set.
+========================
+*/
+void CProgramLinker::run( void )
+{
+	m_contextWidget->makeCurrent();
+
+	m_mutex.lock();
+
+	for( ;; )
+	{
+		deleteGarbage();
+
+		while( m_pending == NULL && m_garbage.isEmpty() && !m_quit ) {
+			m_wake.wait( &m_mutex );
+		}
+
+		if( m_quit )
+			break;
+
+		if( m_pending == NULL )
+			continue; // only garbage
+
+		IShaderBuild* build = m_pending;
+		m_pending = NULL;
+		m_running = build;
+		m_superseded = false;
+		m_mutex.unlock();
+
+		build->run();
+
+		// the render context may use the objects as soon as they are published
+		glFinish();
+
+		m_mutex.lock();
+		m_running = NULL;
+		if( m_superseded )
+		{
+			delete build;
+		}
+		else
+		{
+			if( m_result != NULL ) {
+				m_garbage.append( m_result );
+			}
+			m_result = build;
+		}
+	}
+
+	// results that were not taken
+	SAFE_DELETE( m_result );
+	deleteGarbage();
+
+	m_mutex.unlock();
+
+	m_contextWidget->doneCurrent();
+#if QT_VERSION >= 0x050000
+	m_contextWidget->context()->moveToThread( QCoreApplication::instance()->thread() );
+#endif
+}
+
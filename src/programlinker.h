@@ -0,0 +1,73 @@
+//=============================================================================
+/** @file		programlinker.h
+ *
+ * Defines a worker thread that compiles and links GLSL programs.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#ifndef __PROGRAMLINKER_H_INCLUDED__
+#define __PROGRAMLINKER_H_INCLUDED__
+
+// forward declarations
+class QGLWidget;
+class IShaderBuild;
+
+
+//=============================================================================
+//	IProgramLinker
+//=============================================================================
+
+/** Runs IShaderBuild objects on a worker thread, so the GUI doesn't freeze
+ * while the driver compiles. The thread uses a hidden OpenGL context that
+ * shares its objects with the render context.
+ * \n\n
+ * Only the latest request counts: a new build supersedes the queued one,
+ * the running one and a finished one that was not taken yet. The running
+ * one is canceled, it stops before its next compile. Their objects are
+ * deleted on the worker thread. The render thread polls takeResult()
+ * and passes the build to IShader::finishBuild().
+ */
+class IProgramLinker
+{
+public:
+	/** Creates an IProgramLinker object.
+	 * Changes the current OpenGL context.
+	 * @param shareWidget The widget whose context renders the programs.
+	 * @return NULL if no context sharing objects with it could be
+	 *			created, the programs must be linked on the GUI thread then.
+	 */
+	static IProgramLinker* create( QGLWidget* shareWidget );
+
+	/** Destructor. Waits for the running build and deletes all builds. */
+	virtual ~IProgramLinker( void ) {}
+
+	/** Queues a build, it supersedes all builds that were not taken yet.
+	 * @param build The build, it is owned by the linker until it is taken.
+	 */
+	virtual void link( IShaderBuild* build ) = 0;
+
+	/** Drops all builds that were not taken yet, e.g. because the
+	 * program was deactivated in the meantime.
+	 */
+	virtual void cancel( void ) = 0;
+
+	/** Returns the finished build and forgets about it.
+	 * @return NULL if there is none.
+	 */
+	virtual IShaderBuild* takeResult( void ) = 0;
+
+	/** Returns true while a build is queued or running. */
+	virtual bool isBusy( void ) = 0;
+};
+
+
+#endif	// __PROGRAMLINKER_H_INCLUDED__
+
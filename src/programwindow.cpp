@@ -25,10 +25,12 @@
 #include "uniformwidget.h"
 #include "scenewidget.h"
 #include "texturewidget.h"
+#include "variantwidget.h"
 
 #include "scene.h"
 #include "shader.h"
 #include "editor.h"
+#include "programlinker.h"
 
 
 //=============================================================================
@@ -41,6 +43,9 @@ CProgramWindow::CProgramWindow( void )
 	// components
 	m_scene = IScene::create();
 	m_editor = NULL;
+	m_linker = NULL;
+	m_linkingVariants = false;
+	m_autoLink = false;
 
 	// create misc widgets
 	m_tabs = new QTabWidget();
@@ -52,6 +57,7 @@ CProgramWindow::CProgramWindow( void )
 	createLightWidget();
 	createUniformWidget();
 	createTextureWidget();
+	createVariantWidget();
 	createDriverInfoWidget();
 
 	// setup other widgets
@@ -147,6 +153,18 @@ void CProgramWindow::createTextureWidget( void )
 }
 
 
+/*
+========================
+createVariantWidget
+========================
+*/
+void CProgramWindow::createVariantWidget( void )
+{
+	m_variants = new CVariantWidget( m_scene );
+	m_tabs->addTab( m_variants, tr( "Variants" ) );
+}
+
+
 /*
 ========================
 createLogWidget
@@ -251,8 +269,14 @@ bool CProgramWindow::init( void )
 	connect( m_editor, SIGNAL(linkProgram()), this, SLOT(linkProgram()) );
 	connect( m_editor, SIGNAL(aboutToQuit()), this, SLOT(aboutToQuit()) );
 	connect( m_editor, SIGNAL(deactivateProgram()), this, SLOT(deactivateProgram()) );
+	connect( m_sceneWidget, SIGNAL(linkProgram()), this, SLOT(linkProgram()) );
+	connect( m_variants, SIGNAL(buildVariants()), this, SLOT(linkVariants()) );
 	m_editor->init( QPoint( x() + frameGeometry().width(), y() ) );
 
+	// compile in the background, if the driver can share objects between contexts
+	m_linker = IProgramLinker::create( m_glWidget );
+	m_glWidget->makeCurrent();
+
 	QApplication::restoreOverrideCursor();
 
 	return true;
@@ -266,6 +290,10 @@ shutdown
 */
 void CProgramWindow::shutdown( void )
 {
+	// waits for a running build, it uses the shader
+	m_glWidget->makeCurrent();
+	SAFE_DELETE( m_linker );
+
 	// editor
 	if( m_editor != NULL ) {
 		disconnect( m_editor, 0, this, 0 );
@@ -332,7 +360,14 @@ void CProgramWindow::deactivateProgram( void )
 {
 	if( m_scene != NULL )
 	{
+		// a program linked in the background must not activate it again
+		if( m_linker != NULL ) {
+			m_linker->cancel();
+		}
+		m_linkingVariants = false;
+
 		m_scene->getShader()->deactivateProgram();
+		m_variants->updateVariantList();
 	}
 }
 
@@ -344,22 +379,146 @@ linkProgram
 */
 void CProgramWindow::linkProgram( void )
 {
-	if( m_scene != NULL )
+	if( m_scene == NULL )
+		return;
+
+	m_linkTimer.start();
+	m_autoLink = ( m_editor != NULL && m_editor->isAutoCompiledLink() );
+
+	// the old program keeps rendering, render() swaps in the new one.
+	if( m_linker != NULL )
 	{
-		// compile and link
-		bool result = m_scene->getShader()->compileAndLink();
+		m_linker->link( m_scene->getShader()->createBuild() );
+		m_linkingVariants = false;
+		m_logging->setPlainText( tr( "Compiling..." ) );
+		return;
+	}
 
-		// update state manipulation widgets
-		m_uniform->updateUniformList();
-		m_texture->updateSamplerList();
+	// compile and link
+	bool result = m_scene->getShader()->compileAndLink( m_autoLink );
+	programLinked( result );
+}
 
-		// update log
-		m_logging->setPlainText( m_scene->getShader()->getBuildLog() );
 
-		// if there are any errors, switch to the log widget
-		if( !result )
-			m_tabs->setCurrentWidget( m_logging );
+/*
+========================
+programLinked
+========================
+*/
+void CProgramWindow::programLinked( bool result )
+{
+	// update state manipulation widgets
+	m_uniform->updateUniformList();
+	m_texture->updateSamplerList();
+
+	// update log
+	m_logging->setPlainText( m_scene->getShader()->getBuildLog() );
+
+	// compile latency, including a superseded build that was still running
+	if( m_editor != NULL ) {
+		m_editor->showLinkTime( (int)m_linkTimer.elapsed() );
 	}
+
+	// a failed auto compiled link kept the last good program and its
+	// variants, the log must not take the focus from typing either.
+	if( !result && m_autoLink )
+	{
+		m_variants->updateVariantList();
+		return;
+	}
+
+	// if there are any errors, switch to the log widget
+	if( !result )
+		m_tabs->setCurrentWidget( m_logging );
+
+	// the variants are built from the sources of the new program
+	linkVariants();
+}
+
+
+/*
+========================
+linkVariants
+
+ builds the programs of the variants, after the program itself.
+========================
+*/
+void CProgramWindow::linkVariants( void )
+{
+	if( m_scene == NULL )
+		return;
+
+	if( m_linker != NULL )
+	{
+		// a finished program would be dropped by the next link() call,
+		// programLinked() builds the variants from its sources instead.
+		if( takeLinkerResult() == IShaderBuild::BUILD_PROGRAM )
+			return;
+
+		// a queued build of the program would be superseded,
+		// it builds the variants when it is done.
+		if( m_linker->isBusy() && !m_linkingVariants )
+			return;
+	}
+
+	IShaderBuild* build = m_scene->getShader()->createVariantBuild();
+	if( build == NULL )
+	{
+		m_variants->updateVariantList();
+		return;
+	}
+
+	if( m_linker != NULL )
+	{
+		m_linker->link( build );
+		m_linkingVariants = true;
+		m_variants->updateVariantList();
+		return;
+	}
+
+	build->run();
+	variantsLinked( m_scene->getShader()->finishVariantBuild( build ) );
+}
+
+
+/*
+========================
+variantsLinked
+========================
+*/
+void CProgramWindow::variantsLinked( bool )
+{
+	// failed variants show their log in the table
+	m_variants->updateVariantList();
+}
+
+
+/*
+========================
+takeLinkerResult
+
+ passes a build finished in the background to the shader.
+ returns its IShaderBuild::buildKind_e, or -1 if there was none.
+========================
+*/
+int CProgramWindow::takeLinkerResult( void )
+{
+	IShaderBuild* build = m_linker->takeResult();
+	if( build == NULL )
+		return -1;
+
+	int kind = build->getKind();
+	if( kind == IShaderBuild::BUILD_VARIANTS )
+	{
+		m_linkingVariants = false;
+		variantsLinked( m_scene->getShader()->finishVariantBuild( build ) );
+	}
+	else
+	{
+		programLinked( m_scene->getShader()->finishBuild( build, m_autoLink ) );
+	}
+
+	return kind;
 }
 
 
@@ -370,7 +529,20 @@ render
 */
 void CProgramWindow::render( void )
 {
-	m_scene->render();
+	// swap in a program linked in the background
+	if( m_linker != NULL ) {
+		takeLinkerResult();
+	}
+
+	m_scene->setMouseState( m_glWidget->getMouseState() );
+
+	// a running benchmark or comparison draws the scene itself
+	if( !m_sceneWidget->renderBenchmarkFrame() &&
+		!m_variants->renderComparisonFrame() ) {
+		m_scene->render();
+	}
+	m_sceneWidget->frameRendered();
+	m_glWidget->setStatisticsText( m_scene->getStatisticsText() );
 }
 
 
@@ -16,6 +16,7 @@
 #ifndef __QT_PROGRAMWINDOW_H_INCLUDED__
 #define __QT_PROGRAMWINDOW_H_INCLUDED__
 
+#include <QtCore/QElapsedTimer>
 #include <QMainWindow>
 #include <QTabWidget>
 #include <QTextEdit>
@@ -29,8 +30,10 @@ class CMaterialWidget;
 class CUniformWidget;
 class CSceneWidget;
 class CTextureWidget;
+class CVariantWidget;
 class CGLWidget;
 class CEditor;
+class IProgramLinker;
 
 
 //=============================================================================
@@ -61,6 +64,7 @@ public:
 private slots:;
 	void render( void );
 	void linkProgram( void );
+	void linkVariants( void );
 	void deactivateProgram( void );
 	void aboutToQuit( void );
 
@@ -76,9 +80,15 @@ private:
 	void createUniformWidget( void );
 	void createSceneWidget( void );
 	void createTextureWidget( void );
+	void createVariantWidget( void );
 	void createLayout( void );
 	void createDriverInfoWidget( void );
 
+	// updates the widgets after the program was replaced
+	void programLinked( bool result );
+	void variantsLinked( bool result );
+	int  takeLinkerResult( void );
+
 	// widgets
 	CGLWidget*			m_glWidget;
 	QTabWidget*			m_tabs; // contains config widgets
@@ -87,12 +97,17 @@ private:
 	CUniformWidget*		m_uniform;
 	CSceneWidget*		m_sceneWidget;
 	CTextureWidget*		m_texture;
+	CVariantWidget*		m_variants;
 	QTextEdit*			m_logging;
 	QTextEdit*			m_driverInfoWidget; // shows info about the GL driver
 
 	// components
 	CEditor*	m_editor;
 	IScene*		m_scene;
+	IProgramLinker* m_linker; // NULL if programs are linked on the GUI thread
+	bool		m_linkingVariants; // the last build passed to the linker is a variant build
+	QElapsedTimer	m_linkTimer; // since the last linkProgram() call
+	bool		m_autoLink; // the auto compile mode requested the last link
 };
 
 
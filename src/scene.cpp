@@ -14,6 +14,9 @@
 =============================================================================*/
 
 #include <QtCore/QTime>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QVector>
+#include <math.h>
 
 #include "application.h"
 #include "scene.h"
@@ -22,6 +25,8 @@
 #include "texture.h"
 #include "camera.h"
 #include "shader.h"
+#include "glextra.h"
+#include "feedback.h"
 
 
 //=============================================================================
@@ -289,7 +294,7 @@ public:
 private:
 
 	// projection matrix helpers
-	void setupFrustum( void );
+	void setupFrustum( float worldRadius );
 	void setupOrtho( float worldRadius );
 
 	float		m_fovY;
@@ -320,7 +325,7 @@ void CCameraState::applyProjectionMatrix( float worldRadius )
 	if( m_projectionMode == PROJECT_ORTHO ) {
 		setupOrtho( worldRadius );
 	} else {
-		setupFrustum();
+		setupFrustum( worldRadius );
 	}
 }
 
@@ -384,15 +389,21 @@ void CCameraState::resetCamera( void )
 /*
 ========================
 setupFrustumView
+
+ the far plane is moved back if the world does not fit into the default range.
 ========================
 */
-void CCameraState::setupFrustum( void )
+void CCameraState::setupFrustum( float worldRadius )
 {
 	// tuning constants
 	static const double pi = 4.0 * atan( 1.0 );
 	double zNear = 0.01f;
 	double zFar = 20.0f;
 
+	double distance = sqrt( m_translation.x * m_translation.x +
+		m_translation.y * m_translation.y + m_translation.z * m_translation.z );
+	zFar = qMax( zFar, distance + 2.0 * worldRadius );
+
 	double a,b;
 
 	// do range check
@@ -809,6 +820,428 @@ void CLightingState::initDefaultLightState( void )
 }
 
 
+//=============================================================================
+//	instance state
+//=============================================================================
+
+/** Stores the per-instance attributes for the instanced stress mode.
+ * Every instance has a transformation matrix and a color. They are kept
+ * interleaved in a vertex buffer object and bound to the generic vertex
+ * attributes 'attrInstanceTransform' and 'attrInstanceColor' with a divisor
+ * of one. If the driver or the model can not draw instanced, the instances
+ * are drawn one by one, passing the attributes as constant vertex attributes.
+ */
+class CInstanceState
+{
+public:
+	/** Constructs a CInstanceState object.
+	 * The object must be initialized before use.
+	 */
+	CInstanceState( void );
+
+	/** Initializes the object. */
+	void init( void );
+
+	/** Frees resources and cleans up state.
+	 * Must be called before destruction.
+	 */
+	void shutdown( void );
+
+	/** Sets the number of instances, 1 disables the stress mode. */
+	void setNumInstances( int numInstances );
+	int  getNumInstances( void ) const { return m_numInstances; }
+
+	/** Sets the instance layout, one of IScene::instanceLayout_e. */
+	void setLayout( int layout );
+
+	/** Returns true if the last render() call used a single instanced draw call. */
+	bool getLastDrawInstanced( void ) const { return m_lastDrawInstanced; }
+
+	/** Returns the number of instances the last render() call drew.
+	 * Without instancing at most CONFIG_MAX_LOOP_INSTANCES are drawn.
+	 */
+	int getNumDrawnInstances( void ) const { return m_numDrawnInstances; }
+
+	/** Returns the bounding radius of all instances of a model.
+	 * @param modelRadius Bounding radius of a single instance.
+	 */
+	float getBoundingRadius( float modelRadius );
+
+	/** Draws all instances of the model.
+	 * @param model The model to draw.
+	 * @param attribs Vertex attribute locations of the current program.
+	 * @param programAvailable False if the fixed function pipeline is used.
+	 *        The instance transformation is applied to the modelview matrix
+	 *        in that case.
+	 */
+	void render( IModel* model, const VertexAttribLocations & attribs, bool programAvailable );
+
+private:
+
+	/** Per-instance attributes, this is the layout of the vertex buffer. */
+	struct instance_t
+	{
+		mat4_t	transform;
+		vec4_t	color;
+	};
+
+	// helpers
+	void	updateInstances( float modelRadius );
+	float	getSpacing( float modelRadius ) const;
+	void	bindInstanceArrays( const VertexAttribLocations & attribs );
+	void	unbindInstanceArrays( const VertexAttribLocations & attribs );
+	void	renderLoop( IModel* model, const VertexAttribLocations & attribs, bool programAvailable );
+	static float randomFloat( unsigned int & seed );
+
+	int		m_numInstances;
+	int		m_layout;
+	bool	m_lastDrawInstanced;
+	int		m_numDrawnInstances;
+
+	// parameters the buffer was built with
+	int		m_builtInstances;
+	int		m_builtLayout;
+	float	m_builtRadius;
+
+	QVector< instance_t >	m_instances;
+	GLuint					m_buffer;
+};
+
+
+// construction
+CInstanceState::CInstanceState( void )
+{
+	m_numInstances = 1;
+	m_layout = IScene::INSTANCES_GRID;
+	m_lastDrawInstanced = false;
+	m_numDrawnInstances = 0;
+
+	m_builtInstances = 0;
+	m_builtLayout = -1;
+	m_builtRadius = 0.0f;
+
+	m_buffer = 0;
+}
+
+
+/*
+========================
+init
+========================
+*/
+void CInstanceState::init( void )
+{
+	if( m_buffer == 0 ) {
+		glGenBuffers( 1, &m_buffer );
+	}
+
+	m_builtInstances = 0;
+}
+
+
+/*
+========================
+shutdown
+========================
+*/
+void CInstanceState::shutdown( void )
+{
+	if( m_buffer != 0 )
+	{
+		glDeleteBuffers( 1, &m_buffer );
+		m_buffer = 0;
+	}
+
+	m_instances.clear();
+	m_builtInstances = 0;
+}
+
+
+/*
+========================
+setNumInstances
+========================
+*/
+void CInstanceState::setNumInstances( int numInstances )
+{
+	m_numInstances = qBound( 1, numInstances, CONFIG_MAX_INSTANCES );
+}
+
+
+/*
+========================
+setLayout
+========================
+*/
+void CInstanceState::setLayout( int layout )
+{
+	switch( layout )
+	{
+	case IScene::INSTANCES_GRID:
+	case IScene::INSTANCES_RANDOM:
+		m_layout = layout;
+		break;
+	}
+}
+
+
+/*
+========================
+randomFloat
+
+ a linear congruential generator, the instances must look the same every time.
+ returns a value in [0,1).
+========================
+*/
+float CInstanceState::randomFloat( unsigned int & seed )
+{
+	seed = seed * 1664525u + 1013904223u;
+	return float( seed >> 8 ) / float( 1 << 24 );
+}
+
+
+/*
+========================
+getSpacing
+
+ distance between two neighboring grid instances.
+========================
+*/
+float CInstanceState::getSpacing( float modelRadius ) const
+{
+	return 2.5f * qMax( modelRadius, 0.1f );
+}
+
+
+/*
+========================
+getBoundingRadius
+========================
+*/
+float CInstanceState::getBoundingRadius( float modelRadius )
+{
+	if( m_numInstances <= 1 )
+		return modelRadius;
+
+	// the random cloud is a ball with the volume of the grid cube,
+	// so both layouts have the same bounds.
+	int side = (int)ceil( pow( (double)m_numInstances, 1.0 / 3.0 ) - 0.0001 );
+	float halfExtent = 0.5f * getSpacing( modelRadius ) * float( side - 1 );
+
+	return halfExtent * sqrtf( 3.0f ) + modelRadius;
+}
+
+
+/*
+========================
+updateInstances
+
+ rebuilds the instance attributes if the parameters changed.
+========================
+*/
+void CInstanceState::updateInstances( float modelRadius )
+{
+	if( m_builtInstances == m_numInstances &&
+		m_builtLayout == m_layout &&
+		m_builtRadius == modelRadius )
+		return;
+
+	int side = (int)ceil( pow( (double)m_numInstances, 1.0 / 3.0 ) - 0.0001 );
+	float spacing = getSpacing( modelRadius );
+	float halfExtent = qMax( 0.5f * spacing * float( side - 1 ), 0.0001f );
+	float ballRadius = 0.62f * spacing * float( side ); // (3/4pi)^(1/3)
+	unsigned int seed = 12345;
+
+	m_instances.resize( m_numInstances );
+	instance_t* instances = m_instances.data();
+
+	for( int i = 0 ; i < m_numInstances ; i++ )
+	{
+		vec3_t position;
+		float scale = 1.0f;
+		float angle = 0.0f;
+
+		if( m_layout == IScene::INSTANCES_GRID )
+		{
+			position.x = float( i % side ) * spacing - halfExtent;
+			position.y = float( ( i / side ) % side ) * spacing - halfExtent;
+			position.z = float( i / ( side * side ) ) * spacing - halfExtent;
+		}
+		else
+		{
+			// uniform inside the ball
+			do {
+				position.x = 2.0f * randomFloat( seed ) - 1.0f;
+				position.y = 2.0f * randomFloat( seed ) - 1.0f;
+				position.z = 2.0f * randomFloat( seed ) - 1.0f;
+			} while( position.x * position.x + position.y * position.y + position.z * position.z > 1.0f );
+
+			position = position * ( ballRadius - modelRadius );
+			scale = 0.5f + 0.5f * randomFloat( seed );
+			angle = 6.2831853f * randomFloat( seed );
+		}
+
+		// scaled rotation around the Y axis, then translation
+		float c = cosf( angle ) * scale;
+		float s = sinf( angle ) * scale;
+		float* m = instances[ i ].transform.toFloatPointer();
+		m[ 0] = c;		m[ 4] = 0.0f;	m[ 8] = s;		m[12] = position.x;
+		m[ 1] = 0.0f;	m[ 5] = scale;	m[ 9] = 0.0f;	m[13] = position.y;
+		m[ 2] = -s;		m[ 6] = 0.0f;	m[10] = c;		m[14] = position.z;
+		m[ 3] = 0.0f;	m[ 7] = 0.0f;	m[11] = 0.0f;	m[15] = 1.0f;
+
+		// color from position
+		float extent = ( m_layout == IScene::INSTANCES_GRID ) ? halfExtent : ballRadius;
+		instances[ i ].color = vec4_t(
+			0.5f + 0.5f * qBound( -1.0f, position.x / extent, 1.0f ),
+			0.5f + 0.5f * qBound( -1.0f, position.y / extent, 1.0f ),
+			0.5f + 0.5f * qBound( -1.0f, position.z / extent, 1.0f ), 1.0f );
+	}
+
+	// upload
+	glBindBuffer( GL_ARRAY_BUFFER, m_buffer );
+	glBufferData( GL_ARRAY_BUFFER, sizeof(instance_t) * m_numInstances, instances, GL_STATIC_DRAW );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+	m_builtInstances = m_numInstances;
+	m_builtLayout = m_layout;
+	m_builtRadius = modelRadius;
+}
+
+
+/*
+========================
+bindInstanceArrays
+========================
+*/
+void CInstanceState::bindInstanceArrays( const VertexAttribLocations & attribs )
+{
+	glBindBuffer( GL_ARRAY_BUFFER, m_buffer );
+
+	// a mat4 attribute uses four consecutive locations, one per column.
+	if( attribs.instanceTransform != -1 )
+	{
+		for( int i = 0 ; i < 4 ; i++ )
+		{
+			glVertexAttribPointer( attribs.instanceTransform + i, 4, GL_FLOAT, GL_FALSE,
+				sizeof(instance_t), (const char*)NULL + sizeof(vec4_t) * i );
+			glEnableVertexAttribArray( attribs.instanceTransform + i );
+			smglVertexAttribDivisor( attribs.instanceTransform + i, 1 );
+		}
+	}
+
+	if( attribs.instanceColor != -1 )
+	{
+		glVertexAttribPointer( attribs.instanceColor, 4, GL_FLOAT, GL_FALSE,
+			sizeof(instance_t), (const char*)NULL + sizeof(mat4_t) );
+		glEnableVertexAttribArray( attribs.instanceColor );
+		smglVertexAttribDivisor( attribs.instanceColor, 1 );
+	}
+
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+
+/*
+========================
+unbindInstanceArrays
+
+ the divisor is vertex array state, so it must be reset.
+========================
+*/
+void CInstanceState::unbindInstanceArrays( const VertexAttribLocations & attribs )
+{
+	if( attribs.instanceTransform != -1 )
+	{
+		for( int i = 0 ; i < 4 ; i++ )
+		{
+			smglVertexAttribDivisor( attribs.instanceTransform + i, 0 );
+			glDisableVertexAttribArray( attribs.instanceTransform + i );
+		}
+	}
+
+	if( attribs.instanceColor != -1 )
+	{
+		smglVertexAttribDivisor( attribs.instanceColor, 0 );
+		glDisableVertexAttribArray( attribs.instanceColor );
+	}
+}
+
+
+/*
+========================
+render
+========================
+*/
+void CInstanceState::render( IModel* model, const VertexAttribLocations & attribs, bool programAvailable )
+{
+	m_lastDrawInstanced = false;
+	updateInstances( model->getBoundingRadius() );
+
+	// the fixed function pipeline can't read the instance attributes
+	if( programAvailable && smglIsInstancingAvailable() )
+	{
+		bindInstanceArrays( attribs );
+		m_lastDrawInstanced = model->renderInstanced( &attribs, m_numInstances );
+		unbindInstanceArrays( attribs );
+	}
+
+	m_numDrawnInstances = m_numInstances;
+	if( !m_lastDrawInstanced )
+	{
+		// one draw call per instance, a million of them would stall the GUI
+		m_numDrawnInstances = qMin( m_numInstances, CONFIG_MAX_LOOP_INSTANCES );
+		renderLoop( model, attribs, programAvailable );
+	}
+}
+
+
+/*
+========================
+renderLoop
+
+ draws the instances one by one.
+========================
+*/
+void CInstanceState::renderLoop( IModel* model, const VertexAttribLocations & attribs, bool programAvailable )
+{
+	const instance_t* instances = m_instances.constData();
+
+	glMatrixMode( GL_MODELVIEW );
+
+	for( int i = 0 ; i < m_numDrawnInstances ; i++ )
+	{
+		const instance_t & instance = instances[ i ];
+
+		if( programAvailable )
+		{
+			// constant attributes, the program applies the transformation.
+			if( attribs.instanceTransform != -1 )
+			{
+				const float* m = instance.transform.toConstFloatPointer();
+				for( int k = 0 ; k < 4 ; k++ ) {
+					glVertexAttrib4fv( attribs.instanceTransform + k, m + 4 * k );
+				}
+			}
+
+			if( attribs.instanceColor != -1 ) {
+				glVertexAttrib4fv( attribs.instanceColor, instance.color.toFloatPointer() );
+			}
+
+			model->render( &attribs );
+		}
+		else
+		{
+			glPushMatrix();
+			glMultMatrixf( instance.transform.toConstFloatPointer() );
+			model->render( &attribs, &instance.color );
+			glPopMatrix();
+		}
+	}
+}
+
+
+
 //=============================================================================
 //	IScene implementation
 //=============================================================================
@@ -842,6 +1275,7 @@ public:
 
 	// viewport
 	void setClearColor( const vec4_t & color ) { m_clearColor = color; }
+	void setMouseState( const vec4_t & mouse ) { m_mouse = mouse; }
 
 	// state flags
 	void setUseProgram( bool enable ) { m_useProgram = enable; }
@@ -851,7 +1285,24 @@ public:
 	void setShowNormals( bool enable ) { m_showNormals = enable; }
 	void setShowBoundingBox( bool enable ) { m_showBoundingBox = enable; }
 	void setShowTangents( bool enable ) { m_showTangents = enable; }
+	void setDebugLineLength( float scale ) { m_debugLineLength = scale; }
+	void setDebugLineDensity( int step ) { m_debugLineStep = qMax( step, 1 ); }
+
+	// stress test
+	void setNumInstances( int numInstances ) { m_instances.setNumInstances( numInstances ); }
+	int  getNumInstances( void ) { return m_instances.getNumInstances(); }
+	void setInstanceLayout( int layout ) { m_instances.setLayout( layout ); }
+	QString getStatisticsText( void );
+
+	// transform feedback
+	void requestCapture( const QStringList & varyings );
+	bool isCapturePending( void ) { return m_capturePending; }
+	const FeedbackCapture & getCapture( void ) { return m_capture; }
 
+	// geometry shader output measurement
+	void requestGeometryTuning( void ) { m_geometryTuningStep = TUNING_START; }
+	bool isGeometryTuningPending( void ) { return m_geometryTuningStep != TUNING_IDLE; }
+	const GeometryTuning & getGeometryTuning( void ) { return m_geometryTuning; }
 
 private:
 
@@ -861,6 +1312,9 @@ private:
 	void drawOrigin( void );
 	void drawBoundingBox( const vec3_t & mins, const vec3_t & maxs );
 	void calcLightAutoRotateMatrix( mat4_t & m );
+	void updateStatistics( int numInstances, qint64 deformTime, qint64 drawTime, int uploadedBytes, int uniformUploads );
+	void stepGeometryTuning( void );
+	int  probeGeometryOutput( int numOutputVertices, int numDraws, double* msPerDraw, QString & error );
 
 	// state flags
 	bool m_enableBFC; // back face culling
@@ -871,17 +1325,67 @@ private:
 	bool m_showBoundingBox;
 	bool m_showTangents;
 
+	// normal and tangent lines
+	float	m_debugLineLength;
+	int		m_debugLineStep;
+
 	// sub-objects
 	CTextureState  m_textures;
 	CCameraState   m_camera;
 	CLightingState m_lighting;
+	CInstanceState m_instances;
 
 	// time since initialization
 	QTime m_time;
 
+	// instances per second, measured over one second
+	int		m_statInstances;
+	int		m_statStartTime;
+	double	m_instancesPerSecond;
+
+	// animated models, averaged over the same second
+	int		m_statFrames;
+	int		m_statAnimatedFrames;
+	qint64	m_statDeformTime;	// nanoseconds
+	qint64	m_statDrawTime;		// nanoseconds
+	qint64	m_statUploadedBytes;
+	double	m_deformMsPerFrame;
+	double	m_drawMsPerFrame;
+	double	m_uploadMBPerSecond;
+	bool	m_modelAnimated;
+
+	// uniform values passed by the program, averaged over the frames using it
+	int		m_statProgramFrames;
+	int		m_statUniformUploads;
+	double	m_uniformUploadsPerFrame;
+
+	// transform feedback capture of the next frame
+	bool			m_capturePending;
+	FeedbackCapture	m_capture;
+
+	// geometry shader output measurement, one probe per frame
+	enum geometryTuningStep_e
+	{
+		TUNING_IDLE,
+		TUNING_START,
+		TUNING_REFERENCE,		// probe the largest value
+		TUNING_SEARCH,			// binary search between m_tuningLower and m_tuningUpper
+		TUNING_TIME_DECLARED,	// time the declared value
+		TUNING_TIME_TUNED,		// time the tuned value
+	};
+	int				m_geometryTuningStep;
+	int				m_tuningLower;
+	int				m_tuningUpper;
+	int				m_tuningReference;	// primitives emitted with the largest value
+	GeometryTuning	m_geometryTuning;
+
 	// viewport clear color
 	vec4_t m_clearColor;
 
+	// passed to the built-in uniforms
+	vec4_t	m_mouse;
+	int		m_frameIndex;
+
 	// current test model
 	IModel*	m_model;
 
@@ -904,7 +1408,35 @@ CScene::CScene( void )
 	m_showBoundingBox = false;
 	m_showTangents = false;
 
+	m_debugLineLength = 1.0f;
+	m_debugLineStep = 1;
+
 	m_model = NULL;
+	m_frameIndex = 0;
+
+	m_statInstances = 0;
+	m_statStartTime = 0;
+	m_instancesPerSecond = 0.0;
+
+	m_statFrames = 0;
+	m_statAnimatedFrames = 0;
+	m_statDeformTime = 0;
+	m_statDrawTime = 0;
+	m_statUploadedBytes = 0;
+	m_deformMsPerFrame = 0.0;
+	m_drawMsPerFrame = 0.0;
+	m_uploadMBPerSecond = 0.0;
+	m_modelAnimated = false;
+
+	m_statProgramFrames = 0;
+	m_statUniformUploads = 0;
+	m_uniformUploadsPerFrame = -1.0;
+
+	m_capturePending = false;
+	m_geometryTuningStep = TUNING_IDLE;
+	m_tuningLower = 0;
+	m_tuningUpper = 0;
+	m_tuningReference = 0;
 }
 
 CScene::~CScene( void )
@@ -935,9 +1467,11 @@ void CScene::init( void )
 	m_shader->init();
 	m_textures.init();
 	m_lighting.init();
+	m_instances.init();
 
 	// start the timer
 	m_time.start();
+	m_statStartTime = 0;
 }
 
 
@@ -949,6 +1483,7 @@ shutdown
 void CScene::shutdown( void )
 {
 	// shutdown sub-objects.
+	m_instances.shutdown();
 	m_lighting.shutdown();
 	m_textures.shutdown();
 	m_shader->shutdown();
@@ -981,7 +1516,8 @@ void CScene::render( void )
 	//
 	glMatrixMode( GL_PROJECTION );
 	glLoadIdentity();
-	m_camera.applyProjectionMatrix( m_model != NULL ? m_model->getBoundingRadius() : 1.0f );
+	m_camera.applyProjectionMatrix( m_model != NULL ?
+		m_instances.getBoundingRadius( m_model->getBoundingRadius() ) : 1.0f );
 
 	// setup camera
 	glMatrixMode( GL_MODELVIEW );
@@ -991,6 +1527,8 @@ void CScene::render( void )
 	// draw something
 	drawTestModel( lightRotate );
 	drawHelperGeometry( lightRotate );
+
+	m_frameIndex++;
 }
 
 
@@ -1005,11 +1543,31 @@ void CScene::drawTestModel( const mat4_t & lightRotateMatrix )
 {
 	// no model...
 	if( m_model == NULL )
+	{
+		if( m_capturePending )
+		{
+			m_capture = FeedbackCapture();
+			m_capture.error = QString( "There is no test model." );
+			m_capturePending = false;
+		}
+		if( m_geometryTuningStep != TUNING_IDLE )
+		{
+			m_geometryTuning = GeometryTuning();
+			m_geometryTuning.error = QString( "There is no test model." );
+			m_geometryTuningStep = TUNING_IDLE;
+		}
 		return;
+	}
 
 	VertexAttribLocations attribs;
 	bool programAvailable = false;
 	mat4_t viewMatrix;
+	QElapsedTimer timer;
+
+	// deform animated models on the CPU, before any GL work is issued
+	timer.start();
+	bool animated = m_model->animate( float( m_time.elapsed() ) * 0.001f );
+	qint64 deformTime = animated ? timer.nsecsElapsed() : 0;
 
 	// setup lighting
 	m_camera.getModelViewMatrix( viewMatrix );
@@ -1030,18 +1588,309 @@ void CScene::drawTestModel( const mat4_t & lightRotateMatrix )
 		glDisable( GL_CULL_FACE );
 	}
 
+	// values of the built-in uniforms, before any program is bound
+	if( m_useProgram )
+	{
+		FrameInputs inputs;
+		GLfloat vp[ 4 ];
+		glGetFloatv( GL_VIEWPORT, vp );
+		inputs.frame = m_frameIndex;
+		inputs.resolution = vec3_t( vp[ 2 ], vp[ 3 ], 1.0f );
+		inputs.mouse = m_mouse;
+		inputs.viewMatrix = viewMatrix;
+		glGetFloatv( GL_PROJECTION_MATRIX, inputs.projectionMatrix.toFloatPointer() );
+		m_model->getBoundingBox( inputs.boundsMin, inputs.boundsMax );
+		m_shader->setFrameInputs( inputs );
+	}
+
+	// measure before the regular draw, the probes draw nothing
+	if( m_geometryTuningStep != TUNING_IDLE ) {
+		stepGeometryTuning();
+	}
+
 	//
 	// try using the shader program for rendering.
+	// a requested capture replaces it with the capture program.
 	//
+	bool capturing = false;
+	if( m_useProgram && m_capturePending )
+	{
+		QString error;
+		capturing = m_shader->beginCapture( attribs, m_model->getPrimitiveType(), CONFIG_MAX_CAPTURE_BYTES, error );
+		if( !capturing ) {
+			m_capture = FeedbackCapture();
+			m_capture.error = error;
+		}
+	}
 	if( m_useProgram ) {
-		programAvailable = m_shader->bindState( attribs );
+		programAvailable = capturing || m_shader->bindState( attribs );
 	}
 	if( !programAvailable ) { // not available, use fixed function pipeline.
 		glUseProgram( 0 );
 	}
 
-	// now render the model
-	m_model->render( &attribs );
+	// now render the model, this includes uploading the deformed vertices.
+	timer.start();
+	int numDrawnInstances = 1;
+	if( m_instances.getNumInstances() > 1 )
+	{
+		m_instances.render( m_model, attribs, programAvailable );
+		numDrawnInstances = m_instances.getNumDrawnInstances();
+	}
+	else
+	{
+		m_model->render( &attribs );
+	}
+	qint64 drawTime = timer.nsecsElapsed();
+
+	if( m_capturePending )
+	{
+		if( capturing ) {
+			m_shader->endCapture( m_capture );
+		} else if( !m_useProgram ) {
+			m_capture = FeedbackCapture();
+			m_capture.error = QString( "The fixed function pipeline can't be captured." );
+		}
+		m_capturePending = false;
+	}
+
+	// the capture program is set up by beginCapture(), not bindState()
+	int uniformUploads = ( programAvailable && !capturing ) ? m_shader->getNumUniformUploads() : -1;
+
+	updateStatistics( numDrawnInstances, deformTime, drawTime, m_model->getUploadedBytes(), uniformUploads );
+}
+
+
+/*
+========================
+updateStatistics
+
+ counts the drawn instances, the rate is updated once per second.
+ The deformation and draw times are CPU times, the draw time is the
+ time spent submitting the model, not the time the GPU needs.
+ uniformUploads is -1 if the program was not bound.
+========================
+*/
+void CScene::updateStatistics( int numInstances, qint64 deformTime, qint64 drawTime, int uploadedBytes, int uniformUploads )
+{
+	m_statInstances += numInstances;
+	m_statFrames++;
+	m_statDrawTime += drawTime;
+	m_statUploadedBytes += uploadedBytes;
+	if( deformTime > 0 )
+	{
+		m_statAnimatedFrames++;
+		m_statDeformTime += deformTime;
+	}
+	if( uniformUploads >= 0 )
+	{
+		m_statProgramFrames++;
+		m_statUniformUploads += uniformUploads;
+	}
+
+	int now = m_time.elapsed();
+	int duration = now - m_statStartTime;
+	if( duration >= 1000 )
+	{
+		m_instancesPerSecond = double( m_statInstances ) * 1000.0 / double( duration );
+		m_deformMsPerFrame = double( m_statDeformTime ) * 1.0e-6 / double( qMax( m_statAnimatedFrames, 1 ) );
+		m_drawMsPerFrame = double( m_statDrawTime ) * 1.0e-6 / double( m_statFrames );
+		m_uploadMBPerSecond = double( m_statUploadedBytes ) * 1000.0 / ( double( duration ) * 1048576.0 );
+		m_modelAnimated = ( m_statAnimatedFrames > 0 );
+		m_uniformUploadsPerFrame = ( m_statProgramFrames > 0 ) ?
+			double( m_statUniformUploads ) / double( m_statProgramFrames ) : -1.0;
+
+		m_statInstances = 0;
+		m_statFrames = 0;
+		m_statAnimatedFrames = 0;
+		m_statDeformTime = 0;
+		m_statDrawTime = 0;
+		m_statUploadedBytes = 0;
+		m_statProgramFrames = 0;
+		m_statUniformUploads = 0;
+		m_statStartTime = now;
+	}
+}
+
+
+/*
+========================
+getStatisticsText
+========================
+*/
+QString CScene::getStatisticsText( void )
+{
+	QString text;
+
+	if( m_model != NULL && m_instances.getNumInstances() > 1 )
+	{
+		text += QString( "%1 instances (%2)\n%3 instances/s" )
+			.arg( m_instances.getNumInstances() )
+			.arg( m_instances.getLastDrawInstanced() ? "instanced" : "loop" )
+			.arg( m_instancesPerSecond, 0, 'f', 0 );
+	}
+
+	if( m_model != NULL && m_modelAnimated )
+	{
+		if( !text.isEmpty() ) {
+			text += "\n";
+		}
+
+		text += QString( "deform %1 ms, draw %2 ms\nupload %3 MB/s" )
+			.arg( m_deformMsPerFrame, 0, 'f', 2 )
+			.arg( m_drawMsPerFrame, 0, 'f', 2 )
+			.arg( m_uploadMBPerSecond, 0, 'f', 1 );
+	}
+
+	if( m_model != NULL && m_uniformUploadsPerFrame >= 0.0 )
+	{
+		if( !text.isEmpty() ) {
+			text += "\n";
+		}
+
+		text += QString( "uniforms %1 calls/frame" )
+			.arg( m_uniformUploadsPerFrame, 0, 'f', 1 );
+	}
+
+	return text;
+}
+
+
+/*
+========================
+probeGeometryOutput
+
+ draws the model with a copy of the program and returns the primitives
+ emitted per draw, -1 on failure. The time includes the GPU work.
+========================
+*/
+int CScene::probeGeometryOutput( int numOutputVertices, int numDraws, double* msPerDraw, QString & error )
+{
+	VertexAttribLocations attribs;
+	if( !m_shader->beginGeometryProbe( attribs, numOutputVertices, error ) )
+		return -1;
+
+	QElapsedTimer timer;
+	glFinish();
+	timer.start();
+
+	for( int i = 0 ; i < numDraws ; i++ )
+	{
+		if( m_instances.getNumInstances() > 1 ) {
+			m_instances.render( m_model, attribs, true );
+		} else {
+			m_model->render( &attribs );
+		}
+	}
+
+	glFinish();
+	qint64 time = timer.nsecsElapsed();
+
+	int numPrimitives = m_shader->endGeometryProbe();
+
+	if( msPerDraw != NULL ) {
+		*msPerDraw = double( time ) * 1.0e-6 / double( numDraws );
+	}
+
+	return numPrimitives / numDraws;
+}
+
+
+/*
+========================
+stepGeometryTuning
+
+ the number of emitted primitives grows with GL_GEOMETRY_VERTICES_OUT until
+ nothing is truncated anymore, so a binary search finds the smallest value
+ that emits as many primitives as the largest one.
+ every probe links the program again, so each frame runs only one of them.
+========================
+*/
+void CScene::stepGeometryTuning( void )
+{
+	GeometryTuning & t = m_geometryTuning;
+	int n;
+
+	switch( m_geometryTuningStep )
+	{
+	case TUNING_START:
+		t = GeometryTuning();
+		t.declared = m_shader->getGeometryOutputNum();
+		m_tuningUpper = m_shader->getMaxGeometryOutputNum();
+		m_geometryTuningStep = TUNING_REFERENCE;
+		// fall through
+
+	case TUNING_REFERENCE:
+		n = probeGeometryOutput( m_tuningUpper, 1, NULL, t.error );
+		if( n < 0 )
+		{
+			// the GL maximum may exceed the output component limit of the shader
+			if( m_tuningUpper > t.declared )
+			{
+				m_tuningUpper = t.declared;
+				t.error = QString();
+				return;
+			}
+			break;
+		}
+
+		// without instancing fewer instances may be drawn than requested
+		t.inputPrimitives = m_model->getNumPrimitives() *
+			( m_instances.getNumInstances() > 1 ? m_instances.getNumDrawnInstances() : 1 );
+		m_tuningReference = n;
+		m_tuningLower = 1;
+		m_geometryTuningStep = TUNING_SEARCH;
+		return;
+
+	case TUNING_SEARCH:
+		if( m_tuningLower < m_tuningUpper )
+		{
+			int middle = ( m_tuningLower + m_tuningUpper ) / 2;
+			n = probeGeometryOutput( middle, 1, NULL, t.error );
+			if( n < 0 )
+				break;
+
+			if( n >= m_tuningReference ) {
+				m_tuningUpper = middle;
+			} else {
+				m_tuningLower = middle + 1;
+			}
+			return;
+		}
+
+		t.tuned = m_tuningUpper;
+		t.outputPrimitives = m_tuningReference;
+		m_geometryTuningStep = TUNING_TIME_DECLARED;
+		// fall through
+
+	// compare the geometry stage time
+	case TUNING_TIME_DECLARED:
+		t.declaredPrimitives = probeGeometryOutput( t.declared, CONFIG_GEOMETRY_TUNING_DRAWS, &t.msDeclared, t.error );
+		if( t.declaredPrimitives < 0 )
+			break;
+
+		m_geometryTuningStep = TUNING_TIME_TUNED;
+		return;
+
+	case TUNING_TIME_TUNED:
+		probeGeometryOutput( t.tuned, CONFIG_GEOMETRY_TUNING_DRAWS, &t.msTuned, t.error );
+		break;
+	}
+
+	// done, or failed with t.error
+	m_geometryTuningStep = TUNING_IDLE;
+}
+
+
+/*
+========================
+requestCapture
+========================
+*/
+void CScene::requestCapture( const QStringList & varyings )
+{
+	m_shader->setCaptureVaryings( varyings );
+	m_capturePending = true;
 }
 
 
@@ -1069,12 +1918,12 @@ void CScene::drawHelperGeometry( const mat4_t & lightRotateMatrix )
 	{
 		// draw normals if requested
 		if( m_showNormals ) {
-			m_model->renderNormals();
+			m_model->renderNormals( m_debugLineLength, m_debugLineStep );
 		}
 
 		// show tangent space basis
 		if( m_showTangents ) {
-			m_model->renderTangents();
+			m_model->renderTangents( m_debugLineLength, m_debugLineStep );
 		}
 
 		// draw bounding box
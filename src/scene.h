@@ -16,6 +16,9 @@
 #ifndef __SCENE_H_ICNLDUDED__
 #define __SCENE_H_ICNLDUDED__
 
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
 #include "vector.h"
 
 // forward declarations
@@ -24,6 +27,7 @@ class IShader;
 class ICameraState;
 class ILightingState;
 class ITextureState;
+class FeedbackCapture;
 
 
 //=============================================================================
@@ -39,6 +43,38 @@ class ITextureState;
 class IScene
 {
 public:
+	/** Arrangements of the test model instances, see setInstanceLayout(). */
+	enum instanceLayout_e
+	{
+		INSTANCES_GRID,		///< regular cube shaped grid
+		INSTANCES_RANDOM,	///< random positions, scales and rotations inside a ball
+	};
+
+	/** Result of a geometry shader output measurement, see requestGeometryTuning(). */
+	class GeometryTuning
+	{
+	public:
+		GeometryTuning( void ) : declared( 0 ), tuned( 0 ), inputPrimitives( 0 ), outputPrimitives( 0 ),
+			declaredPrimitives( 0 ), msDeclared( 0.0 ), msTuned( 0.0 ) {}
+
+		int		declared;			///< GL_GEOMETRY_VERTICES_OUT of the program
+		int		tuned;				///< smallest value that emits all primitives
+		int		inputPrimitives;	///< primitives drawn per frame
+		int		outputPrimitives;	///< primitives emitted with the largest value
+		int		declaredPrimitives;	///< primitives emitted with the declared value
+		double	msDeclared;			///< geometry stage time with the declared value
+		double	msTuned;			///< geometry stage time with the tuned value
+		QString	error;				///< empty if the measurement succeeded
+
+		/** Returns the emitted primitives per input primitive. */
+		double getAmplification( void ) const {
+			return inputPrimitives > 0 ? double( outputPrimitives ) / double( inputPrimitives ) : 0.0;
+		}
+
+		/** Returns true if the declared value drops primitives. */
+		bool isTruncating( void ) const { return declaredPrimitives < outputPrimitives; }
+	};
+
 	/** Creates a IScene object.
 	 * The object must then be initialized with init() in order to use it.
 	 */
@@ -82,6 +118,11 @@ public:
 	 */
 	virtual void setClearColor( const vec4_t & color ) = 0;
 
+	/** Sets the mouse state passed to the 'mouse' uniform.
+	 * @param mouse See FrameInputs::mouse, in viewport pixels.
+	 */
+	virtual void setMouseState( const vec4_t & mouse ) = 0;
+
 
 	/** Sets the current test model.
 	 * The default test model is NULL.
@@ -126,6 +167,16 @@ public:
 	 */
 	virtual void setShowTangents( bool enable ) = 0;
 
+	/** Sets the length of the normal and tangent space lines.
+	 * The value scales the default length, the default is 1.
+	 */
+	virtual void setDebugLineLength( float scale ) = 0;
+
+	/** Sets the density of the normal and tangent space lines.
+	 * Only the lines of every step-th vertex are drawn. The default is 1.
+	 */
+	virtual void setDebugLineDensity( int step ) = 0;
+
 	/** Sets the 'draw as wireframe' flag.
 	 * If this is set, GL_POLYGON_MODE will be set to GL_LINES for the test model.
 	 * Otherwise if is GL_FILL.
@@ -138,6 +189,62 @@ public:
 	 * The default is false.
 	 */
 	virtual void setBackFaceCulling( bool enable ) = 0;
+
+
+	/** Sets the number of test model instances.
+	 * If this is greater than one, the test model is drawn that many times
+	 * with a single instanced draw call. The shader program reads the
+	 * per-instance transformation and color from the 'attrInstanceTransform'
+	 * (mat4) and 'attrInstanceColor' (vec4) vertex attributes.
+	 * If instancing is not available, the instances are drawn in a loop.
+	 * The default is 1, the maximum is CONFIG_MAX_INSTANCES.
+	 */
+	virtual void setNumInstances( int numInstances ) = 0;
+
+	/** Returns the number of test model instances, see setNumInstances(). */
+	virtual int getNumInstances( void ) = 0;
+
+	/** Sets the arrangement of the test model instances.
+	 * @param layout One of instanceLayout_e. The default is INSTANCES_GRID.
+	 */
+	virtual void setInstanceLayout( int layout ) = 0;
+
+	/** Returns rendering statistics to show in the viewport.
+	 * The text may contain several lines, it is empty if there is nothing to report.
+	 */
+	virtual QString getStatisticsText( void ) = 0;
+
+
+	/** Records the output of the program during the next frame.
+	 * The vertices emitted by the last stage before rasterization are
+	 * captured with transform feedback, see IShader::beginCapture().
+	 * The capture buffer holds at most CONFIG_MAX_CAPTURE_BYTES.
+	 * @param varyings Names of the recorded varyings, e.g. gl_Position.
+	 */
+	virtual void requestCapture( const QStringList & varyings ) = 0;
+
+	/** Returns true until the frame requested by requestCapture() was rendered. */
+	virtual bool isCapturePending( void ) = 0;
+
+	/** Returns the result of the last capture. */
+	virtual const FeedbackCapture & getCapture( void ) = 0;
+
+
+	/** Measures the geometry shader output during the next frames.
+	 * The program is linked again with different GL_GEOMETRY_VERTICES_OUT
+	 * values, a binary search finds the smallest one that emits as many
+	 * primitives as the GL maximum. Each frame links only one of them,
+	 * so the window stays responsive. The result is only valid for the current
+	 * model and uniform values. The program itself is not changed.
+	 * The geometry stage is then timed with the declared and the tuned value.
+	 */
+	virtual void requestGeometryTuning( void ) = 0;
+
+	/** Returns true until the measurement requested by requestGeometryTuning() is done. */
+	virtual bool isGeometryTuningPending( void ) = 0;
+
+	/** Returns the result of the last geometry shader output measurement. */
+	virtual const GeometryTuning & getGeometryTuning( void ) = 0;
 };
 
 
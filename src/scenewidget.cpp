@@ -17,15 +17,97 @@
 #include <QColorDialog>
 #include <QFileDialog>
 #include <QMessageBox>
-#include <QLineEdit>
-#include <QValidator>
+#include <QDialog>
+#include <QVBoxLayout>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QtCore/QTimer>
 
 #include "application.h"
 #include "scene.h"
 #include "scenewidget.h"
 #include "camera.h"
 #include "model.h"
+#include "modelcache.h"
 #include "shader.h"
+#include "benchmark.h"
+#include "feedback.h"
+#include "modelbuilder.h"
+
+
+//=============================================================================
+//	test models
+//=============================================================================
+
+/** The slots of the test model list.
+ * The plane and the cube depend on the vertex density and are shared
+ * with the model cache, they are acquired on the GUI thread when needed.
+ * The other procedural models are built by the model builder.
+ */
+enum testModel_e
+{
+	MODEL_POINT,
+	MODEL_PLANE,
+	MODEL_CUBE,
+	MODEL_SPHERE,
+	MODEL_TORUS,
+	MODEL_MESH,
+	MODEL_LINES,
+	MODEL_LINE_STRIP,
+	MODEL_LINE_STRIP_ADJACENCY,
+	MODEL_TWISTING_CYLINDER,
+	MODEL_MORPHING_SPHERE,
+
+	NUM_TEST_MODELS,
+};
+
+/** Names and primitive types, they are needed before the models are built. */
+static const struct testModelInfo_s
+{
+	const char*	name;
+	int			primitiveType;
+} testModelInfos[ NUM_TEST_MODELS ] =
+{
+	{ "Single Point",		GL_POINTS },
+	{ "Plane",				GL_TRIANGLES },
+	{ "Cube",				GL_TRIANGLES },
+	{ "Sphere",				GL_TRIANGLES },
+	{ "Torus",				GL_TRIANGLES },
+	{ "Mesh",				GL_TRIANGLES },
+	{ "Lines",				GL_LINES },
+	{ "Line Strip",			GL_LINE_STRIP },
+	{ "Line Strip Adj",		GL_LINE_STRIP_ADJACENCY },
+	{ "Twisting Cylinder",	GL_TRIANGLES },
+	{ "Morphing Sphere",	GL_TRIANGLES },
+};
+
+
+/** Builds one of the density independent test models on the worker thread. */
+class CTestModelJob : public IModelJob
+{
+public:
+	CTestModelJob( int model ) : m_model( model ) {}
+
+	IModel* build( void )
+	{
+		switch( m_model )
+		{
+		case MODEL_POINT:				return IModel::createPoint();
+		case MODEL_SPHERE:				return IModel::createSphere( 32, 64, 1.0f );
+		case MODEL_TORUS:				return IModel::createTorus( 32, 24, 1.0f, 0.5f );
+		case MODEL_LINES:				return IModel::createLineStrip( "Lines", GL_LINES );
+		case MODEL_LINE_STRIP:			return IModel::createLineStrip( "Line Strip", GL_LINE_STRIP );
+		case MODEL_LINE_STRIP_ADJACENCY: return IModel::createLineStrip( "Line Strip Adj", GL_LINE_STRIP_ADJACENCY );
+		case MODEL_TWISTING_CYLINDER:	return IModel::createTwistingCylinder( CONFIG_ANIMATED_MODEL_RINGS, 64, 0.4f, 2.0f, 8 );
+		case MODEL_MORPHING_SPHERE:		return IModel::createMorphingSphere( CONFIG_ANIMATED_MODEL_RINGS, 2 * CONFIG_ANIMATED_MODEL_RINGS, 1.0f );
+		}
+
+		return NULL;
+	}
+
+private:
+	int m_model; // testModel_e
+};
 
 
 //=============================================================================
@@ -35,12 +117,17 @@
 // construction
 CSceneWidget::CSceneWidget( IScene* scene ) : m_scene( scene )
 {
+	m_modelCache = NULL;
+	m_benchmark = NULL;
+	m_modelBuilder = NULL;
+	m_capturePending = false;
+	m_geometryTuningPending = false;
 	m_models = NULL;
 	m_numModels = 0;
 	m_meshModelIndex = -1;
 	m_meshModel = NULL;
 	m_meshFileName = QString( "" );
-    m_vertexDensityLevel=7;
+	m_vertexDensityQuads = CONFIG_DEFAULT_GRID_RESOLUTION;
 
 	//
 	// setup geometry state widgets
@@ -55,7 +142,14 @@ CSceneWidget::CSceneWidget( IScene* scene ) : m_scene( scene )
 	m_activeModel         = new QComboBox();
 	QLabel* testModelText = new QLabel( "Test Model:" );
 	QGroupBox* groupModel = new QGroupBox( "Geometry Processing" );
-    m_vertexDensity       = new QLineEdit("7");
+	m_vertexDensity       = new QSpinBox();
+	m_vertexDensitySlider = new QSlider( Qt::Horizontal );
+	m_numInstances        = new QSpinBox();
+	m_instanceLayout      = new QComboBox();
+	m_instanceLayout->addItem( QString( "Grid" ), QVariant( (int)IScene::INSTANCES_GRID ) );
+	m_instanceLayout->addItem( QString( "Random" ), QVariant( (int)IScene::INSTANCES_RANDOM ) );
+	m_debugLineLength     = new QDoubleSpinBox();
+	m_debugLineDensity    = new QSpinBox();
 	QGridLayout* groupModelLayout = new QGridLayout();
     groupModelLayout->addWidget( testModelText,        0,0, 1,1 );
 	groupModelLayout->addWidget( m_activeModel,        0,1, 1,1 );
@@ -66,8 +160,17 @@ CSceneWidget::CSceneWidget( IScene* scene ) : m_scene( scene )
 	groupModelLayout->addWidget( m_chkShowNormals,     5,0, 1,2 );
 	groupModelLayout->addWidget( m_chkShowBoundingBox, 6,0, 1,2 );
 	groupModelLayout->addWidget( m_chkShowTangents,    7,0, 1,2 );
-    groupModelLayout->addWidget( new QLabel("Vertex Density(1,20):"),      8,0, 1,1 );
-    groupModelLayout->addWidget( m_vertexDensity,      8,1, 1,1 );
+	groupModelLayout->addWidget( new QLabel( "Vertex Density:" ), 8,0, 1,1 );
+	groupModelLayout->addWidget( m_vertexDensity,      8,1, 1,1 );
+	groupModelLayout->addWidget( m_vertexDensitySlider, 9,0, 1,2 );
+	groupModelLayout->addWidget( new QLabel( "Instances:" ), 10,0, 1,1 );
+	groupModelLayout->addWidget( m_numInstances,       10,1, 1,1 );
+	groupModelLayout->addWidget( new QLabel( "Instance Layout:" ), 11,0, 1,1 );
+	groupModelLayout->addWidget( m_instanceLayout,     11,1, 1,1 );
+	groupModelLayout->addWidget( new QLabel( "Line Length:" ), 12,0, 1,1 );
+	groupModelLayout->addWidget( m_debugLineLength,    12,1, 1,1 );
+	groupModelLayout->addWidget( new QLabel( "Line Density:" ), 13,0, 1,1 );
+	groupModelLayout->addWidget( m_debugLineDensity,   13,1, 1,1 );
 	groupModel->setLayout( groupModelLayout );
 
 	// setup tool tips
@@ -78,7 +181,12 @@ CSceneWidget::CSceneWidget( IScene* scene ) : m_scene( scene )
 	m_chkShowTangents->   setToolTip( "Draws the tangent space vectors for each vertex.\nTangent in red, bitangent in green, normal in blue" );
 	m_chkShowNormals->    setToolTip( "Draws the normal of each vertex.\nThe color is choosen from the greatest normal component." );
 	m_chkShowBoundingBox->setToolTip( "Draws the model's bounding box.\nRed == X axis, green == Y axis, blue == Z axis." );
-    m_vertexDensity->     setToolTip( "How many triangles should be drawn");
+	m_vertexDensity->     setToolTip( "Number of quads along each side of the plane and the cube faces.\nEach quad is drawn as two triangles." );
+	m_vertexDensitySlider->setToolTip( m_vertexDensity->toolTip() );
+	m_numInstances->      setToolTip( "Number of copies of the test model, drawn with a single instanced draw call.\nThe program reads 'attribute mat4 attrInstanceTransform' and 'attribute vec4 attrInstanceColor'." );
+	m_instanceLayout->    setToolTip( "Places the instances on a regular grid or randomly inside a ball." );
+	m_debugLineLength->   setToolTip( "Scales the length of the normal and tangent space lines." );
+	m_debugLineDensity->  setToolTip( "Draws the normal and tangent space lines of every n-th vertex only." );
 
 	//
 	// setup projection mode group
@@ -147,23 +255,75 @@ CSceneWidget::CSceneWidget( IScene* scene ) : m_scene( scene )
     groupGeometryShaderLayout->addWidget( m_geometryOutputNum,	2,1, 2,1 );
 
     groupGeometryShaderLayout->addWidget( relinkWarning,        3,0, 3,2 );
+	m_btnTuneGeometry   = new QPushButton( "Measure Output" );
+	m_chkApplyTuning    = new QCheckBox( "Apply" );
+	m_labGeometryTuning = new QLabel();
+	groupGeometryShaderLayout->addWidget( m_btnTuneGeometry,	6,0, 1,1 );
+	groupGeometryShaderLayout->addWidget( m_chkApplyTuning,		6,1, 1,1 );
+	groupGeometryShaderLayout->addWidget( m_labGeometryTuning,	7,0, 1,2 );
 	m_groupGeometryShader->setLayout( groupGeometryShaderLayout );
+	m_btnTuneGeometry->setToolTip( "Counts the primitives emitted by the geometry shader with GL_PRIMITIVES_GENERATED\n"
+								   "and finds the smallest number of output vertices that does not drop any of them.\n"
+								   "The result is only valid for the current test model and uniform values." );
+	m_chkApplyTuning->setToolTip( "Sets the measured number of output vertices and relinks the program." );
 	m_geometryOutputType->addItem( "GL_POINTS",			QVariant( int(GL_POINTS) ) );
 	m_geometryOutputType->addItem( "GL_LINE_STRIP",		QVariant( int(GL_LINE_STRIP) ) );
 	m_geometryOutputType->addItem( "GL_TRIANGLE_STRIP",	QVariant( int(GL_TRIANGLE_STRIP) ) );
 	m_geometryOutputType->setCurrentIndex( 2 ); // default to GL_TRIANGLE_STRIP
 	relinkWarning->setToolTip( "This is necessary because the primitive\ntypes are required for linking." );
 
+	//
+	// setup benchmark group
+	//
+	m_benchmarkModel = new QComboBox();
+	m_benchmarkModel->addItem( QString( "Sphere" ), QVariant( (int)ITriangleBenchmark::MODEL_SPHERE ) );
+	m_benchmarkModel->addItem( QString( "Plane" ),  QVariant( (int)ITriangleBenchmark::MODEL_PLANE ) );
+	m_btnBenchmark = new QPushButton( QString( "Run Benchmark" ) );
+	QGroupBox* groupBenchmark = new QGroupBox( "Triangle Throughput" );
+	QGridLayout* groupBenchmarkLayout = new QGridLayout();
+	groupBenchmarkLayout->addWidget( m_benchmarkModel,	0,0, 1,1 );
+	groupBenchmarkLayout->addWidget( m_btnBenchmark,	0,1, 1,1 );
+	groupBenchmark->setLayout( groupBenchmarkLayout );
+	m_btnBenchmark->setToolTip( "Draws the model at increasing tessellation with the current program\n"
+								"and measures the triangles per second. The results are saved as CSV." );
+
+	//
+	// setup transform feedback group
+	//
+	m_captureVaryings = new QLineEdit( QString( "gl_Position" ) );
+	m_btnCapture      = new QPushButton( QString( "Capture Frame" ) );
+	m_btnCaptureShow  = new QPushButton( QString( "Show..." ) );
+	m_btnCaptureSave  = new QPushButton( QString( "Save..." ) );
+	m_labCapture      = new QLabel( QString( "-" ) );
+	m_groupCapture    = new QGroupBox( "Transform Feedback" );
+	QGridLayout* groupCaptureLayout = new QGridLayout();
+	groupCaptureLayout->addWidget( new QLabel( "Varyings:" ), 0,0, 1,1 );
+	groupCaptureLayout->addWidget( m_captureVaryings,	0,1, 1,2 );
+	groupCaptureLayout->addWidget( m_btnCapture,		1,0, 1,1 );
+	groupCaptureLayout->addWidget( m_btnCaptureShow,	1,1, 1,1 );
+	groupCaptureLayout->addWidget( m_btnCaptureSave,	1,2, 1,1 );
+	groupCaptureLayout->addWidget( m_labCapture,		2,0, 1,3 );
+	m_groupCapture->setLayout( groupCaptureLayout );
+	m_btnCaptureShow->setEnabled( false );
+	m_btnCaptureSave->setEnabled( false );
+	m_captureVaryings->setToolTip( "Comma separated list of the recorded varyings,\n"
+								   "written by the geometry shader, or by the vertex shader if there is none." );
+	m_btnCapture->setToolTip( QString( "Records the primitives emitted by the program during the next frame.\n"
+									   "At most %1 MB are recorded, the remaining primitives are only counted." )
+									   .arg( CONFIG_MAX_CAPTURE_BYTES / ( 1024 * 1024 ) ) );
+
 	// misc widgets
 	m_btnResetCamera = new QPushButton( QString( "Reset Camera Positon And Orientation" ) );
 
 	// setup layout
 	QGridLayout* layout = new QGridLayout();
-	layout->addWidget( groupModel,            0,0, 3,1 );
+	layout->addWidget( groupModel,            0,0, 5,1 );
 	layout->addWidget( groupProjection,       0,1, 1,1 );
 	layout->addWidget( groupMesh,             1,1, 1,1 );
 	layout->addWidget( m_groupGeometryShader, 2,1, 1,1 );
-	layout->addWidget( m_btnResetCamera,      3,0, 1,2 );
+	layout->addWidget( groupBenchmark,        3,1, 1,1 );
+	layout->addWidget( m_groupCapture,        4,1, 1,1 );
+	layout->addWidget( m_btnResetCamera,      5,0, 1,2 );
 	setLayout( layout );
 
 	// initialize check box state
@@ -174,9 +334,26 @@ CSceneWidget::CSceneWidget( IScene* scene ) : m_scene( scene )
 	pal.setColor( QPalette::Button, QColor(0,0,0) );
 	m_btnClearColor->setPalette( pal );
 
-    // initial vertex density
-    m_vertexDensity->setValidator(new QIntValidator(-1,100));
-    m_vertexDensity->setReadOnly(false);
+	// initial vertex density
+	m_vertexDensity->setRange( 1, CONFIG_MAX_GRID_RESOLUTION );
+	m_vertexDensity->setValue( m_vertexDensityQuads );
+	m_vertexDensity->setKeyboardTracking( false );
+	m_vertexDensitySlider->setRange( 1, CONFIG_SLIDER_GRID_RESOLUTION );
+	m_vertexDensitySlider->setValue( m_vertexDensityQuads );
+	m_vertexDensitySlider->setTracking( false ); // rebuild once, when the slider is released
+
+	// initial instance count
+	m_numInstances->setRange( 1, CONFIG_MAX_INSTANCES );
+	m_numInstances->setValue( 1 );
+	m_numInstances->setKeyboardTracking( false );
+
+	// initial normal and tangent line settings
+	m_debugLineLength->setRange( 0.1, 10.0 );
+	m_debugLineLength->setSingleStep( 0.1 );
+	m_debugLineLength->setValue( 1.0 );
+	m_debugLineDensity->setRange( 1, 1000 );
+	m_debugLineDensity->setValue( 1 );
+	m_debugLineDensity->setPrefix( "every " );
 
 	// setup signals
 	connect( m_chkUseProgram,      SIGNAL(stateChanged(int)),        this, SLOT(checkUseProgram(int)) );
@@ -194,7 +371,17 @@ CSceneWidget::CSceneWidget( IScene* scene ) : m_scene( scene )
 	connect( m_projectionMode,     SIGNAL(currentIndexChanged(int)), this, SLOT(setProjectionMode(int)) );
     connect( m_geometryOutputNum,SIGNAL(valueChanged(int)), this, SLOT(setGeometryOutputNum(int)));
 	connect( m_fov,                SIGNAL(currentIndexChanged(int)), this, SLOT(setFov(int)) );
-    connect(m_vertexDensity,       SIGNAL(editingFinished()),        this, SLOT(setVertexDensity()));
+	connect( m_vertexDensity,      SIGNAL(valueChanged(int)),        this, SLOT(setVertexDensity(int)) );
+	connect( m_vertexDensitySlider, SIGNAL(valueChanged(int)),       m_vertexDensity, SLOT(setValue(int)) );
+	connect( m_numInstances,       SIGNAL(valueChanged(int)),        this, SLOT(setNumInstances(int)) );
+	connect( m_instanceLayout,     SIGNAL(currentIndexChanged(int)), this, SLOT(setInstanceLayout(int)) );
+	connect( m_debugLineLength,    SIGNAL(valueChanged(double)),     this, SLOT(setDebugLineLength(double)) );
+	connect( m_debugLineDensity,   SIGNAL(valueChanged(int)),        this, SLOT(setDebugLineDensity(int)) );
+	connect( m_btnBenchmark,       SIGNAL(clicked(bool)),            this, SLOT(runBenchmark(bool)) );
+	connect( m_btnCapture,         SIGNAL(clicked(bool)),            this, SLOT(captureFrame(bool)) );
+	connect( m_btnCaptureShow,     SIGNAL(clicked(bool)),            this, SLOT(showCapture(bool)) );
+	connect( m_btnCaptureSave,     SIGNAL(clicked(bool)),            this, SLOT(saveCapture(bool)) );
+	connect( m_btnTuneGeometry,    SIGNAL(clicked(bool)),            this, SLOT(tuneGeometryOutput(bool)) );
 }
 
 CSceneWidget::~CSceneWidget( void )
@@ -214,34 +401,54 @@ void CSceneWidget::init( void )
 {
 	m_meshFileName = QString( "" );
 
-	// create destmodels
-    m_numModels = 9;
-	m_meshModelIndex = 5;
-	m_models    = new IModel* [ m_numModels ];
-	m_models[0] = IModel::createPoint();
-	m_models[1] = IModel::createPlane();
-	m_models[2] = IModel::createCube();
-	m_models[3] = IModel::createSphere( 32, 64, 1.0f );
-	m_models[4] = IModel::createTorus( 32, 24, 1.0f, 0.5f );
-	m_models[5] = m_meshModel = IMeshModel::createMeshModel();
-    m_models[6] = IModel::createLineStrip("Lines", GL_LINES);
-    m_models[7] = IModel::createLineStrip("Line Strip", GL_LINE_STRIP);
-    m_models[8] = IModel::createLineStrip("Line Strip Adj", GL_LINE_STRIP_ADJACENCY);
+	// only the initial test model is built here, the others are built on
+	// demand or by the model builder, after the window is shown.
+	m_modelCache = IModelCache::create( CONFIG_MODEL_CACHE_BUDGET );
+	m_modelBuilder = IModelBuilder::create();
+	m_numModels = NUM_TEST_MODELS;
+	m_meshModelIndex = MODEL_MESH;
+	m_models = new IModel* [ m_numModels ];
+	for( int i = 0 ; i < m_numModels ; i++ ) {
+		m_models[i] = NULL;
+	}
+	m_models[ MODEL_MESH ] = m_meshModel = IMeshModel::createMeshModel(); // empty until loaded
+	m_benchmark = ITriangleBenchmark::create( m_scene );
 
 	// setup combo box
 	for( int i = 0 ; i < m_numModels ; i++ )
 	{
-		m_activeModel->addItem( m_models[i]->getName() );
+		m_activeModel->addItem( QString( testModelInfos[i].name ) );
 	}
 
 	// select a cool initial test model
-	m_activeModel->setCurrentIndex( 1 );
+	m_activeModel->setCurrentIndex( MODEL_PLANE );
+
+	QTimer::singleShot( 0, this, SLOT(buildModels()) );
 
 	// disable geometry stuff, if that shader is not available
 	if( !m_scene->getShader()->isShaderTypeAvailable( IShader::TYPE_GEOMETRY ) )
 	{
 		m_groupGeometryShader->setEnabled( false );
 	}
+	else
+	{
+		m_geometryOutputNum->setRange( 1, m_scene->getShader()->getMaxGeometryOutputNum() );
+		m_geometryOutputNum->setValue( m_scene->getShader()->getGeometryOutputNum() );
+	}
+
+	// the measurement counts primitives with transform feedback queries
+	if( !m_scene->getShader()->isCaptureAvailable() )
+	{
+		m_btnTuneGeometry->setEnabled( false );
+		m_chkApplyTuning->setEnabled( false );
+	}
+
+	// transform feedback is a GL 3.0 feature
+	if( !m_scene->getShader()->isCaptureAvailable() )
+	{
+		m_groupCapture->setEnabled( false );
+		m_labCapture->setText( QString( "Transform feedback is not available." ) );
+	}
 }
 
 
@@ -254,16 +461,25 @@ void CSceneWidget::shutdown( void )
 {
 	m_scene->setCurrentModel( NULL );
 
+	// deletes the model of an unfinished benchmark
+	SAFE_DELETE( m_benchmark );
+
+	// waits for the current job and deletes the models that were not taken
+	SAFE_DELETE( m_modelBuilder );
+
 	// NULL out only, it points into m_models
 	m_meshModel = NULL;
 	m_meshFileName = QString( "" );
 
-	// destroy testmodels
-	for( int i = 0 ; i < m_numModels ; i++ )
+	// destroy testmodels, the cached ones are deleted with the cache.
+	for( int i = 0 ; i < m_numModels && m_models != NULL ; i++ )
 	{
-		SAFE_DELETE( m_models[ i ] );
+		if( !m_modelCache->release( m_models[ i ] ) ) {
+			SAFE_DELETE( m_models[ i ] );
+		}
 	}
 	SAFE_DELETE_ARRAY( m_models );
+	SAFE_DELETE( m_modelCache );
 	m_numModels = 0;
 }
 
@@ -282,9 +498,10 @@ void CSceneWidget::setActiveModel( int index )
 	// validate index
 	if( index >= 0 && index < m_numModels )
 	{
-		mdl = m_models[ index ];
-		pt  = mdl->getPrimitiveType();
-		ptName = mdl->getPrimitiveTypeName();
+		// the scene draws nothing, until the model builder is done.
+		mdl = getModel( index );
+		pt  = ( mdl != NULL ) ? mdl->getPrimitiveType() : testModelInfos[ index ].primitiveType;
+		ptName = IModel::primitiveTypeName( pt );
 	}
 
 	// set new state
@@ -294,6 +511,98 @@ void CSceneWidget::setActiveModel( int index )
 }
 
 
+/*
+========================
+getModel
+
+ returns the model of a slot, the cached ones are acquired on first use.
+ Returns NULL while the model builder works on the slot.
+========================
+*/
+IModel* CSceneWidget::getModel( int index )
+{
+	if( m_models[ index ] != NULL )
+		return m_models[ index ];
+
+	switch( index )
+	{
+	case MODEL_PLANE:
+		m_models[ index ] = m_modelCache->acquirePlane( m_vertexDensityQuads, m_vertexDensityQuads );
+		break;
+
+	case MODEL_CUBE:
+		m_models[ index ] = m_modelCache->acquireCube( m_vertexDensityQuads, m_vertexDensityQuads );
+		break;
+
+	default:
+		if( m_modelBuilder != NULL )
+		{
+			m_models[ index ] = m_modelBuilder->takeModel( index );
+			if( m_models[ index ] == NULL ) {
+				m_modelBuilder->prioritize( index );
+			}
+		}
+		break;
+	}
+
+	return m_models[ index ];
+}
+
+
+/*
+========================
+buildModels
+
+ queues the procedural models that don't depend on the vertex density,
+ the selected one first.
+========================
+*/
+void CSceneWidget::buildModels( void )
+{
+	if( m_modelBuilder == NULL )
+		return;
+
+	int current = m_activeModel->currentIndex();
+	for( int i = 0 ; i < m_numModels ; i++ )
+	{
+		if( m_models[ i ] == NULL && i != MODEL_PLANE && i != MODEL_CUBE ) {
+			m_modelBuilder->enqueue( i, new CTestModelJob( i ) );
+		}
+	}
+
+	m_modelBuilder->prioritize( current );
+}
+
+
+/*
+========================
+updateModelStatus
+
+ picks up the models finished by the model builder.
+========================
+*/
+void CSceneWidget::updateModelStatus( void )
+{
+	if( m_modelBuilder == NULL || m_modelBuilder->getNumPending() == 0 )
+		return;
+
+	for( int i = 0 ; i < m_numModels ; i++ )
+	{
+		if( m_models[ i ] != NULL )
+			continue;
+
+		m_models[ i ] = m_modelBuilder->takeModel( i );
+
+		// the user is waiting for it
+		if( m_models[ i ] != NULL && i == m_activeModel->currentIndex() &&
+			( m_benchmark == NULL || !m_benchmark->isRunning() ) )
+		{
+			setActiveModel( i );
+		}
+	}
+}
+
+
 /*
 ========================
 checkUseProgram
@@ -535,29 +844,393 @@ void CSceneWidget::resetCamera( bool )
 	m_scene->getCameraState()->resetCamera();
 }
 
-void CSceneWidget::setVertexDensity(){
-    const QString &text=m_vertexDensity->text();
-    // Check density range
-    int density=atoi(text.toStdString().c_str());
-    if(density>14|| density<1){
-        QMessageBox* box = new QMessageBox();
-        box->setWindowTitle(QString("Out of range"));
-        box->setText(QString("The density should be in range of 1-14. default is 7.\nCurrent Text:\""+text+"\""));
-        box->show();
-
-        // restor it.
-        m_vertexDensity->setText("7");
-        return;
-    }
-    // set density
-    m_vertexDensityLevel=density;
-
-    // rebuild plane and cube;
-    IModel* plane= m_models[1];
-    IModel* cube = m_models[2];
-    m_models[1] = IModel::createPlane();
-    m_models[2] = IModel::createCube();
-//    delete plane;
-//    delete cube;
+
+/*
+========================
+setVertexDensity
+
+ rebuilds the plane and the cube with numQuads * numQuads quads per face.
+========================
+*/
+void CSceneWidget::setVertexDensity( int numQuads )
+{
+	// keep the slider in sync, it covers only a part of the range.
+	m_vertexDensitySlider->blockSignals( true );
+	m_vertexDensitySlider->setValue( numQuads );
+	m_vertexDensitySlider->blockSignals( false );
+
+	if( numQuads == m_vertexDensityQuads || m_models == NULL )
+		return;
+
+	m_vertexDensityQuads = numQuads;
+
+	// drop plane and cube, they are acquired again when needed.
+	IModel* plane = m_models[ MODEL_PLANE ];
+	IModel* cube  = m_models[ MODEL_CUBE ];
+	m_models[ MODEL_PLANE ] = NULL;
+	m_models[ MODEL_CUBE ]  = NULL;
+
+	// the scene may still reference one of the old models
+	setActiveModel( m_activeModel->currentIndex() );
+
+	// keeps them for reuse, as long as they fit into the memory budget.
+	m_modelCache->release( plane );
+	m_modelCache->release( cube );
+}
+
+
+/*
+========================
+setNumInstances
+========================
+*/
+void CSceneWidget::setNumInstances( int numInstances )
+{
+	m_scene->setNumInstances( numInstances );
+}
+
+
+/*
+========================
+setInstanceLayout
+========================
+*/
+void CSceneWidget::setInstanceLayout( int index )
+{
+	m_scene->setInstanceLayout( m_instanceLayout->itemData( index ).toInt() );
+}
+
+
+/*
+========================
+setDebugLineLength
+========================
+*/
+void CSceneWidget::setDebugLineLength( double scale )
+{
+	m_scene->setDebugLineLength( (float)scale );
+}
+
+
+/*
+========================
+setDebugLineDensity
+========================
+*/
+void CSceneWidget::setDebugLineDensity( int step )
+{
+	m_scene->setDebugLineDensity( step );
+}
+
+
+/*
+========================
+runBenchmark
+
+ starts the benchmark, or cancels it if it is running.
+========================
+*/
+void CSceneWidget::runBenchmark( bool )
+{
+	if( m_benchmark == NULL )
+		return;
+
+	if( m_benchmark->isRunning() )
+	{
+		m_benchmark->cancel();
+		setActiveModel( m_activeModel->currentIndex() );
+		m_btnBenchmark->setText( QString( "Run Benchmark" ) );
+		return;
+	}
+
+	m_benchmark->start( m_benchmarkModel->itemData( m_benchmarkModel->currentIndex() ).toInt() );
+	m_btnBenchmark->setText( QString( "Cancel Benchmark" ) );
+}
+
+
+/*
+========================
+renderBenchmarkFrame
+========================
+*/
+bool CSceneWidget::renderBenchmarkFrame( void )
+{
+	if( m_benchmark == NULL || !m_benchmark->renderFrame() )
+		return false;
+
+	if( m_benchmark->isRunning() )
+	{
+		int step, numSteps;
+		m_benchmark->getProgress( step, numSteps );
+		m_btnBenchmark->setText( QString( "Cancel Benchmark (%1/%2)" ).arg( step + 1 ).arg( numSteps ) );
+	}
+	else
+	{
+		// the last step is done, but don't open dialogs inside the render loop.
+		QTimer::singleShot( 0, this, SLOT(benchmarkFinished()) );
+	}
+
+	return true;
+}
+
+
+/*
+========================
+benchmarkFinished
+
+ restores the test model, shows a summary and saves the results.
+========================
+*/
+void CSceneWidget::benchmarkFinished( void )
+{
+	setActiveModel( m_activeModel->currentIndex() );
+	m_btnBenchmark->setText( QString( "Run Benchmark" ) );
+
+	const QVector< ITriangleBenchmark::Sample > & results = m_benchmark->getResults();
+	int saturation = m_benchmark->getSaturationSample();
+	if( saturation < 0 )
+		return;
+
+	const ITriangleBenchmark::Sample & s = results[ saturation ];
+	QMessageBox::information( this, QString( "Triangle Throughput" ),
+		QString( "The throughput stops scaling at %1 (%2 triangles per instance).\n"
+				 "%3 million triangles per second, %4 ms per frame.\n\n"
+				 "Larger models are limited by the vertex or geometry stage." )
+			.arg( s.modelName ).arg( s.numTriangles )
+			.arg( s.trianglesPerSecond / 1000000.0, 0, 'f', 1 )
+			.arg( s.msPerFrame, 0, 'f', 2 ) );
+
+	// save the samples
+	QString fileName = QFileDialog::getSaveFileName( this,
+		QString( "Save Benchmark Results" ), QString( "benchmark.csv" ),
+		QString( "Comma Separated Values (*.csv);;All Files (*)" ) );
+	if( !fileName.isEmpty() && !m_benchmark->writeCSV( fileName ) )
+	{
+		QMessageBox::warning( this, CONFIG_STRING_ERRORDLG_TITLE,
+			QString( "Failed to write %1." ).arg( fileName ) );
+	}
+}
+
+
+/*
+========================
+captureFrame
+
+ the scene records the next frame, see updateCaptureStatus().
+========================
+*/
+void CSceneWidget::captureFrame( bool )
+{
+	QStringList varyings;
+	QStringList names = m_captureVaryings->text().split( QChar( ',' ), QString::SkipEmptyParts );
+	for( int i = 0 ; i < names.size() ; i++ )
+	{
+		QString name = names[ i ].trimmed();
+		if( !name.isEmpty() ) {
+			varyings.append( name );
+		}
+	}
+
+	m_scene->requestCapture( varyings );
+	m_capturePending = true;
+
+	m_btnCapture->setEnabled( false );
+	m_labCapture->setText( QString( "Capturing..." ) );
+}
+
+
+/*
+========================
+frameRendered
+========================
+*/
+void CSceneWidget::frameRendered( void )
+{
+	updateModelStatus();
+	updateCaptureStatus();
+	updateGeometryTuningStatus();
+}
+
+
+/*
+========================
+updateCaptureStatus
+========================
+*/
+void CSceneWidget::updateCaptureStatus( void )
+{
+	if( !m_capturePending || m_scene->isCapturePending() )
+		return;
+
+	m_capturePending = false;
+	m_btnCapture->setEnabled( true );
+
+	const FeedbackCapture & capture = m_scene->getCapture();
+	bool haveVertices = capture.error.isEmpty() && capture.getNumVertices() > 0;
+	m_btnCaptureShow->setEnabled( haveVertices );
+	m_btnCaptureSave->setEnabled( haveVertices );
+
+	if( !capture.error.isEmpty() )
+	{
+		m_labCapture->setText( capture.error );
+		return;
+	}
+
+	if( capture.isTruncated() )
+	{
+		m_labCapture->setText( QString( "%1 of %2 primitives, the buffer is full." )
+			.arg( capture.primitivesWritten ).arg( capture.primitivesGenerated ) );
+	}
+	else
+	{
+		m_labCapture->setText( QString( "%1 primitives, %2 vertices" )
+			.arg( capture.primitivesWritten ).arg( capture.getNumVertices() ) );
+	}
+}
+
+
+/*
+========================
+showCapture
+
+ lists the captured vertices in a table, only the first rows for large captures.
+========================
+*/
+void CSceneWidget::showCapture( bool )
+{
+	const FeedbackCapture & capture = m_scene->getCapture();
+	int numVertices = capture.getNumVertices();
+	int numRows = qMin( numVertices, CONFIG_MAX_CAPTURE_ROWS );
+	int numColumns = capture.varyings.size() + 1;
+
+	QTableWidget* table = new QTableWidget( numRows, numColumns );
+	table->setEditTriggers( QAbstractItemView::NoEditTriggers );
+
+	QStringList headers;
+	headers.append( QString( "Primitive" ) );
+	headers += capture.varyings;
+	table->setHorizontalHeaderLabels( headers );
+
+	int verticesPerPrimitive = capture.getVerticesPerPrimitive();
+	for( int v = 0 ; v < numRows ; v++ )
+	{
+		table->setItem( v, 0, new QTableWidgetItem( QString::number( v / verticesPerPrimitive ) ) );
+		for( int i = 0 ; i < capture.varyings.size() ; i++ ) {
+			table->setItem( v, i + 1, new QTableWidgetItem( capture.getValueText( v, i ) ) );
+		}
+	}
+	table->resizeColumnsToContents();
+
+	QDialog dialog( this );
+	dialog.setWindowTitle( QString( "Transform Feedback" ) );
+	QVBoxLayout* dialogLayout = new QVBoxLayout();
+	if( numRows < numVertices )
+	{
+		dialogLayout->addWidget( new QLabel( QString( "Showing the first %1 of %2 vertices, "
+			"save the capture to see all of them." ).arg( numRows ).arg( numVertices ) ) );
+	}
+	dialogLayout->addWidget( table );
+	dialog.setLayout( dialogLayout );
+	dialog.resize( 640, 480 );
+	dialog.exec();
+}
+
+
+/*
+========================
+saveCapture
+========================
+*/
+void CSceneWidget::saveCapture( bool )
+{
+	QString fileName = QFileDialog::getSaveFileName( this,
+		QString( "Save Captured Vertices" ), QString( "capture.txt" ),
+		QString( "Text Files (*.txt);;All Files (*)" ) );
+	if( !fileName.isEmpty() && !m_scene->getCapture().writeText( fileName ) )
+	{
+		QMessageBox::warning( this, CONFIG_STRING_ERRORDLG_TITLE,
+			QString( "Failed to write %1." ).arg( fileName ) );
+	}
+}
+
+
+/*
+========================
+tuneGeometryOutput
+
+ the scene measures during the next frame, see updateGeometryTuningStatus().
+========================
+*/
+void CSceneWidget::tuneGeometryOutput( bool )
+{
+	m_scene->requestGeometryTuning();
+	m_geometryTuningPending = true;
+
+	m_btnTuneGeometry->setEnabled( false );
+	m_labGeometryTuning->setText( QString( "Measuring..." ) );
+}
+
+
+/*
+========================
+updateGeometryTuningStatus
+========================
+*/
+void CSceneWidget::updateGeometryTuningStatus( void )
+{
+	if( !m_geometryTuningPending || m_scene->isGeometryTuningPending() )
+		return;
+
+	m_geometryTuningPending = false;
+
+	// it may relink the program, so leave the render loop first.
+	QTimer::singleShot( 0, this, SLOT(geometryTuningFinished()) );
+}
+
+
+/*
+========================
+geometryTuningFinished
+
+ shows the result and applies it, if requested.
+========================
+*/
+void CSceneWidget::geometryTuningFinished( void )
+{
+	m_btnTuneGeometry->setEnabled( true );
+
+	const IScene::GeometryTuning & t = m_scene->getGeometryTuning();
+	if( !t.error.isEmpty() )
+	{
+		m_labGeometryTuning->setText( t.error );
+		return;
+	}
+
+	QString text = QString( "%1 primitives in, %2 out (x%3)\n" )
+		.arg( t.inputPrimitives ).arg( t.outputPrimitives )
+		.arg( t.getAmplification(), 0, 'f', 2 );
+
+	if( t.isTruncating() )
+	{
+		text += QString( "%1 output vertices drop %2 primitives,\nat least %3 are needed.\n" )
+			.arg( t.declared ).arg( t.outputPrimitives - t.declaredPrimitives ).arg( t.tuned );
+	}
+	else
+	{
+		text += QString( "%1 output vertices declared, %2 are enough.\n" )
+			.arg( t.declared ).arg( t.tuned );
+	}
+
+	text += QString( "Geometry stage: %1 ms declared, %2 ms tuned" )
+		.arg( t.msDeclared, 0, 'f', 3 ).arg( t.msTuned, 0, 'f', 3 );
+
+	m_labGeometryTuning->setText( text );
+
+	// the spin box passes the value to the shader
+	if( m_chkApplyTuning->isChecked() && t.tuned > 0 && t.tuned != t.declared )
+	{
+		m_geometryOutputNum->setValue( t.tuned );
+		emit linkProgram();
+	}
 }
 
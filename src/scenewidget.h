@@ -23,11 +23,17 @@
 #include <QLabel>
 #include <QGroupBox>
 #include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QSlider>
+#include <QLineEdit>
 
 // forward declarations
 class IScene;
 class IModel;
 class IMeshModel;
+class IModelCache;
+class ITriangleBenchmark;
+class IModelBuilder;
 
 
 //=============================================================================
@@ -59,6 +65,21 @@ public:
 	 */
 	void shutdown( void );
 
+	/** Renders a frame of the triangle throughput benchmark.
+	 * This must be called instead of IScene::render() while it returns true.
+	 * @return False if the benchmark is not running.
+	 */
+	bool renderBenchmarkFrame( void );
+
+	/** Shows the results of measurements that were requested from the scene.
+	 * This must be called after every rendered frame.
+	 */
+	void frameRendered( void );
+
+signals:
+	/** Emitted if a changed setting requires relinking the program. */
+	void linkProgram( void );
+
 private slots:
 	void checkUseProgram( int toggleState );
 	void checkWireframe( int toggleState );
@@ -75,7 +96,19 @@ private slots:
     void setGeometryOutputNum ( int index );
     void setProjectionMode( int index );
 	void setFov( int index );
-    void setVertexDensity();
+	void setVertexDensity( int numQuads );
+	void setNumInstances( int numInstances );
+	void setInstanceLayout( int index );
+	void setDebugLineLength( double scale );
+	void setDebugLineDensity( int step );
+	void runBenchmark( bool );
+	void benchmarkFinished( void );
+	void captureFrame( bool );
+	void showCapture( bool );
+	void saveCapture( bool );
+	void buildModels( void );
+	void tuneGeometryOutput( bool );
+	void geometryTuningFinished( void );
 
 private:
 
@@ -97,15 +130,47 @@ private:
 	QPushButton*	m_btnLoadMesh;
     QLabel*         m_labPrimitiveType;
 	QGroupBox*		m_groupGeometryShader;
-    QLineEdit*      m_vertexDensity;
-
-	// test models are stored here.
+	QSpinBox*		m_vertexDensity;
+	QSlider*		m_vertexDensitySlider;
+	QSpinBox*		m_numInstances;
+	QComboBox*		m_instanceLayout;
+	QDoubleSpinBox*	m_debugLineLength;
+	QSpinBox*		m_debugLineDensity;
+	QComboBox*		m_benchmarkModel;
+	QPushButton*	m_btnBenchmark;
+	QLineEdit*		m_captureVaryings;
+	QPushButton*	m_btnCapture;
+	QPushButton*	m_btnCaptureShow;
+	QPushButton*	m_btnCaptureSave;
+	QLabel*			m_labCapture;
+	QGroupBox*		m_groupCapture;
+	bool			m_capturePending; // waiting for the scene
+	QPushButton*	m_btnTuneGeometry;
+	QCheckBox*		m_chkApplyTuning;
+	QLabel*			m_labGeometryTuning;
+	bool			m_geometryTuningPending; // waiting for the scene
+
+	// test model slots
+	IModel* getModel( int index );
+
+	// results of requested measurements
+	void updateModelStatus( void );
+	void updateCaptureStatus( void );
+	void updateGeometryTuningStatus( void );
+
+	// test models are stored here, NULL until used or built.
+	// the plane and the cube are owned by m_modelCache.
+	IModelCache* m_modelCache;
+	IModelBuilder* m_modelBuilder; // builds the other procedural models
 	IModel**	m_models; // [ m_numModels ]
 	int			m_numModels;
 	IMeshModel*	m_meshModel; // this points into m_models !!!!
 	int			m_meshModelIndex; // index into m_models
 	QString		m_meshFileName;
-    int         m_vertexDensityLevel;
+	int			m_vertexDensityQuads; // quads per side of plane and cube
+
+	// measures the triangle throughput of the current program
+	ITriangleBenchmark* m_benchmark;
 
 	// the scene to modify
 	IScene*		m_scene;
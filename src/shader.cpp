@@ -14,9 +14,17 @@
 =============================================================================*/
 
 #include <QtCore/QTime>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMutex>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QRegExp>
 #include <QMessageBox>
 #include "application.h"
 #include "shader.h"
+#include "glextra.h"
+#include "feedback.h"
+#include "programcache.h"
+#include "includegraph.h"
 
 #include <assert.h>
 
@@ -73,237 +81,506 @@ The geometry shader is executed for every input primitive and with only
 a single point as input, the geometry shader is executed exactly once!
 This allows you to create your own geometry on the GPU without overdrawing it several times.
 
+If you are not sure what your geometry shader emits, go to the 'Transform Feedback' group
+on the 'Scene' tab. Enter the varyings you want to see, gl_Position for example, and
+press 'Capture Frame'. The primitives emitted during the next frame are recorded and counted.
+You can inspect the vertices in a table or save them to a text file.
+The capture buffer has a fixed size, so a shader that emits far too many primitives
+only reports how many there were.
+
+The 'Numb. outputs' value is the maximum number of vertices a single geometry shader
+invocation may emit. Larger values than necessary cost performance, smaller values
+silently drop primitives. Press 'Measure Output' to find the smallest value that
+does not drop anything for the current test model. If 'Apply' is checked, the value
+is set and the program is relinked.
+
 */
 
 
 //=============================================================================
-//	IShader implementation
+//	IShaderBuild implementation
 //=============================================================================
 
-/** Implementation of IShader.
- * This class doensn't add new functionality. It is only used to hide
- * the class definition from the interface definition.
- */
-class CShader : public IShader
+/*
+========================
+toGlShaderType
+
+ maps TYPE_xy to GL_xy
+========================
+*/
+static int toGlShaderType( int symbol )
 {
-public:
-	/** Constructs a shader object. */
-	CShader( void );
-	virtual ~CShader( void ); ///< Destructor.
+	switch( symbol )
+	{
+	case IShader::TYPE_VERTEX:		return GL_VERTEX_SHADER;		break;
+	case IShader::TYPE_GEOMETRY:	return GL_GEOMETRY_SHADER_EXT;	break;
+	case IShader::TYPE_FRAGMENT:	return GL_FRAGMENT_SHADER;		break;
+	}
 
-	// initialization
-	bool init( void );
-	void shutdown( void );
+	// never get here...
+	assert( 0 );
+	return 0;
+}
 
-	// rendering
-	bool bindState( VertexAttribLocations & attribs );
 
-	// shader state
-	void setShaderSource( int shaderType, const QString & source );
-	void setGeometryInputType( int type );
-	void setGeometryOutputType( int type );
-    void setGeometryOutputNum( int type );
+/*
+========================
+setupGeometryParameters
 
-	// linking
-	bool compileAndLink( void );
-	void deactivateProgram( void );
-	QString getBuildLog( void );
+ geometry shader specific program parameters, they must be set before linking.
+========================
+*/
+static void setupGeometryParameters( GLuint program, int numOutputVertices, int maxOutputVertices,
+									 int inputType, int outputType )
+{
+	// the smallest value that does not truncate the output is the fastest,
+	// see IScene::requestGeometryTuning().
+	numOutputVertices = qBound( 1, numOutputVertices, maxOutputVertices );
+	glProgramParameteriEXT( program, GL_GEOMETRY_VERTICES_OUT_EXT, numOutputVertices );
+
+	// set primitive types
+	glProgramParameteriEXT( program, GL_GEOMETRY_INPUT_TYPE_EXT,  inputType );
+	glProgramParameteriEXT( program, GL_GEOMETRY_OUTPUT_TYPE_EXT, outputType );
+}
 
-	// type management
-	bool isShaderTypeAvailable( int type );
 
-	// IUniformState
-	int getActiveUniforms( void );
-	CUniform getUniform( int index );
-	void setUniform( int index, const CUniform & u );
+/*
+========================
+compileShader
 
-private:
+ compiles the source of a shader type and appends the compiler messages
+ to the log. Returns 0 on failure.
+========================
+*/
+static GLuint compileShader( int shaderType, const QString & source, QString & log )
+{
+	GLint status;
+	char text[ 4096 ];
 
-	// Does actual compile and link work.
-	// Is is encapsulated into a try/catch block for driver exceptions!
-	bool compileAndLink2( void );
-	bool compileAndAttachShader( int shaderType );
-	bool linkAndValidateProgram( void );
-	void setupProgramParameters( void );
+	// create the shader object.
+	GLuint shader = glCreateShader( toGlShaderType( shaderType ) );
+	if( shader == 0 )
+	{
+		log += QString( "ERROR: failed on glCreateShader( %1 )\n" ).
+						arg( IShader::getShaderTypeName( shaderType ) );
+		return 0;
+	}
 
-	// logs additional linking info
-	void logActiveAttributes( void );
-	void logActiveUniforms( void );
+	// recompile shader
+	int length = source.length() + 1;
+	char* buf = new char[ length ];
+	const GLchar* src = buf;
+    strncpy( buf, source.toStdString().c_str(), length );
+	glShaderSource ( shader, 1, &src, NULL );
+	glCompileShader( shader );
+	delete [] buf;
 
-	// sets initial uniform state after linking
-	void setupInitialUniforms( void );
-	void setupRememberedUniformState( void );
+	// read the log
+	memset( text, 0, sizeof(text) );
+	glGetShaderInfoLog( shader, sizeof(text), NULL, text );
+	text[ sizeof(text)-1 ] = '\0';
+	log += QString( "%1\n" ).arg( text );
 
-	// checks wether this is the time variable and updates it.
-	void updateTimeVariable( CUniform & u );
+	glGetShaderiv( shader, GL_COMPILE_STATUS, &status );
+	if( status == GL_FALSE )
+	{
+		glDeleteShader( shader );
+		return 0;
+	}
 
-	// shader type symbol mapping
-	int toGlShaderType( int symbol );
+	return shader;
+}
 
-	// state of the uniforms
-	QVector< CUniform > m_activeUniforms;
 
-	// from last state
-	// -> only updated if the program was successfully linked!
-	QVector< CUniform > m_oldUniforms;
+/*
+========================
+insertDefines
 
-	// vertex and fragment shaders are included in OpenGL 2.0
-	// -> geometry shader is still an extension
-	bool m_geometryShaderAvailable;
+ inserts #define lines after the #version directive, or at the start
+ of the source. A #line directive keeps the line numbers of the source.
+========================
+*/
+static QString insertDefines( const QString & source, const QString & defines )
+{
+	if( defines.isEmpty() )
+		return source;
 
-	// wether the program is ready to operate
-	bool m_linked;
+	QStringList lines = source.split( '\n' );
 
-	// results of compile and link operation
-	QString m_log;
+	// #version must be the first directive
+	QRegExp versionExp( "^\\s*#\\s*version\\s+(\\d+)" );
+	int versionLine = -1;
+	int version = 110;
+	for( int i = 0 ; i < lines.size() ; i++ )
+	{
+		if( versionExp.indexIn( lines[ i ] ) >= 0 )
+		{
+			versionLine = i;
+			version = versionExp.cap( 1 ).toInt();
+			break;
+		}
+	}
 
-	// timer for the "uniform float time"
-	QTime m_timer;
+	// before GLSL 3.30, #line numbers the line of the directive itself
+	int lineBias = ( version >= 330 ) ? 0 : -1;
 
-	// program parameters
-    int m_num_output;
-	int m_geometryInputType; // for geometry shader
-	int m_geometryOutputType;
+	QString header = defines;
+	if( !header.endsWith( '\n' ) ) {
+		header += '\n';
+	}
+	header += QString( "#line %1" ).arg( versionLine + 2 + lineBias );
+	lines.insert( versionLine + 1, header );
 
-	// where vertex arrays can write to...
-	VertexAttribLocations m_attribLocations;
+	return lines.join( QString( "\n" ) );
+}
 
-	// source code for each shader type.
-	QString m_shaderSources[ MAX_SHADER_TYPES ];
 
-	// objects
-	GLuint	m_shaders[ MAX_SHADER_TYPES ];
-	GLuint	m_program;
+//=============================================================================
+//	CShaderObjectCache
+//=============================================================================
+
+/** Compiled shader objects, identified by the shader type and a hash of
+ * the source. A link only compiles the stages that changed, the others
+ * are attached from this cache.
+ * \n\n
+ * The objects are owned by the cache and counted: every acquire() call must
+ * be paired with a release() call. Up to CONFIG_SHADER_OBJECT_CACHE_SIZE
+ * unreferenced objects are kept, the least recently used ones are deleted.
+ * Builds use the cache on the worker thread, so it is protected by a mutex.
+ * The mutex is not held while compiling: if two builds compile the same
+ * source at once, the second result is deleted and the first is shared.
+ * A context sharing objects with the render context must be current.
+ */
+class CShaderObjectCache
+{
+public:
+	CShaderObjectCache( void );
+	~CShaderObjectCache( void ); ///< Deletes all objects.
+
+	/** Returns a compiled shader object, it is compiled if it is not cached.
+	 * Compile failures are not cached.
+	 * @param log Receives the compiler messages, they are stored with the object.
+	 * @param reused Set to true, if the object was cached.
+	 * @return The shader object, 0 on failure.
+	 */
+	GLuint acquire( int shaderType, const QString & source, QString & log, bool & reused );
+
+	/** Releases an object returned by acquire(), 0 is ignored. */
+	void release( GLuint shader );
+
+private:
+
+	/** A compiled shader. */
+	class Entry
+	{
+	public:
+		Entry( void ) : shader( 0 ), numRefs( 0 ), lastUse( 0 ) {}
+
+		GLuint	shader;
+		QString	log;
+		int		numRefs;
+		int		lastUse;
+	};
+
+	// deletes unreferenced objects beyond the size limit
+	void trim( void );
+
+	QMutex					m_mutex;
+	QHash< QString, Entry >	m_entries;
+	QHash< GLuint, QString >m_keys;
+	int						m_clock;	// for lastUse
 };
 
 
 // construction
-CShader::CShader( void )
+CShaderObjectCache::CShaderObjectCache( void )
+ : m_clock( 0 )
 {
-	m_geometryShaderAvailable = false;
-	m_program = 0;
-	m_linked = false;
-
-    m_num_output = 4;
-    m_geometryInputType  = GL_LINE_STRIP_ADJACENCY;
-	m_geometryOutputType = GL_TRIANGLE_STRIP;
-
-	for( int i = 0 ; i < MAX_SHADER_TYPES ; i++ )
-		m_shaders[ i ] = 0;
 }
 
-CShader::~CShader( void )
+// destruction
+CShaderObjectCache::~CShaderObjectCache( void )
 {
+	QHash< QString, Entry >::iterator it;
+	for( it = m_entries.begin() ; it != m_entries.end() ; ++it ) {
+		glDeleteShader( it.value().shader );
+	}
 }
 
 
 /*
 ========================
-create
+acquire
 ========================
 */
-IShader* IShader::create( void )
+GLuint CShaderObjectCache::acquire( int shaderType, const QString & source, QString & log, bool & reused )
 {
-	return new CShader();
-}
+	QByteArray description = QString( "stage %1\n" ).arg( shaderType ).toUtf8();
+	description += source.toUtf8();
+	QString key = QString( QCryptographicHash::hash( description, QCryptographicHash::Sha1 ).toHex() );
 
+	m_mutex.lock();
 
-/*
-========================
-init
+	QHash< QString, Entry >::iterator it = m_entries.find( key );
+	if( it != m_entries.end() )
+	{
+		it.value().numRefs++;
+		it.value().lastUse = ++m_clock;
+		log += it.value().log;
+		reused = true;
+
+		GLuint shader = it.value().shader;
+		m_mutex.unlock();
+		return shader;
+	}
 
- assumes OpenGL context is ready
-========================
-*/
-bool CShader::init( void )
-{
-	// clean up old state.
-	shutdown();
+	m_mutex.unlock();
 
-	//
-	// find out wether we can use geometry shaders
-	//
-#ifdef CONFIG_ENABLE_GEOMETRY_SHADER
-	const char* ext = (const char*)glGetString( GL_EXTENSIONS );
-	if( strstr( ext, "GL_EXT_geometry_shader4" ) != NULL )
+	// compile without the lock, the render thread releases objects while the driver works.
+	QString compilerLog;
+	GLuint shader = compileShader( shaderType, source, compilerLog );
+	reused = false;
+
+	if( shader == 0 )
 	{
-		m_geometryShaderAvailable = true;
+		log += compilerLog;
+		return 0;
 	}
-#endif // CONFIG_ENABLE_GEOMETRY_SHADER
 
-	return true;
+	m_mutex.lock();
+
+	// another build compiled the same source meanwhile, use its object.
+	it = m_entries.find( key );
+	if( it != m_entries.end() )
+	{
+		glDeleteShader( shader );
+
+		it.value().numRefs++;
+		it.value().lastUse = ++m_clock;
+		log += it.value().log;
+		reused = true;
+
+		shader = it.value().shader;
+		m_mutex.unlock();
+		return shader;
+	}
+
+	Entry entry;
+	entry.shader	= shader;
+	entry.log		= compilerLog;
+	entry.numRefs	= 1;
+	entry.lastUse	= ++m_clock;
+	m_entries.insert( key, entry );
+	m_keys.insert( shader, key );
+	log += compilerLog;
+
+	m_mutex.unlock();
+	return shader;
 }
 
 
 /*
 ========================
-shutdown
+release
 ========================
 */
-void CShader::shutdown( void )
+void CShaderObjectCache::release( GLuint shader )
 {
-	m_geometryShaderAvailable = false;
+	if( shader == 0 )
+		return;
 
-	deactivateProgram();
+	m_mutex.lock();
 
-	for( int i = 0 ; i < MAX_SHADER_TYPES ; i++ )
-		m_shaderSources[ i ] = QString( "" );
+	QHash< GLuint, QString >::iterator key = m_keys.find( shader );
+	if( key != m_keys.end() )
+	{
+		QHash< QString, Entry >::iterator it = m_entries.find( key.value() );
+		if( it != m_entries.end() && it.value().numRefs > 0 ) {
+			it.value().numRefs--;
+		}
+		trim();
+	}
+
+	m_mutex.unlock();
 }
 
 
 /*
 ========================
-deactivateProgram
+trim
 
- Destroy all shaders and program. They are re-created when needed.
- Does not touch the shader source.
+ assumes m_mutex is locked.
 ========================
 */
-void CShader::deactivateProgram( void )
+void CShaderObjectCache::trim( void )
 {
-	// make sure we have no references to the program.
-	m_linked = false; // in case of empty sources
-	m_attribLocations = VertexAttribLocations();
+	for( ;; )
+	{
+		// find the least recently used unreferenced object
+		int numUnused = 0;
+		QHash< QString, Entry >::iterator oldest = m_entries.end();
+		QHash< QString, Entry >::iterator it;
+		for( it = m_entries.begin() ; it != m_entries.end() ; ++it )
+		{
+			if( it.value().numRefs > 0 )
+				continue;
 
-	glUseProgram( 0 );
+			numUnused++;
+			if( oldest == m_entries.end() || it.value().lastUse < oldest.value().lastUse ) {
+				oldest = it;
+			}
+		}
 
-	// delete program object
-	if( m_program != 0 )
+		if( numUnused <= CONFIG_SHADER_OBJECT_CACHE_SIZE )
+			break;
+
+		glDeleteShader( oldest.value().shader );
+		m_keys.remove( oldest.value().shader );
+		m_entries.erase( oldest );
+	}
+}
+
+
+//=============================================================================
+//	CCancelFlag
+//=============================================================================
+
+/** Set by IShaderBuild::cancel() on the GUI thread, read by run(). */
+class CCancelFlag
+{
+public:
+	CCancelFlag( void ) : m_set( false ) {}
+
+	void set( void )
 	{
-		glDeleteProgram( m_program );
-		m_program = 0;
+		m_mutex.lock();
+		m_set = true;
+		m_mutex.unlock();
 	}
 
-	// delete shader objects
-	for( int i = 0 ; i < MAX_SHADER_TYPES ; i++ )
+	bool isSet( void )
 	{
-		if( m_shaders[ i ] != 0 )
-		{
-			glDeleteShader( m_shaders[ i ] );
-			m_shaders[ i ] = 0;
-		}
+		m_mutex.lock();
+		bool result = m_set;
+		m_mutex.unlock();
+		return result;
+	}
+
+private:
+	QMutex	m_mutex;
+	bool	m_set;
+};
+
+
+//=============================================================================
+//	CShaderBuild
+//=============================================================================
+
+/** Implementation of IShaderBuild.
+ * The inputs are copied by CShader::createBuild(), the objects are
+ * taken over by CShader::finishBuild(). run() only touches the members
+ * of this class and the caches, so it can run on any thread.
+ */
+class CShaderBuild : public IShaderBuild
+{
+public:
+	CShaderBuild( void );
+	virtual ~CShaderBuild( void );
+
+	// IShaderBuild
+	int  getKind( void ) { return BUILD_PROGRAM; }
+	void run( void );
+	void cancel( void ) { m_canceled.set(); }
+
+	// inputs
+	QString	sources[ IShader::MAX_SHADER_TYPES ]; // empty for unused stages, includes expanded
+	QStringList files[ IShader::MAX_SHADER_TYPES ]; // by source string number, see IIncludeGraph
+	QString	preprocessLog; // failed includes, nothing is compiled if set
+	bool	geometryShaderAvailable;
+	int		numOutputVertices;
+	int		maxOutputVertices;
+	int		geometryInputType;
+	int		geometryOutputType;
+	IProgramCache* programCache; // not owned, NULL if not used
+	QString	programKey; // empty if the program is not cached
+	CShaderObjectCache* shaderObjects; // not owned
+	QHash< QString, int > attribLocations; // bound before linking, empty to let the linker choose
+
+	// results
+	GLuint	shaders[ IShader::MAX_SHADER_TYPES ]; // references into shaderObjects, 0 if loaded from the cache
+	GLuint	program;
+	QString	log;
+	bool	compiled; // all shaders compiled, or loaded from the cache
+	bool	linked;
+	double	compileMs; // wall clock of the compile calls, 0 if loaded from the cache
+	double	linkMs; // wall clock of the link, or of loading the binary
+
+private:
+
+	// Does actual compile and link work.
+	// Is is encapsulated into a try/catch block for driver exceptions!
+	void run2( void );
+	bool compileAndAttachShader( int shaderType );
+	bool linkProgram( void );
+
+	// program binary cache
+	bool loadCachedProgram( void );
+	void storeCachedProgram( const QString & buildLog );
+
+	CCancelFlag m_canceled;
+};
+
+
+// construction
+CShaderBuild::CShaderBuild( void )
+{
+	geometryShaderAvailable = false;
+	numOutputVertices = 1;
+	maxOutputVertices = 0;
+	geometryInputType = GL_TRIANGLES;
+	geometryOutputType = GL_TRIANGLE_STRIP;
+	programCache = NULL;
+	shaderObjects = NULL;
+
+	for( int i = 0 ; i < IShader::MAX_SHADER_TYPES ; i++ )
+		shaders[ i ] = 0;
+	program = 0;
+	compiled = false;
+	linked = false;
+	compileMs = 0.0;
+	linkMs = 0.0;
+}
+
+// destruction, deletes the objects that were not taken
+CShaderBuild::~CShaderBuild( void )
+{
+	if( program != 0 ) {
+		glDeleteProgram( program );
+	}
+
+	for( int i = 0 ; i < IShader::MAX_SHADER_TYPES ; i++ ) {
+		shaderObjects->release( shaders[ i ] );
 	}
 }
 
 
 /*
 ========================
-compileAndLink
+run
 ========================
 */
-bool CShader::compileAndLink( void )
+void CShaderBuild::run( void )
 {
-	bool result = false;
-
 	// if we get any exceptions, they must be from the GL driver!
 	try
 	{
-		result = compileAndLink2();
+		run2();
 	}
 	catch( ... )
 	{
-		result = false;
-		m_log = QString(
+		compiled = false;
+		linked = false;
+		log = QString(
 			"*** CRITICAL ERROR ***\n"
 			"\n"
 			"  There was an exception thrown by the OpenGL driver!\n"
@@ -323,302 +600,1909 @@ bool CShader::compileAndLink( void )
 			"}\n"
 			"\n" );
 	}
-
-	return result;
 }
 
 
 /*
 ========================
-compileAndLink2
+run2
 ========================
 */
-bool CShader::compileAndLink2( void )
+void CShaderBuild::run2( void )
 {
-	bool totalResult = true;
-
-	// clean up old state
-	deactivateProgram();
-	m_log = QString();
+	log = QString();
+	compiled = false;
+	linked = false;
+	compileMs = 0.0;
+	linkMs = 0.0;
 
 	// create a new program object
-	m_program = glCreateProgram();
-	if( m_program == 0 )
+	program = glCreateProgram();
+	if( program == 0 )
 	{
-		m_log += QString( "ERROR: Failed on glCreateProgram()\n" );
-		return false;
+		log += QString( "ERROR: Failed on glCreateProgram()\n" );
+		return;
 	}
 
-	// update shaders
-	for( int i = 0 ; i < MAX_SHADER_TYPES ; i++ )
+	// a program linked earlier with the same sources and parameters
+	// is loaded without compiling anything.
+	QElapsedTimer timer;
+	timer.start();
+	if( !programKey.isEmpty() && loadCachedProgram() )
 	{
-		bool result = compileAndAttachShader( i );
-		totalResult = totalResult && result;
+		linkMs = timer.nsecsElapsed() / 1000000.0;
+		compiled = true;
+		return;
 	}
 
-	// if we have shaders attached, link them to a program.
-	if( totalResult )
+	if( program == 0 )
 	{
-		bool result = linkAndValidateProgram();
-		totalResult = totalResult && result;
+		log += QString( "ERROR: Failed on glCreateProgram()\n" );
+		return;
 	}
 
-	// post processing...
-	if( totalResult )
+	// the includes were expanded by CShader::createBuild()
+	if( !preprocessLog.isEmpty() )
 	{
-		setupInitialUniforms();
-		setupRememberedUniformState();
+		log += preprocessLog;
+		return;
 	}
 
-	return totalResult;
+	int logStart = log.length();
+
+	// update shaders
+	timer.restart();
+	compiled = true;
+	for( int i = 0 ; i < IShader::MAX_SHADER_TYPES ; i++ )
+	{
+		if( m_canceled.isSet() )
+		{
+			compiled = false;
+			return;
+		}
+
+		bool result = compileAndAttachShader( i );
+		compiled = compiled && result;
+	}
+	compileMs = timer.nsecsElapsed() / 1000000.0;
+
+	if( !compiled || m_canceled.isSet() )
+		return;
+
+	// if we have shaders attached, link them to a program.
+	timer.restart();
+	bool result = linkProgram();
+	linkMs = timer.nsecsElapsed() / 1000000.0;
+
+	if( result && !programKey.isEmpty() ) {
+		storeCachedProgram( log.mid( logStart ) );
+	}
 }
 
 
 /*
 ========================
 compileAndAttachShader
+========================
+*/
+bool CShaderBuild::compileAndAttachShader( int shaderType )
+{
+	// must be deleted before use!
+	assert( shaders[ shaderType ] == 0 );
+
+	// check if we have source code defined for this shader
+	if( sources[ shaderType ].isEmpty() )
+		return true; // shader not used.
+
+	// unchanged stages are not compiled again
+	QString compilerLog;
+	bool reused = false;
+	shaders[ shaderType ] = shaderObjects->acquire( shaderType, sources[ shaderType ], compilerLog, reused );
+
+	log += QString( reused ? "Reusing %1, the source is unchanged\n" : "Compiling %1\n" ).
+			arg( IShader::getShaderTypeName( shaderType ) );
+	log += IIncludeGraph::mapLog( compilerLog, files[ shaderType ] );
+
+	if( shaders[ shaderType ] == 0 )
+		return false;
+
+	glAttachShader( program, shaders[ shaderType ] );
+	return true;
+}
+
 
- assumes the shader is available.
+/*
+========================
+linkProgram
 ========================
 */
-bool CShader::compileAndAttachShader( int shaderType )
+bool CShaderBuild::linkProgram( void )
 {
 	GLint status;
 	char text[ 4096 ];
 
-	// must be deleted before use!
-	assert( m_shaders[ shaderType ] == 0 );
+	log += QString( "Linking...\n" );
 
-	// shader type not supported, skip
-	if( !isShaderTypeAvailable( shaderType ) )
-		return true;
+	// things that must be done before linking
+	if( geometryShaderAvailable ) {
+		setupGeometryParameters( program, numOutputVertices, maxOutputVertices, geometryInputType, geometryOutputType );
+	}
+	if( programCache != NULL ) {
+		smglProgramParameteri( program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+	}
 
-	// check if we have source code defined for this shader
-	if( m_shaderSources[ shaderType ].isEmpty() )
-		return true; // shader not used.
+	QHash< QString, int >::const_iterator it;
+	for( it = attribLocations.constBegin() ; it != attribLocations.constEnd() ; ++it ) {
+		glBindAttribLocation( program, it.value(), it.key().toLatin1().constData() );
+	}
 
-	m_log += QString( "Compiling %1\n" ).arg( getShaderTypeName(shaderType) );
+	glLinkProgram( program );
 
-	// create the shader object.
-	m_shaders[ shaderType ] = glCreateShader( toGlShaderType( shaderType ) );
-	if( m_shaders[ shaderType ] == 0 )
+	// read log
+	memset( text, 0, sizeof(text) );
+	glGetProgramInfoLog( program, sizeof(text), NULL, text );
+	text[ sizeof(text)-1 ] = '\0';
+	log += QString( "%1\n\n" ).arg( text );
+
+	// check link status
+	glGetProgramiv( program, GL_LINK_STATUS, &status );
+	linked = ( status != GL_FALSE );
+
+	return linked;
+}
+
+
+/*
+========================
+loadCachedProgram
+
+ loads the binary into program. A binary rejected by the driver is
+ removed from the cache, program is replaced by a new program object then.
+========================
+*/
+bool CShaderBuild::loadCachedProgram( void )
+{
+	ProgramBinary binary;
+	if( !programCache->load( programKey, binary ) )
 	{
-		m_log += QString( "ERROR: failed on glCreateShader( %1 )\n" ).
-							arg( getShaderTypeName( shaderType ) );
+		log += QString( "Program binary cache: miss\n\n" );
 		return false;
 	}
 
-	// recompile shader
-	int length = m_shaderSources[ shaderType ].length() + 1;
-	char* buf = new char[ length ];
-	const GLchar* src = buf;
-    strncpy( buf, m_shaderSources[ shaderType ].toStdString().c_str(), length );
-	glShaderSource ( m_shaders[ shaderType ], 1, &src, NULL );
-	glCompileShader( m_shaders[ shaderType ] );
-	delete [] buf;
+	smglProgramBinary( program, binary.format, binary.data.constData(), binary.data.size() );
 
-	// read the log
-	memset( text, 0, sizeof(text) );
-	glGetShaderInfoLog( m_shaders[ shaderType ], sizeof(text), NULL, text );
-	text[ sizeof(text)-1 ] = '\0';
-	m_log += QString( "%1\n" ).arg( text );
+	GLint status = GL_FALSE;
+	glGetProgramiv( program, GL_LINK_STATUS, &status );
+	if( status == GL_FALSE )
+	{
+		// e.g. after a driver update, start over with a clean program
+		programCache->remove( programKey );
+		glDeleteProgram( program );
+		program = glCreateProgram();
+
+		log += QString( "Program binary cache: rejected by the driver, compiling\n\n" );
+		return false;
+	}
+
+	log += QString( "Program binary cache: hit\n\n" );
+	log += binary.log;
+	linked = true;
+
+	return true;
+}
+
+
+/*
+========================
+storeCachedProgram
+========================
+*/
+void CShaderBuild::storeCachedProgram( const QString & buildLog )
+{
+	GLint length = 0;
+	glGetProgramiv( program, GL_PROGRAM_BINARY_LENGTH, &length );
+	if( length <= 0 )
+		return;
+
+	ProgramBinary binary;
+	GLenum format = 0;
+	binary.data.resize( length );
+	smglGetProgramBinary( program, length, &length, &format, binary.data.data() );
+	binary.data.resize( length );
+	binary.format = format;
+	binary.log = buildLog;
+
+	if( !programCache->store( programKey, binary ) ) {
+		log += QString( "Program binary cache: failed to write %1\n" ).arg( programKey );
+	}
+}
+
+
+
+//=============================================================================
+//	CShaderVariantBuild
+//=============================================================================
+
+/** Implementation of IShaderBuild for the variants of a program.
+ * Every variant is an ordinary CShaderBuild, so it uses the shader object
+ * cache and the program binary cache like the program itself.
+ * See CShader::createVariantBuild().
+ */
+class CShaderVariantBuild : public IShaderBuild
+{
+public:
+	CShaderVariantBuild( void ) : serial( 0 ) {}
+	virtual ~CShaderVariantBuild( void );
+
+	// IShaderBuild
+	int  getKind( void ) { return BUILD_VARIANTS; }
+	void run( void );
+	void cancel( void );
+
+	QVector< CShaderBuild* > builds; // parallel to the variants
+	int serial; // CShader::m_variantSerial when it was created
+
+private:
+	CCancelFlag m_canceled;
+};
+
+
+// destruction, the builds delete the objects that were not taken
+CShaderVariantBuild::~CShaderVariantBuild( void )
+{
+	for( int i = 0 ; i < builds.size() ; i++ ) {
+		delete builds[ i ];
+	}
+}
+
+
+/*
+========================
+run
+========================
+*/
+void CShaderVariantBuild::run( void )
+{
+	// a superseded batch stops between the builds
+	for( int i = 0 ; i < builds.size() && !m_canceled.isSet() ; i++ ) {
+		builds[ i ]->run();
+	}
+}
+
+
+/*
+========================
+cancel
+
+ the running build stops before its next compile.
+========================
+*/
+void CShaderVariantBuild::cancel( void )
+{
+	m_canceled.set();
+
+	for( int i = 0 ; i < builds.size() ; i++ ) {
+		builds[ i ]->cancel();
+	}
+}
+
+
+
+//=============================================================================
+//	IShader implementation
+//=============================================================================
+
+/** Implementation of IShader.
+ * This class doensn't add new functionality. It is only used to hide
+ * the class definition from the interface definition.
+ */
+class CShader : public IShader
+{
+public:
+	/** Constructs a shader object. */
+	CShader( void );
+	virtual ~CShader( void ); ///< Destructor.
+
+	// initialization
+	bool init( bool useProgramCache );
+	void shutdown( void );
+
+	// rendering
+	bool bindState( VertexAttribLocations & attribs );
+	int  getNumUniformUploads( void ) { return m_numUniformUploads; }
+	void setFrameInputs( const FrameInputs & inputs );
+
+	// shader state
+	void setShaderSource( int shaderType, const QString & source, const QString & fileName );
+	void setGeometryInputType( int type );
+	void setGeometryOutputType( int type );
+    void setGeometryOutputNum( int type );
+	int  getGeometryOutputNum( void ) { return m_num_output; }
+	int  getMaxGeometryOutputNum( void ) { return m_maxOutputVertices; }
+
+	// linking
+	bool compileAndLink( bool keepOnError );
+	IShaderBuild* createBuild( void );
+	bool finishBuild( IShaderBuild* build, bool keepOnError );
+	void deactivateProgram( void );
+	QString getBuildLog( void );
+	void getBuildTimes( double & compileMs, double & linkMs ) { compileMs = m_compileMs; linkMs = m_linkMs; }
+
+	// variants
+	void setVariants( const QVector< ShaderVariant > & variants );
+	IShaderBuild* createVariantBuild( void );
+	bool finishVariantBuild( IShaderBuild* build );
+	int  getNumVariants( void ) { return m_variants.size(); }
+	QString getVariantName( int index );
+	bool isVariantLinked( int index );
+	QString getVariantLog( int index );
+	void selectVariant( int index );
+	int  getSelectedVariant( void ) { return m_selectedVariant; }
+
+	// transform feedback
+	void setCaptureVaryings( const QStringList & varyings );
+	bool isCaptureAvailable( void ) { return smglIsTransformFeedbackAvailable(); }
+	bool beginCapture( VertexAttribLocations & attribs, int drawPrimitiveType, int maxBytes, QString & error );
+	void endCapture( FeedbackCapture & result );
+
+	// geometry shader output measurement
+	bool beginGeometryProbe( VertexAttribLocations & attribs, int numOutputVertices, QString & error );
+	int  endGeometryProbe( void );
+
+	// type management
+	bool isShaderTypeAvailable( int type );
+
+	// IUniformState
+	int getActiveUniforms( void );
+	CUniform getUniform( int index );
+	void setUniform( int index, const CUniform & u );
+
+private:
+
+	// the compile and link work is done by CShaderBuild
+	bool validateProgram( void );
+	void setupProgramParameters( GLuint program, int numOutputVertices );
+	void setupAttribLocations( void );
+	bool isStageUsed( int shaderType );
+	void setupBuild( CShaderBuild* build ); // link parameters and caches
+	QByteArray getProgramDescription( const QString* sources ); // key of the program binary cache
+
+	// programs made of other shaders, that share the state of m_program
+	void getUniformLocations( GLuint program, QVector< int > & uniformLocations );
+	void bindUniformBlocks( GLuint program );
+	void deleteVariantPrograms( void );
+
+	// programs made of the same shader objects as m_program
+	GLuint linkCopy( int numOutputVertices, const QStringList & varyings,
+					 QVector< int > & uniformLocations, QString & error );
+	bool compileShaderObjects( QString & error );
+	void applyUniforms( const QVector< int > & uniformLocations );
+
+	// links the shaders into m_captureProgram
+	bool linkCaptureProgram( QString & error );
+	void deleteCaptureProgram( void );
+	int  getCapturePrimitiveType( int drawPrimitiveType );
+
+	// logs additional linking info
+	void logActiveAttributes( void );
+	void logActiveUniforms( void );
+
+	// sets initial uniform state after linking
+	void setupInitialUniforms( void );
+	void setupRememberedUniformState( void );
+
+	// buffer objects of the uniform blocks
+	void setupUniformBlocks( void );
+	void deleteUniformBlocks( void );
+	int  updateUniformBlocks( void );
+
+	// writes the per frame values to the built-in uniforms.
+	void updateBuiltinUniforms( void );
+
+	// state of the uniforms
+	QVector< CUniform > m_activeUniforms;
+	QVector< bool >		m_uniformDirty; // parallel to m_activeUniforms, not passed to m_program yet
+	int					m_numUniformUploads; // by the last bindState() call
+	GLuint				m_uniformProgram; // the program that got the values, 0 if none
+
+	// parallel to m_activeUniforms: the number of elements passed with one call,
+	// 0 for array elements passed with the first one and for block members
+	QVector< int >		m_uniformCounts;
+
+	/** Where a uniform is stored in the buffer of its block. */
+	class BlockMember
+	{
+	public:
+		BlockMember( int Uniform=0, int Offset=0, int MatrixStride=0, bool RowMajor=false )
+			: uniform( Uniform ), offset( Offset ), matrixStride( MatrixStride ), rowMajor( RowMajor ) {}
+
+		int		uniform;	// into m_activeUniforms
+		int		offset;		// bytes
+		int		matrixStride;
+		bool	rowMajor;
+	};
+
+	/** A uniform block, its buffer is written at most once per frame. */
+	class UniformBlock
+	{
+	public:
+		UniformBlock( void ) : buffer( 0 ), binding( -1 ), dirty( true ) {}
+
+		QString					name;
+		GLuint					buffer;
+		int						binding;	// -1 if there are more blocks than binding points
+		QByteArray				data;		// the buffer contents
+		QVector< BlockMember >	members;
+		bool					dirty;		// data was not written to the buffer yet
+	};
+
+	QVector< UniformBlock >	m_uniformBlocks; // indexed like the blocks of m_program
+	bool					m_uniformBuffersAvailable;
+
+	/** An active uniform set by updateBuiltinUniforms(). */
+	class BuiltinUniform
+	{
+	public:
+		BuiltinUniform( int Index=0, int Role=BUILTIN_NONE ) : index( Index ), role( Role ) {}
+
+		int index;	// into m_activeUniforms
+		int role;	// builtinUniform_e
+	};
+
+	// resolved when the program is linked, so no names are compared per frame
+	QVector< BuiltinUniform >	m_builtinUniforms;
+	FrameInputs					m_frameInputs;
+	double						m_frameTime;		// seconds, read by setFrameInputs()
+	double						m_frameDeltaTime;	// seconds since the previous setFrameInputs() call
+
+	/** The value of a uniform of a previous program. */
+	class RememberedUniform
+	{
+	public:
+		RememberedUniform( const CUniform & u=CUniform(), int Link=0 ) : value( u ), link( Link ) {}
+
+		CUniform	value;
+		int			link;	// m_numLinks when it was last active
+	};
+
+	// values of previous programs, keyed by name
+	// -> only updated if the program was successfully linked!
+	QHash< QString, RememberedUniform > m_rememberedUniforms;
+	int									m_numLinks;
+
+	// vertex and fragment shaders are included in OpenGL 2.0
+	// -> geometry shader is still an extension
+	bool m_geometryShaderAvailable;
+
+	// wether the program is ready to operate
+	bool m_linked;
+
+	// results of compile and link operation
+	QString m_log;
+	double	m_compileMs;
+	double	m_linkMs;
+
+	// timer for the "uniform float time"
+	QTime m_timer;
+
+	// program parameters
+    int m_num_output;
+	int m_maxOutputVertices; // GL_MAX_GEOMETRY_OUTPUT_VERTICES_EXT
+	int m_geometryInputType; // for geometry shader
+	int m_geometryOutputType;
+
+	// where vertex arrays can write to...
+	VertexAttribLocations m_attribLocations;
+
+	// source code for each shader type.
+	QString m_shaderSources[ MAX_SHADER_TYPES ];
+	QString m_shaderFileNames[ MAX_SHADER_TYPES ]; // empty if not saved
+	QString m_programSources[ MAX_SHADER_TYPES ]; // the ones m_program was built from, includes expanded
+	QStringList m_programFiles[ MAX_SHADER_TYPES ]; // by source string number, see IIncludeGraph
+
+	// #include resolution, unchanged files are not read again
+	IIncludeGraph* m_includes;
+
+	// objects
+	GLuint	m_shaders[ MAX_SHADER_TYPES ]; // references into m_shaderObjects, 0 if loaded from m_programCache
+	GLuint	m_program;
+
+	// compiled shaders, unchanged stages are reused by the next link
+	CShaderObjectCache* m_shaderObjects;
+
+	// linked programs of previous runs, NULL if the driver can't return binaries
+	IProgramCache*	m_programCache;
+	QString			m_driverId; // vendor, renderer and version strings
+
+	// transform feedback capture
+	QStringList		m_captureVaryings;
+	bool			m_captureVaryingsChanged;	// relink the capture program
+	GLuint			m_captureProgram;			// same shaders as m_program
+	QVector< int >	m_captureLocations;			// uniform locations, parallel to m_activeUniforms
+	QVector< int >	m_captureTypes;
+	QVector< int >	m_captureSizes;
+	GLuint			m_captureBuffer;
+	GLuint			m_captureQueries[ 2 ];		// generated, written
+	int				m_capturePrimitiveType;
+
+	// geometry shader output measurement
+	GLuint			m_probeProgram;
+	GLuint			m_probeQuery;
+
+	/** The program of a variant, see setVariants(). */
+	class VariantProgram
+	{
+	public:
+		VariantProgram( void ) : program( 0 ) {
+			for( int i = 0 ; i < MAX_SHADER_TYPES ; i++ ) shaders[ i ] = 0;
+		}
+
+		GLuint			program;	// 0 if the variant failed
+		GLuint			shaders[ MAX_SHADER_TYPES ]; // references into m_shaderObjects
+		QVector< int >	uniformLocations; // parallel to m_activeUniforms
+		QString			log;
+	};
+
+	// variants
+	QVector< ShaderVariant >	m_variants;
+	QVector< VariantProgram >	m_variantPrograms;	// parallel to m_variants, empty until they are built
+	int							m_selectedVariant;	// -1 for m_program
+	int							m_variantSerial;	// changes with the variants and with m_program
+};
+
+
+// construction
+CShader::CShader( void )
+{
+	m_geometryShaderAvailable = false;
+	m_uniformBuffersAvailable = false;
+	m_program = 0;
+	m_linked = false;
+	m_compileMs = 0.0;
+	m_linkMs = 0.0;
+	m_numUniformUploads = 0;
+	m_uniformProgram = 0;
+	m_frameTime = 0.0;
+	m_frameDeltaTime = 0.0;
+	m_numLinks = 0;
+
+    m_num_output = 4;
+	m_maxOutputVertices = 0;
+    m_geometryInputType  = GL_LINE_STRIP_ADJACENCY;
+	m_geometryOutputType = GL_TRIANGLE_STRIP;
+
+	for( int i = 0 ; i < MAX_SHADER_TYPES ; i++ )
+		m_shaders[ i ] = 0;
+
+	m_captureVaryingsChanged = false;
+	m_captureProgram = 0;
+	m_captureBuffer = 0;
+	m_captureQueries[ 0 ] = m_captureQueries[ 1 ] = 0;
+	m_capturePrimitiveType = GL_POINTS;
+
+	m_probeProgram = 0;
+	m_probeQuery = 0;
+
+	m_programCache = NULL;
+	m_shaderObjects = NULL;
+	m_includes = NULL;
+
+	m_selectedVariant = -1;
+	m_variantSerial = 0;
+}
+
+CShader::~CShader( void )
+{
+}
+
+
+/*
+========================
+create
+========================
+*/
+IShader* IShader::create( void )
+{
+	return new CShader();
+}
+
+
+/*
+========================
+init
+
+ assumes OpenGL context is ready
+========================
+*/
+bool CShader::init( bool useProgramCache )
+{
+	// clean up old state.
+	shutdown();
+
+	m_shaderObjects = new CShaderObjectCache();
+	m_includes = IIncludeGraph::create( QString( CONFIG_SHADER_DIRECTORY ) );
+	m_uniformBuffersAvailable = smglIsUniformBufferAvailable();
+
+	//
+	// find out wether we can use geometry shaders
+	//
+#ifdef CONFIG_ENABLE_GEOMETRY_SHADER
+	const char* ext = (const char*)glGetString( GL_EXTENSIONS );
+	if( strstr( ext, "GL_EXT_geometry_shader4" ) != NULL )
+	{
+		m_geometryShaderAvailable = true;
+
+		GLint n = 0;
+		glGetIntegerv( GL_MAX_GEOMETRY_OUTPUT_VERTICES_EXT, &n );
+		m_maxOutputVertices = n;
+	}
+#endif // CONFIG_ENABLE_GEOMETRY_SHADER
+
+	//
+	// binaries are only valid for the driver that created them
+	//
+#ifdef CONFIG_ENABLE_PROGRAM_CACHE
+	if( useProgramCache && smglIsProgramBinaryAvailable() )
+	{
+		m_programCache = IProgramCache::create( QString( CONFIG_PROGRAM_CACHE_DIRECTORY ) );
+		m_driverId = QString( "%1\n%2\n%3\n%4" ).
+			arg( (const char*)glGetString( GL_VENDOR ) ).
+			arg( (const char*)glGetString( GL_RENDERER ) ).
+			arg( (const char*)glGetString( GL_VERSION ) ).
+			arg( (const char*)glGetString( GL_SHADING_LANGUAGE_VERSION ) );
+	}
+#endif // CONFIG_ENABLE_PROGRAM_CACHE
+
+	return true;
+}
+
+
+/*
+========================
+shutdown
+========================
+*/
+void CShader::shutdown( void )
+{
+	m_geometryShaderAvailable = false;
+	m_maxOutputVertices = 0;
+
+	deactivateProgram();
+	m_uniformBuffersAvailable = false;
+	SAFE_DELETE( m_shaderObjects );
+	SAFE_DELETE( m_programCache );
+	SAFE_DELETE( m_includes );
+	m_driverId = QString();
+
+	for( int i = 0 ; i < MAX_SHADER_TYPES ; i++ )
+	{
+		m_shaderSources[ i ] = QString( "" );
+		m_shaderFileNames[ i ] = QString();
+	}
+}
+
+
+/*
+========================
+deactivateProgram
+
+ Destroy the program and release its shaders. They are re-created when needed.
+ Does not touch the shader source.
+========================
+*/
+void CShader::deactivateProgram( void )
+{
+	// make sure we have no references to the program.
+	m_linked = false; // in case of empty sources
+	m_attribLocations = VertexAttribLocations();
+
+	glUseProgram( 0 );
+
+	// it shares the shader objects
+	deleteCaptureProgram();
+	deleteUniformBlocks();
+
+	// built from the sources of the program
+	deleteVariantPrograms();
+	m_variantSerial++;
+	m_uniformProgram = 0;
+
+	// delete program object
+	if( m_program != 0 )
+	{
+		glDeleteProgram( m_program );
+		m_program = 0;
+	}
+
+	// delete shader objects
+	for( int i = 0 ; i < MAX_SHADER_TYPES ; i++ )
+	{
+		if( m_shaders[ i ] != 0 )
+		{
+			m_shaderObjects->release( m_shaders[ i ] );
+			m_shaders[ i ] = 0;
+		}
+	}
+}
+
+
+/*
+========================
+compileAndLink
+========================
+*/
+bool CShader::compileAndLink( bool keepOnError )
+{
+	IShaderBuild* build = createBuild();
+	build->run();
+	return finishBuild( build, keepOnError );
+}
+
+
+/*
+========================
+createBuild
+========================
+*/
+IShaderBuild* CShader::createBuild( void )
+{
+	CShaderBuild* build = new CShaderBuild();
+	setupBuild( build );
+
+	for( int i = 0 ; i < MAX_SHADER_TYPES ; i++ )
+	{
+		if( !isStageUsed( i ) )
+			continue;
+
+		// the expanded text is what the shader object cache compares
+		QString error;
+		if( !m_includes->expand( m_shaderSources[ i ], m_shaderFileNames[ i ],
+								 build->sources[ i ], build->files[ i ], error ) )
+		{
+			build->preprocessLog += QString( "Compiling %1\n" ).arg( getShaderTypeName( i ) ) + error;
+		}
+	}
+
+	if( m_programCache != NULL && build->preprocessLog.isEmpty() )
+	{
+		QByteArray description = getProgramDescription( build->sources );
+		if( !description.isEmpty() ) {
+			build->programKey = IProgramCache::makeKey( description );
+		}
+	}
+
+	return build;
+}
+
+
+/*
+========================
+setupBuild
+
+ copies the link parameters and the caches into a build.
+========================
+*/
+void CShader::setupBuild( CShaderBuild* build )
+{
+	build->geometryShaderAvailable = m_geometryShaderAvailable;
+	build->numOutputVertices	= m_num_output;
+	build->maxOutputVertices	= m_maxOutputVertices;
+	build->geometryInputType	= m_geometryInputType;
+	build->geometryOutputType	= m_geometryOutputType;
+
+	build->programCache = m_programCache;
+	build->shaderObjects = m_shaderObjects;
+}
+
+
+/*
+========================
+finishBuild
+
+ replaces the program with the objects of the build.
+========================
+*/
+bool CShader::finishBuild( IShaderBuild* shaderBuild, bool keepOnError )
+{
+	if( shaderBuild->getKind() != IShaderBuild::BUILD_PROGRAM )
+	{
+		delete shaderBuild;
+		return false;
+	}
+
+	CShaderBuild* build = static_cast< CShaderBuild* >( shaderBuild );
+
+	// the working program outlives a half-typed source
+	if( keepOnError && m_linked && ( !build->compiled || !build->linked ) )
+	{
+		m_log = build->log;
+		delete build;
+		return false;
+	}
+
+	// clean up old state
+	deactivateProgram();
+
+	// take over the objects, so the build doesn't delete them
+	m_program = build->program;
+	build->program = 0;
+	for( int i = 0 ; i < MAX_SHADER_TYPES ; i++ )
+	{
+		m_shaders[ i ] = build->shaders[ i ];
+		m_programSources[ i ] = build->sources[ i ];
+		m_programFiles[ i ] = build->files[ i ];
+		build->shaders[ i ] = 0;
+	}
+
+	m_log = build->log;
+	m_linked = build->linked;
+	m_compileMs = build->compileMs;
+	m_linkMs = build->linkMs;
+	bool totalResult = build->compiled;
+	delete build;
+
+	if( m_program == 0 )
+		return false;
+
+	// the build has no access to the uniforms and the render context
+	if( totalResult )
+	{
+		bool result = validateProgram();
+		totalResult = totalResult && result;
+	}
+
+	// post processing...
+	if( totalResult )
+	{
+		setupInitialUniforms();
+		setupRememberedUniformState();
+	}
+
+	return totalResult;
+}
+
+
+/*
+========================
+setVariants
+========================
+*/
+void CShader::setVariants( const QVector< ShaderVariant > & variants )
+{
+	deleteVariantPrograms();
+	m_variants = variants;
+	m_variantSerial++;
+
+	if( m_selectedVariant >= m_variants.size() ) {
+		m_selectedVariant = -1;
+	}
+}
+
+
+/*
+========================
+createVariantBuild
+========================
+*/
+IShaderBuild* CShader::createVariantBuild( void )
+{
+	if( m_program == 0 || !m_linked || m_variants.isEmpty() )
+		return NULL;
+
+	CShaderVariantBuild* variantBuild = new CShaderVariantBuild();
+	variantBuild->serial = m_variantSerial;
+
+	// sorted, so the key of the program binary cache doesn't depend on the hash order
+	QStringList attribNames = m_attribLocations.named.keys();
+	attribNames.sort();
+
+	for( int i = 0 ; i < m_variants.size() ; i++ )
+	{
+		CShaderBuild* build = new CShaderBuild();
+		setupBuild( build );
+
+		for( int j = 0 ; j < MAX_SHADER_TYPES ; j++ )
+		{
+			if( m_programSources[ j ].isEmpty() )
+				continue;
+
+			build->sources[ j ] = insertDefines( m_programSources[ j ], m_variants[ i ].defines );
+			build->files[ j ] = m_programFiles[ j ];
+		}
+
+		// the variants are drawn with the vertex streams of the program
+		build->attribLocations = m_attribLocations.named;
+
+		if( m_programCache != NULL )
+		{
+			QByteArray description = getProgramDescription( build->sources );
+			for( int j = 0 ; j < attribNames.size() ; j++ )
+			{
+				description += QString( "attrib %1 %2\n" ).
+					arg( attribNames[ j ] ).
+					arg( build->attribLocations.value( attribNames[ j ] ) ).toUtf8();
+			}
+			build->programKey = IProgramCache::makeKey( description );
+		}
+
+		variantBuild->builds.append( build );
+	}
+
+	return variantBuild;
+}
+
+
+/*
+========================
+finishVariantBuild
+========================
+*/
+bool CShader::finishVariantBuild( IShaderBuild* shaderBuild )
+{
+	if( shaderBuild->getKind() != IShaderBuild::BUILD_VARIANTS )
+	{
+		delete shaderBuild;
+		return false;
+	}
+
+	CShaderVariantBuild* variantBuild = static_cast< CShaderVariantBuild* >( shaderBuild );
+
+	// built from another program or for other variants
+	if( variantBuild->serial != m_variantSerial )
+	{
+		delete variantBuild;
+		return false;
+	}
+
+	deleteVariantPrograms();
+	m_variantPrograms.resize( variantBuild->builds.size() );
+
+	bool totalResult = true;
+	for( int i = 0 ; i < variantBuild->builds.size() ; i++ )
+	{
+		CShaderBuild* build = variantBuild->builds[ i ];
+		VariantProgram & variant = m_variantPrograms[ i ];
+		variant.log = build->log;
+
+		if( !build->linked )
+		{
+			totalResult = false;
+			continue;
+		}
+
+		// take over the objects, so the build doesn't delete them
+		variant.program = build->program;
+		build->program = 0;
+		for( int j = 0 ; j < MAX_SHADER_TYPES ; j++ )
+		{
+			variant.shaders[ j ] = build->shaders[ j ];
+			build->shaders[ j ] = 0;
+		}
+
+		getUniformLocations( variant.program, variant.uniformLocations );
+		bindUniformBlocks( variant.program );
+	}
+
+	delete variantBuild;
+	return totalResult;
+}
+
+
+/*
+========================
+deleteVariantPrograms
+========================
+*/
+void CShader::deleteVariantPrograms( void )
+{
+	for( int i = 0 ; i < m_variantPrograms.size() ; i++ )
+	{
+		if( m_variantPrograms[ i ].program != 0 ) {
+			glDeleteProgram( m_variantPrograms[ i ].program );
+		}
+
+		for( int j = 0 ; j < MAX_SHADER_TYPES ; j++ ) {
+			m_shaderObjects->release( m_variantPrograms[ i ].shaders[ j ] );
+		}
+	}
+	m_variantPrograms.clear();
+
+	// the name may be reused by the next program
+	m_uniformProgram = 0;
+}
+
+
+/*
+========================
+getVariantName
+========================
+*/
+QString CShader::getVariantName( int index )
+{
+	if( index < 0 || index >= m_variants.size() )
+		return QString();
+
+	return m_variants[ index ].name;
+}
+
+
+/*
+========================
+isVariantLinked
+========================
+*/
+bool CShader::isVariantLinked( int index )
+{
+	return index >= 0 && index < m_variantPrograms.size() && m_variantPrograms[ index ].program != 0;
+}
+
+
+/*
+========================
+getVariantLog
+========================
+*/
+QString CShader::getVariantLog( int index )
+{
+	if( index < 0 || index >= m_variantPrograms.size() )
+		return QString();
+
+	return m_variantPrograms[ index ].log;
+}
+
+
+/*
+========================
+selectVariant
+========================
+*/
+void CShader::selectVariant( int index )
+{
+	if( index < -1 || index >= m_variants.size() )
+		index = -1;
+
+	m_selectedVariant = index;
+}
+
+
+/*
+========================
+isStageUsed
+
+ true if the shader type is available and has source code.
+========================
+*/
+bool CShader::isStageUsed( int shaderType )
+{
+	return isShaderTypeAvailable( shaderType ) && !m_shaderSources[ shaderType ].isEmpty();
+}
+
+
+/*
+========================
+validateProgram
+
+ validates the linked program and logs its uniforms and attributes.
+========================
+*/
+bool CShader::validateProgram( void )
+{
+	GLint status;
+	char text[ 4096 ];
+
+	// validate program
+	glValidateProgram( m_program );
+	glGetProgramiv( m_program, GL_VALIDATE_STATUS, &status );
+	m_log += QString( "Validation: %1\n" ).arg( status ? "succeeded" : "failed" );
+
+	// validation log
+	memset( text, 0, sizeof(text) );
+	glGetProgramInfoLog( m_program, sizeof(text), NULL, text );
+	text[ sizeof(text)-1 ] = '\0';
+	m_log += QString( "%1\n" ).arg( text );
+	m_log += QString( "\n" );
+
+	// restart timer
+	m_timer.start();
+	m_frameTime = 0.0;
+	m_frameDeltaTime = 0.0;
+
+	// query named attrib locations
+	if( m_linked ) {
+		setupAttribLocations();
+	}
+
+	// log log log
+	logActiveUniforms();
+	logActiveAttributes();
+
+	return m_linked;
+}
+
+
+/*
+========================
+setupAttribLocations
+
+ reads the locations of all active attributes into the name table
+ and resolves the attributes known by the application from it.
+========================
+*/
+void CShader::setupAttribLocations( void )
+{
+	// vertex streams cache their lookups by this number
+	static int programSerial = 0;
+
+	m_attribLocations = VertexAttribLocations();
+	m_attribLocations.programSerial = ++programSerial;
+
+	GLint n = 0;
+	glGetProgramiv( m_program, GL_ACTIVE_ATTRIBUTES, &n );
+
+	int builtins = 0;
+	bool builtinsListed = false;
+
+	for( int i = 0 ; i < n ; i++ )
+	{
+		char name[ 256 ] = "\0";
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveAttrib( m_program, i, sizeof(name), &length, &size, &type, name );
+
+		// built-in attributes have no location
+		if( strncmp( name, "gl_", 3 ) == 0 )
+		{
+			builtinsListed = true;
+
+			if( strcmp( name, "gl_Normal" ) == 0 ) {
+				builtins |= VertexAttribLocations::BUILTIN_NORMAL;
+			} else if( strcmp( name, "gl_MultiTexCoord0" ) == 0 ) {
+				builtins |= VertexAttribLocations::BUILTIN_TEXCOORD;
+			} else if( strcmp( name, "gl_Color" ) == 0 ) {
+				builtins |= VertexAttribLocations::BUILTIN_COLOR;
+			}
+			continue;
+		}
+
+		GLint locus = glGetAttribLocation( m_program, name );
+		if( locus < 0 )
+			continue;
+
+		m_attribLocations.named.insert( QString( name ), locus );
+	}
+
+	// Without a vertex shader the fixed function pipeline reads everything.
+	// Some drivers do not list built-in attributes at all, a program without
+	// any of them (not even gl_Vertex) is treated like that, too.
+	if( !m_programSources[ TYPE_VERTEX ].isEmpty() && builtinsListed ) {
+		m_attribLocations.builtins = builtins;
+	}
+
+	m_attribLocations.tangent			= m_attribLocations.find( "attrTangent" );
+	m_attribLocations.bitangent			= m_attribLocations.find( "attrBitangent" );
+	m_attribLocations.instanceTransform	= m_attribLocations.find( "attrInstanceTransform" );
+	m_attribLocations.instanceColor		= m_attribLocations.find( "attrInstanceColor" );
+}
+
+
+/*
+========================
+getProgramDescription
+
+ everything the linked program depends on, it is hashed into the key
+ of the program binary cache. Takes the expanded sources, so an edited
+ include changes the key. Returns an empty array without shaders.
+========================
+*/
+QByteArray CShader::getProgramDescription( const QString* sources )
+{
+	QByteArray description;
+
+	for( int i = 0 ; i < MAX_SHADER_TYPES ; i++ )
+	{
+		if( sources[ i ].isEmpty() )
+			continue;
+
+		description += QString( "stage %1\n" ).arg( i ).toUtf8();
+		description += sources[ i ].toUtf8();
+		description += '\0';
+	}
+
+	if( description.isEmpty() )
+		return description;
+
+	description += QString( "geometry %1 %2 %3\n" ).
+		arg( m_geometryInputType ).
+		arg( m_geometryOutputType ).
+		arg( m_num_output ).toUtf8();
+	description += m_driverId.toUtf8();
+
+	return description;
+}
+
+
+/*
+========================
+setupProgramParameters
+========================
+*/
+void CShader::setupProgramParameters( GLuint program, int numOutputVertices )
+{
+	if( m_geometryShaderAvailable )
+	{
+		setupGeometryParameters( program, numOutputVertices, m_maxOutputVertices,
+								 m_geometryInputType, m_geometryOutputType );
+	}
+}
+
+
+/*
+========================
+setShaderSource
+========================
+*/
+void CShader::setShaderSource( int shaderType, const QString & src, const QString & fileName )
+{
+	if( shaderType >= 0 && shaderType < MAX_SHADER_TYPES )
+	{
+		m_shaderSources[ shaderType ] = src;
+		m_shaderFileNames[ shaderType ] = fileName;
+	}
+}
+
+
+/*
+========================
+setGeometryInputType
+========================
+*/
+void CShader::setGeometryInputType( int type )
+{
+	switch( type )
+	{
+	case GL_POINTS:
+	case GL_LINES:
+	case GL_LINES_ADJACENCY_EXT:
+	case GL_TRIANGLES:
+	case GL_TRIANGLES_ADJACENCY_EXT:
+		m_geometryInputType = type;
+		break;
+	}
+}
+
+
+/*
+========================
+setGeometryOutputType
+========================
+*/
+void CShader::setGeometryOutputType( int type )
+{
+	switch( type )
+	{
+	case GL_POINTS:
+	case GL_LINE_STRIP:
+	case GL_TRIANGLE_STRIP:
+		m_geometryOutputType = type;
+		break;
+    }
+}
+
+void CShader::setGeometryOutputNum(int type)
+{
+    m_num_output = type;
+}
+
+
+/*
+========================
+bindState
+
+ bind current state to GL.
+ returns true, if successfull
+========================
+*/
+bool CShader::bindState( VertexAttribLocations & attribs )
+{
+	if( m_program != 0 && m_linked )
+	{
+		// a variant that is not linked yet is drawn with the program itself
+		GLuint program = m_program;
+		const QVector< int >* locations = NULL;
+		if( isVariantLinked( m_selectedVariant ) )
+		{
+			program = m_variantPrograms[ m_selectedVariant ].program;
+			locations = &m_variantPrograms[ m_selectedVariant ].uniformLocations;
+		}
+
+		glUseProgram( program );
+		attribs = m_attribLocations;
+
+		updateBuiltinUniforms();
+
+		// the program keeps the values, only changed ones are passed.
+		// A program that was switched to gets all of them.
+		if( program != m_uniformProgram )
+		{
+			m_uniformDirty.fill( true );
+			m_uniformProgram = program;
+		}
+
+		m_numUniformUploads = 0;
+		for( int i = 0 ; i < m_activeUniforms.size() ; i++ )
+		{
+			// arrays are passed as a whole if an element changed
+			int count = m_uniformCounts[i];
+			bool dirty = false;
+			for( int j = i ; j < i + count ; j++ )
+			{
+				dirty = dirty || m_uniformDirty[j];
+				m_uniformDirty[j] = false;
+			}
+
+			if( !dirty )
+				continue;
+
+			if( locations != NULL )
+			{
+				// a variant may have fewer array elements, they are located one by one
+				for( int j = i ; j < i + count ; j++ ) {
+					CUniform( m_activeUniforms[j], (*locations)[j] ).applyToGL();
+				}
+			}
+			else if( count == 1 ) {
+				m_activeUniforms[i].applyToGL();
+			} else {
+				CUniform::applyArrayToGL( m_activeUniforms.constData() + i, count );
+			}
+			m_numUniformUploads++;
+		}
+
+		m_numUniformUploads += updateUniformBlocks();
+
+		return true;
+	}
+
+	m_numUniformUploads = 0;
+	attribs = VertexAttribLocations();
+	glUseProgram( 0 );
+	return false;
+}
+
+
+/*
+========================
+setCaptureVaryings
+========================
+*/
+void CShader::setCaptureVaryings( const QStringList & varyings )
+{
+	if( varyings != m_captureVaryings )
+	{
+		m_captureVaryings = varyings;
+		m_captureVaryingsChanged = true;
+	}
+}
+
+
+/*
+========================
+deleteCaptureProgram
+========================
+*/
+void CShader::deleteCaptureProgram( void )
+{
+	if( m_captureProgram != 0 )
+	{
+		glDeleteProgram( m_captureProgram );
+		m_captureProgram = 0;
+	}
+
+	m_captureLocations.clear();
+	m_captureTypes.clear();
+	m_captureSizes.clear();
+}
+
+
+/*
+========================
+linkCopy
+
+ links the shader objects of m_program into a new program, with a different
+ number of geometry shader output vertices and optional capture varyings.
+ The attributes are bound to the locations of m_program, so the vertex
+ streams can use the same VertexAttribLocations. The uniform locations
+ may differ, they are returned parallel to m_activeUniforms.
+ Returns 0 on failure.
+========================
+*/
+GLuint CShader::linkCopy( int numOutputVertices, const QStringList & varyings,
+						  QVector< int > & uniformLocations, QString & error )
+{
+	// a program loaded from the cache has no shader objects yet
+	if( !compileShaderObjects( error ) )
+		return 0;
+
+	GLuint program = glCreateProgram();
+	if( program == 0 )
+	{
+		error = QString( "Failed on glCreateProgram()." );
+		return 0;
+	}
+
+	for( int i = 0 ; i < MAX_SHADER_TYPES ; i++ )
+	{
+		if( m_shaders[ i ] != 0 ) {
+			glAttachShader( program, m_shaders[ i ] );
+		}
+	}
+
+	QHash< QString, int >::const_iterator it;
+	for( it = m_attribLocations.named.begin() ; it != m_attribLocations.named.end() ; ++it ) {
+		glBindAttribLocation( program, it.value(), it.key().toLatin1().constData() );
+	}
+
+	setupProgramParameters( program, numOutputVertices );
+
+	if( !varyings.isEmpty() )
+	{
+		// the names must stay valid until the call returns
+		QVector< QByteArray > names;
+		QVector< const GLchar* > pointers;
+		for( int i = 0 ; i < varyings.size() ; i++ ) {
+			names.append( varyings[ i ].toLatin1() );
+		}
+		for( int i = 0 ; i < names.size() ; i++ ) {
+			pointers.append( names[ i ].constData() );
+		}
+		smglTransformFeedbackVaryings( program, pointers.size(), pointers.data(), GL_INTERLEAVED_ATTRIBS );
+	}
+
+	glLinkProgram( program );
+
+	GLint status = GL_FALSE;
+	glGetProgramiv( program, GL_LINK_STATUS, &status );
+	if( status == GL_FALSE )
+	{
+		char text[ 4096 ];
+		memset( text, 0, sizeof(text) );
+		glGetProgramInfoLog( program, sizeof(text), NULL, text );
+		text[ sizeof(text)-1 ] = '\0';
+
+		error = QString( "Linking a copy of the program failed:\n%1" ).arg( text );
+		glDeleteProgram( program );
+		return 0;
+	}
+
+	getUniformLocations( program, uniformLocations );
+	bindUniformBlocks( program );
+
+	return program;
+}
+
+
+/*
+========================
+getUniformLocations
+
+ the locations of the uniforms of m_program in another program,
+ parallel to m_activeUniforms. -1 for the ones it doesn't use.
+========================
+*/
+void CShader::getUniformLocations( GLuint program, QVector< int > & uniformLocations )
+{
+	uniformLocations.clear();
+	for( int i = 0 ; i < m_activeUniforms.size() ; i++ )
+	{
+		uniformLocations.append( glGetUniformLocation( program,
+			m_activeUniforms[ i ].getName().toLatin1().constData() ) );
+	}
+}
+
+
+/*
+========================
+bindUniformBlocks
+
+ the blocks of another program read the buffers of m_program.
+========================
+*/
+void CShader::bindUniformBlocks( GLuint program )
+{
+	for( int i = 0 ; i < m_uniformBlocks.size() ; i++ )
+	{
+		if( m_uniformBlocks[ i ].binding < 0 )
+			continue;
+
+		GLuint index = smglGetUniformBlockIndex( program, m_uniformBlocks[ i ].name.toLatin1().constData() );
+		if( index != GL_INVALID_INDEX ) {
+			smglUniformBlockBinding( program, index, m_uniformBlocks[ i ].binding );
+		}
+	}
+}
+
+
+/*
+========================
+compileShaderObjects
+
+ compiles the shaders of the program that have no shader object.
+========================
+*/
+bool CShader::compileShaderObjects( QString & error )
+{
+	for( int i = 0 ; i < MAX_SHADER_TYPES ; i++ )
+	{
+		if( m_shaders[ i ] != 0 || m_programSources[ i ].isEmpty() )
+			continue;
+
+		QString log;
+		bool reused = false;
+		m_shaders[ i ] = m_shaderObjects->acquire( i, m_programSources[ i ], log, reused );
+		if( m_shaders[ i ] == 0 )
+		{
+			error = QString( "Compiling the %1 failed:\n%2" ).arg( getShaderTypeName( i ) ).arg( log );
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/*
+========================
+applyUniforms
+
+ passes the uniform values to a program made by linkCopy().
+========================
+*/
+void CShader::applyUniforms( const QVector< int > & uniformLocations )
+{
+	updateBuiltinUniforms();
+
+	for( int i = 0 ; i < m_activeUniforms.size() ; i++ )
+	{
+		CUniform( m_activeUniforms[i], uniformLocations[i] ).applyToGL();
+	}
+
+	updateUniformBlocks();
+}
+
+
+/*
+========================
+linkCaptureProgram
+========================
+*/
+bool CShader::linkCaptureProgram( QString & error )
+{
+	deleteCaptureProgram();
+
+	if( m_captureVaryings.isEmpty() )
+	{
+		error = QString( "No varyings to capture." );
+		return false;
+	}
+
+	m_captureProgram = linkCopy( m_num_output, m_captureVaryings, m_captureLocations, error );
+	if( m_captureProgram == 0 )
+		return false;
+
+	// the layout of the recorded vertices
+	for( int i = 0 ; i < m_captureVaryings.size() ; i++ )
+	{
+		char name[ 256 ] = "\0";
+		GLsizei length = 0;
+		GLsizei size = 0;
+		GLenum type = 0;
+		smglGetTransformFeedbackVarying( m_captureProgram, i, sizeof(name), &length, &size, &type, name );
 
-	// attach/detach
-	glGetShaderiv( m_shaders[ shaderType ], GL_COMPILE_STATUS, &status );
-	if( status != GL_FALSE )
-	{
-		// success
-		glAttachShader( m_program, m_shaders[ shaderType ] );
-		return true;
+		m_captureTypes.append( type );
+		m_captureSizes.append( size );
 	}
 
-	return false;
+	return true;
 }
 
 
 /*
 ========================
-linkAndValidateProgram
+getCapturePrimitiveType
+
+ transform feedback records points, lines or triangles.
+ The type depends on the geometry shader, if any, or on the draw calls.
 ========================
 */
-bool CShader::linkAndValidateProgram( void )
+int CShader::getCapturePrimitiveType( int drawPrimitiveType )
 {
-	GLint status;
-	char text[ 4096 ];
+	int type = drawPrimitiveType;
+	if( !m_programSources[ TYPE_GEOMETRY ].isEmpty() ) {
+		type = m_geometryOutputType;
+	}
 
-	m_log += QString( "Linking...\n" );
+	switch( type )
+	{
+	case GL_POINTS:
+		return GL_POINTS;
 
-	// things that must be done before linking
-	setupProgramParameters();
+	case GL_LINES:
+	case GL_LINE_STRIP:
+	case GL_LINE_LOOP:
+	case GL_LINES_ADJACENCY_EXT:
+	case GL_LINE_STRIP_ADJACENCY_EXT:
+		return GL_LINES;
+	}
 
-	glLinkProgram( m_program );
+	return GL_TRIANGLES;
+}
 
-	// read log
-	memset( text, 0, sizeof(text) );
-	glGetProgramInfoLog( m_program, sizeof(text), NULL, text );
-	text[ sizeof(text)-1 ] = '\0';
-	m_log += QString( "%1\n\n" ).arg( text );
 
-	// check link status
-	glGetProgramiv( m_program, GL_LINK_STATUS, &status );
-	m_linked = ( status != GL_FALSE );
+/*
+========================
+beginCapture
+========================
+*/
+bool CShader::beginCapture( VertexAttribLocations & attribs, int drawPrimitiveType,
+							int maxBytes, QString & error )
+{
+	if( !isCaptureAvailable() )
+	{
+		error = QString( "Transform feedback is not supported by the OpenGL implementation." );
+		return false;
+	}
 
-	// validate program
-	glValidateProgram( m_program );
-	glGetProgramiv( m_program, GL_VALIDATE_STATUS, &status );
-	m_log += QString( "Validation: %1\n" ).arg( status ? "succeeded" : "failed" );
+	if( m_program == 0 || !m_linked )
+	{
+		error = QString( "The program is not linked." );
+		return false;
+	}
 
-	// validation log
-	memset( text, 0, sizeof(text) );
-	glGetProgramInfoLog( m_program, sizeof(text), NULL, text );
-	text[ sizeof(text)-1 ] = '\0';
-	m_log += QString( "%1\n" ).arg( text );
-	m_log += QString( "\n" );
+	// link on first use, and after the varyings changed
+	if( m_captureProgram == 0 || m_captureVaryingsChanged )
+	{
+		m_captureVaryingsChanged = false;
+		if( !linkCaptureProgram( error ) )
+			return false;
+	}
 
-	// restart timer
-	m_timer.start();
+	glUseProgram( m_captureProgram );
+	attribs = m_attribLocations;
 
-	// query named attrib locations
-	m_attribLocations.tangent   = glGetAttribLocation( m_program, "attrTangent" );
-	m_attribLocations.bitangent = glGetAttribLocation( m_program, "attrBitangent" );
+	// same uniform values as the regular program
+	applyUniforms( m_captureLocations );
 
-	// log log log
-	logActiveUniforms();
-	logActiveAttributes();
+	// the capture buffer
+	glGenBuffers( 1, &m_captureBuffer );
+	glBindBuffer( GL_TRANSFORM_FEEDBACK_BUFFER, m_captureBuffer );
+	glBufferData( GL_TRANSFORM_FEEDBACK_BUFFER, maxBytes, NULL, GL_STREAM_READ );
+	glBindBuffer( GL_TRANSFORM_FEEDBACK_BUFFER, 0 );
+	smglBindBufferBase( GL_TRANSFORM_FEEDBACK_BUFFER, 0, m_captureBuffer );
 
-	return m_linked;
+	// count the primitives, including those that don't fit
+	glGenQueries( 2, m_captureQueries );
+	glBeginQuery( GL_PRIMITIVES_GENERATED, m_captureQueries[ 0 ] );
+	glBeginQuery( GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, m_captureQueries[ 1 ] );
+
+	m_capturePrimitiveType = getCapturePrimitiveType( drawPrimitiveType );
+	smglBeginTransformFeedback( m_capturePrimitiveType );
+
+	return true;
 }
 
 
 /*
 ========================
-setupProgramParameters
+endCapture
 ========================
 */
-void CShader::setupProgramParameters( void )
+void CShader::endCapture( FeedbackCapture & result )
 {
-	GLint n;
+	result = FeedbackCapture();
 
-	//
-	// geometry shader specific program parameters
-	//
-	if( m_geometryShaderAvailable )
+	if( m_captureBuffer == 0 )
 	{
-		// query maximum
-        glGetIntegerv( GL_MAX_GEOMETRY_OUTPUT_VERTICES_EXT, &n );
-
-		// set maximum. may be inefficient, but of universal use.
-        glProgramParameteriEXT( m_program, GL_GEOMETRY_VERTICES_OUT_EXT, m_num_output );
+		result.error = QString( "No capture in progress." );
+		return;
+	}
 
-		// set primitive types
-		glProgramParameteriEXT( m_program, GL_GEOMETRY_INPUT_TYPE_EXT,  m_geometryInputType );
-		glProgramParameteriEXT( m_program, GL_GEOMETRY_OUTPUT_TYPE_EXT, m_geometryOutputType );
+	smglEndTransformFeedback();
+	glEndQuery( GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN );
+	glEndQuery( GL_PRIMITIVES_GENERATED );
+
+	GLuint generated = 0;
+	GLuint written = 0;
+	glGetQueryObjectuiv( m_captureQueries[ 0 ], GL_QUERY_RESULT, &generated );
+	glGetQueryObjectuiv( m_captureQueries[ 1 ], GL_QUERY_RESULT, &written );
+	glDeleteQueries( 2, m_captureQueries );
+	m_captureQueries[ 0 ] = m_captureQueries[ 1 ] = 0;
+
+	result.varyings				= m_captureVaryings;
+	result.types				= m_captureTypes;
+	result.sizes				= m_captureSizes;
+	result.primitiveType		= m_capturePrimitiveType;
+	result.primitivesGenerated	= generated;
+	result.primitivesWritten	= written;
+
+	// read back the recorded primitives only
+	GLint bufferSize = 0;
+	glBindBuffer( GL_TRANSFORM_FEEDBACK_BUFFER, m_captureBuffer );
+	glGetBufferParameteriv( GL_TRANSFORM_FEEDBACK_BUFFER, GL_BUFFER_SIZE, &bufferSize );
+
+	int numBytes = int( written ) * result.getVerticesPerPrimitive() * result.getVertexSize();
+	numBytes = qBound( 0, numBytes, int( bufferSize ) );
+
+	result.data.resize( numBytes );
+	if( numBytes > 0 ) {
+		glGetBufferSubData( GL_TRANSFORM_FEEDBACK_BUFFER, 0, numBytes, result.data.data() );
 	}
+
+	glBindBuffer( GL_TRANSFORM_FEEDBACK_BUFFER, 0 );
+	smglBindBufferBase( GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0 );
+	glDeleteBuffers( 1, &m_captureBuffer );
+	m_captureBuffer = 0;
 }
 
 
 /*
 ========================
-setShaderSource
+beginGeometryProbe
 ========================
 */
-void CShader::setShaderSource( int shaderType, const QString & src )
+bool CShader::beginGeometryProbe( VertexAttribLocations & attribs, int numOutputVertices, QString & error )
 {
-	if( shaderType >= 0 && shaderType < MAX_SHADER_TYPES )
+	if( !isCaptureAvailable() )
 	{
-		m_shaderSources[ shaderType ] = src;
+		error = QString( "Counting primitives requires transform feedback." );
+		return false;
 	}
-}
-
 
-/*
-========================
-setGeometryInputType
-========================
-*/
-void CShader::setGeometryInputType( int type )
-{
-	switch( type )
+	if( m_program == 0 || !m_linked || m_programSources[ TYPE_GEOMETRY ].isEmpty() )
 	{
-	case GL_POINTS:
-	case GL_LINES:
-	case GL_LINES_ADJACENCY_EXT:
-	case GL_TRIANGLES:
-	case GL_TRIANGLES_ADJACENCY_EXT:
-		m_geometryInputType = type;
-		break;
+		error = QString( "The program has no geometry shader." );
+		return false;
 	}
+
+	QVector< int > locations;
+	m_probeProgram = linkCopy( numOutputVertices, QStringList(), locations, error );
+	if( m_probeProgram == 0 )
+		return false;
+
+	glUseProgram( m_probeProgram );
+	attribs = m_attribLocations;
+	applyUniforms( locations );
+
+	// the geometry stage runs, nothing is drawn
+	glEnable( GL_RASTERIZER_DISCARD );
+
+	glGenQueries( 1, &m_probeQuery );
+	glBeginQuery( GL_PRIMITIVES_GENERATED, m_probeQuery );
+
+	return true;
 }
 
 
 /*
 ========================
-setGeometryOutputType
+endGeometryProbe
 ========================
 */
-void CShader::setGeometryOutputType( int type )
+int CShader::endGeometryProbe( void )
 {
-	switch( type )
-	{
-	case GL_POINTS:
-	case GL_LINE_STRIP:
-	case GL_TRIANGLE_STRIP:
-		m_geometryOutputType = type;
-		break;
-    }
-}
+	if( m_probeProgram == 0 )
+		return 0;
 
-void CShader::setGeometryOutputNum(int type)
-{
-    m_num_output = type;
+	glEndQuery( GL_PRIMITIVES_GENERATED );
+	glDisable( GL_RASTERIZER_DISCARD );
+
+	GLuint generated = 0;
+	glGetQueryObjectuiv( m_probeQuery, GL_QUERY_RESULT, &generated );
+	glDeleteQueries( 1, &m_probeQuery );
+	m_probeQuery = 0;
+
+	glUseProgram( 0 );
+	glDeleteProgram( m_probeProgram );
+	m_probeProgram = 0;
+
+	return int( generated );
 }
 
 
 /*
 ========================
-bindState
+setFrameInputs
 
- bind current state to GL.
- returns true, if successfull
+ the timer is read once per frame, so the capture and probe programs
+ drawn before the regular one don't shorten its delta time.
 ========================
 */
-bool CShader::bindState( VertexAttribLocations & attribs )
+void CShader::setFrameInputs( const FrameInputs & inputs )
 {
-	if( m_program != 0 && m_linked )
-	{
-		glUseProgram( m_program );
-		attribs = m_attribLocations;
-
-		for( int i = 0 ; i < m_activeUniforms.size() ; i++ )
-		{
-			updateTimeVariable( m_activeUniforms[i] );
-			m_activeUniforms[i].applyToGL();
-		}
-
-		return true;
-	}
+	m_frameInputs = inputs;
 
-	attribs = VertexAttribLocations();
-	glUseProgram( 0 );
-	return false;
+	// read timer and convert to seconds
+	double time = double(m_timer.elapsed()) * 0.001;
+	m_frameDeltaTime = time - m_frameTime;
+	m_frameTime = time;
 }
 
 
 /*
 ========================
-updateTimeVariable
+updateBuiltinUniforms
 
- checks wether this is the 'time' variable and updates it.
+ sets the uniforms found by setupInitialUniforms() and marks
+ the changed ones dirty.
 ========================
 */
-void CShader::updateTimeVariable( CUniform & u )
+void CShader::updateBuiltinUniforms( void )
 {
-	// is this the time variable?
-	if( u.getType() == GL_FLOAT &&
-		0 == QString("time").compare( u.getName(), Qt::CaseInsensitive ) )
+	const FrameInputs & in = m_frameInputs;
+
+	for( int i = 0 ; i < m_builtinUniforms.size() ; i++ )
 	{
-		// read timer and convert to seconds
-		u.setValueAsFloat( 0, double(m_timer.elapsed()) * 0.001 );
+		int index = m_builtinUniforms[ i ].index;
+		CUniform u = m_activeUniforms[ index ];
+
+		// vectors get all four components, only the used ones are passed
+		switch( m_builtinUniforms[ i ].role )
+		{
+		case BUILTIN_TIME:
+			u.setValueAsFloat( 0, m_frameTime );
+			break;
+
+		case BUILTIN_DELTA_TIME:
+			u.setValueAsFloat( 0, m_frameDeltaTime );
+			break;
+
+		case BUILTIN_FRAME:
+			if( u.getBaseType() == CUniform::BASE_TYPE_INT ) {
+				u.setValueAsInt( 0, in.frame );
+			} else {
+				u.setValueAsFloat( 0, in.frame );
+			}
+			break;
+
+		case BUILTIN_RESOLUTION:
+			u.setValueAsFloat( 0, in.resolution.x );
+			u.setValueAsFloat( 1, in.resolution.y );
+			u.setValueAsFloat( 2, in.resolution.z );
+			break;
+
+		case BUILTIN_MOUSE:
+			u.setValueAsFloat( 0, in.mouse.x );
+			u.setValueAsFloat( 1, in.mouse.y );
+			u.setValueAsFloat( 2, in.mouse.z );
+			u.setValueAsFloat( 3, in.mouse.w );
+			break;
+
+		case BUILTIN_VIEW_MATRIX:
+			u.setMatrix4( in.viewMatrix.toConstFloatPointer() );
+			break;
+
+		case BUILTIN_PROJECTION_MATRIX:
+			u.setMatrix4( in.projectionMatrix.toConstFloatPointer() );
+			break;
+
+		case BUILTIN_BOUNDS_MIN:
+			u.setValueAsFloat( 0, in.boundsMin.x );
+			u.setValueAsFloat( 1, in.boundsMin.y );
+			u.setValueAsFloat( 2, in.boundsMin.z );
+			break;
+
+		case BUILTIN_BOUNDS_MAX:
+			u.setValueAsFloat( 0, in.boundsMax.x );
+			u.setValueAsFloat( 1, in.boundsMax.y );
+			u.setValueAsFloat( 2, in.boundsMax.z );
+			break;
+		}
+
+		if( !u.isValueEqual( m_activeUniforms[ index ] ) )
+		{
+			m_activeUniforms[ index ] = u;
+			m_uniformDirty[ index ] = true;
+		}
 	}
 }
 
@@ -647,6 +2531,12 @@ void CShader::setupInitialUniforms( void )
 	glGetProgramiv( m_program, GL_ACTIVE_UNIFORMS, &n );
 
 	QVector< CUniform > uniforms;
+	QVector< int > counts;
+
+	deleteUniformBlocks();
+	if( m_uniformBuffersAvailable ) {
+		setupUniformBlocks();
+	}
 
 	// read all active uniforms
 	for( int i = 0 ; i < n ; i++ )
@@ -657,15 +2547,185 @@ void CShader::setupInitialUniforms( void )
 		GLint size = 0;
 		GLenum type = 0;
 		glGetActiveUniform( m_program, i, sizeof(name), &length, &size, &type, name );
-		GLint locus = glGetUniformLocation( m_program, name );
+
+		// layout of uniform block members
+		GLint block = -1, offset = 0, arrayStride = 0, matrixStride = 0, rowMajor = 0;
+		if( m_uniformBuffersAvailable )
+		{
+			GLuint index = i;
+			smglGetActiveUniformsiv( m_program, 1, &index, GL_UNIFORM_BLOCK_INDEX, &block );
+			if( block >= 0 )
+			{
+				smglGetActiveUniformsiv( m_program, 1, &index, GL_UNIFORM_OFFSET, &offset );
+				smglGetActiveUniformsiv( m_program, 1, &index, GL_UNIFORM_ARRAY_STRIDE, &arrayStride );
+				smglGetActiveUniformsiv( m_program, 1, &index, GL_UNIFORM_MATRIX_STRIDE, &matrixStride );
+				smglGetActiveUniformsiv( m_program, 1, &index, GL_UNIFORM_IS_ROW_MAJOR, &rowMajor );
+			}
+		}
+
+		// arrays are split into their elements, some drivers append "[0]"
+		QString baseName( name );
+		bool isArray = size > 1 || baseName.endsWith( "[0]" );
+		if( baseName.endsWith( "[0]" ) ) {
+			baseName.chop( 3 );
+		}
 
 		// add to list
-		uniforms.append( CUniform( QString( name ), type, locus ) );
+		for( int e = 0 ; e < size ; e++ )
+		{
+			QString elementName = isArray ? QString( "%1[%2]" ).arg( baseName ).arg( e ) : baseName;
+
+			if( block >= 0 && block < m_uniformBlocks.size() )
+			{
+				m_uniformBlocks[ block ].members.append(
+					BlockMember( uniforms.size(), offset + e * arrayStride, matrixStride, rowMajor != 0 ) );
+				uniforms.append( CUniform( elementName, type, -1, block ) );
+				counts.append( 0 );
+			}
+			else
+			{
+				GLint locus = glGetUniformLocation( m_program, elementName.toLatin1().constData() );
+				uniforms.append( CUniform( elementName, type, locus ) );
+				counts.append( e == 0 ? size : 0 );
+			}
+		}
+	}
+
+	// keep the values of the old program
+	for( int i = 0 ; i < m_activeUniforms.size() ; i++ )
+	{
+		const CUniform & u = m_activeUniforms[ i ];
+		m_rememberedUniforms.insert( u.getName(), RememberedUniform( u, m_numLinks ) );
 	}
+	m_numLinks++;
 
 	// replace buffers
-	m_oldUniforms = m_activeUniforms;
 	m_activeUniforms = uniforms;
+	m_uniformCounts = counts;
+
+	// a new program has default values
+	m_uniformDirty.fill( true, m_activeUniforms.size() );
+
+	// find the uniforms set by the shader editor
+	m_builtinUniforms.clear();
+	for( int i = 0 ; i < m_activeUniforms.size() ; i++ )
+	{
+		int role = getBuiltinUniformRole( m_activeUniforms[ i ].getName(), m_activeUniforms[ i ].getType() );
+		if( role != BUILTIN_NONE ) {
+			m_builtinUniforms.append( BuiltinUniform( i, role ) );
+		}
+	}
+}
+
+
+/*
+========================
+setupUniformBlocks
+
+ creates a buffer object for each uniform block of m_program.
+ The block index is used as binding point.
+========================
+*/
+void CShader::setupUniformBlocks( void )
+{
+	GLint numBlocks = 0;
+	GLint maxBindings = 0;
+	glGetProgramiv( m_program, GL_ACTIVE_UNIFORM_BLOCKS, &numBlocks );
+	glGetIntegerv( GL_MAX_UNIFORM_BUFFER_BINDINGS, &maxBindings );
+
+	for( int i = 0 ; i < numBlocks ; i++ )
+	{
+		char name[ 256 ] = "\0";
+		GLint size = 0;
+		smglGetActiveUniformBlockName( m_program, i, sizeof(name), NULL, name );
+		smglGetActiveUniformBlockiv( m_program, i, GL_UNIFORM_BLOCK_DATA_SIZE, &size );
+
+		UniformBlock block;
+		block.name = QString( name );
+		block.data.fill( 0, size );
+
+		if( i < maxBindings )
+		{
+			block.binding = i;
+			smglUniformBlockBinding( m_program, i, i );
+		}
+
+		glGenBuffers( 1, &block.buffer );
+		glBindBuffer( GL_UNIFORM_BUFFER, block.buffer );
+		glBufferData( GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW );
+
+		m_uniformBlocks.append( block );
+	}
+
+	glBindBuffer( GL_UNIFORM_BUFFER, 0 );
+}
+
+
+/*
+========================
+deleteUniformBlocks
+========================
+*/
+void CShader::deleteUniformBlocks( void )
+{
+	for( int i = 0 ; i < m_uniformBlocks.size() ; i++ )
+	{
+		if( m_uniformBlocks[ i ].buffer != 0 ) {
+			glDeleteBuffers( 1, &m_uniformBlocks[ i ].buffer );
+		}
+	}
+
+	m_uniformBlocks.clear();
+}
+
+
+/*
+========================
+updateUniformBlocks
+
+ copies the changed members into the block data, then writes each
+ changed block with a single call and binds the buffers.
+ Returns the number of written buffers.
+========================
+*/
+int CShader::updateUniformBlocks( void )
+{
+	int numWrites = 0;
+
+	for( int i = 0 ; i < m_uniformBlocks.size() ; i++ )
+	{
+		UniformBlock & block = m_uniformBlocks[ i ];
+
+		for( int j = 0 ; j < block.members.size() ; j++ )
+		{
+			const BlockMember & member = block.members[ j ];
+			if( !m_uniformDirty[ member.uniform ] )
+				continue;
+
+			GLubyte* data = reinterpret_cast< GLubyte* >( block.data.data() ) + member.offset;
+			m_activeUniforms[ member.uniform ].copyToBlock( data, member.matrixStride, member.rowMajor );
+			m_uniformDirty[ member.uniform ] = false;
+			block.dirty = true;
+		}
+
+		if( block.dirty )
+		{
+			glBindBuffer( GL_UNIFORM_BUFFER, block.buffer );
+			glBufferSubData( GL_UNIFORM_BUFFER, 0, block.data.size(), block.data.constData() );
+			block.dirty = false;
+			numWrites++;
+		}
+
+		if( block.binding >= 0 ) {
+			smglBindBufferBase( GL_UNIFORM_BUFFER, block.binding, block.buffer );
+		}
+	}
+
+	if( numWrites > 0 ) {
+		glBindBuffer( GL_UNIFORM_BUFFER, 0 );
+	}
+
+	return numWrites;
 }
 
 
@@ -673,31 +2733,42 @@ void CShader::setupInitialUniforms( void )
 ========================
 setupRememberedUniformState
 
- Scans m_oldUniforms for name and type matches in m_activeUniforms
- and copies thoses values. This makes it unnecessary for the user
+ Looks up the name of each uniform in m_rememberedUniforms and copies
+ the value if the type matches. This makes it unnecessary for the user
  to setup each uniform every time the shader is compiled. This way
  no data is stored in the presentation code.
+ Array elements are separate uniforms, so they are matched one by one.
+ Uniforms missing from the new program are kept for a number of links,
+ e.g. while the code using them is commented out.
 ========================
 */
 void CShader::setupRememberedUniformState( void )
 {
-	for( int i = 0 ; i < m_oldUniforms.size() ; i++ )
+	for( int i = 0 ; i < m_activeUniforms.size() ; i++ )
 	{
-		for( int j = 0 ; j < m_activeUniforms.size() ; j++ )
-		{
-			const CUniform & old = m_oldUniforms[ i ];
-			const CUniform & neu = m_activeUniforms[ j ];
+		const CUniform & neu = m_activeUniforms[ i ];
 
-			// match name
-			if( old.getName().compare( neu.getName(), Qt::CaseSensitive ) )
-				continue;
+		QHash< QString, RememberedUniform >::const_iterator it = m_rememberedUniforms.constFind( neu.getName() );
+		if( it == m_rememberedUniforms.constEnd() )
+			continue;
 
-			// match type
-			if( old.getType() != neu.getType() )
-				continue;
+		// match type
+		const CUniform & old = it.value().value;
+		if( old.getType() != neu.getType() )
+			continue;
+
+		// do not overwrite the new location!!
+		m_activeUniforms[ i ] = CUniform( old, neu.getLocation(), neu.getBlock() );
+	}
 
-			// do not overwrite the new location!!
-			m_activeUniforms[ j ] = CUniform( old, neu.getLocation() );
+	// forget the uniforms that were missing for too long
+	QHash< QString, RememberedUniform >::iterator it = m_rememberedUniforms.begin();
+	while( it != m_rememberedUniforms.end() )
+	{
+		if( m_numLinks - it.value().link > CONFIG_REMEMBERED_UNIFORM_LINKS ) {
+			it = m_rememberedUniforms.erase( it );
+		} else {
+			++it;
 		}
 	}
 }
@@ -723,7 +2794,10 @@ void CShader::setUniform( int index, const CUniform & u )
 		return;
 	}
 
-	// saves new data
+	// saves new data, it is passed by the next bindState() call
+	if( !u2.isValueEqual( u ) ) {
+		m_uniformDirty[ index ] = true;
+	}
 	m_activeUniforms[ index ] = u;
 }
 
@@ -760,28 +2834,6 @@ CUniform CShader::getUniform( int index )
 }
 
 
-/*
-========================
-toGlShaderType
-
- maps TYPE_xy to GL_xy
-========================
-*/
-int CShader::toGlShaderType( int symbol )
-{
-	switch( symbol )
-	{
-	case TYPE_VERTEX:	return GL_VERTEX_SHADER;		break;
-	case TYPE_GEOMETRY:	return GL_GEOMETRY_SHADER_EXT;	break;
-	case TYPE_FRAGMENT:	return GL_FRAGMENT_SHADER;		break;
-	}
-
-	// never get here...
-	assert( 0 );
-	return 0;
-}
-
-
 /*
 ========================
 isShaderTypeAvailable
@@ -821,6 +2873,59 @@ QString IShader::getShaderTypeName( int symbol )
 }
 
 
+// names of the built-in uniforms, a role may accept several types
+static const struct builtinUniformName_s
+{
+	const char*	name;
+	int			type;
+	int			role;
+} builtinUniformNames[] =
+{
+	{ "time",				GL_FLOAT,		IShader::BUILTIN_TIME },
+	{ "iTime",				GL_FLOAT,		IShader::BUILTIN_TIME },
+	{ "deltaTime",			GL_FLOAT,		IShader::BUILTIN_DELTA_TIME },
+	{ "iTimeDelta",			GL_FLOAT,		IShader::BUILTIN_DELTA_TIME },
+	{ "frame",				GL_INT,			IShader::BUILTIN_FRAME },
+	{ "frame",				GL_FLOAT,		IShader::BUILTIN_FRAME },
+	{ "iFrame",				GL_INT,			IShader::BUILTIN_FRAME },
+	{ "iFrame",				GL_FLOAT,		IShader::BUILTIN_FRAME },
+	{ "resolution",			GL_FLOAT_VEC2,	IShader::BUILTIN_RESOLUTION },
+	{ "resolution",			GL_FLOAT_VEC3,	IShader::BUILTIN_RESOLUTION },
+	{ "iResolution",		GL_FLOAT_VEC2,	IShader::BUILTIN_RESOLUTION },
+	{ "iResolution",		GL_FLOAT_VEC3,	IShader::BUILTIN_RESOLUTION },
+	{ "mouse",				GL_FLOAT_VEC2,	IShader::BUILTIN_MOUSE },
+	{ "mouse",				GL_FLOAT_VEC4,	IShader::BUILTIN_MOUSE },
+	{ "iMouse",				GL_FLOAT_VEC2,	IShader::BUILTIN_MOUSE },
+	{ "iMouse",				GL_FLOAT_VEC4,	IShader::BUILTIN_MOUSE },
+	{ "viewMatrix",			GL_FLOAT_MAT4,	IShader::BUILTIN_VIEW_MATRIX },
+	{ "projectionMatrix",	GL_FLOAT_MAT4,	IShader::BUILTIN_PROJECTION_MATRIX },
+	{ "boundsMin",			GL_FLOAT_VEC3,	IShader::BUILTIN_BOUNDS_MIN },
+	{ "boundsMax",			GL_FLOAT_VEC3,	IShader::BUILTIN_BOUNDS_MAX },
+};
+
+
+/*
+========================
+getBuiltinUniformRole
+========================
+*/
+int IShader::getBuiltinUniformRole( const QString & name, int type )
+{
+	int n = sizeof( builtinUniformNames ) / sizeof( builtinUniformNames[ 0 ] );
+
+	for( int i = 0 ; i < n ; i++ )
+	{
+		if( builtinUniformNames[ i ].type == type &&
+			0 == name.compare( QString( builtinUniformNames[ i ].name ), Qt::CaseInsensitive ) )
+		{
+			return builtinUniformNames[ i ].role;
+		}
+	}
+
+	return BUILTIN_NONE;
+}
+
+
 /*
 ========================
 logActiveUniforms
@@ -17,11 +17,57 @@
 #define __SHADER_H_ICNLDUDED__
 
 #include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
 
 #include "uniform.h"
+#include "vector.h"
 
 // forward declarations
 class VertexAttribLocations;
+class FeedbackCapture;
+class IShaderBuild;
+
+
+//=============================================================================
+//	FrameInputs - per frame values of the built-in uniforms
+//=============================================================================
+
+/** Values the scene passes to the built-in uniforms every frame,
+ * see IShader::setFrameInputs(). The time is measured by IShader itself,
+ * once per setFrameInputs() call.
+ */
+class FrameInputs
+{
+public:
+	FrameInputs( void ) : frame( 0 ), resolution( 0, 0, 1 ), mouse( 0, 0, 0, 0 ) {}
+
+	int		frame;				///< index of the rendered frame
+	vec3_t	resolution;			///< viewport width and height in pixels, z is the pixel aspect
+	vec4_t	mouse;				///< xy: position while a button is held, zw: position of the last click, negative while released
+	mat4_t	viewMatrix;			///< camera transformation
+	mat4_t	projectionMatrix;	///< GL_PROJECTION_MATRIX
+	vec3_t	boundsMin;			///< bounding box of the test model
+	vec3_t	boundsMax;
+};
+
+
+//=============================================================================
+//	ShaderVariant - a permutation of the program's #defines
+//=============================================================================
+
+/** A variant of the program, built from the same sources with additional
+ * #define lines, see IShader::setVariants().
+ */
+class ShaderVariant
+{
+public:
+	ShaderVariant( void ) {}
+	ShaderVariant( const QString & Name, const QString & Defines ) : name( Name ), defines( Defines ) {}
+
+	QString	name;		///< shown to the user
+	QString	defines;	///< #define lines, inserted after the #version directive
+};
 
 
 //=============================================================================
@@ -47,9 +93,10 @@ public:
 
 	/** Initialized the object.
 	 * After this call the object is ready to compile and link GLSL code.
+	 * @param useProgramCache False to always compile, e.g. to measure the compile times.
 	 * @pre Requeires a valid OpenGL context in use.
 	 */
-	virtual bool init( void ) = 0;
+	virtual bool init( bool useProgramCache = true ) = 0;
 
 
 	/** Destroys all OpenGL objects and goes back to uninitialized state.
@@ -68,18 +115,116 @@ public:
 	virtual bool bindState( VertexAttribLocations & attribs ) = 0;
 
 
+	/** Returns the number of uniform values passed to OpenGL by the last
+	 * bindState() call. Only values that changed since the previous call
+	 * are passed, e.g. after setUniform() or the time variable.
+	 */
+	virtual int getNumUniformUploads( void ) = 0;
+
+
+	/** Sets the values of the built-in uniforms for the next bindState() call.
+	 * Call it once per frame, it also advances the time and the delta time.
+	 * The built-in uniforms are resolved once the program is linked,
+	 * see getBuiltinUniformRole().
+	 */
+	virtual void setFrameInputs( const FrameInputs & inputs ) = 0;
+
+
 	/** Compiles shaders and links the program.
 	 * Is also setups uniform lists and build log.
 	 * If no sources are specified for all shaders, this call
 	 * will return true although no program is generated.
+	 * If the driver supports program binaries, a program linked before
+	 * from the same sources and parameters is loaded from a disk cache
+	 * instead, the build log tells wether that happened. Otherwise only the
+	 * shaders whose source changed since one of the last links are compiled.
+	 * @param keepOnError If true, a failed build doesn't replace a linked
+	 *			program, see finishBuild().
+	 * @return True if the program was successfully linked. False otherwise.
+	 */
+	virtual bool compileAndLink( bool keepOnError = false ) = 0;
+
+
+	/** Copies the shader sources and the link parameters into a build,
+	 * so they can be compiled on another thread while the current program
+	 * keeps rendering. compileAndLink() is the same as createBuild(),
+	 * IShaderBuild::run() and finishBuild().
+	 * @return A new build, it must be passed to finishBuild() or deleted.
+	 */
+	virtual IShaderBuild* createBuild( void ) = 0;
+
+
+	/** Replaces the program with the result of a build.
+	 * Also setups uniform lists and build log, like compileAndLink().
+	 * @param build A build created by this object, after its run() call.
+	 *			It is deleted by this call. Builds of another kind are
+	 *			deleted without changing the program.
+	 * @param keepOnError If true and the build failed to compile or link,
+	 *			a linked program and its variants are kept. Only the build
+	 *			log is replaced, so it shows the errors.
 	 * @return True if the program was successfully linked. False otherwise.
 	 */
-	virtual bool compileAndLink( void ) = 0;
+	virtual bool finishBuild( IShaderBuild* build, bool keepOnError = false ) = 0;
+
+
+	/** Sets the variants of the program. Every variant is linked into
+	 * a program of its own, so switching between them is only a
+	 * glUseProgram() call. The programs of the old variants are deleted.
+	 * @param variants The variants, empty to use only the program itself.
+	 */
+	virtual void setVariants( const QVector< ShaderVariant > & variants ) = 0;
+
+
+	/** Like createBuild(), but the build links the programs of all variants
+	 * from the sources of the current program. The variants share the uniform
+	 * values, the attribute locations and the uniform block buffers of the
+	 * program, uniforms that are only active in a variant keep their defaults.
+	 * @return A new build, it must be passed to finishVariantBuild() or deleted.
+	 *			NULL if there are no variants or the program is not linked.
+	 */
+	virtual IShaderBuild* createVariantBuild( void ) = 0;
+
+
+	/** Takes the programs of a build created by createVariantBuild().
+	 * The build is deleted by this call. It is ignored if the program
+	 * or the variants changed since it was created, or if it is not
+	 * a variant build.
+	 * @return True if all variants were successfully linked.
+	 */
+	virtual bool finishVariantBuild( IShaderBuild* build ) = 0;
+
+
+	/** Returns the number of variants passed to setVariants(). */
+	virtual int getNumVariants( void ) = 0;
+
+
+	/** Returns the name of a variant. */
+	virtual QString getVariantName( int index ) = 0;
+
+
+	/** Returns true if the program of a variant is ready to use. */
+	virtual bool isVariantLinked( int index ) = 0;
+
+
+	/** Returns the build log of a variant, empty if it was not built yet. */
+	virtual QString getVariantLog( int index ) = 0;
+
+
+	/** Selects the variant bindState() uses.
+	 * The program itself is used while the variant is not linked.
+	 * @param index The variant, -1 for the program itself.
+	 */
+	virtual void selectVariant( int index ) = 0;
+
+
+	/** Returns the variant passed to selectVariant(). */
+	virtual int getSelectedVariant( void ) = 0;
 
 
 	/** Destroys the current program and makes it unuseable.
 	 * Future calls to bindState() will fail until a call to
 	 * compileAndLink() successfully created a program.
+	 * The programs of the variants are deleted, the variants are kept.
 	 */
 	virtual void deactivateProgram( void ) = 0;
 
@@ -93,15 +238,28 @@ public:
 	virtual QString getBuildLog( void ) = 0;
 
 
+	/** Returns the wall clock times of the last compileAndLink() or finishBuild().
+	 * @param compileMs Receives the time of all compile calls, 0 if the
+	 *			program was loaded from the program binary cache.
+	 * @param linkMs Receives the time of the link, or of loading the binary.
+	 */
+	virtual void getBuildTimes( double & compileMs, double & linkMs ) = 0;
+
+
 	/** Assigns GLSL source code to a shader.
 	 * Old source code is replaced with the new code.
 	 * the program is not changed until compileAndLink() is called.
 	 * An empty string indicates that the specified shader type should
 	 * not be attached to the program.
+	 * #include directives are resolved when the program is built,
+	 * see IIncludeGraph.
 	 * @param shaderType The shader type to replace.
 	 * @param source The source code.
+	 * @param fileName The file of the source, includes are searched
+	 *			relative to it. Empty if the source was not saved.
 	 */
-	virtual void setShaderSource( int shaderType, const QString & source ) = 0;
+	virtual void setShaderSource( int shaderType, const QString & source,
+								  const QString & fileName = QString() ) = 0;
 
 
 	/** Sets the geometry shaders input primitive type.
@@ -126,6 +284,63 @@ public:
 	virtual void setGeometryOutputType( int type ) = 0;
     virtual void setGeometryOutputNum( int type ) = 0;
 
+	/** Returns the maximum number of vertices emitted by a geometry shader invocation,
+	 * as set by setGeometryOutputNum().
+	 */
+	virtual int getGeometryOutputNum( void ) = 0;
+
+	/** Returns the largest value accepted by setGeometryOutputNum().
+	 * Returns 0 if geometry shaders are not available.
+	 */
+	virtual int getMaxGeometryOutputNum( void ) = 0;
+
+	/** Binds a copy of the program, linked with a different maximum number of
+	 * geometry shader output vertices, and starts counting the primitives it emits.
+	 * Rasterization is disabled until endGeometryProbe() is called. Comparing the
+	 * counts for different values shows which values truncate the output.
+	 * Requires transform feedback, see isCaptureAvailable().
+	 * @param attribs Receives the attribute locations, see bindState().
+	 * @param numOutputVertices The maximum number of output vertices to try.
+	 * @param error Receives the reason, if the call fails.
+	 * @return True if the copy is in use.
+	 */
+	virtual bool beginGeometryProbe( VertexAttribLocations & attribs, int numOutputVertices, QString & error ) = 0;
+
+	/** Stops counting and restores the rasterizer state.
+	 * @return The number of primitives emitted since beginGeometryProbe().
+	 */
+	virtual int endGeometryProbe( void ) = 0;
+
+
+	/** Sets the varyings recorded by beginCapture().
+	 * Built-in varyings like gl_Position can be listed, too.
+	 * The names are used by the next beginCapture() call.
+	 */
+	virtual void setCaptureVaryings( const QStringList & varyings ) = 0;
+
+	/** Returns true if the program output can be captured with transform feedback. */
+	virtual bool isCaptureAvailable( void ) = 0;
+
+	/** Binds the program like bindState() and starts recording its output.
+	 * The shaders are linked into a second program that records the capture
+	 * varyings, so invalid names never break the regular program. The uniform
+	 * values and the attribute locations of the regular program are used.
+	 * Every successful call must be followed by endCapture() after drawing.
+	 * @param attribs Receives the attribute locations, see bindState().
+	 * @param drawPrimitiveType Primitive type of the following draw calls.
+	 * @param maxBytes Size of the capture buffer, primitives that don't
+	 *			fit into it are counted, but not recorded.
+	 * @param error Receives the reason, if the call fails.
+	 * @return True if the capture program is in use.
+	 */
+	virtual bool beginCapture( VertexAttribLocations & attribs, int drawPrimitiveType,
+							   int maxBytes, QString & error ) = 0;
+
+	/** Stops recording and reads back the captured vertices.
+	 * @param result Receives the vertices and the primitive counts.
+	 */
+	virtual void endCapture( FeedbackCapture & result ) = 0;
+
 
 	/** Check wether a given shader type is avilable for this program.
 	 * Returns false for invalid input.
@@ -141,6 +356,28 @@ public:
 	 */
 	static QString getShaderTypeName( int type );
 
+	/** Roles of the uniforms the shader editor sets itself.
+	 * The names are case insensitive, the shadertoy names are accepted as well.
+	 */
+	enum builtinUniform_e
+	{
+		BUILTIN_NONE = -1,
+		BUILTIN_TIME,				///< float time, iTime: seconds since the program was linked
+		BUILTIN_DELTA_TIME,			///< float deltaTime, iTimeDelta: seconds since the previous frame
+		BUILTIN_FRAME,				///< int or float frame, iFrame: FrameInputs::frame
+		BUILTIN_RESOLUTION,			///< vec2 or vec3 resolution, iResolution: FrameInputs::resolution
+		BUILTIN_MOUSE,				///< vec2 or vec4 mouse, iMouse: FrameInputs::mouse
+		BUILTIN_VIEW_MATRIX,		///< mat4 viewMatrix: FrameInputs::viewMatrix
+		BUILTIN_PROJECTION_MATRIX,	///< mat4 projectionMatrix: FrameInputs::projectionMatrix
+		BUILTIN_BOUNDS_MIN,			///< vec3 boundsMin: FrameInputs::boundsMin
+		BUILTIN_BOUNDS_MAX,			///< vec3 boundsMax: FrameInputs::boundsMax
+	};
+
+	/** Returns the builtinUniform_e role of a uniform.
+	 * @return BUILTIN_NONE if the uniform is set by the user.
+	 */
+	static int getBuiltinUniformRole( const QString & name, int type );
+
 	/** OpenGL independend shader types.
 	 * They can be used as indices into arrays in a for loop.
 	 */
@@ -155,6 +392,48 @@ public:
 };
 
 
+//=============================================================================
+//	IShaderBuild - compiles a snapshot of the shader state
+//=============================================================================
+
+/** The sources and link parameters of an IShader, compiled and linked
+ * independent of the IShader object. See IShader::createBuild().
+ * \n\n
+ * A build uses the program binary cache of its IShader, so all builds
+ * must be deleted before IShader::shutdown() is called.
+ */
+class IShaderBuild
+{
+public:
+	/** The kinds of builds, see getKind(). */
+	enum buildKind_e
+	{
+		BUILD_PROGRAM,	///< made by IShader::createBuild(), see IShader::finishBuild()
+		BUILD_VARIANTS,	///< made by IShader::createVariantBuild(), see IShader::finishVariantBuild()
+	};
+
+	/** Destructor. Deletes the program and shader objects, unless they
+	 * were taken by IShader::finishBuild(). A context sharing objects
+	 * with the render context must be current then.
+	 */
+	virtual ~IShaderBuild( void ) {}
+
+	/** Returns the kind of the build, a buildKind_e value. */
+	virtual int getKind( void ) = 0;
+
+	/** Compiles the shaders and links the program.
+	 * It can be called on any thread, as long as a context sharing
+	 * objects with the render context is current.
+	 */
+	virtual void run( void ) = 0;
+
+	/** Makes a running run() call return before the next compile or link.
+	 * It can be called from any thread. The result of a canceled build
+	 * is incomplete, it must be deleted.
+	 */
+	virtual void cancel( void ) = 0;
+};
+
 
 #endif	// __SHADER_H_ICNLDUDED__
 
@@ -0,0 +1,641 @@
+//=============================================================================
+/** @file		tangentspace.cpp
+ *
+ * Implements the tangent space generator.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#include <math.h>
+#include <float.h>
+#include <QtCore/QHash>
+
+#include "application.h"
+#include "tangentspace.h"
+#include "parallel.h"
+
+// SSE is part of every x86-64 target, 32 bit targets must enable it.
+#if defined( CONFIG_ENABLE_SSE ) && \
+	( defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 ) )
+#define TANGENT_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+
+//=============================================================================
+//	helpers
+//=============================================================================
+
+/*
+========================
+projectNormalize
+
+ removes the normal component and normalizes the rest.
+========================
+*/
+static inline vec3_t projectNormalize( const vec3_t & v, const vec3_t & normal )
+{
+	return ( v - normal * normal.dotProduct( v ) ).normalize();
+}
+
+
+/*
+========================
+perpendicular
+
+ returns an arbitrary unit vector perpendicular to the normal.
+========================
+*/
+static vec3_t perpendicular( const vec3_t & normal )
+{
+	vec3_t a = normal.absolute();
+	vec3_t axis( 1,0,0 );
+
+	if( a.y <= a.x && a.y <= a.z ) {
+		axis = vec3_t( 0,1,0 );
+	} else if( a.z <= a.x && a.z <= a.y ) {
+		axis = vec3_t( 0,0,1 );
+	}
+
+	return projectNormalize( axis, normal );
+}
+
+
+/*
+========================
+triangleTangent
+
+ the unnormalized tangent of a triangle, pointing into the direction of increasing u.
+ returns the orientation, +1 for regular, -1 for mirrored, 0 if the triangle has no texture area.
+========================
+*/
+static inline int triangleTangent( const vec3_t & p0, const vec3_t & p1, const vec3_t & p2,
+								   const vec2_t & t0, const vec2_t & t1, const vec2_t & t2,
+								   vec3_t & tangent )
+{
+	vec3_t d1 = p1 - p0;
+	vec3_t d2 = p2 - p0;
+	vec2_t s1 = t1 - t0;
+	vec2_t s2 = t2 - t0;
+
+	float area = s1.x * s2.y - s2.x * s1.y;
+	if( fabs( area ) <= FLT_MIN )
+		return 0;
+
+	// only the direction matters, so don't divide by the area.
+	tangent = d1 * s2.y - d2 * s1.y;
+	if( area < 0.0f )
+	{
+		tangent = tangent * -1.0f;
+		return -1;
+	}
+
+	return 1;
+}
+
+
+/*
+========================
+cornerOfVertex
+
+ the corner of a triangle that uses the vertex, -1 if none does.
+========================
+*/
+static inline int cornerOfVertex( const unsigned int* triangle, unsigned int vertex )
+{
+	for( int k = 0 ; k < 3 ; k++ ) {
+		if( triangle[ k ] == vertex )
+			return k;
+	}
+
+	return -1;
+}
+
+
+#ifdef TANGENT_USE_SSE
+
+//=============================================================================
+//	SSE helpers, one vector per lane
+//=============================================================================
+
+/** Four 3D vectors, stored by component. */
+struct vec3x4_t
+{
+	__m128 x, y, z;
+};
+
+static inline vec3x4_t gather( const vec3_t* v, const int* index )
+{
+	vec3x4_t r;
+	r.x = _mm_setr_ps( v[ index[0] ].x, v[ index[1] ].x, v[ index[2] ].x, v[ index[3] ].x );
+	r.y = _mm_setr_ps( v[ index[0] ].y, v[ index[1] ].y, v[ index[2] ].y, v[ index[3] ].y );
+	r.z = _mm_setr_ps( v[ index[0] ].z, v[ index[1] ].z, v[ index[2] ].z, v[ index[3] ].z );
+	return r;
+}
+
+static inline vec3x4_t sub4( const vec3x4_t & a, const vec3x4_t & b )
+{
+	vec3x4_t r;
+	r.x = _mm_sub_ps( a.x, b.x );
+	r.y = _mm_sub_ps( a.y, b.y );
+	r.z = _mm_sub_ps( a.z, b.z );
+	return r;
+}
+
+static inline vec3x4_t scale4( const vec3x4_t & a, __m128 s )
+{
+	vec3x4_t r;
+	r.x = _mm_mul_ps( a.x, s );
+	r.y = _mm_mul_ps( a.y, s );
+	r.z = _mm_mul_ps( a.z, s );
+	return r;
+}
+
+static inline __m128 dot4( const vec3x4_t & a, const vec3x4_t & b )
+{
+	return _mm_add_ps( _mm_add_ps( _mm_mul_ps( a.x, b.x ), _mm_mul_ps( a.y, b.y ) ), _mm_mul_ps( a.z, b.z ) );
+}
+
+// see projectNormalize(), null vectors stay null.
+static inline vec3x4_t projectNormalize4( const vec3x4_t & v, const vec3x4_t & normal )
+{
+	vec3x4_t p = sub4( v, scale4( normal, dot4( normal, v ) ) );
+
+	__m128 lengthSq = dot4( p, p );
+	__m128 valid = _mm_cmpgt_ps( lengthSq, _mm_setzero_ps() );
+	__m128 scale = _mm_and_ps( valid, _mm_div_ps( _mm_set1_ps( 1.0f ), _mm_sqrt_ps( lengthSq ) ) );
+
+	return scale4( p, scale );
+}
+
+#endif // TANGENT_USE_SSE
+
+
+//=============================================================================
+//	CTriangleTangentJob
+//=============================================================================
+
+/** Computes the weighted tangent of every triangle corner.
+ * The corners of a triangle are stored consecutively, so different
+ * triangle ranges never write to the same memory.
+ */
+class CTriangleTangentJob : public IParallelJob
+{
+public:
+	const vec3_t*		positions;
+	const vec3_t*		normals;
+	const vec2_t*		texCoords;
+	const unsigned int*	indices;
+
+	vec3_t*				cornerTangents;		// [ 3 * numTriangles ], weighted
+	float*				cornerWeights;		// [ 3 * numTriangles ]
+	signed char*		orientations;		// [ numTriangles ]
+
+	void run( int first, int last )
+	{
+		int i = first;
+
+#ifdef TANGENT_USE_SSE
+		for( ; i + 4 <= last ; i += 4 ) {
+			runSSE( i );
+		}
+#endif
+
+		for( ; i < last ; i++ ) {
+			runTriangle( i );
+		}
+	}
+
+private:
+
+	inline int vertex( int triangle, int k ) const
+	{
+		return ( indices != NULL ) ? (int)indices[ 3*triangle + k ] : 3*triangle + k;
+	}
+
+	void runTriangle( int i );
+#ifdef TANGENT_USE_SSE
+	void runSSE( int first );
+#endif
+};
+
+
+/*
+========================
+CTriangleTangentJob::runTriangle
+========================
+*/
+void CTriangleTangentJob::runTriangle( int i )
+{
+	int v[ 3 ];
+	for( int k = 0 ; k < 3 ; k++ ) {
+		v[ k ] = vertex( i, k );
+	}
+
+	vec3_t tangent;
+	orientations[ i ] = (signed char)triangleTangent(
+		positions[ v[0] ], positions[ v[1] ], positions[ v[2] ],
+		texCoords[ v[0] ], texCoords[ v[1] ], texCoords[ v[2] ], tangent );
+
+	for( int k = 0 ; k < 3 ; k++ )
+	{
+		int c = 3*i + k;
+		cornerTangents[ c ] = vec3_t( 0,0,0 );
+		cornerWeights [ c ] = 0.0f;
+
+		if( orientations[ i ] == 0 )
+			continue;
+
+		const vec3_t & normal = normals[ v[ k ] ];
+		const vec3_t & p = positions[ v[ k ] ];
+
+		// weight by the angle between the edges, in the tangent plane.
+		vec3_t e1 = projectNormalize( positions[ v[ (k+1) % 3 ] ] - p, normal );
+		vec3_t e2 = projectNormalize( positions[ v[ (k+2) % 3 ] ] - p, normal );
+		float angle = acosf( qBound( -1.0f, e1.dotProduct( e2 ), 1.0f ) );
+
+		cornerTangents[ c ] = projectNormalize( tangent, normal ) * angle;
+		cornerWeights [ c ] = angle;
+	}
+}
+
+
+#ifdef TANGENT_USE_SSE
+/*
+========================
+CTriangleTangentJob::runSSE
+
+ the same as runTriangle() for four triangles, one per lane.
+ only acosf() runs per lane.
+========================
+*/
+void CTriangleTangentJob::runSSE( int first )
+{
+	int v[ 3 ][ 4 ]; // corner k of triangle first + lane
+	for( int k = 0 ; k < 3 ; k++ ) {
+		for( int l = 0 ; l < 4 ; l++ ) {
+			v[ k ][ l ] = vertex( first + l, k );
+		}
+	}
+
+	vec3x4_t p[ 3 ];
+	__m128 s[ 3 ], t[ 3 ];
+	for( int k = 0 ; k < 3 ; k++ )
+	{
+		p[ k ] = gather( positions, v[ k ] );
+		s[ k ] = _mm_setr_ps( texCoords[ v[k][0] ].x, texCoords[ v[k][1] ].x, texCoords[ v[k][2] ].x, texCoords[ v[k][3] ].x );
+		t[ k ] = _mm_setr_ps( texCoords[ v[k][0] ].y, texCoords[ v[k][1] ].y, texCoords[ v[k][2] ].y, texCoords[ v[k][3] ].y );
+	}
+
+	// see triangleTangent()
+	vec3x4_t d1 = sub4( p[ 1 ], p[ 0 ] );
+	vec3x4_t d2 = sub4( p[ 2 ], p[ 0 ] );
+	__m128 s1x = _mm_sub_ps( s[ 1 ], s[ 0 ] );
+	__m128 s1y = _mm_sub_ps( t[ 1 ], t[ 0 ] );
+	__m128 s2x = _mm_sub_ps( s[ 2 ], s[ 0 ] );
+	__m128 s2y = _mm_sub_ps( t[ 2 ], t[ 0 ] );
+
+	float area[ 4 ];
+	_mm_storeu_ps( area, _mm_sub_ps( _mm_mul_ps( s1x, s2y ), _mm_mul_ps( s2x, s1y ) ) );
+
+	float sign[ 4 ];
+	for( int l = 0 ; l < 4 ; l++ )
+	{
+		int orientation = 0;
+		if( fabs( area[ l ] ) > FLT_MIN ) {
+			orientation = ( area[ l ] < 0.0f ) ? -1 : 1;
+		}
+		orientations[ first + l ] = (signed char)orientation;
+		sign[ l ] = (float)orientation;
+	}
+
+	vec3x4_t tangent = scale4( sub4( scale4( d1, s2y ), scale4( d2, s1y ) ), _mm_loadu_ps( sign ) );
+
+	for( int k = 0 ; k < 3 ; k++ )
+	{
+		vec3x4_t normal = gather( normals, v[ k ] );
+
+		// weight by the angle between the edges, in the tangent plane.
+		vec3x4_t e1 = projectNormalize4( sub4( p[ (k+1) % 3 ], p[ k ] ), normal );
+		vec3x4_t e2 = projectNormalize4( sub4( p[ (k+2) % 3 ], p[ k ] ), normal );
+		__m128 cosine = _mm_max_ps( _mm_set1_ps( -1.0f ), _mm_min_ps( dot4( e1, e2 ), _mm_set1_ps( 1.0f ) ) );
+
+		float angle[ 4 ];
+		_mm_storeu_ps( angle, cosine );
+		for( int l = 0 ; l < 4 ; l++ ) {
+			angle[ l ] = ( sign[ l ] != 0.0f ) ? acosf( angle[ l ] ) : 0.0f;
+		}
+
+		vec3x4_t weighted = scale4( projectNormalize4( tangent, normal ), _mm_loadu_ps( angle ) );
+
+		float x[ 4 ], y[ 4 ], z[ 4 ];
+		_mm_storeu_ps( x, weighted.x );
+		_mm_storeu_ps( y, weighted.y );
+		_mm_storeu_ps( z, weighted.z );
+
+		for( int l = 0 ; l < 4 ; l++ )
+		{
+			int c = 3 * ( first + l ) + k;
+			cornerTangents[ c ] = vec3_t( x[ l ], y[ l ], z[ l ] );
+			cornerWeights [ c ] = angle[ l ];
+		}
+	}
+}
+#endif // TANGENT_USE_SSE
+
+
+//=============================================================================
+//	CVertexTangentJob
+//=============================================================================
+
+/** Sums the corner tangents of every vertex and builds the tangent space.
+ * The corners of a vertex are found through a compressed adjacency list.
+ */
+class CVertexTangentJob : public IParallelJob
+{
+public:
+	const vec3_t*		normals;
+	const int*			firstCorner;		// [ numVertices + 1 ]
+	const int*			corners;			// [ 3 * numTriangles ]
+	const vec3_t*		cornerTangents;
+	const float*		cornerWeights;
+	const signed char*	orientations;
+
+	vec3_t*				tangents;
+	vec3_t*				bitangents;
+
+	void run( int first, int last )
+	{
+		for( int i = first ; i < last ; i++ )
+		{
+			// regular and mirrored triangles are accumulated separately
+			vec3_t sum[ 2 ];
+			float weight[ 2 ] = { 0.0f, 0.0f };
+
+			for( int k = firstCorner[ i ] ; k < firstCorner[ i+1 ] ; k++ )
+			{
+				int c = corners[ k ];
+				int side = ( orientations[ c / 3 ] < 0 ) ? 1 : 0;
+
+				sum   [ side ] = sum[ side ] + cornerTangents[ c ];
+				weight[ side ] += cornerWeights[ c ];
+			}
+
+			int side = ( weight[ 1 ] > weight[ 0 ] ) ? 1 : 0;
+			const vec3_t & normal = normals[ i ];
+
+			vec3_t tangent = projectNormalize( sum[ side ], normal );
+			if( tangent.lengthSq() < 0.5f ) { // no valid triangle
+				tangent = perpendicular( normal );
+			}
+
+			tangents  [ i ] = tangent;
+			bitangents[ i ] = normal.crossProduct( tangent ) * ( side == 0 ? 1.0f : -1.0f );
+		}
+	}
+};
+
+
+//=============================================================================
+//	tangent space generation
+//=============================================================================
+
+/*
+========================
+computeTangentSpace
+========================
+*/
+void computeTangentSpace( int numVertices, const vec3_t* positions,
+						  const vec3_t* normals, const vec2_t* texCoords,
+						  int numTriangles, const unsigned int* indices,
+						  vec3_t* tangents, vec3_t* bitangents )
+{
+	int i;
+	int numCorners = 3 * numTriangles;
+
+	if( numVertices <= 0 )
+		return;
+
+	//
+	// pass 1: triangles
+	//
+	vec3_t*			cornerTangents	= new vec3_t[ numCorners ];
+	float*			cornerWeights	= new float[ numCorners ];
+	signed char*	orientations	= new signed char[ numTriangles ];
+
+	CTriangleTangentJob triangleJob;
+	triangleJob.positions		= positions;
+	triangleJob.normals			= normals;
+	triangleJob.texCoords		= texCoords;
+	triangleJob.indices			= indices;
+	triangleJob.cornerTangents	= cornerTangents;
+	triangleJob.cornerWeights	= cornerWeights;
+	triangleJob.orientations	= orientations;
+	parallelFor( numTriangles, &triangleJob, 1024 );
+
+	//
+	// corners of each vertex, as a compressed list
+	//
+	int* firstCorner = new int[ numVertices + 1 ];
+	int* corners	 = new int[ numCorners ];
+	memset( firstCorner, 0, sizeof(int) * ( numVertices + 1 ) );
+
+	for( i = 0 ; i < numCorners ; i++ ) {
+		firstCorner[ ( indices != NULL ? (int)indices[ i ] : i ) + 1 ]++;
+	}
+	for( i = 0 ; i < numVertices ; i++ ) {
+		firstCorner[ i+1 ] += firstCorner[ i ];
+	}
+
+	int* fill = new int[ numVertices ];
+	memcpy( fill, firstCorner, sizeof(int) * numVertices );
+	for( i = 0 ; i < numCorners ; i++ ) {
+		corners[ fill[ indices != NULL ? (int)indices[ i ] : i ]++ ] = i;
+	}
+	SAFE_DELETE_ARRAY( fill );
+
+	//
+	// pass 2: vertices
+	//
+	CVertexTangentJob vertexJob;
+	vertexJob.normals			= normals;
+	vertexJob.firstCorner		= firstCorner;
+	vertexJob.corners			= corners;
+	vertexJob.cornerTangents	= cornerTangents;
+	vertexJob.cornerWeights		= cornerWeights;
+	vertexJob.orientations		= orientations;
+	vertexJob.tangents			= tangents;
+	vertexJob.bitangents		= bitangents;
+	parallelFor( numVertices, &vertexJob, 1024 );
+
+	SAFE_DELETE_ARRAY( corners );
+	SAFE_DELETE_ARRAY( firstCorner );
+	SAFE_DELETE_ARRAY( orientations );
+	SAFE_DELETE_ARRAY( cornerWeights );
+	SAFE_DELETE_ARRAY( cornerTangents );
+}
+
+
+/*
+========================
+splitTangentGroups
+========================
+*/
+void splitTangentGroups( int numVertices, const vec3_t* positions,
+						 const vec2_t* texCoords, int numTriangles,
+						 unsigned int* indices, QVector< int > & copies )
+{
+	int i, k;
+	int numCorners = 3 * numTriangles;
+
+	copies.clear();
+	if( numVertices <= 0 || indices == NULL )
+		return;
+
+	// orientations of the triangles, 0 for triangles without texture area.
+	// like MikkTSpace, those join the first group that reaches them.
+	signed char* orientations = new signed char[ numTriangles ];
+	bool*		 degenerate	  = new bool[ numTriangles ]; // a vertex is repeated
+
+	for( i = 0 ; i < numTriangles ; i++ )
+	{
+		const unsigned int* v = indices + 3*i;
+
+		vec3_t tangent;
+		orientations[ i ] = (signed char)triangleTangent(
+			positions[ v[0] ], positions[ v[1] ], positions[ v[2] ],
+			texCoords[ v[0] ], texCoords[ v[1] ], texCoords[ v[2] ], tangent );
+		degenerate[ i ] = ( v[0] == v[1] || v[1] == v[2] || v[0] == v[2] );
+	}
+
+	// the neighbor across the edge from corner k to k+1, -1 if none.
+	// neighbors share the edge in the opposite direction.
+	int* neighbors = new int[ numCorners ];
+	QHash< quint64, int > edges; // first corner of each directed edge
+
+	for( i = 0 ; i < numCorners ; i++ )
+	{
+		neighbors[ i ] = -1;
+		if( degenerate[ i / 3 ] )
+			continue;
+
+		quint64 key = ( (quint64)indices[ i ] << 32 ) | indices[ i - i % 3 + ( i + 1 ) % 3 ];
+		if( !edges.contains( key ) ) {
+			edges.insert( key, i );
+		}
+	}
+
+	for( i = 0 ; i < numCorners ; i++ )
+	{
+		if( degenerate[ i / 3 ] || neighbors[ i ] >= 0 )
+			continue;
+
+		quint64 key = ( (quint64)indices[ i - i % 3 + ( i + 1 ) % 3 ] << 32 ) | indices[ i ];
+		QHash< quint64, int >::const_iterator it = edges.constFind( key );
+		if( it != edges.constEnd() && neighbors[ it.value() ] < 0 && it.value() / 3 != i / 3 )
+		{
+			neighbors[ i ] = it.value() / 3;
+			neighbors[ it.value() ] = i / 3;
+		}
+	}
+
+	// the corners of a vertex form groups: triangles of the same orientation,
+	// connected by the edges at the vertex. every group gets its own vertex.
+	int*	group		= new int[ numCorners ];
+	bool*	hasGroup	= new bool[ numVertices ];
+	QVector< int > groupVertex; // new index of each group
+	QVector< int > stack;
+
+	for( i = 0 ; i < numCorners ; i++ ) {
+		group[ i ] = -1;
+	}
+	memset( hasGroup, 0, sizeof(bool) * numVertices );
+
+	for( i = 0 ; i < numCorners ; i++ )
+	{
+		int triangle = i / 3;
+		if( group[ i ] >= 0 || degenerate[ triangle ] || orientations[ triangle ] == 0 )
+			continue;
+
+		unsigned int vertex = indices[ i ];
+		int side = orientations[ triangle ];
+		int g = groupVertex.size();
+
+		if( hasGroup[ vertex ] )
+		{
+			groupVertex.append( numVertices + copies.size() );
+			copies.append( (int)vertex );
+		}
+		else
+		{
+			groupVertex.append( (int)vertex );
+			hasGroup[ vertex ] = true;
+		}
+
+		stack.append( triangle );
+		while( !stack.isEmpty() )
+		{
+			int t = stack.last();
+			stack.resize( stack.size() - 1 );
+
+			k = cornerOfVertex( indices + 3*t, vertex );
+			int c = 3*t + k;
+			if( k < 0 || group[ c ] >= 0 )
+				continue;
+
+			if( orientations[ t ] == 0 && group[ 3*t ] < 0 && group[ 3*t+1 ] < 0 && group[ 3*t+2 ] < 0 ) {
+				orientations[ t ] = (signed char)side;
+			}
+			if( orientations[ t ] != side )
+				continue;
+
+			group[ c ] = g;
+			if( neighbors[ c ] >= 0 ) {
+				stack.append( neighbors[ c ] );
+			}
+			if( neighbors[ 3*t + ( k + 2 ) % 3 ] >= 0 ) {
+				stack.append( neighbors[ 3*t + ( k + 2 ) % 3 ] );
+			}
+		}
+	}
+
+	for( i = 0 ; i < numCorners ; i++ ) {
+		if( group[ i ] >= 0 ) {
+			indices[ i ] = (unsigned int)groupVertex[ group[ i ] ];
+		}
+	}
+
+	SAFE_DELETE_ARRAY( hasGroup );
+	SAFE_DELETE_ARRAY( group );
+	SAFE_DELETE_ARRAY( neighbors );
+	SAFE_DELETE_ARRAY( degenerate );
+	SAFE_DELETE_ARRAY( orientations );
+}
+
+
+/*
+========================
+computeTriangleTangentSpace
+========================
+*/
+bool computeTriangleTangentSpace( const vec3_t & p0, const vec3_t & p1, const vec3_t & p2,
+								  const vec2_t & t0, const vec2_t & t1, const vec2_t & t2,
+								  const vec3_t & normal, vec3_t & tangent, vec3_t & bitangent )
+{
+	vec3_t planeTangent;
+	int orientation = triangleTangent( p0, p1, p2, t0, t1, t2, planeTangent );
+	if( orientation == 0 )
+		return false;
+
+	tangent = projectNormalize( planeTangent, normal );
+	bitangent = normal.crossProduct( tangent ) * float( orientation );
+	return true;
+}
+
@@ -0,0 +1,110 @@
+//=============================================================================
+/** @file		tangentspace.h
+ *
+ * Defines the tangent space generator shared by all model types.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#ifndef __TANGENTSPACE_H_INCLUDED__
+#define __TANGENTSPACE_H_INCLUDED__
+
+#include <QtCore/QVector>
+
+#include "vector.h"
+
+
+/** Computes a tangent space for an indexed triangle mesh.
+ * The result follows the MikkTSpace conventions, which are used by most
+ * normal map bakers:
+ * - The tangent points into the direction of increasing u, the bitangent
+ *   into the direction of increasing v.
+ * - The triangle tangents are projected into the tangent plane of each
+ *   vertex normal and weighted by the triangle's angle at that vertex.
+ * - Triangles with mirrored texture mapping are accumulated separately,
+ *   the bitangent is sign * cross( normal, tangent ).
+ * - Triangles without texture area don't contribute.
+ *
+ * Call splitTangentGroups() first for indexed meshes, so every vertex gets
+ * the tangent space MikkTSpace gives its corners. A vertex that is still
+ * shared by mirrored and non-mirrored triangles gets the side with the
+ * larger angle sum.
+ * Vertices without a valid triangle get an arbitrary tangent space
+ * around their normal.
+ * \n\n
+ * Large meshes are processed by several threads, see parallelFor().
+ *
+ * @param numVertices Number of vertices.
+ * @param positions Vertex positions [ numVertices ].
+ * @param normals Normalized vertex normals [ numVertices ].
+ * @param texCoords Texture coordinates [ numVertices ].
+ * @param numTriangles Number of triangles.
+ * @param indices Three vertex indices per triangle [ 3 * numTriangles ].
+ *        If this is NULL, the vertices form a triangle list.
+ * @param tangents Receives the normalized tangents [ numVertices ].
+ * @param bitangents Receives the normalized bitangents [ numVertices ].
+ */
+void computeTangentSpace( int numVertices, const vec3_t* positions,
+						  const vec3_t* normals, const vec2_t* texCoords,
+						  int numTriangles, const unsigned int* indices,
+						  vec3_t* tangents, vec3_t* bitangents );
+
+/** Splits the vertices whose corners MikkTSpace gives different tangent spaces.
+ * Like MikkTSpace, the triangles around a vertex form groups: a group
+ * grows across the edges at the vertex, shared in opposite directions,
+ * and only contains triangles of one orientation. Triangles without
+ * texture area join the first group that reaches them.
+ * Every group after the first one of a vertex gets a copy of the vertex.
+ * The indices of its triangles are changed, the caller appends the copies
+ * to its vertex arrays. Unlike MikkTSpace, vertices are identified by
+ * their index only, not by equal data.
+ *
+ * @param numVertices Number of vertices.
+ * @param positions Vertex positions [ numVertices ].
+ * @param texCoords Texture coordinates [ numVertices ].
+ * @param numTriangles Number of triangles.
+ * @param indices Three vertex indices per triangle [ 3 * numTriangles ].
+ * @param copies Receives the original vertex of each copy, the copy k
+ *        has the index numVertices + k. Empty if nothing was split.
+ */
+void splitTangentGroups( int numVertices, const vec3_t* positions,
+						 const vec2_t* texCoords, int numTriangles,
+						 unsigned int* indices, QVector< int > & copies );
+
+/** Appends the copies made by splitTangentGroups() to a vertex array.
+ * The array is re-allocated with new[].
+ */
+template< class T >
+void appendSplitVertices( T* & data, int numVertices, const QVector< int > & copies )
+{
+	T* grown = new T[ numVertices + copies.size() ];
+	for( int i = 0 ; i < numVertices ; i++ ) {
+		grown[ i ] = data[ i ];
+	}
+	for( int i = 0 ; i < copies.size() ; i++ ) {
+		grown[ numVertices + i ] = data[ copies[ i ] ];
+	}
+
+	delete [] data;
+	data = grown;
+}
+
+/** Computes the tangent space of a single triangle at a vertex with the given normal.
+ * This matches computeTangentSpace() for planar meshes, where all vertices
+ * share the same tangent space.
+ * @return False if the triangle has no texture area, the output is not modified then.
+ */
+bool computeTriangleTangentSpace( const vec3_t & p0, const vec3_t & p1, const vec3_t & p2,
+								  const vec2_t & t0, const vec2_t & t1, const vec2_t & t2,
+								  const vec3_t & normal, vec3_t & tangent, vec3_t & bitangent );
+
+
+#endif	// __TANGENTSPACE_H_INCLUDED__
+
@@ -13,9 +13,11 @@
 
 =============================================================================*/
 
+#include <QtCore/QVector>
 #include "application.h"
 #include "uniform.h"
 #include <assert.h>
+#include <string.h>
 
 
 //=============================================================================
@@ -31,8 +33,8 @@
  *	      defined in the OpenGL 2.0 specification.
  * @param location Location of the uniform variable.
  * */
-CUniform::CUniform( const QString & name, int type, int location )
- : m_name( name ), m_type( type ), m_location( location )
+CUniform::CUniform( const QString & name, int type, int location, int block )
+ : m_name( name ), m_type( type ), m_location( location ), m_block( block )
 {
 	memset( &m_data, 0, sizeof(m_data) );
 	
@@ -65,8 +67,8 @@ CUniform::CUniform( const QString & name, int type, int location )
  * @param u Source uniform variable.
  * @param location New location of the uniform variable.
  */
-CUniform::CUniform( const CUniform & u, int location )
-: m_name( u.getName() ), m_type( u.getType() ), m_location( location )
+CUniform::CUniform( const CUniform & u, int location, int block )
+: m_name( u.getName() ), m_type( u.getType() ), m_location( location ), m_block( block )
 {
 	memcpy( &m_data, &u.m_data, sizeof(m_data) );
 }
@@ -181,39 +183,148 @@ double CUniform::getValueAsFloat( int component ) const
  */
 //======================
 void CUniform::applyToGL( void )
+{
+	uploadToGL( m_type, m_location, 1, &m_data );
+}
+
+
+//======================
+/** Passes the elements of an array to OpenGL with a single glUniform* command.
+ * The elements must have the same type and follow each other in the array,
+ * starting with element zero. If its location is -1, this call has no effect.
+ * @param elements The array elements.
+ * @param count Number of elements.
+ */
+//======================
+void CUniform::applyArrayToGL( const CUniform* elements, int count )
+{
+	if( count < 1 || elements[ 0 ].m_location == -1 )
+		return;
+
+	// pack the used components of each element, both base types are 32 bits
+	int n = elements[ 0 ].getComponentCount() * elements[ 0 ].getColumnCount();
+	QVector< GLfloat > buffer( n * count );
+	for( int i = 0 ; i < count ; i++ ) {
+		memcpy( buffer.data() + n * i, &elements[ i ].m_data, n * sizeof(GLfloat) );
+	}
+
+	uploadToGL( elements[ 0 ].m_type, elements[ 0 ].m_location, count, buffer.constData() );
+}
+
+
+//======================
+/** Calls the glUniform* command for a type.
+ * If the location is -1, this call has no effect.
+ * @param type The GL_xxx type identifier.
+ * @param location Location of the uniform or of the first array element.
+ * @param count Number of array elements.
+ * @param data Packed data of all elements.
+ */
+//======================
+void CUniform::uploadToGL( int type, int location, int count, const void* data )
 {
 	// can't be set
-	if( m_location == -1 )
+	if( location == -1 )
 		return;
 
-	switch( m_type )
+	const GLfloat* f = static_cast< const GLfloat* >( data );
+	const GLint* i = static_cast< const GLint* >( data );
+
+	switch( type )
+	{
+	case GL_FLOAT:		glUniform1fv( location, count, f ); break;
+	case GL_FLOAT_VEC2:	glUniform2fv( location, count, f ); break;
+	case GL_FLOAT_VEC3:	glUniform3fv( location, count, f ); break;
+	case GL_FLOAT_VEC4:	glUniform4fv( location, count, f ); break;
+
+	case GL_FLOAT_MAT2:	glUniformMatrix2fv( location, count, false, f ); break;
+	case GL_FLOAT_MAT3:	glUniformMatrix3fv( location, count, false, f ); break;
+	case GL_FLOAT_MAT4:	glUniformMatrix4fv( location, count, false, f ); break;
+
+	case GL_INT:		glUniform1iv( location, count, i ); break;
+	case GL_INT_VEC2:	glUniform2iv( location, count, i ); break;
+	case GL_INT_VEC3:	glUniform3iv( location, count, i ); break;
+	case GL_INT_VEC4:	glUniform4iv( location, count, i ); break;
+
+	case GL_BOOL:		glUniform1iv( location, count, i ); break;
+	case GL_BOOL_VEC2:	glUniform2iv( location, count, i ); break;
+	case GL_BOOL_VEC3:	glUniform3iv( location, count, i ); break;
+	case GL_BOOL_VEC4:	glUniform4iv( location, count, i ); break;
+
+	case GL_SAMPLER_1D:			glUniform1iv( location, count, i ); break;
+	case GL_SAMPLER_2D:			glUniform1iv( location, count, i ); break;
+	case GL_SAMPLER_3D:			glUniform1iv( location, count, i ); break;
+	case GL_SAMPLER_CUBE:		glUniform1iv( location, count, i ); break;
+	case GL_SAMPLER_1D_SHADOW:	glUniform1iv( location, count, i ); break;
+	case GL_SAMPLER_2D_SHADOW:	glUniform1iv( location, count, i ); break;
+	}
+}
+
+
+//======================
+/** Writes the data into the storage of a uniform block.
+ * The layout is the one the driver reports for the member, so it
+ * works for std140 and for the other layouts.
+ * @param data Points to the member in the block storage.
+ * @param matrixStride Bytes between matrix columns, or rows if rowMajor is set.
+ * @param rowMajor Wether the member is declared row_major.
+ */
+//======================
+void CUniform::copyToBlock( GLubyte* data, int matrixStride, bool rowMajor ) const
+{
+	int components = getComponentCount();
+
+	if( !isMatrix() )
 	{
-	case GL_FLOAT:		glUniform1fv( m_location, 1, m_data._float ); break;
-	case GL_FLOAT_VEC2:	glUniform2fv( m_location, 1, m_data._float ); break;
-	case GL_FLOAT_VEC3:	glUniform3fv( m_location, 1, m_data._float ); break;
-	case GL_FLOAT_VEC4:	glUniform4fv( m_location, 1, m_data._float ); break;
-
-	case GL_FLOAT_MAT2:	glUniformMatrix2fv( m_location, 1, false, m_data._float ); break;
-	case GL_FLOAT_MAT3:	glUniformMatrix3fv( m_location, 1, false, m_data._float ); break;
-	case GL_FLOAT_MAT4:	glUniformMatrix4fv( m_location, 1, false, m_data._float ); break;
-
-	case GL_INT:		glUniform1iv( m_location, 1, m_data._int ); break;
-	case GL_INT_VEC2:	glUniform2iv( m_location, 1, m_data._int ); break;
-	case GL_INT_VEC3:	glUniform3iv( m_location, 1, m_data._int ); break;
-	case GL_INT_VEC4:	glUniform4iv( m_location, 1, m_data._int ); break;
-
-	case GL_BOOL:		glUniform1iv( m_location, 1, m_data._int ); break;
-	case GL_BOOL_VEC2:	glUniform2iv( m_location, 1, m_data._int ); break;
-	case GL_BOOL_VEC3:	glUniform3iv( m_location, 1, m_data._int ); break;
-	case GL_BOOL_VEC4:	glUniform4iv( m_location, 1, m_data._int ); break;
-
-	case GL_SAMPLER_1D:			glUniform1iv( m_location, 1, m_data._int ); break;
-	case GL_SAMPLER_2D:			glUniform1iv( m_location, 1, m_data._int ); break;
-	case GL_SAMPLER_3D:			glUniform1iv( m_location, 1, m_data._int ); break;
-	case GL_SAMPLER_CUBE:		glUniform1iv( m_location, 1, m_data._int ); break;
-	case GL_SAMPLER_1D_SHADOW:	glUniform1iv( m_location, 1, m_data._int ); break;
-	case GL_SAMPLER_2D_SHADOW:	glUniform1iv( m_location, 1, m_data._int ); break;
+		// bools are stored as 32 bit integers, like ints
+		memcpy( data, &m_data, components * sizeof(GLfloat) );
+		return;
+	}
+
+	for( int column = 0 ; column < getColumnCount() ; column++ )
+	{
+		for( int row = 0 ; row < components ; row++ )
+		{
+			int offset = rowMajor ?
+				row * matrixStride + column * sizeof(GLfloat) :
+				column * matrixStride + row * sizeof(GLfloat);
+			memcpy( data + offset, &m_data._float[ column * components + row ], sizeof(GLfloat) );
+		}
+	}
+}
+
+
+//======================
+/** Sets all elements of a GL_FLOAT_MAT4 uniform.
+ * If the uniform is not a GL_FLOAT_MAT4, the behavior is undefined.
+ * @param matrix 16 floats in column major order.
+ */
+//========================
+void CUniform::setMatrix4( const GLfloat* matrix )
+{
+	assert( m_type == GL_FLOAT_MAT4 );
+	memcpy( m_data._float, matrix, 16 * sizeof(GLfloat) );
+}
+
+
+//======================
+/** Compares the data of two uniforms.
+ * Only the components passed to OpenGL by applyToGL() are compared.
+ * @param u The uniform to compare with.
+ * @return True if both uniforms have the same type and the same value.
+ */
+//======================
+bool CUniform::isValueEqual( const CUniform & u ) const
+{
+	if( m_type != u.m_type )
+		return false;
+
+	int n = getComponentCount() * getColumnCount();
+	if( getBaseType() == BASE_TYPE_FLOAT ) {
+		return memcmp( m_data._float, u.m_data._float, n * sizeof(GLfloat) ) == 0;
 	}
+
+	return memcmp( m_data._int, u.m_data._int, n * sizeof(GLint) ) == 0;
 }
 
 
@@ -32,6 +32,8 @@
  * those meta informations ( example: getBaseType() ).
  *
  * This class supports bool, int and float variables with up to 4x4 elements.
+ * Arrays are stored as one CUniform per element, named like "name[i]".
+ * Members of uniform blocks have no location, they belong to a block instead.
  * The methods for accessing the data of these types are exclusive to its type.
  * For example, results are undefined if the uniform type is int and
  * the method setValueAsFloat is called. These types are also called base types,
@@ -48,8 +50,8 @@
 class CUniform
 {
 public:
-	CUniform( const QString & name=QString(), int type=0, int location=-1 );
-	CUniform( const CUniform & u, int location );
+	CUniform( const QString & name=QString(), int type=0, int location=-1, int block=-1 );
+	CUniform( const CUniform & u, int location, int block=-1 );
 	virtual ~CUniform( void );
 
 	/** Uniform base type.
@@ -77,6 +79,9 @@ public:
 	/** Returns the location of this uniform. */
 	int getLocation( void ) const { return m_location; }
 
+	/** Returns the index of the uniform block, -1 for the default block. */
+	int getBlock( void ) const { return m_block; }
+
 	// meta infos.
 	int getComponentCount( void ) const;
 	baseType_e getBaseType( void ) const;
@@ -95,15 +100,26 @@ public:
 	void   setValueAsBool ( int component, bool value );
 	void   setValueAsInt  ( int component, int value );
 	void   setValueAsFloat( int component, double value );
+	void   setMatrix4( const GLfloat* matrix ); // GL_FLOAT_MAT4 only, column major
+
+	// compares the data of two uniforms of the same type
+	bool isValueEqual( const CUniform & u ) const;
 
 	// passes its data directly to the GL
 	void applyToGL( void );
+	static void applyArrayToGL( const CUniform* elements, int count );
+
+	// writes its data into the storage of a uniform block
+	void copyToBlock( GLubyte* data, int matrixStride, bool rowMajor ) const;
 
 	// helpers
 	static QString getTypeNameString( int type );
 
 private:
 
+	// calls the glUniform* command of the type
+	static void uploadToGL( int type, int location, int count, const void* data );
+
 	/** The actual data container.
 	 * @internal
 	 *   - Must match for each basic type!
@@ -116,6 +132,7 @@ private:
 	QString		m_name;
 	int			m_type; // GL_xxx type identifier
 	int			m_location;
+	int			m_block; // index of the uniform block, -1 for the default block
 	dataUnit_t	m_data;
 };
 
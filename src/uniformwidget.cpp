@@ -22,6 +22,7 @@
 #include "universalslider.h"
 #include "vector.h"
 #include "uniform.h"
+#include "shader.h"
 
 
 //=============================================================================
@@ -66,6 +67,14 @@ If you want to edit matrix types, like GL_FLOAT_MAT3, you can only edit one matr
 You can change the matrix column with the 'Active Matrix Column' spin box on the bottom of the widget.
 Matrices are initialized to identity matrices and not to zero matrices.
 
+Arrays are edited element by element, the combo box lists them as lights[0], lights[1] and so on.
+Uniform blocks, like
+
+layout(std140) uniform Material { vec4 diffuse; float shininess; };
+
+need OpenGL 3.1. Their members are edited like the other uniforms,
+the shader editor stores them in a buffer object.
+
 Uniform variables are available at all shader types, but they must be defined in all shaders that use them.
 If you define a uniform with the equal name but different type, the results are undefined!
 
@@ -81,6 +90,19 @@ You can test this functionality with the following code:
 
 gl_FragColor = gl_Color * ( 0.5 + 0.5 * sin( time ) );
 
+The other special uniforms are set the same way, every frame:
+
+- float deltaTime: seconds since the previous frame.
+- int frame (or float): counts the rendered frames.
+- vec2 resolution (or vec3): viewport size in pixels, z is always 1.
+- vec4 mouse (or vec2): xy is the mouse position in pixels while a button is held,
+  zw is the position of the last click, negative while no button is held.
+  The origin is the lower left corner of the viewport.
+- mat4 viewMatrix, mat4 projectionMatrix: the camera matrices.
+- vec3 boundsMin, vec3 boundsMax: the bounding box of the test model.
+
+The shadertoy names iTime, iTimeDelta, iFrame, iResolution and iMouse work as well.
+
 
 Now go on to the last tutorial, @ref geometryshader.
 */
@@ -608,18 +630,13 @@ accpetsUniform
 */
 bool CUniformWidget::acceptsUniform( const CUniform & u )
 {
-	// not editable
-	if( u.getLocation() == -1 )
+	// not editable, block members are written to their buffer instead
+	if( u.getLocation() == -1 && u.getBlock() == -1 )
 		return false;
 
-	// Evil Hack:
-	//  time is constantly increasing, so it is not useful to
-	//  make it editable by hand...
-	if( u.getType() == GL_FLOAT &&
-		0 == QString("time").compare( u.getName(), Qt::CaseInsensitive )  )
-	{
+	// the built-in uniforms are overwritten every frame
+	if( IShader::getBuiltinUniformRole( u.getName(), u.getType() ) != IShader::BUILTIN_NONE )
 		return false;
-	}
 
 	// matrices are edited by editing their column vectors
 	if( u.isMatrix() && u.getBaseType() == CUniform::BASE_TYPE_FLOAT )
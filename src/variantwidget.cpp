@@ -0,0 +1,417 @@
+//=============================================================================
+/** @file		variantwidget.cpp
+ *
+ * Implements CVariantWidget.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#include <QtCore/QElapsedTimer>
+#include <QGridLayout>
+#include <QHeaderView>
+#include <QMessageBox>
+
+#include "application.h"
+#include "variantwidget.h"
+#include "scene.h"
+#include "shader.h"
+
+
+// comparison constants
+static const int	COMPARE_WARMUP_FRAMES	= 3;	// not measured, includes the switch to the variant
+static const int	COMPARE_MEASURED_FRAMES	= 20;	// per variant
+
+// table columns
+enum variantColumn_e
+{
+	COLUMN_NAME,
+	COLUMN_STATUS,
+	COLUMN_FRAME_TIME,
+	COLUMN_RELATIVE,
+
+	NUM_COLUMNS,
+};
+
+
+//=============================================================================
+//	CVariantWidget implementation
+//=============================================================================
+
+// construction
+CVariantWidget::CVariantWidget( IScene* scene )
+ : m_scene( scene )
+{
+	m_compareRow = -1;
+	m_compareFrame = 0;
+	m_compareTime = 0;
+	m_compareSelection = -1;
+	m_skipSelectVariant = 0;
+
+	// define sets
+	m_defineSets = new QTextEdit();
+	m_defineSets->setAcceptRichText( false );
+	m_defineSets->setLineWrapMode( QTextEdit::NoWrap );
+	m_defineSets->setToolTip( "One define set per line: NAME: value | value | ...\n"
+							  "Every permutation of the values is built, - leaves the macro undefined.\n"
+							  "Example:\n"
+							  "SHADOWS: - | 1\n"
+							  "NUM_LIGHTS: 1 | 2 | 4" );
+
+	m_btnApply = new QPushButton( QString( "Build Variants" ) );
+	m_btnApply->setToolTip( "Links a program for every permutation in the background.\n"
+							"They are built again after every link." );
+
+	m_btnCompare = new QPushButton( QString( "Compare" ) );
+	m_btnCompare->setToolTip( "Renders every variant for some frames and measures the frame time." );
+
+	// variant table
+	m_table = new QTableWidget( 0, NUM_COLUMNS );
+	m_table->setEditTriggers( QAbstractItemView::NoEditTriggers );
+	m_table->setSelectionBehavior( QAbstractItemView::SelectRows );
+	m_table->setSelectionMode( QAbstractItemView::SingleSelection );
+	m_table->verticalHeader()->hide();
+
+	QStringList headers;
+	headers.append( QString( "Variant" ) );
+	headers.append( QString( "Status" ) );
+	headers.append( QString( "ms/frame" ) );
+	headers.append( QString( "Relative" ) );
+	m_table->setHorizontalHeaderLabels( headers );
+
+	// layout
+	QGridLayout* layout = new QGridLayout();
+	layout->addWidget( m_defineSets,	0,0, 1,2 );
+	layout->addWidget( m_btnApply,		1,0, 1,1 );
+	layout->addWidget( m_btnCompare,	1,1, 1,1 );
+	layout->addWidget( m_table,			0,2, 2,1 );
+	layout->setColumnStretch( 2, 1 );
+	setLayout( layout );
+
+	// connections
+	connect( m_btnApply,   SIGNAL(clicked(bool)), this, SLOT(applyDefineSets(bool)) );
+	connect( m_btnCompare, SIGNAL(clicked(bool)), this, SLOT(compareVariants(bool)) );
+	connect( m_table, SIGNAL(currentCellChanged(int,int,int,int)), this, SLOT(selectVariant(int,int,int,int)) );
+
+	updateVariantList();
+}
+
+
+/*
+========================
+parseDefineSets
+
+ returns the permutations of the define sets.
+========================
+*/
+bool CVariantWidget::parseDefineSets( QVector< ShaderVariant > & variants, QString & error )
+{
+	QStringList lines = m_defineSets->toPlainText().split( '\n' );
+
+	// the permutations of the sets parsed so far, none for no sets
+	variants.clear();
+
+	for( int i = 0 ; i < lines.size() ; i++ )
+	{
+		QString line = lines[ i ].trimmed();
+		if( line.isEmpty() || line.startsWith( "//" ) )
+			continue;
+
+		int colon = line.indexOf( ':' );
+		QString name = line.left( colon ).trimmed();
+		QStringList values = line.mid( colon + 1 ).split( '|' );
+		if( colon < 0 || name.isEmpty() || name.contains( ' ' ) )
+		{
+			error = QString( "Line %1: expected NAME: value | value | ...\n" ).arg( i + 1 );
+			return false;
+		}
+
+		if( variants.isEmpty() ) {
+			variants.append( ShaderVariant() );
+		}
+
+		QVector< ShaderVariant > permutations;
+		for( int v = 0 ; v < variants.size() ; v++ )
+		{
+			for( int j = 0 ; j < values.size() ; j++ )
+			{
+				QString value = values[ j ].trimmed();
+				if( value.isEmpty() )
+				{
+					error = QString( "Line %1: empty value, use - to leave %2 undefined.\n" ).arg( i + 1 ).arg( name );
+					return false;
+				}
+
+				ShaderVariant variant = variants[ v ];
+				if( !variant.name.isEmpty() ) {
+					variant.name += QString( " " );
+				}
+
+				if( value == QString( "-" ) )
+				{
+					variant.name += QString( "!%1" ).arg( name );
+				}
+				else
+				{
+					variant.name += QString( "%1=%2" ).arg( name ).arg( value );
+					variant.defines += QString( "#define %1 %2\n" ).arg( name ).arg( value );
+				}
+
+				permutations.append( variant );
+			}
+		}
+
+		if( permutations.size() > CONFIG_MAX_SHADER_VARIANTS )
+		{
+			error = QString( "More than %1 permutations.\n" ).arg( CONFIG_MAX_SHADER_VARIANTS );
+			return false;
+		}
+
+		variants = permutations;
+	}
+
+	return true;
+}
+
+
+/*
+========================
+applyDefineSets
+========================
+*/
+void CVariantWidget::applyDefineSets( bool )
+{
+	QVector< ShaderVariant > variants;
+	QString error;
+	if( !parseDefineSets( variants, error ) )
+	{
+		QMessageBox::warning( this, QString( CONFIG_STRING_ERRORDLG_TITLE ), error,
+							  QMessageBox::Ok, QMessageBox::Ok );
+		return;
+	}
+
+	// the measurements belong to the old variants
+	endComparison();
+	m_msPerFrame.clear();
+
+	m_scene->getShader()->setVariants( variants );
+	updateVariantList();
+
+	emit buildVariants();
+}
+
+
+/*
+========================
+updateVariantList
+========================
+*/
+void CVariantWidget::updateVariantList( void )
+{
+	IShader* shader = m_scene->getShader();
+	int numRows = shader->getNumVariants() + 1;
+
+	m_skipSelectVariant++;
+
+	m_table->setRowCount( numRows );
+	m_msPerFrame.resize( numRows );
+
+	// the fastest measured row is the reference
+	double fastest = 0.0;
+	for( int row = 0 ; row < numRows ; row++ )
+	{
+		if( m_msPerFrame[ row ] > 0.0 && ( fastest == 0.0 || m_msPerFrame[ row ] < fastest ) ) {
+			fastest = m_msPerFrame[ row ];
+		}
+	}
+
+	for( int row = 0 ; row < numRows ; row++ )
+	{
+		QString name, status, log;
+		if( row == 0 )
+		{
+			name = QString( "(program)" );
+			status = QString( "-" );
+		}
+		else
+		{
+			name = shader->getVariantName( row - 1 );
+			log = shader->getVariantLog( row - 1 );
+			if( shader->isVariantLinked( row - 1 ) ) {
+				status = QString( "linked" );
+			} else if( log.isEmpty() ) {
+				status = QString( "not built" );
+			} else {
+				status = QString( "failed" );
+			}
+		}
+
+		QString frameTime, relative;
+		if( m_msPerFrame[ row ] > 0.0 )
+		{
+			frameTime = QString::number( m_msPerFrame[ row ], 'f', 3 );
+			relative = QString::number( m_msPerFrame[ row ] / fastest, 'f', 2 );
+		}
+
+		QTableWidgetItem* statusItem = new QTableWidgetItem( status );
+		statusItem->setToolTip( log );
+
+		m_table->setItem( row, COLUMN_NAME,			new QTableWidgetItem( name ) );
+		m_table->setItem( row, COLUMN_STATUS,		statusItem );
+		m_table->setItem( row, COLUMN_FRAME_TIME,	new QTableWidgetItem( frameTime ) );
+		m_table->setItem( row, COLUMN_RELATIVE,		new QTableWidgetItem( relative ) );
+	}
+
+	// a running comparison selects the variants itself
+	if( m_compareRow < 0 ) {
+		m_table->setCurrentCell( shader->getSelectedVariant() + 1, COLUMN_NAME );
+	}
+	m_table->resizeColumnsToContents();
+
+	m_skipSelectVariant--;
+}
+
+
+/*
+========================
+selectVariant
+========================
+*/
+void CVariantWidget::selectVariant( int row, int, int, int )
+{
+	if( m_skipSelectVariant > 0 || row < 0 )
+		return;
+
+	// the user picked a variant, the comparison would override it
+	endComparison();
+
+	m_scene->getShader()->selectVariant( row - 1 );
+}
+
+
+/*
+========================
+compareVariants
+
+ starts the comparison, or cancels it if it is running.
+========================
+*/
+void CVariantWidget::compareVariants( bool )
+{
+	if( m_compareRow >= 0 )
+	{
+		endComparison();
+		updateVariantList();
+		return;
+	}
+
+	m_msPerFrame.fill( 0.0 );
+	m_compareSelection = m_scene->getShader()->getSelectedVariant();
+	m_compareRow = nextComparisonRow( 0 );
+	m_compareFrame = 0;
+	m_compareTime = 0;
+
+	m_btnCompare->setText( QString( "Cancel Comparison" ) );
+	updateVariantList();
+}
+
+
+/*
+========================
+nextComparisonRow
+
+ the next row starting at row that can be measured, -1 if there is none.
+========================
+*/
+int CVariantWidget::nextComparisonRow( int row )
+{
+	IShader* shader = m_scene->getShader();
+
+	for( ; row < m_table->rowCount() ; row++ )
+	{
+		// the program itself, or a linked variant
+		if( row == 0 || shader->isVariantLinked( row - 1 ) )
+			return row;
+	}
+
+	return -1;
+}
+
+
+/*
+========================
+endComparison
+
+ stops the comparison and selects the variant that was used before.
+========================
+*/
+void CVariantWidget::endComparison( void )
+{
+	if( m_compareRow < 0 )
+		return;
+
+	m_compareRow = -1;
+	m_scene->getShader()->selectVariant( m_compareSelection );
+	m_btnCompare->setText( QString( "Compare" ) );
+}
+
+
+/*
+========================
+renderComparisonFrame
+========================
+*/
+bool CVariantWidget::renderComparisonFrame( void )
+{
+	if( m_compareRow < 0 )
+		return false;
+
+	// the variants were rebuilt in the meantime
+	if( m_compareRow >= m_table->rowCount() )
+	{
+		endComparison();
+		updateVariantList();
+		return false;
+	}
+
+	m_scene->getShader()->selectVariant( m_compareRow - 1 );
+
+	// wait for the previous frame, so only this one is measured.
+	glFinish();
+
+	QElapsedTimer timer;
+	timer.start();
+	m_scene->render();
+	glFinish();
+	qint64 frameTime = timer.nsecsElapsed();
+
+	if( ++m_compareFrame <= COMPARE_WARMUP_FRAMES )
+		return true;
+
+	m_compareTime += frameTime;
+	if( m_compareFrame < COMPARE_WARMUP_FRAMES + COMPARE_MEASURED_FRAMES )
+		return true;
+
+	// variant done
+	m_msPerFrame[ m_compareRow ] = (double)m_compareTime / ( 1000000.0 * COMPARE_MEASURED_FRAMES );
+	int nextRow = nextComparisonRow( m_compareRow + 1 );
+	m_compareFrame = 0;
+	m_compareTime = 0;
+
+	// the last one restores the selection, while m_compareRow is still valid
+	if( nextRow < 0 ) {
+		endComparison();
+	} else {
+		m_compareRow = nextRow;
+	}
+	updateVariantList();
+
+	return true;
+}
+
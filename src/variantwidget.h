@@ -0,0 +1,105 @@
+//=============================================================================
+/** @file		variantwidget.h
+ *
+ * Defines the shader variant widget.
+ *
+	@internal
+	created:	2026-10-18
+	last mod:	2026-10-18
+
+    Shader Maker - a cross-platform GLSL editor.
+    Copyright (C) 2007-2008 Markus Kramer
+    For details, see main.cpp or COPYING.
+
+=============================================================================*/
+
+#ifndef __VARIANTWIDGET_H_INCLUDED__
+#define __VARIANTWIDGET_H_INCLUDED__
+
+#include <QtCore/QVector>
+#include <QWidget>
+#include <QTextEdit>
+#include <QPushButton>
+#include <QTableWidget>
+
+// forward declarations
+class IScene;
+class ShaderVariant;
+
+
+//=============================================================================
+//	CVariantWidget
+//=============================================================================
+
+/** Widget for the variants of the program, see IShader::setVariants().
+ * The user declares named define sets, one per line:
+ * \n\n
+ * NAME: value | value | ...
+ * \n\n
+ * Every permutation of the values is a variant, the value - leaves the
+ * macro undefined. The programs of the variants are built in the background
+ * after every link. Selecting a variant in the table switches the program
+ * immediately, the comparison renders every variant for some frames and
+ * shows the frame times side by side.
+ */
+class CVariantWidget : public QWidget
+{
+	Q_OBJECT
+public:
+	/** Constructs a CVariantWidget.
+	 * @param scene The scene, it must live longer than the widget.
+	 */
+	CVariantWidget( IScene* scene );
+
+	/** Renders a frame of the running comparison instead of IScene::render().
+	 * A valid OpenGL context must be active.
+	 * @return False if no comparison is running.
+	 */
+	bool renderComparisonFrame( void );
+
+public slots:
+	/** Shows the state of the variants, e.g. after their programs were built. */
+	void updateVariantList( void );
+
+signals:
+	/** Emitted when the variants changed, their programs must be built. */
+	void buildVariants( void );
+
+private slots:
+	void applyDefineSets( bool );
+	void selectVariant( int row, int column, int previousRow, int previousColumn );
+	void compareVariants( bool );
+
+private:
+
+	// permutations of the define sets
+	bool parseDefineSets( QVector< ShaderVariant > & variants, QString & error );
+
+	// comparison helpers
+	int  nextComparisonRow( int row );
+	void endComparison( void );
+
+	// widgets
+	QTextEdit*		m_defineSets;
+	QPushButton*	m_btnApply;
+	QPushButton*	m_btnCompare;
+	QTableWidget*	m_table; // row 0 is the program itself, then one row per variant
+
+	// frame times by row, 0 if not measured
+	QVector< double > m_msPerFrame;
+
+	// running comparison
+	int		m_compareRow;		// -1 if not running
+	int		m_compareFrame;
+	qint64	m_compareTime;		// ns of the measured frames
+	int		m_compareSelection;	// restored when done
+
+	// signal processing
+	int m_skipSelectVariant;
+
+	IScene* m_scene;
+};
+
+
+#endif	// __VARIANTWIDGET_H_INCLUDED__
+
@@ -13,8 +13,13 @@
 
 =============================================================================*/
 
+#include <QtCore/QVector>
+
 #include "application.h"
 #include "vertexstream.h"
+#include "glextra.h"
+#include "tangentspace.h"
+#include "debuglines.h"
 
 
 //=============================================================================
@@ -24,36 +29,63 @@
 
 /** Implementation of the IVertexStream interface.
  * The methods work like described in IVertexStream.
+ * In GPU-resident mode all arrays are stored in a single vertex buffer
+ * object, one block per array in the order defined by vertexArray_e.
  */
 class CVertexStream : public IVertexStream
 {
 public:
 	/** Construcs a vertex stream objecct with space for a given number of vertices.
 	 * @param numVertices Number of vertices this stream can contains.
+	 * @param numIndices Number of indices this stream can contain, may be zero.
 	 */
-	CVertexStream( int numVertices );
+	CVertexStream( int numVertices, int numIndices );
 	virtual ~CVertexStream( void );
 
 	// computes tanget space basis 
-	// -> works only with individual triangles!!!
+	// -> works only with individual or indexed triangles!!!
 	void coumputeTangentVectors( void );
 
 	// bounding radius
 	float computeBoundingRadius( void );
 
+	// buffer object management
+	int  getNumVertices( void ) { return m_numVertices; }
+	int  getNumIndices( void ) { return m_numIndices; }
+	size_t getMemoryUsage( void );
+	void setGpuResident( bool enable );
+	void invalidate( int arrays, int first, int count );
+	int  getUploadedBytes( void );
+
 	// rendering
 	void render( int primitiveType, const vec4_t * overrideColor,
-				 const VertexAttribLocations * attribs );
-	void renderNormals( void );
-	void renderTangentVectors( void );
+				 const VertexAttribLocations * attribs, int numInstances );
+	void renderNormals( float lengthScale, int step );
+	void renderTangentVectors( float lengthScale, int step );
+
+	// custom attributes
+	int		addAttribute( const QString & name, int numComponents, int type );
+	int		findAttribute( const QString & name );
+	int		getNumAttributes( void ) { return m_attributes.size(); }
+	QString	getAttributeName( int index );
+	void*	attribute( int index );
 
 	// vertex arrays
-	vec3_t*	v( void ) { return m_vertices; }
-	vec3_t*	n( void ) { return m_normals; }
-	vec2_t*	t( void ) { return m_texCoords; }
-	vec4_t*	c( void ) { return m_colors; }
-	vec3_t* tan1( void ) { return m_tangents; }
-	vec3_t* tan2( void ) { return m_bitangents; }
+	vec3_t*	v( void ) { invalidate( ARRAY_POSITION,  0, m_numVertices ); return m_vertices; }
+	vec3_t*	n( void ) { invalidate( ARRAY_NORMAL,    0, m_numVertices ); return m_normals; }
+	vec2_t*	t( void ) { invalidate( ARRAY_TEXCOORD,  0, m_numVertices ); return m_texCoords; }
+	vec4_t*	c( void ) { invalidate( ARRAY_COLOR,     0, m_numVertices ); return m_colors; }
+	vec3_t* tan1( void ) { invalidate( ARRAY_TANGENT,   0, m_numVertices ); return m_tangents; }
+	vec3_t* tan2( void ) { invalidate( ARRAY_BITANGENT, 0, m_numVertices ); return m_bitangents; }
+	unsigned int* i( void ) { m_indicesDirty = true; return m_indices; }
+
+	const vec3_t* constV( void ) const { return m_vertices; }
+	const vec3_t* constN( void ) const { return m_normals; }
+	const vec2_t* constT( void ) const { return m_texCoords; }
+	const vec4_t* constC( void ) const { return m_colors; }
+	const vec3_t* constTan1( void ) const { return m_tangents; }
+	const vec3_t* constTan2( void ) const { return m_bitangents; }
+	const unsigned int* constI( void ) const { return m_indices; }
 
 private:
 
@@ -63,6 +95,40 @@ private:
 		vec3_t	bitangent;
 	} tanSpace_t;
 
+	/** A named custom attribute array, stored in its own buffer object. */
+	class CustomAttribute
+	{
+	public:
+		QString			name;
+		int				numComponents;
+		int				type;			// GL_FLOAT or GL_UNSIGNED_BYTE
+		int				elementSize;	// in bytes
+		unsigned char*	data;			// [ m_numVertices * elementSize ]
+		GLuint			vbo;
+		bool			dirty;			// modified since the last upload
+
+		// cached lookup
+		int				programSerial;	// VertexAttribLocations::programSerial of the last lookup
+		int				location;		// -1 if the program does not read it
+	};
+
+	// custom attribute helpers
+	void bindAttributes( const VertexAttribLocations * attribs );
+	void unbindAttributes( void );
+
+	// buffer object helpers
+	int  consumedArrays( const VertexAttribLocations * attribs, const vec4_t * overrideColor );
+	void uploadDirtyRanges( int arrays );
+	void destroyBufferObject( void );
+	void appendVertexCopies( const QVector< int > & copies );
+	int  arrayElementSize( int array ) const;
+	int  arrayOffset( int array ) const;
+	const void* arrayData( int array ) const;
+
+	// debug line helpers
+	void buildNormalLines( void );
+	void buildTangentLines( void );
+
 	int			m_numVertices;
 	vec3_t*		m_vertices;
 	vec3_t*		m_normals;
@@ -70,12 +136,43 @@ private:
 	vec4_t*		m_colors;
 	vec3_t*		m_tangents;
 	vec3_t*		m_bitangents;
+
+	int				m_numIndices;
+	unsigned int*	m_indices;		// NULL if not indexed
+
+	// GPU-resident mode
+	bool		m_gpuResident;
+	GLuint		m_vbo;
+	GLuint		m_ibo;			// index buffer object
+	bool		m_indicesDirty;
+	GLenum		m_vboUsage;		// GL_STATIC_DRAW until an uploaded array is rewritten
+	int			m_uploadedArrays;	// vertexArray_e flags, arrays stored in the buffer object
+	int			m_uploadedBytes;
+
+	// dirty range, in vertices, [m_dirtyFirst, m_dirtyLast)
+	int			m_dirtyArrays;	// vertexArray_e flags
+	int			m_dirtyFirst;
+	int			m_dirtyLast;
+
+	// cached debug lines, NULL until first drawn
+	IDebugLines*	m_normalLines;
+	IDebugLines*	m_tangentLines;
+	bool			m_normalLinesDirty;
+	bool			m_tangentLinesDirty;
+
+	// vertexArray_e flags read by the program with the serial number m_consumedSerial
+	int			m_consumedSerial;
+	int			m_consumedArrays;
+
+	// custom attributes
+	QVector< CustomAttribute >	m_attributes;
+	QVector< int >				m_boundLocations;	// enabled by bindAttributes()
 };
 
 
 // construction
-CVertexStream::CVertexStream( int numVertices )
- : m_numVertices( numVertices )
+CVertexStream::CVertexStream( int numVertices, int numIndices )
+ : m_numVertices( numVertices ), m_numIndices( numIndices )
 {
 	m_vertices		= new vec3_t[ m_numVertices ];
 	m_normals		= new vec3_t[ m_numVertices ];
@@ -83,17 +180,49 @@ CVertexStream::CVertexStream( int numVertices )
 	m_colors		= new vec4_t[ m_numVertices ];
 	m_tangents		= new vec3_t[ m_numVertices ];
 	m_bitangents	= new vec3_t[ m_numVertices ];
+	m_indices		= ( m_numIndices > 0 ) ? new unsigned int[ m_numIndices ] : NULL;
+
+	m_gpuResident	= true;
+	m_vbo			= 0;
+	m_ibo			= 0;
+	m_indicesDirty	= true;
+	m_vboUsage		= GL_STATIC_DRAW;
+	m_uploadedArrays = 0;
+	m_uploadedBytes	= 0;
+
+	// nothing uploaded yet
+	m_dirtyArrays	= ARRAY_ALL;
+	m_dirtyFirst	= 0;
+	m_dirtyLast		= m_numVertices;
+
+	m_consumedSerial	= -1;
+	m_consumedArrays	= ARRAY_ALL;
+
+	m_normalLines		= NULL;
+	m_tangentLines		= NULL;
+	m_normalLinesDirty	= true;
+	m_tangentLinesDirty	= true;
 }
 
 // destruction
 CVertexStream::~CVertexStream( void )
 {
+	destroyBufferObject();
+
+	SAFE_DELETE( m_normalLines );
+	SAFE_DELETE( m_tangentLines );
+
+	for( int i = 0 ; i < m_attributes.size() ; i++ ) {
+		SAFE_DELETE_ARRAY( m_attributes[ i ].data );
+	}
+
 	SAFE_DELETE_ARRAY( m_vertices );
 	SAFE_DELETE_ARRAY( m_normals );
 	SAFE_DELETE_ARRAY( m_texCoords );
 	SAFE_DELETE_ARRAY( m_colors );
 	SAFE_DELETE_ARRAY( m_tangents );
 	SAFE_DELETE_ARRAY( m_bitangents );
+	SAFE_DELETE_ARRAY( m_indices );
 }
 
 
@@ -102,9 +231,9 @@ CVertexStream::~CVertexStream( void )
 IVertexStream::create
 ========================
 */
-IVertexStream* IVertexStream::create( int numVertices )
+IVertexStream* IVertexStream::create( int numVertices, int numIndices )
 {
-	return new CVertexStream( numVertices );
+	return new CVertexStream( numVertices, numIndices );
 }
 
 
@@ -127,47 +256,461 @@ float CVertexStream::computeBoundingRadius( void )
 }
 
 
+/*
+========================
+getMemoryUsage
+========================
+*/
+size_t CVertexStream::getMemoryUsage( void )
+{
+	size_t arrays  = (size_t)arrayOffset( ARRAY_BITANGENT << 1 );
+	size_t indices = m_numIndices * sizeof( unsigned int );
+	size_t size = arrays + indices;
+
+	// the copies in the buffer objects
+	if( m_vbo != 0 ) {
+		size += arrays;
+	}
+	if( m_ibo != 0 ) {
+		size += indices;
+	}
+
+	if( m_normalLines != NULL ) {
+		size += m_normalLines->getMemoryUsage();
+	}
+	if( m_tangentLines != NULL ) {
+		size += m_tangentLines->getMemoryUsage();
+	}
+
+	for( int i = 0 ; i < m_attributes.size() ; i++ )
+	{
+		size_t bytes = m_attributes[ i ].elementSize * m_numVertices;
+		size += ( m_attributes[ i ].vbo != 0 ) ? 2 * bytes : bytes;
+	}
+
+	return size;
+}
+
+
+/*
+========================
+setGpuResident
+========================
+*/
+void CVertexStream::setGpuResident( bool enable )
+{
+	if( enable == m_gpuResident )
+		return;
+
+	m_gpuResident = enable;
+
+	// a new buffer object must be filled completely.
+	if( !enable ) {
+		destroyBufferObject();
+	}
+}
+
+
+/*
+========================
+invalidate
+
+ extends the dirty range. Uploading a single range that covers all
+ modifications is cheaper than tracking individual ranges.
+========================
+*/
+void CVertexStream::invalidate( int arrays, int first, int count )
+{
+	int last = qMin( first + count, m_numVertices );
+	first = qMax( first, 0 );
+
+	if( first >= last || ( arrays & ARRAY_ALL ) == 0 )
+		return;
+
+	// the debug lines are rebuilt on the next draw
+	if( arrays & ( ARRAY_POSITION | ARRAY_NORMAL ) ) {
+		m_normalLinesDirty = true;
+	}
+	if( arrays & ( ARRAY_POSITION | ARRAY_NORMAL | ARRAY_TANGENT | ARRAY_BITANGENT ) ) {
+		m_tangentLinesDirty = true;
+	}
+
+	if( m_dirtyArrays == 0 )
+	{
+		m_dirtyFirst = first;
+		m_dirtyLast  = last;
+	}
+	else
+	{
+		m_dirtyFirst = qMin( m_dirtyFirst, first );
+		m_dirtyLast  = qMax( m_dirtyLast,  last );
+	}
+
+	m_dirtyArrays |= ( arrays & ARRAY_ALL );
+}
+
+
+/*
+========================
+getUploadedBytes
+========================
+*/
+int CVertexStream::getUploadedBytes( void )
+{
+	int bytes = m_uploadedBytes;
+	m_uploadedBytes = 0;
+	return bytes;
+}
+
+
+/*
+========================
+appendVertexCopies
+
+ grows all vertex arrays, the new vertices are copies of the given ones.
+ the buffer objects are re-created on the next upload.
+========================
+*/
+void CVertexStream::appendVertexCopies( const QVector< int > & copies )
+{
+	destroyBufferObject();
+
+	appendSplitVertices( m_vertices,   m_numVertices, copies );
+	appendSplitVertices( m_normals,    m_numVertices, copies );
+	appendSplitVertices( m_texCoords,  m_numVertices, copies );
+	appendSplitVertices( m_colors,     m_numVertices, copies );
+	appendSplitVertices( m_tangents,   m_numVertices, copies );
+	appendSplitVertices( m_bitangents, m_numVertices, copies );
+
+	for( int i = 0 ; i < m_attributes.size() ; i++ )
+	{
+		CustomAttribute & a = m_attributes[ i ];
+		unsigned char* grown = new unsigned char[ ( m_numVertices + copies.size() ) * a.elementSize ];
+
+		memcpy( grown, a.data, m_numVertices * a.elementSize );
+		for( int k = 0 ; k < copies.size() ; k++ ) {
+			memcpy( grown + ( m_numVertices + k ) * a.elementSize,
+					a.data + copies[ k ] * a.elementSize, a.elementSize );
+		}
+
+		SAFE_DELETE_ARRAY( a.data );
+		a.data = grown;
+	}
+
+	m_numVertices += copies.size();
+
+	m_dirtyFirst		= 0;
+	m_dirtyLast			= m_numVertices;
+	m_indicesDirty		= true;
+	m_normalLinesDirty	= true;
+	m_tangentLinesDirty	= true;
+}
+
+
+/*
+========================
+arrayElementSize
+========================
+*/
+int CVertexStream::arrayElementSize( int array ) const
+{
+	switch( array )
+	{
+	case ARRAY_POSITION:	return sizeof( vec3_t ); break;
+	case ARRAY_NORMAL:		return sizeof( vec3_t ); break;
+	case ARRAY_TEXCOORD:	return sizeof( vec2_t ); break;
+	case ARRAY_COLOR:		return sizeof( vec4_t ); break;
+	case ARRAY_TANGENT:		return sizeof( vec3_t ); break;
+	case ARRAY_BITANGENT:	return sizeof( vec3_t ); break;
+	}
+
+	return 0;
+}
+
+
+/*
+========================
+arrayOffset
+
+ byte offset of an array block inside the buffer object.
+ the blocks are stored in the order of the vertexArray_e flags.
+========================
+*/
+int CVertexStream::arrayOffset( int array ) const
+{
+	int offset = 0;
+
+	for( int a = ARRAY_POSITION ; a < array ; a <<= 1 )
+	{
+		offset += arrayElementSize( a ) * m_numVertices;
+	}
+
+	return offset;
+}
+
+
+/*
+========================
+arrayData
+========================
+*/
+const void* CVertexStream::arrayData( int array ) const
+{
+	switch( array )
+	{
+	case ARRAY_POSITION:	return m_vertices; break;
+	case ARRAY_NORMAL:		return m_normals; break;
+	case ARRAY_TEXCOORD:	return m_texCoords; break;
+	case ARRAY_COLOR:		return m_colors; break;
+	case ARRAY_TANGENT:		return m_tangents; break;
+	case ARRAY_BITANGENT:	return m_bitangents; break;
+	}
+
+	return NULL;
+}
+
+
+/*
+========================
+consumedArrays
+
+ returns the vertexArray_e flags of the arrays the program reads.
+ The result is cached per program, see VertexAttribLocations::programSerial.
+========================
+*/
+int CVertexStream::consumedArrays( const VertexAttribLocations * attribs, const vec4_t * overrideColor )
+{
+	// fixed function pipeline
+	if( attribs == NULL ) {
+		m_consumedSerial = -1;
+		m_consumedArrays = ARRAY_POSITION | ARRAY_NORMAL | ARRAY_TEXCOORD | ARRAY_COLOR;
+	}
+	else if( attribs->programSerial != m_consumedSerial )
+	{
+		m_consumedSerial = attribs->programSerial;
+		m_consumedArrays = ARRAY_POSITION;
+
+		if( attribs->builtins & VertexAttribLocations::BUILTIN_NORMAL )		m_consumedArrays |= ARRAY_NORMAL;
+		if( attribs->builtins & VertexAttribLocations::BUILTIN_TEXCOORD )	m_consumedArrays |= ARRAY_TEXCOORD;
+		if( attribs->builtins & VertexAttribLocations::BUILTIN_COLOR )		m_consumedArrays |= ARRAY_COLOR;
+		if( attribs->tangent != -1 )	m_consumedArrays |= ARRAY_TANGENT;
+		if( attribs->bitangent != -1 )	m_consumedArrays |= ARRAY_BITANGENT;
+	}
+
+	// the color is constant
+	if( overrideColor != NULL ) {
+		return m_consumedArrays & ~ARRAY_COLOR;
+	}
+
+	return m_consumedArrays;
+}
+
+
+/*
+========================
+uploadDirtyRanges
+
+ assumes the buffer object is bound to GL_ARRAY_BUFFER.
+ If every array is dirty over the complete stream, the buffer storage is
+ orphaned, so the driver does not have to wait for pending draw calls
+ using the old data. Otherwise only the dirty range of every modified
+ array is replaced.
+ Only the given arrays are uploaded, the others stay dirty until a
+ program reads them.
+========================
+*/
+void CVertexStream::uploadDirtyRanges( int arrays )
+{
+	if( ( m_dirtyArrays & arrays ) == 0 )
+		return;
+
+	// orphaning discards the static blocks too, e.g. the texcoords of an animated stream.
+	bool complete = ( m_dirtyFirst == 0 && m_dirtyLast == m_numVertices &&
+					  m_dirtyArrays == ARRAY_ALL );
+
+	// Streams modified after their initial upload are likely to be modified
+	// again, so let the driver know when we orphan the storage next time.
+	// The first upload of an array that a new program reads is no modification.
+	if( m_dirtyArrays & arrays & m_uploadedArrays ) {
+		m_vboUsage = GL_STREAM_DRAW;
+	}
+
+	if( complete )
+	{
+		// orphan the old storage, the size is the offset behind the last block.
+		glBufferData( GL_ARRAY_BUFFER, arrayOffset( ARRAY_BITANGENT << 1 ), NULL, m_vboUsage );
+	}
+
+	for( int a = ARRAY_POSITION ; a <= ARRAY_BITANGENT ; a <<= 1 )
+	{
+		if( ( m_dirtyArrays & arrays & a ) == 0 )
+			continue;
+
+		int size  = arrayElementSize( a );
+		int bytes = size * ( m_dirtyLast - m_dirtyFirst );
+
+		glBufferSubData( GL_ARRAY_BUFFER,
+						 arrayOffset( a ) + size * m_dirtyFirst, bytes,
+						 (const char*)arrayData( a ) + size * m_dirtyFirst );
+
+		m_uploadedBytes += bytes;
+	}
+
+	m_uploadedArrays |= ( m_dirtyArrays & arrays );
+	m_dirtyArrays &= ~arrays;
+}
+
+
+/*
+========================
+destroyBufferObject
+
+ the next render() call in GPU-resident mode re-creates and fills it.
+========================
+*/
+void CVertexStream::destroyBufferObject( void )
+{
+	if( m_vbo != 0 )
+	{
+		glDeleteBuffers( 1, &m_vbo );
+		m_vbo = 0;
+	}
+
+	if( m_ibo != 0 )
+	{
+		glDeleteBuffers( 1, &m_ibo );
+		m_ibo = 0;
+	}
+
+	for( int i = 0 ; i < m_attributes.size() ; i++ )
+	{
+		CustomAttribute & a = m_attributes[ i ];
+		if( a.vbo != 0 ) {
+			glDeleteBuffers( 1, &a.vbo );
+			a.vbo = 0;
+		}
+		a.dirty = true;
+	}
+
+	m_uploadedArrays = 0;
+	m_vboUsage		= GL_STATIC_DRAW;
+	m_dirtyArrays	= ARRAY_ALL;
+	m_dirtyFirst	= 0;
+	m_dirtyLast		= m_numVertices;
+	m_indicesDirty	= true;
+}
+
+
 /*
 ========================
 render
 ========================
 */
 void CVertexStream::render( int primitiveType, const vec4_t * overrideColor,
-						    const VertexAttribLocations * attribs )
+						    const VertexAttribLocations * attribs, int numInstances )
 {
-	// enable arrays
+	// array base addresses
+	const char* vertices	= (const char*)m_vertices;
+	const char* normals		= (const char*)m_normals;
+	const char* texCoords	= (const char*)m_texCoords;
+	const char* colors		= (const char*)m_colors;
+	const char* tangents	= (const char*)m_tangents;
+	const char* bitangents	= (const char*)m_bitangents;
+	const char* indices		= (const char*)m_indices;
+
+	// arrays read by the current program
+	int arrays = consumedArrays( attribs, overrideColor );
+
+	// GPU-resident: update the buffer object and use offsets instead of pointers.
+	if( m_gpuResident )
+	{
+		if( m_vbo == 0 ) {
+			glGenBuffers( 1, &m_vbo );
+		}
+
+		glBindBuffer( GL_ARRAY_BUFFER, m_vbo );
+		uploadDirtyRanges( arrays );
+
+		vertices	= (const char*)NULL + arrayOffset( ARRAY_POSITION );
+		normals		= (const char*)NULL + arrayOffset( ARRAY_NORMAL );
+		texCoords	= (const char*)NULL + arrayOffset( ARRAY_TEXCOORD );
+		colors		= (const char*)NULL + arrayOffset( ARRAY_COLOR );
+		tangents	= (const char*)NULL + arrayOffset( ARRAY_TANGENT );
+		bitangents	= (const char*)NULL + arrayOffset( ARRAY_BITANGENT );
+
+		// the index array is written once in most cases, no need for ranges.
+		if( m_indices != NULL )
+		{
+			if( m_ibo == 0 ) {
+				glGenBuffers( 1, &m_ibo );
+			}
+
+			glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_ibo );
+
+			if( m_indicesDirty )
+			{
+				glBufferData( GL_ELEMENT_ARRAY_BUFFER, m_numIndices * sizeof(unsigned int),
+							  m_indices, GL_STATIC_DRAW );
+				m_uploadedBytes += m_numIndices * sizeof(unsigned int);
+				m_indicesDirty = false;
+			}
+
+			indices = NULL;
+		}
+	}
+
+	// enable arrays, only the ones the program reads
 	glEnableClientState( GL_VERTEX_ARRAY );
-	glEnableClientState( GL_NORMAL_ARRAY );
-	glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+	glVertexPointer( 3, GL_FLOAT, 0, vertices );
+
+	if( arrays & ARRAY_NORMAL ) {
+		glEnableClientState( GL_NORMAL_ARRAY );
+		glNormalPointer( GL_FLOAT, 0, normals );
+	}
+
+	if( arrays & ARRAY_TEXCOORD ) {
+		glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+		glTexCoordPointer( 2, GL_FLOAT, 0, texCoords );
+	}
 
 	// primary color
 	if( overrideColor != NULL ) {
 		glColor4fv( overrideColor->toFloatPointer() );
 		glDisableClientState( GL_COLOR_ARRAY );
-	} else {
+	} else if( arrays & ARRAY_COLOR ) {
 		glEnableClientState( GL_COLOR_ARRAY );
+		glColorPointer( 4, GL_FLOAT, 0, colors );
 	}
 
-	// set pointers
-	glVertexPointer  ( 3, GL_FLOAT, 0, m_vertices );
-	glNormalPointer  (    GL_FLOAT, 0, m_normals );
-	glTexCoordPointer( 2, GL_FLOAT, 0, m_texCoords );
-	glColorPointer   ( 4, GL_FLOAT, 0, m_colors );
-
 	// tangent space matrix, X
-	if( attribs != NULL && attribs->tangent != -1 ) {
-		glVertexAttribPointer( attribs->tangent, 3, GL_FLOAT, true, sizeof(vec3_t), m_tangents );
+	if( arrays & ARRAY_TANGENT ) {
+		glVertexAttribPointer( attribs->tangent, 3, GL_FLOAT, true, sizeof(vec3_t), tangents );
 		glEnableVertexAttribArray( attribs->tangent );
 	}
 
 	// tangent space matrix, Y
-	if( attribs != NULL && attribs->bitangent != -1 ) {
-		glVertexAttribPointer( attribs->bitangent, 3, GL_FLOAT, true, sizeof(vec3_t), m_bitangents );
+	if( arrays & ARRAY_BITANGENT ) {
+		glVertexAttribPointer( attribs->bitangent, 3, GL_FLOAT, true, sizeof(vec3_t), bitangents );
 		glEnableVertexAttribArray( attribs->bitangent );
 	}
 
+	// named attributes
+	bindAttributes( attribs );
+
 	// draw it
-	glDrawArrays( primitiveType, 0, m_numVertices );
+	if( numInstances > 1 )
+	{
+		if( m_indices != NULL ) {
+			smglDrawElementsInstanced( primitiveType, m_numIndices, GL_UNSIGNED_INT, indices, numInstances );
+		} else {
+			smglDrawArraysInstanced( primitiveType, 0, m_numVertices, numInstances );
+		}
+	}
+	else if( m_indices != NULL ) {
+		glDrawElements( primitiveType, m_numIndices, GL_UNSIGNED_INT, indices );
+	} else {
+		glDrawArrays( primitiveType, 0, m_numVertices );
+	}
 
 	// clean up state
 	glDisableClientState( GL_VERTEX_ARRAY );
@@ -176,118 +719,281 @@ void CVertexStream::render( int primitiveType, const vec4_t * overrideColor,
 	glDisableClientState( GL_COLOR_ARRAY );
 
 	// disable custom attribs
-	if( attribs != NULL && attribs->tangent != -1 )
+	if( arrays & ARRAY_TANGENT )
 		glDisableVertexAttribArray( attribs->tangent );
 
-	if( attribs != NULL && attribs->bitangent != -1 )
+	if( arrays & ARRAY_BITANGENT )
 		glDisableVertexAttribArray( attribs->bitangent );
+
+	unbindAttributes();
+
+	if( m_gpuResident ) {
+		glBindBuffer( GL_ARRAY_BUFFER, 0 );
+		glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+	}
 }
 
 
 /*
 ========================
-renderTangentVectors
+addAttribute
 ========================
 */
-void CVertexStream::renderTangentVectors( void )
+int CVertexStream::addAttribute( const QString & name, int numComponents, int type )
 {
-	float length = 0.1f;
+	if( name.isEmpty() || numComponents < 1 || numComponents > 4 )
+		return -1;
 
-	glBegin( GL_LINES );
+	int componentSize = 0;
+	switch( type )
+	{
+	case GL_FLOAT:			componentSize = sizeof( GLfloat ); break;
+	case GL_UNSIGNED_BYTE:	componentSize = sizeof( GLubyte ); break;
+	default: return -1;
+	}
 
-	for( int i = 0 ; i < m_numVertices ; i++ )
+	// reuse an existing attribute
+	int index = findAttribute( name );
+	if( index != -1 )
 	{
-		// tangent
-		glColor3f( 1,0,0 );
-		glVertex3fv( m_vertices[i].toFloatPointer() );
-		glVertex3fv( ( m_vertices[i] + m_tangents[i] * length ).toFloatPointer() );
+		const CustomAttribute & a = m_attributes[ index ];
+		return ( a.numComponents == numComponents && a.type == type ) ? index : -1;
+	}
+
+	CustomAttribute a;
+	a.name			= name;
+	a.numComponents	= numComponents;
+	a.type			= type;
+	a.elementSize	= numComponents * componentSize;
+	a.data			= new unsigned char[ m_numVertices * a.elementSize ];
+	a.vbo			= 0;
+	a.dirty			= true;
+	a.programSerial	= 0;
+	a.location		= -1;
+	memset( a.data, 0, m_numVertices * a.elementSize );
+
+	m_attributes.append( a );
+	return m_attributes.size() - 1;
+}
 
-		// bitangent
-		glColor3f( 0,1,0 );
-		glVertex3fv( m_vertices[i].toFloatPointer() );
-		glVertex3fv( ( m_vertices[i] + m_bitangents[i] * length ).toFloatPointer() );
 
-		// normal
-		glColor3f( 0,0,1 );
-		glVertex3fv( m_vertices[i].toFloatPointer() );
-		glVertex3fv( ( m_vertices[i] + m_normals[i] * length ).toFloatPointer() );
+/*
+========================
+findAttribute
+========================
+*/
+int CVertexStream::findAttribute( const QString & name )
+{
+	for( int i = 0 ; i < m_attributes.size() ; i++ )
+	{
+		if( m_attributes[ i ].name == name )
+			return i;
 	}
 
-	glEnd();
+	return -1;
 }
 
 
 /*
 ========================
-renderNormals
+getAttributeName
 ========================
 */
-void CVertexStream::renderNormals( void )
+QString CVertexStream::getAttributeName( int index )
 {
-	glBegin( GL_LINES );
+	if( index < 0 || index >= m_attributes.size() )
+		return QString();
 
-	for( int i = 0 ; i < m_numVertices ; i++ )
+	return m_attributes[ index ].name;
+}
+
+
+/*
+========================
+attribute
+========================
+*/
+void* CVertexStream::attribute( int index )
+{
+	if( index < 0 || index >= m_attributes.size() )
+		return NULL;
+
+	m_attributes[ index ].dirty = true;
+	return m_attributes[ index ].data;
+}
+
+
+/*
+========================
+bindAttributes
+
+ binds the custom attributes the program reads. The others are skipped,
+ so they are never uploaded.
+========================
+*/
+void CVertexStream::bindAttributes( const VertexAttribLocations * attribs )
+{
+	m_boundLocations.clear();
+
+	if( attribs == NULL || attribs->programSerial == 0 )
+		return;
+
+	for( int i = 0 ; i < m_attributes.size() ; i++ )
 	{
-		const vec3_t & n = m_normals[ i ];
-		float x = fabs( n.x );
-		float y = fabs( n.y );
-		float z = fabs( n.z );
-
-		// select max. component as color
-		if( x > y && x > z ) {
-			glColor3f( 1,0,0 );
-		} else if( y > x && y > z ) {
-			glColor3f( 0,1,0 );
-		} else if( z > x && z > y ) {
-			glColor3f( 0,0,1 );
-		} else { // two components equal
-			glColor3f( 1,1,1 );
+		CustomAttribute & a = m_attributes[ i ];
+
+		// look up the name only once per program
+		if( a.programSerial != attribs->programSerial )
+		{
+			a.location = attribs->find( a.name );
+			a.programSerial = attribs->programSerial;
+		}
+
+		if( a.location == -1 )
+			continue;
+
+		const char* pointer = (const char*)a.data;
+		if( m_gpuResident )
+		{
+			if( a.vbo == 0 ) {
+				glGenBuffers( 1, &a.vbo );
+			}
+
+			glBindBuffer( GL_ARRAY_BUFFER, a.vbo );
+			if( a.dirty )
+			{
+				glBufferData( GL_ARRAY_BUFFER, m_numVertices * a.elementSize, a.data, GL_STATIC_DRAW );
+				m_uploadedBytes += m_numVertices * a.elementSize;
+				a.dirty = false;
+			}
+
+			pointer = NULL;
 		}
 
-		glVertex3fv( m_vertices[i].toFloatPointer() );
-		glVertex3fv( ( m_vertices[i] + n * 0.3f ).toFloatPointer() );
+		glVertexAttribPointer( a.location, a.numComponents, a.type, a.type != GL_FLOAT, 0, pointer );
+		glEnableVertexAttribArray( a.location );
+		m_boundLocations.append( a.location );
+	}
+}
+
+
+/*
+========================
+unbindAttributes
+========================
+*/
+void CVertexStream::unbindAttributes( void )
+{
+	for( int i = 0 ; i < m_boundLocations.size() ; i++ ) {
+		glDisableVertexAttribArray( m_boundLocations[ i ] );
 	}
 
-	glEnd();
+	m_boundLocations.clear();
 }
 
 
 /*
 ========================
-computeTangentVectors
+buildTangentLines
 ========================
 */
-void CVertexStream::coumputeTangentVectors( void )
+void CVertexStream::buildTangentLines( void )
 {
-	// assumes triangles!
-	int numTriangles = m_numVertices / 3;
+	if( m_tangentLines == NULL ) {
+		m_tangentLines = IDebugLines::create();
+	}
 
-	for( int i = 0 ; i < numTriangles ; i++ )
+	// one group of three lines per vertex
+	m_tangentLines->begin( 3 * m_numVertices, 3 );
+
+	for( int i = 0 ; i < m_numVertices ; i++ )
 	{
-		vec3_t e1 = m_vertices [3*i+1] - m_vertices [3*i];
-		vec3_t e2 = m_vertices [3*i+2] - m_vertices [3*i];
-		vec2_t t1 = m_texCoords[3*i+1] - m_texCoords[3*i];
-		vec2_t t2 = m_texCoords[3*i+2] - m_texCoords[3*i];
+		m_tangentLines->setLine( 3*i + 0, m_vertices[i], m_tangents[i],   vec3_t( 1,0,0 ) );
+		m_tangentLines->setLine( 3*i + 1, m_vertices[i], m_bitangents[i], vec3_t( 0,1,0 ) );
+		m_tangentLines->setLine( 3*i + 2, m_vertices[i], m_normals[i],    vec3_t( 0,0,1 ) );
+	}
 
-		float length = t1.y * t2.x - t1.x *t2.y;
-		if( fabs(length) > 0.000001 ) // triangle not degenerated
-		{
-			// solve linear equations
-			vec3_t planeTangent = ( e2 * t1.y - e1 * t2.y );
+	m_tangentLines->end();
+	m_tangentLinesDirty = false;
+}
 
-			// adjust tangents to the vertex normal
-			for( int k = 0 ; k < 3 ; k++ )
-			{
-				// assumed to be normalized.
-				const vec3_t & normal = m_normals[3*i+k];
 
-				// orthogonalize
-				vec3_t tangent = planeTangent - normal * planeTangent.dotProduct( normal );
-				tangent = tangent.normalize();
+/*
+========================
+buildNormalLines
+========================
+*/
+void CVertexStream::buildNormalLines( void )
+{
+	if( m_normalLines == NULL ) {
+		m_normalLines = IDebugLines::create();
+	}
+
+	m_normalLines->begin( m_numVertices );
 
-				m_tangents  [3*i+k] = tangent;
-				m_bitangents[3*i+k] = tangent.crossProduct( normal );
-			}
+	for( int i = 0 ; i < m_numVertices ; i++ ) {
+		m_normalLines->setLine( i, m_vertices[i], m_normals[i], debugNormalColor( m_normals[i] ) );
+	}
+
+	m_normalLines->end();
+	m_normalLinesDirty = false;
+}
+
+
+/*
+========================
+renderTangentVectors
+========================
+*/
+void CVertexStream::renderTangentVectors( float lengthScale, int step )
+{
+	if( m_tangentLinesDirty ) {
+		buildTangentLines();
+	}
+
+	m_tangentLines->render( 0.1f * lengthScale, step );
+}
+
+
+/*
+========================
+renderNormals
+========================
+*/
+void CVertexStream::renderNormals( float lengthScale, int step )
+{
+	if( m_normalLinesDirty ) {
+		buildNormalLines();
+	}
+
+	m_normalLines->render( 0.3f * lengthScale, step );
+}
+
+
+/*
+========================
+computeTangentVectors
+========================
+*/
+void CVertexStream::coumputeTangentVectors( void )
+{
+	// assumes triangles!
+	int numTriangles = ( m_indices != NULL ) ? m_numIndices / 3 : m_numVertices / 3;
+
+	// vertices shared by mirrored or unconnected triangles get a copy.
+	if( m_indices != NULL )
+	{
+		QVector< int > copies;
+		splitTangentGroups( m_numVertices, m_vertices, m_texCoords,
+							numTriangles, m_indices, copies );
+
+		if( !copies.isEmpty() ) {
+			appendVertexCopies( copies );
 		}
 	}
+
+	computeTangentSpace( m_numVertices, m_vertices, m_normals, m_texCoords,
+						 numTriangles, m_indices, m_tangents, m_bitangents );
+
+	invalidate( ARRAY_TANGENT | ARRAY_BITANGENT, 0, m_numVertices );
 }
@@ -16,8 +16,12 @@
 #ifndef __VERTEXSTREAM_H_INCLUDED__
 #define __VERTEXSTREAM_H_INCLUDED__
 
+#include <stddef.h>
+#include <QtCore/QString>
 #include "vector.h"
 
+// -> include application.h before this file, it includes GLee.h.
+
 // forward declarations
 class VertexAttribLocations;
 
@@ -29,21 +33,97 @@ class VertexAttribLocations;
 /** An interface to a generic vertex data container.
  * The container is an easy-to-use wrapper for OpenGL vertex arrays.
  * It supports some custom vertex attributes for vertex shaders.
+ * \n\n
+ * By default the stream is GPU-resident: the vertex arrays are kept
+ * in a vertex buffer object and are only sent to OpenGL when they have
+ * been modified. Every call to one of the array accessors v(), n(), t(),
+ * c(), tan1() and tan2() marks the complete array as modified, because
+ * the caller gets write access to all elements. Use invalidate() to mark
+ * smaller ranges after writing through a previously returned pointer.
+ * Code that only reads the arrays uses constV(), constN() and so on,
+ * they leave the arrays clean.
+ * Dirty ranges are uploaded on the next call to render().
+ * \n\n
+ * A stream may optionally store an index array. In that case render()
+ * draws the indexed primitives, so vertices can be shared between
+ * primitives. The index array is kept in its own buffer object.
+ * \n\n
+ * Besides the fixed arrays, a stream can store any number of named custom
+ * attributes, see addAttribute(). They are matched by name to the active
+ * attributes of the current program.
  */
 class IVertexStream
 {
 public:
 	/** creates an IVertexStream object.
 	 * @param numVertices Number of vertices available in the buffer.
+	 * @param numIndices Number of indices available in the buffer.
+	 *        If zero, the vertices are drawn in the order they are stored.
 	 */
-	static IVertexStream* create( int numVertices );
+	static IVertexStream* create( int numVertices, int numIndices = 0 );
 	virtual ~IVertexStream( void ) {} ///< Destructor, provided for compatibility.
 
+	/** Vertex arrays stored in the stream.
+	 * The values are bit flags, so they can be combined for invalidate().
+	 */
+	enum vertexArray_e
+	{
+		ARRAY_POSITION	= 0x01,
+		ARRAY_NORMAL	= 0x02,
+		ARRAY_TEXCOORD	= 0x04,
+		ARRAY_COLOR		= 0x08,
+		ARRAY_TANGENT	= 0x10,
+		ARRAY_BITANGENT	= 0x20,
+
+		ARRAY_ALL		= 0x3f,
+	};
+
+	/** Returns the number of vertices stored in the stream. */
+	virtual int getNumVertices( void ) = 0;
+
+	/** Returns the number of indices stored in the stream, may be zero. */
+	virtual int getNumIndices( void ) = 0;
+
+	/** Returns the size of all vertex and index arrays in bytes.
+	 * The copies held by the buffer objects in GPU-resident mode and
+	 * the debug lines are included once they have been created,
+	 * so the result grows after the first render() calls.
+	 */
+	virtual size_t getMemoryUsage( void ) = 0;
+
+	/** Enables or disables the GPU-resident mode.
+	 * If enabled, the vertex data is stored in a vertex buffer object
+	 * and only modified ranges are uploaded. If disabled, the client
+	 * memory arrays are passed to OpenGL on every render() call.
+	 * The default is enabled.
+	 * @param enable Wether to keep the stream in a buffer object.
+	 */
+	virtual void setGpuResident( bool enable ) = 0;
+
+	/** Marks a range of vertices as modified.
+	 * The range is uploaded to the buffer object with the next render() call.
+	 * Out of range values are clamped to the stream size.
+	 * @param arrays Combination of vertexArray_e flags selecting the modified arrays.
+	 * @param first Index of the first modified vertex.
+	 * @param count Number of modified vertices.
+	 */
+	virtual void invalidate( int arrays, int first, int count ) = 0;
+
+	/** Returns the number of bytes sent to the buffer object since the last call.
+	 * The counter is reset to zero by this call.
+	 */
+	virtual int getUploadedBytes( void ) = 0;
+
 	/** Computes tangent space vectors 'tangent' and 'bitangent'.
 	 * @warning Assumes individual triangles are stored in the stream.
 	 * Calculates for each triangle in the buffer the vertex attributes
 	 * 'attrTangent' and 'attrBitangent'. These vectors are based on the
 	 * vertex normals, texture coords and positions.
+	 * If the stream is indexed, the triangles are read from the index array
+	 * and the tangents of all triangles sharing a vertex are averaged.
+	 * Vertices whose corners need different tangent spaces are split,
+	 * see splitTangentGroups(), so the stream may have more vertices afterwards.
+	 * The result is MikkTSpace compatible, see computeTangentSpace().
 	 */
 	virtual void coumputeTangentVectors( void ) = 0;
 
@@ -57,37 +137,93 @@ public:
 	/** Sends the stream to OpenGL.
 	 * It setups OpenGL client state, binds vertex arrays, draws the
 	 * complete array and cleans up the GL client state.
+	 * Indexed streams are drawn with glDrawElements().
+	 * Only the arrays the program reads are enabled and uploaded, see
+	 * VertexAttribLocations::builtins. The other arrays stay dirty until
+	 * a program reads them.
 	 * @param primitiveType The primitive type that is passed to OpenGL.
 	 * @param overrideColor If != NULL, this color will be passed to
 	 *        OpenGL instead of the colors stored in the stream.
 	 * @param attribs If != NULL the custom vertex attributes are send to
 	 *                the locations defined in the parameter.
+	 * @param numInstances If > 1, the stream is drawn with a single instanced
+	 *        draw call. The caller must check smglIsInstancingAvailable() and
+	 *        setup the per-instance attributes.
 	 */
 	virtual void render( int primitiveType, const vec4_t * overrideColor = NULL,
-						 const VertexAttribLocations * attribs = NULL ) = 0;
+						 const VertexAttribLocations * attribs = NULL,
+						 int numInstances = 1 ) = 0;
 
 	/** Draws the normals of all vertices.
 	 * It loops through all vertices and draws a colored line starting
 	 * at the vertex position and pointing into the normal's direction.
 	 * The colors are chosen from the largest component:
 	 *  x == red, Y == green, Z == blue.
+	 * The lines are built once into a buffer object and rebuilt only
+	 * if the positions or normals are modified.
+	 * @param lengthScale Scale factor for the default line length of 0.3.
+	 * @param step Only every step-th vertex is drawn.
 	 */
-	virtual void renderNormals( void ) = 0;
+	virtual void renderNormals( float lengthScale = 1.0f, int step = 1 ) = 0;
 
 	/** Draw the basis vectors of the tangent space for all vertices.
 	 * It draws a line from the vertex position in the direction of 
 	 * each tangent space vector.
 	 * Tangent == red, Bitangent == green, Normal == blue.
+	 * The lines are cached like in renderNormals().
+	 * @param lengthScale Scale factor for the default line length of 0.1.
+	 * @param step Only every step-th vertex is drawn.
+	 */
+	virtual void renderTangentVectors( float lengthScale = 1.0f, int step = 1 ) = 0;
+
+	/** Adds a named custom vertex attribute array.
+	 * On render() the array is bound to the program attribute with the same
+	 * name, e.g. 'attribute vec2 attrCurvature'. Arrays the program does not
+	 * read are neither uploaded nor bound. The lookup is cached per program.
+	 * @param name Name of the GLSL attribute.
+	 * @param numComponents Number of components per vertex, 1 to 4.
+	 * @param type GL_FLOAT, or GL_UNSIGNED_BYTE for values normalized to [0,1].
+	 * @return Index of the attribute for attribute(), -1 if the parameters are
+	 *         invalid. If the name exists, its index is returned if the format
+	 *         matches, otherwise -1.
+	 */
+	virtual int addAttribute( const QString & name, int numComponents, int type = GL_FLOAT ) = 0;
+
+	/** Returns the index of a custom attribute, -1 if there is none with this name. */
+	virtual int findAttribute( const QString & name ) = 0;
+
+	/** Returns the number of custom attributes. */
+	virtual int getNumAttributes( void ) = 0;
+
+	/** Returns the name of a custom attribute. */
+	virtual QString getAttributeName( int index ) = 0;
+
+	/** Returns a custom attribute array and marks it as modified.
+	 * The array stores getNumVertices() tightly packed elements
+	 * of the format passed to addAttribute().
+	 * @return The array, NULL if the index is invalid.
 	 */
-	virtual void renderTangentVectors( void ) = 0;
+	virtual void* attribute( int index ) = 0;
 
 	// vertex arrays access
+	// -> marks the returned array as modified, see invalidate().
 	virtual vec3_t*	v( void ) = 0; ///< Returns the vertex position array.
 	virtual vec3_t*	n( void ) = 0; ///< Returns the normal array.
 	virtual vec2_t*	t( void ) = 0; ///< Returns the tex coord array.
 	virtual vec4_t*	c( void ) = 0; ///< Returns the primary color array.
 	virtual vec3_t* tan1( void ) = 0; ///< Returns the tangent array.
 	virtual vec3_t* tan2( void ) = 0; ///< Returns the bitangent array.
+	virtual unsigned int* i( void ) = 0; ///< Returns the index array, NULL if not indexed.
+
+	// read-only vertex arrays access
+	// -> nothing is marked as modified.
+	virtual const vec3_t* constV( void ) const = 0; ///< Returns the vertex position array.
+	virtual const vec3_t* constN( void ) const = 0; ///< Returns the normal array.
+	virtual const vec2_t* constT( void ) const = 0; ///< Returns the tex coord array.
+	virtual const vec4_t* constC( void ) const = 0; ///< Returns the primary color array.
+	virtual const vec3_t* constTan1( void ) const = 0; ///< Returns the tangent array.
+	virtual const vec3_t* constTan2( void ) const = 0; ///< Returns the bitangent array.
+	virtual const unsigned int* constI( void ) const = 0; ///< Returns the index array, NULL if not indexed.
 };
 
 